@@ -3,6 +3,7 @@
  */
 
 #define _POSIX_C_SOURCE 200112L
+#define _GNU_SOURCE         // SO_REUSEPORT, pthread_attr_setaffinity_np
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h> 
@@ -16,11 +17,36 @@
 #include <sys/select.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
 
 
 #define CY_HEADER_OFFSET 16
 #define CY_BUFFSIZE 2048
 
+// cy_hash_flag bits
+#define CY_HASH_FLAG_MERKLE 0x01    // leaf size, root and leaf hashes follow the header
+#define CY_HASH_FLAG_CRC32C 0x02    // CRC32C of the payload then the 16 header bytes follows it, 4 bytes big endian
+#define CY_HASH_FLAG_RESUME 0x04    // with MERKLE, the receiver answers the leaf list with a bitmap of the leaves it still needs
+
+#define CY_MERKLE_LEAF (1 << 20)
+#define CY_POOL_SLOTS 16
+#define CY_POOL_MAX (1 << 24)
+#define CY_POOL_BYTES ((size_t)1 << 26)    // most a worker's pool keeps across all its slots
+#define CY_MERKLE_MIN_LEAF 1024
+#define CY_MAX_MSG ((uint64_t)1 << 30)     // largest payload a receiver allocates for
+#define CY_CONN_IDLE 30                    // seconds without a byte before a connection is dropped
+#define CY_OUT_MAX ((size_t)1 << 28)       // bytes queued for stdout before a loop stops reading its connections
+#define CY_FRAME_SIZE 16                   // event loop stdout frame: client id then payload length, 8 bytes each big endian
+
 struct CY_HEADER
 {
     uint64_t cy_data_len;
@@ -32,6 +58,7 @@ struct CY_HEADER
     uint8_t cy_key_type;
     uint8_t cy_hash_flag;
     uint8_t cy_hash_type;
+    uint32_t cy_crc;        // CRC32C of payload and header, sent as the trailer rather than in the 16 header bytes
 };
 
 
@@ -45,6 +72,15 @@ void cy_buff_size_imp(const uint8_t buff[], size_t *size);
 
 void serror(const char *fmt);
 
+void cy_buff_send_all(int __fd, const uint8_t *buff, const size_t size);
+
+void cy_buff_recv_all(int __fd, uint8_t *buff, const size_t size, uint32_t *crc);
+
+// merkle root a server was told to expect with -R, without it a root only
+// shows the leaf list is self consistent, not who sent it
+static uint8_t cy_pin[64];
+static size_t cy_pin_len;
+
 
 void cy_buff_size_exp(const size_t size, uint8_t buff[])
 {
@@ -78,42 +114,248 @@ void cy_buff_header_imp(const uint8_t buff[], struct CY_HEADER *head)
     head->cy_hash_flag = buff[14]; head->cy_hash_type = buff[15];
 }
 
-void cy_buff_send(int __fd, const struct CY_HEADER head, uint8_t *buff)
+void cy_buff_send_all(int __fd, const uint8_t *buff, const size_t size)
 {
-    cy_buff_header_exp(head, buff);
-    size_t fullsize = head.cy_data_len + 16;
     size_t total = 0;
-    while (total < fullsize)
+    while (total < size)
     {
-        ssize_t n = send(__fd, buff + total, fullsize - total, 0);
+        ssize_t n = send(__fd, buff + total, size - total, 0);
         if(n == 0) serror("cy_buff_send(-> send <-)");
         if(n < 0) serror("cy_buff_send(-> send <-)");
         total +=n;
     }
 }
 
-void cy_buff_recv(int __fd, struct CY_HEADER *head, uint8_t **buff)
+// crc, when given, takes in each piece while it is still in cache
+void cy_buff_recv_all(int __fd, uint8_t *buff, const size_t size, uint32_t *crc)
 {
-    size_t fullsize = 16;
     size_t total = 0;
-    memset(head, 0, sizeof(*head));
-    *buff = malloc(CY_BUFFSIZE * sizeof(**buff));
-    if(!*buff) serror("cy_buff_read(-> malloc <-)");
-    while (total < fullsize)
+    while (total < size)
     {
-        ssize_t n = recv(__fd, *buff + total, fullsize - total, 0);
+        ssize_t n = recv(__fd, buff + total, size - total, 0);
         if(n == 0) serror("cy_buff_recv(-> recv <-)");
         if(n < 0) serror("cy_buff_recv(-> recv <-)");
+        if(crc) *crc = cy_crc32c(*crc, buff + total, (size_t)n);
         total +=n;
-        if(total == 16)
+    }
+}
+
+void cy_buff_pwrite_all(int __fd, const uint8_t *buff, const size_t size, const off_t off)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        ssize_t n = pwrite(__fd, buff + total, size - total, off + (off_t)total);
+        if(n <= 0) serror("cy_buff_pwrite(-> pwrite <-)");
+        total +=n;
+    }
+}
+
+int cy_hex_digit(const char c)
+{
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// 0 when all of s is hex and fits max bytes
+int cy_hex_imp(const char *s, uint8_t *out, const size_t max, size_t *len)
+{
+    size_t n = strlen(s);
+    if(n % 2 || !n || n / 2 > max) return -1;
+    for (size_t i = 0; i < n; i += 2)
+    {
+        int hi = cy_hex_digit(s[i]), lo = cy_hex_digit(s[i + 1]);
+        if(hi < 0 || lo < 0) return -1;
+        out[i / 2] = (uint8_t)(hi << 4 | lo);
+    }
+    *len = n / 2;
+    return 0;
+}
+
+// client -H names
+static const struct {const char *name; CY_HASH_TYPE type;} cy_hash_names[] =
+{
+    {"sha256", CY_HASH_SHA256}, {"blake3", CY_HASH_BLAKE3}, {"sha3-256", CY_HASH_SHA3_256},
+    {"sha3-512", CY_HASH_SHA3_512}, {"shake128", CY_HASH_SHAKE128}, {"shake256", CY_HASH_SHAKE256}
+};
+
+// -R <root> anywhere after the port, 0 when absent, -1 when it is not a hash
+int cy_server_pin(int argc, char *argv[])
+{
+    for (int i = 3; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-R")) continue;
+        if(i + 1 == argc || cy_hex_imp(argv[i + 1], cy_pin, sizeof(cy_pin), &cy_pin_len) < 0)
+        {fprintf(stderr, "main(-> -R takes the merkle root in hex <-)\n"); return -1;}
+    }
+    return 0;
+}
+
+// the root has to match the leaf list, then the pinned root when there is one
+int cy_merkle_check(const char *who, const CY_HASH_TYPE type, const uint8_t *leaves, const size_t count, const size_t hsize)
+{
+    uint8_t root[64];
+    if(cy_merkle_root(type, leaves + hsize, count, root) != CY_OK || memcmp(root, leaves, hsize))
+    {fprintf(stderr, "%s(-> merkle root mismatch <-)\n", who); return -1;}
+    if(cy_pin_len && (cy_pin_len != hsize || memcmp(cy_pin, root, hsize)))
+    {fprintf(stderr, "%s(-> merkle root is not the pinned one <-)\n", who); return -1;}
+    return 0;
+}
+
+int cy_merkle_leaf_ok(const CY_HASH_TYPE type, const uint8_t *in, const size_t len, const uint8_t *expect, const size_t hsize)
+{
+    uint8_t h[64];
+    return cy_merkle_leaf(type, in, len, h) == CY_OK && !memcmp(h, expect, hsize);
+}
+
+/*
+ * Merkle preamble: leaf size (8 bytes), root, then one hash per leaf. The
+ * leaves are hashed on every core and the root lets the receiver trust the
+ * leaf list before any payload arrives, as far as it trusts the root: a
+ * receiver pins it with -R, the client prints it on stderr.
+ */
+uint8_t *cy_buff_merkle_exp(const struct CY_HEADER head, const uint8_t *data, const size_t leaf, size_t *size)
+{
+    size_t hsize, count = head.cy_data_len ? (head.cy_data_len + leaf - 1) / leaf : 1;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if(cy_hash_size(head.cy_hash_type, &hsize) != CY_OK) return NULL;
+    uint8_t *pre = malloc(8 + (count + 1) * hsize);
+    if(!pre) serror("cy_buff_merkle_exp(-> malloc <-)");
+    cy_buff_size_exp(leaf, pre);
+    if(cy_merkle_leaves(head.cy_hash_type, data, head.cy_data_len, leaf, ncpu > 0 ? (size_t)ncpu : 1, pre + 8 + hsize) != CY_OK ||
+       cy_merkle_root(head.cy_hash_type, pre + 8 + hsize, count, pre + 8) != CY_OK) {free(pre); return NULL;}
+    *size = 8 + (count + 1) * hsize;
+    fprintf(stderr, "merkle root ");
+    for (size_t i = 0; i < hsize; i++) fprintf(stderr, "%02x", pre[8 + i]);
+    fprintf(stderr, "\n");
+    return pre;
+}
+
+void cy_buff_send(int __fd, const struct CY_HEADER head, uint8_t *buff, const size_t leaf)
+{
+    cy_buff_header_exp(head, buff);
+    if(!(head.cy_hash_flag & CY_HASH_FLAG_MERKLE)) cy_buff_send_all(__fd, buff, head.cy_data_len + 16);
+    else
+    {
+        size_t size;
+        uint8_t *pre = cy_buff_merkle_exp(head, buff + 16, leaf, &size);
+        if(!pre) {fprintf(stderr, "cy_buff_send(-> merkle tree <-)\n"); exit(1);}
+        cy_buff_send_all(__fd, buff, 16);
+        cy_buff_send_all(__fd, pre, size);
+        if(!(head.cy_hash_flag & CY_HASH_FLAG_RESUME)) cy_buff_send_all(__fd, buff + 16, head.cy_data_len);
+        else
         {
-            cy_buff_header_imp(*buff, head);
-            fullsize = head->cy_data_len + total;
+            // the receiver diffed the leaf list against what it holds, only its misses go out
+            size_t hsize, count;
+            cy_hash_size(head.cy_hash_type, &hsize);
+            count = (size - 8) / hsize - 1;
+            uint8_t *need = malloc((count + 7) / 8);
+            if(!need) serror("cy_buff_send(-> malloc <-)");
+            cy_buff_recv_all(__fd, need, (count + 7) / 8, NULL);
+            size_t sent = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                if(!(need[i / 8] >> (i % 8) & 1)) continue;
+                size_t off = i * leaf, n = head.cy_data_len - off < leaf ? head.cy_data_len - off : leaf;
+                cy_buff_send_all(__fd, buff + 16 + off, n);
+                sent++;
+            }
+            fprintf(stderr, "resumed, %zu of %zu leaves sent\n", sent, count);
+            free(need);
         }
+        free(pre);
     }
+    if(head.cy_hash_flag & CY_HASH_FLAG_CRC32C)
+    {
+        // the payload CRC is already taken, the header is folded in last
+        const uint32_t crc = cy_crc32c(head.cy_crc, buff, 16);
+        uint8_t trailer[4] = {(uint8_t)(crc >> 24), (uint8_t)(crc >> 16), (uint8_t)(crc >> 8), (uint8_t)crc};
+        cy_buff_send_all(__fd, trailer, 4);
+    }
+}
+
+/*
+ * Payload arrives one leaf at a time and each leaf is checked before the
+ * next is read. With a file, every checked leaf is written to it at once,
+ * so after a broken transfer the file holds what did arrive. On a resume
+ * the leaves already in the file are hashed first and the sender is told,
+ * one bit per leaf, which ones it still has to send.
+ */
+void cy_buff_recv_merkle(int __fd, struct CY_HEADER *head, uint8_t *data, const int file)
+{
+    uint32_t *crc = head->cy_hash_flag & CY_HASH_FLAG_CRC32C ? &head->cy_crc : NULL;
+    uint8_t lbuff[8];
+    size_t leaf, hsize;
+    cy_buff_recv_all(__fd, lbuff, 8, NULL);
+    cy_buff_size_imp(lbuff, &leaf);
+    if(cy_hash_size(head->cy_hash_type, &hsize) != CY_OK || leaf < CY_MERKLE_MIN_LEAF)
+    {fprintf(stderr, "cy_buff_recv(-> bad merkle preamble <-)\n"); exit(1);}
+    size_t count = head->cy_data_len ? (head->cy_data_len - 1) / leaf + 1 : 1;
+    if(count >= SIZE_MAX / hsize) {fprintf(stderr, "cy_buff_recv(-> bad merkle preamble <-)\n"); exit(1);}
+    uint8_t *leaves = malloc((count + 1) * hsize);
+    if(!leaves) serror("cy_buff_recv(-> malloc <-)");
+    cy_buff_recv_all(__fd, leaves, (count + 1) * hsize, NULL);
+    if(cy_merkle_check("cy_buff_recv", head->cy_hash_type, leaves, count, hsize) < 0) exit(1);
+
+    uint8_t *need = NULL;
+    if(head->cy_hash_flag & CY_HASH_FLAG_RESUME)
+    {
+        size_t kept = 0;
+        need = malloc((count + 7) / 8);
+        if(!need) serror("cy_buff_recv(-> malloc <-)");
+        memset(need, 0xFF, (count + 7) / 8);
+        for (size_t i = 0; file >= 0 && i < count; i++)
+        {
+            size_t off = i * leaf, n = head->cy_data_len - off < leaf ? head->cy_data_len - off : leaf;
+            if(pread(file, data + off, n, (off_t)off) != (ssize_t)n) break;
+            if(cy_merkle_leaf_ok(head->cy_hash_type, data + off, n, leaves + (i + 1) * hsize, hsize)) {need[i / 8] &= (uint8_t)~(1u << (i % 8)); kept++;}
+        }
+        cy_buff_send_all(__fd, need, (count + 7) / 8);
+        fprintf(stderr, "resuming, %zu of %zu leaves already here\n", kept, count);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t off = i * leaf, n = head->cy_data_len - off < leaf ? head->cy_data_len - off : leaf;
+        if(need && !(need[i / 8] >> (i % 8) & 1)) {if(crc) *crc = cy_crc32c(*crc, data + off, n); continue;}
+        cy_buff_recv_all(__fd, data + off, n, crc);
+        if(!cy_merkle_leaf_ok(head->cy_hash_type, data + off, n, leaves + (i + 1) * hsize, hsize))
+        {fprintf(stderr, "cy_buff_recv(-> leaf %zu corrupted <-)\n", i); exit(1);}
+        if(file >= 0) cy_buff_pwrite_all(file, data + off, n, (off_t)off);
+    }
+    free(need);
+    free(leaves);
 }
 
-void cy_buff_read(int __fd, struct CY_HEADER *head, uint8_t **buff)
+// file, when not -1, takes merkle leaves as they are checked and serves resumes
+void cy_buff_recv(int __fd, struct CY_HEADER *head, uint8_t **buff, const int file)
+{
+    uint8_t hbuff[16];
+    memset(head, 0, sizeof(*head));
+    cy_buff_recv_all(__fd, hbuff, 16, NULL);
+    cy_buff_header_imp(hbuff, head);
+    // sized from the header, the payload used to land in a fixed CY_BUFFSIZE block
+    if(head->cy_data_len > CY_MAX_MSG) {fprintf(stderr, "cy_buff_recv(-> message too large <-)\n"); exit(1);}
+    *buff = malloc((head->cy_data_len + 16) * sizeof(**buff));
+    if(!*buff) serror("cy_buff_recv(-> malloc <-)");
+    memcpy(*buff, hbuff, 16);
+    if((head->cy_hash_flag & CY_HASH_FLAG_RESUME) && !(head->cy_hash_flag & CY_HASH_FLAG_MERKLE))
+    {fprintf(stderr, "cy_buff_recv(-> resume without a merkle tree <-)\n"); exit(1);}
+    if(head->cy_hash_flag & CY_HASH_FLAG_MERKLE) cy_buff_recv_merkle(__fd, head, *buff + 16, file);
+    else cy_buff_recv_all(__fd, *buff + 16, head->cy_data_len, head->cy_hash_flag & CY_HASH_FLAG_CRC32C ? &head->cy_crc : NULL);
+    if(head->cy_hash_flag & CY_HASH_FLAG_CRC32C)
+    {
+        uint8_t trailer[4];
+        cy_buff_recv_all(__fd, trailer, 4, NULL);
+        head->cy_crc = cy_crc32c(head->cy_crc, hbuff, 16);
+        uint32_t crc = (uint32_t)trailer[0] << 24 | (uint32_t)trailer[1] << 16 | (uint32_t)trailer[2] << 8 | trailer[3];
+        if(crc != head->cy_crc) {fprintf(stderr, "cy_buff_recv(-> crc32c mismatch <-)\n"); exit(1);}
+    }
+}
+
+// crc set takes the payload's CRC32C on the way in, for -c
+void cy_buff_read(int __fd, struct CY_HEADER *head, uint8_t **buff, const int crc)
 {
     size_t buffsize = CY_BUFFSIZE;
     memset(head, 0, sizeof(*head));
@@ -130,6 +372,9 @@ void cy_buff_read(int __fd, struct CY_HEADER *head, uint8_t **buff)
         ssize_t n = read(__fd, *buff + head->cy_data_len + 16, CY_BUFFSIZE - 16);
         if(n == 0) return;
         if(n < 0) serror("cy_buff_read(-> read <-)");
+        if(head->cy_data_len + (size_t)n > CY_MAX_MSG) {fprintf(stderr, "cy_buff_read(-> input larger than a message <-)\n"); exit(1);}
+        // same pass as the copy in, the bytes are still in cache
+        if(crc) head->cy_crc = cy_crc32c(head->cy_crc, *buff + head->cy_data_len + 16, (size_t)n);
         head->cy_data_len += n;
     }
 }
@@ -147,6 +392,487 @@ void cy_buff_write(int __fd, const struct CY_HEADER head, const uint8_t *buff)
     }
 }
 
+/*
+ * Event loop server: every connection is a small state machine fed by
+ * non-blocking reads, so a slow sender only ever holds its own state.
+ */
+enum CY_CONN_STATE {CY_CONN_HEAD, CY_CONN_LEAF, CY_CONN_PRE, CY_CONN_BODY, CY_CONN_TRAIL};
+
+// a finished payload on its way to stdout behind its frame, then back to its worker's pool
+struct CY_OUT_MSG
+{
+    struct CY_OUT_MSG *next;
+    uint8_t frame[CY_FRAME_SIZE];
+    uint8_t *buff;
+    size_t len, cap;
+};
+
+/*
+ * One per event loop. Nothing on the read path is shared: each worker owns
+ * its listener, its epoll set, its leaf hash state and a pool of payload
+ * buffers that connections borrow from and hand back once a message has
+ * been written out. stdout is the one thing all workers feed, and only the
+ * writer thread touches it. Finished messages wait in the worker's own
+ * output queue under a lock it shares with the writer alone, so a slow
+ * stdout never holds up the loop; written buffers come back on the done
+ * list. Every message goes out behind a CY_FRAME_SIZE frame with its
+ * connection's id, ids step by the worker count from the worker's index so
+ * no two workers hand out the same one, and a reader splits the stream
+ * back per client. Past CY_OUT_MAX queued bytes the loop takes
+ * EPOLLIN off each connection it hears from and parks it on the held list,
+ * the writer's wake eventfd brings it back to re-arm them once the queue
+ * has drained to half.
+ */
+struct CY_WORKER
+{
+    pthread_t tid;
+    const char *port;
+    int sd;
+    size_t npool, pool_bytes;
+    struct {uint8_t *buff; size_t cap;} pool[CY_POOL_SLOTS];
+    CY_HASH_CTX leaf_seed;                  // leaf prefix absorbed once, copied for every leaf check
+    int leaf_type;                          // hash type of leaf_seed, -1 before the first one
+    struct CY_CONN *first, *last;           // connections by last activity, oldest first
+    struct CY_CONN *held;                   // connections without EPOLLIN until stdout catches up
+    uint64_t next_id, id_step;              // client ids for the stdout frames
+    int wake;                               // eventfd the writer bumps after each batch
+    pthread_mutex_t out_lock;               // shared with the writer only
+    struct CY_OUT_MSG *out_head, *out_tail, *out_done;
+    size_t out_bytes;
+};
+
+// the one stdout writer, draining every worker's queue in turn
+static struct
+{
+    sem_t ready;                            // one post per queued message
+    struct CY_WORKER *w;
+    size_t n;
+} cy_out;
+
+struct CY_CONN
+{
+    int fd;
+    uint64_t id;            // in every frame this connection writes
+    struct CY_WORKER *w;
+    enum CY_CONN_STATE state;
+    struct CY_HEADER head;
+    uint8_t part[16];       // header, merkle leaf size or trailer bytes
+    uint8_t *dst;           // where the current part lands
+    size_t have, need;      // bytes of the current part
+    uint8_t *data;          // payload
+    uint8_t *leaves;        // merkle root then leaf hashes
+    size_t dcap, lcap;      // pool capacities of data and leaves
+    size_t leaf, hsize, count, checked;
+    struct CY_CONN *prev, *next;            // worker's activity list, or its held list
+    int held;
+    time_t seen;
+};
+
+// smallest pooled buffer that fits, or a fresh one
+uint8_t *cy_pool_get(struct CY_WORKER *w, const size_t size, size_t *cap)
+{
+    size_t best = w->npool;
+    for (size_t i = 0; i < w->npool; i++)
+        if(w->pool[i].cap >= size && (best == w->npool || w->pool[i].cap < w->pool[best].cap)) best = i;
+    if(best == w->npool) {*cap = size ? size : 1; return malloc(*cap);}
+    uint8_t *buff = w->pool[best].buff;
+    *cap = w->pool[best].cap;
+    w->pool_bytes -= *cap;
+    w->pool[best] = w->pool[--w->npool];
+    return buff;
+}
+
+void cy_pool_put(struct CY_WORKER *w, uint8_t *buff, const size_t cap)
+{
+    if(!buff) return;
+    if(w->npool == CY_POOL_SLOTS || cap > CY_POOL_MAX || w->pool_bytes + cap > CY_POOL_BYTES) {free(buff); return;}
+    w->pool[w->npool].buff = buff; w->pool[w->npool].cap = cap; w->npool++;
+    w->pool_bytes += cap;
+}
+
+// writes a whole batch, picking up after short writes
+void cy_out_writev(struct iovec *iov, int n)
+{
+    while (n)
+    {
+        ssize_t k = writev(STDOUT_FILENO, iov, n);
+        if(k <= 0) serror("cy_out_writev(-> writev <-)");
+        for (; n && (size_t)k >= iov->iov_len; iov++, n--) k -= (ssize_t)iov->iov_len;
+        if(n) {iov->iov_base = (uint8_t *)iov->iov_base + k; iov->iov_len -= (size_t)k;}
+    }
+}
+
+/*
+ * Takes a worker's whole queue at once and writes it with one writev, so
+ * messages never interleave on stdout and no lock is held while writing.
+ */
+void *cy_out_writer(void *arg)
+{
+    (void)arg;
+    struct iovec iov[64];
+    for (size_t rr = 0;; rr = (rr + 1) % cy_out.n)
+    {
+        while (sem_wait(&cy_out.ready) < 0) if(errno != EINTR) serror("cy_out_writer(-> sem_wait <-)");
+        sem_post(&cy_out.ready);        // only a wake-up, the counts are taken below
+        struct CY_WORKER *w = NULL;
+        struct CY_OUT_MSG *batch = NULL;
+        for (size_t i = 0; i < cy_out.n && !batch; i++)
+        {
+            w = &cy_out.w[(rr + i) % cy_out.n];
+            pthread_mutex_lock(&w->out_lock);
+            batch = w->out_head; w->out_head = w->out_tail = NULL;
+            pthread_mutex_unlock(&w->out_lock);
+        }
+        if(!batch) continue;
+
+        size_t bytes = 0, count = 0;
+        struct CY_OUT_MSG *m = batch, *tail = batch;
+        while (m)
+        {
+            int n = 0;
+            for (; m && n < 64; tail = m, m = m->next, n += 2)
+            {
+                iov[n].iov_base = m->frame; iov[n].iov_len = CY_FRAME_SIZE;
+                iov[n + 1].iov_base = m->buff; iov[n + 1].iov_len = m->len;
+                bytes += m->len; count++;
+            }
+            cy_out_writev(iov, n);
+        }
+        for (size_t i = 0; i < count; i++) while (sem_wait(&cy_out.ready) < 0 && errno == EINTR);
+
+        pthread_mutex_lock(&w->out_lock);
+        w->out_bytes -= bytes;
+        tail->next = w->out_done; w->out_done = batch;
+        pthread_mutex_unlock(&w->out_lock);
+        const uint64_t one = 1;
+        if(write(w->wake, &one, sizeof(one)) < 0 && errno != EAGAIN) serror("cy_out_writer(-> write <-)");
+    }
+    return NULL;
+}
+
+void cy_out_start(struct CY_WORKER *w, const size_t n)
+{
+    pthread_t tid;
+    cy_out.w = w; cy_out.n = n;
+    if(sem_init(&cy_out.ready, 0, 0) < 0) serror("cy_out_start(-> sem_init <-)");
+    for (size_t i = 0; i < n; i++)
+    {
+        w[i].leaf_type = -1;
+        w[i].next_id = i; w[i].id_step = n;
+        if(pthread_mutex_init(&w[i].out_lock, NULL) != 0) serror("cy_out_start(-> pthread <-)");
+        if((w[i].wake = eventfd(0, EFD_NONBLOCK)) < 0) serror("cy_out_start(-> eventfd <-)");
+    }
+    if(pthread_create(&tid, NULL, cy_out_writer, NULL) != 0) serror("cy_out_start(-> pthread_create <-)");
+    pthread_detach(tid);
+}
+
+// written buffers go back to the pool, from the loop's own thread
+void cy_out_reclaim(struct CY_WORKER *w)
+{
+    pthread_mutex_lock(&w->out_lock);
+    struct CY_OUT_MSG *m = w->out_done;
+    w->out_done = NULL;
+    pthread_mutex_unlock(&w->out_lock);
+    while (m)
+    {
+        struct CY_OUT_MSG *next = m->next;
+        cy_pool_put(w, m->buff, m->cap);
+        free(m); m = next;
+    }
+}
+
+// hands a finished payload to the writer, never waits, the loop holds back reads instead
+int cy_out_push(struct CY_WORKER *w, const uint64_t id, uint8_t *buff, const size_t len, const size_t cap)
+{
+    struct CY_OUT_MSG *m = malloc(sizeof(*m));
+    if(!m) {perror("cy_out_push(-> malloc <-)"); return -1;}
+    m->next = NULL; m->buff = buff; m->len = len; m->cap = cap;
+    cy_buff_size_exp(id, m->frame); cy_buff_size_exp(len, m->frame + 8);
+    pthread_mutex_lock(&w->out_lock);
+    if(w->out_tail) w->out_tail->next = m; else w->out_head = m;
+    w->out_tail = m;
+    w->out_bytes += len;
+    pthread_mutex_unlock(&w->out_lock);
+    sem_post(&cy_out.ready);
+    cy_out_reclaim(w);
+    return 0;
+}
+
+size_t cy_out_queued(struct CY_WORKER *w)
+{
+    pthread_mutex_lock(&w->out_lock);
+    size_t bytes = w->out_bytes;
+    pthread_mutex_unlock(&w->out_lock);
+    return bytes;
+}
+
+// with reuseport every worker binds its own socket and the kernel spreads accepts
+int cy_server_listen(const char *port, const int reuseport)
+{
+    struct addrinfo hints, *info = NULL;
+    int on = 1;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET; hints.ai_socktype = SOCK_STREAM; hints.ai_flags = AI_PASSIVE;
+    int rc = getaddrinfo(NULL, port, &hints, &info);
+    if(rc != 0) {fprintf(stderr, "cy_server_listen(-> getaddrinfo: %s <-)\n", gai_strerror(rc)); return -1;}
+    int sd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if(sd < 0) {freeaddrinfo(info); return -1;}
+    setsockopt(sd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if(reuseport && setsockopt(sd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) {close(sd); freeaddrinfo(info); return -1;}
+    if(bind(sd, info->ai_addr, info->ai_addrlen) < 0 || listen(sd, SOMAXCONN) < 0 ||
+       fcntl(sd, F_SETFL, fcntl(sd, F_GETFL, 0) | O_NONBLOCK) < 0) {close(sd); sd = -1;}
+    freeaddrinfo(info);
+    return sd;
+}
+
+void cy_conn_part(struct CY_CONN *c, const enum CY_CONN_STATE state, uint8_t *dst, const size_t need)
+{
+    c->state = state; c->dst = dst; c->have = 0; c->need = need;
+}
+
+void cy_conn_reset(struct CY_CONN *c)
+{
+    cy_pool_put(c->w, c->data, c->dcap); cy_pool_put(c->w, c->leaves, c->lcap);
+    c->data = NULL; c->leaves = NULL; c->checked = 0;
+    cy_conn_part(c, CY_CONN_HEAD, c->part, 16);
+}
+
+time_t cy_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+void cy_conn_unlink(struct CY_CONN *c)
+{
+    if(c->prev) c->prev->next = c->next; else if(c->held) c->w->held = c->next; else c->w->first = c->next;
+    if(c->next) c->next->prev = c->prev; else if(!c->held) c->w->last = c->prev;
+    c->prev = c->next = NULL;
+}
+
+// most recently active goes last, so idle connections gather at the front
+void cy_conn_touch(struct CY_CONN *c)
+{
+    if(c->prev || c->w->first == c) cy_conn_unlink(c);
+    c->seen = cy_now();
+    c->prev = c->w->last;
+    if(c->w->last) c->w->last->next = c; else c->w->first = c;
+    c->w->last = c;
+}
+
+// off the activity list too, a held connection is not idle, stdout is slow
+void cy_conn_hold(int ep, struct CY_CONN *c)
+{
+    struct epoll_event ev = {.events = 0, .data.ptr = c};
+    cy_conn_unlink(c);
+    c->held = 1;
+    c->next = c->w->held;
+    if(c->next) c->next->prev = c;
+    c->w->held = c;
+    epoll_ctl(ep, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+void cy_conn_release(int ep, struct CY_WORKER *w)
+{
+    struct epoll_event ev = {.events = EPOLLIN | EPOLLRDHUP};
+    while (w->held)
+    {
+        struct CY_CONN *c = w->held;
+        cy_conn_unlink(c);
+        c->held = 0;
+        ev.data.ptr = c;
+        epoll_ctl(ep, EPOLL_CTL_MOD, c->fd, &ev);
+        cy_conn_touch(c);
+    }
+}
+
+void cy_conn_close(int ep, struct CY_CONN *c)
+{
+    cy_conn_unlink(c);
+    epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    cy_pool_put(c->w, c->data, c->dcap); cy_pool_put(c->w, c->leaves, c->lcap); free(c);
+}
+
+// same hash as cy_merkle_leaf, started from the worker's seeded state
+CY_STATE_FLAG cy_conn_leaf(struct CY_WORKER *w, const CY_HASH_TYPE type, const uint8_t *in, const size_t len, uint8_t *out)
+{
+    static const uint8_t tag = 0x00;
+    if(w->leaf_type != (int)type)
+    {
+        if(cy_hash_init(&w->leaf_seed, type) != CY_OK) return CY_ERR;
+        cy_hash_update(&w->leaf_seed, &tag, 1);
+        w->leaf_type = (int)type;
+    }
+    CY_HASH_CTX ctx = w->leaf_seed;
+    cy_hash_update(&ctx, in, len);
+    return cy_hash_final(&ctx, out);
+}
+
+// -1 on a protocol error, the caller then drops the connection
+int cy_conn_body(struct CY_CONN *c, const size_t from)
+{
+    if(c->head.cy_hash_flag & CY_HASH_FLAG_CRC32C) c->head.cy_crc = cy_crc32c(c->head.cy_crc, c->data + from, c->have - from);
+    if(c->head.cy_hash_flag & CY_HASH_FLAG_MERKLE)
+        for (; c->checked < c->count && (c->have == c->need || (c->checked + 1) * c->leaf <= c->have); c->checked++)
+        {
+            uint8_t h[64];
+            size_t off = c->checked * c->leaf, n = c->need - off < c->leaf ? c->need - off : c->leaf;
+            if(cy_conn_leaf(c->w, c->head.cy_hash_type, c->data + off, n, h) != CY_OK || memcmp(h, c->leaves + (c->checked + 1) * c->hsize, c->hsize))
+            {fprintf(stderr, "cy_conn(-> leaf %zu corrupted <-)\n", c->checked); return -1;}
+        }
+    return 0;
+}
+
+// moves to the next part once the current one is complete
+int cy_conn_next(struct CY_CONN *c)
+{
+    switch (c->state)
+    {
+        case CY_CONN_HEAD:
+            memset(&c->head, 0, sizeof(c->head));
+            cy_buff_header_imp(c->part, &c->head);
+            if(c->head.cy_data_len > CY_MAX_MSG) {fprintf(stderr, "cy_conn(-> message too large <-)\n"); return -1;}
+            // the event loops keep nothing between connections to resume from
+            if(c->head.cy_hash_flag & CY_HASH_FLAG_RESUME) {fprintf(stderr, "cy_conn(-> resume needs the -sp receiver with a file <-)\n"); return -1;}
+            c->data = cy_pool_get(c->w, c->head.cy_data_len, &c->dcap);
+            if(!c->data) {perror("cy_conn(-> malloc <-)"); return -1;}
+            if(c->head.cy_hash_flag & CY_HASH_FLAG_MERKLE) cy_conn_part(c, CY_CONN_LEAF, c->part, 8);
+            else cy_conn_part(c, CY_CONN_BODY, c->data, c->head.cy_data_len);
+            return 0;
+        case CY_CONN_LEAF:
+            cy_buff_size_imp(c->part, &c->leaf);
+            if(cy_hash_size(c->head.cy_hash_type, &c->hsize) != CY_OK || c->leaf < CY_MERKLE_MIN_LEAF)
+            {fprintf(stderr, "cy_conn(-> bad merkle preamble <-)\n"); return -1;}
+            c->count = c->head.cy_data_len ? (c->head.cy_data_len - 1) / c->leaf + 1 : 1;
+            if(c->count >= SIZE_MAX / c->hsize) {fprintf(stderr, "cy_conn(-> bad merkle preamble <-)\n"); return -1;}
+            c->leaves = cy_pool_get(c->w, (c->count + 1) * c->hsize, &c->lcap);
+            if(!c->leaves) {perror("cy_conn(-> malloc <-)"); return -1;}
+            cy_conn_part(c, CY_CONN_PRE, c->leaves, (c->count + 1) * c->hsize);
+            return 0;
+        case CY_CONN_PRE:
+            if(cy_merkle_check("cy_conn", c->head.cy_hash_type, c->leaves, c->count, c->hsize) < 0) return -1;
+            cy_conn_part(c, CY_CONN_BODY, c->data, c->head.cy_data_len);
+            return cy_conn_body(c, 0);
+        case CY_CONN_BODY:
+            if(c->head.cy_hash_flag & CY_HASH_FLAG_CRC32C)
+            {
+                // part no longer holds the header, its 16 bytes are rebuilt for the CRC
+                uint8_t hbuff[16];
+                cy_buff_header_exp(c->head, hbuff);
+                c->head.cy_crc = cy_crc32c(c->head.cy_crc, hbuff, 16);
+                cy_conn_part(c, CY_CONN_TRAIL, c->part, 4);
+                return 0;
+            }
+            break;
+        case CY_CONN_TRAIL:
+        {
+            uint32_t crc = (uint32_t)c->part[0] << 24 | (uint32_t)c->part[1] << 16 | (uint32_t)c->part[2] << 8 | c->part[3];
+            if(crc != c->head.cy_crc) {fprintf(stderr, "cy_conn(-> crc32c mismatch <-)\n"); return -1;}
+            break;
+        }
+    }
+    if(cy_out_push(c->w, c->id, c->data, c->head.cy_data_len, c->dcap) < 0) return -1;
+    c->data = NULL;
+    cy_conn_reset(c);
+    return 0;
+}
+
+/*
+ * Reads what is available up to a budget, so one fast sender cannot starve
+ * the rest of the loop. -1 when the connection is done with.
+ */
+int cy_conn_read(struct CY_CONN *c)
+{
+    size_t budget = 1 << 18;
+    while (budget)
+    {
+        if(c->have == c->need) {if(cy_conn_next(c) < 0) return -1; continue;}
+        size_t want = c->need - c->have < budget ? c->need - c->have : budget;
+        ssize_t n = recv(c->fd, c->dst + c->have, want, 0);
+        if(n == 0)
+        {
+            // a clean close falls between two messages
+            if(c->state != CY_CONN_HEAD || c->have) fprintf(stderr, "cy_conn(-> truncated message <-)\n");
+            return -1;
+        }
+        if(n < 0)
+        {
+            if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return 0;
+            perror("cy_conn(-> recv <-)");
+            return -1;
+        }
+        size_t from = c->have;
+        c->have += (size_t)n; budget -= (size_t)n;
+        if(c->state == CY_CONN_BODY && cy_conn_body(c, from) < 0) return -1;
+    }
+    return 0;
+}
+
+void cy_server_loop(struct CY_WORKER *w)
+{
+    int sd = w->sd;
+    struct epoll_event ev, events[256];
+    int ep = epoll_create1(0);
+    if(ep < 0) serror("cy_server_loop(-> epoll_create1 <-)");
+    ev.events = EPOLLIN; ev.data.ptr = NULL;
+    if(epoll_ctl(ep, EPOLL_CTL_ADD, sd, &ev) < 0) serror("cy_server_loop(-> epoll_ctl <-)");
+    ev.events = EPOLLIN; ev.data.ptr = w;
+    if(epoll_ctl(ep, EPOLL_CTL_ADD, w->wake, &ev) < 0) serror("cy_server_loop(-> epoll_ctl <-)");
+    while (1)
+    {
+        // wakes at least once a second to drop connections gone quiet
+        int n = epoll_wait(ep, events, 256, 1000);
+        if(n < 0) {if(errno == EINTR) continue; serror("cy_server_loop(-> epoll_wait <-)");}
+        for (int i = 0; i < n; i++)
+        {
+            if(events[i].data.ptr == w) {uint64_t k; while (read(w->wake, &k, sizeof(k)) > 0); continue;}
+            struct CY_CONN *c = events[i].data.ptr;
+            if(c && c->held)
+            {
+                // without EPOLLIN only an error or a hangup gets here
+                if(events[i].events & (EPOLLERR | EPOLLHUP)) cy_conn_close(ep, c);
+                continue;
+            }
+            if(c && cy_out_queued(w) >= CY_OUT_MAX) {cy_conn_hold(ep, c); continue;}
+            if(c) {cy_conn_touch(c); if(cy_conn_read(c) < 0) cy_conn_close(ep, c); continue;}
+            for (int fd; (fd = accept(sd, NULL, NULL)) >= 0;)
+            {
+                c = calloc(1, sizeof(*c));
+                if(!c || fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0) {free(c); close(fd); continue;}
+                c->fd = fd; c->w = w;
+                c->id = w->next_id; w->next_id += w->id_step;
+                cy_conn_reset(c);
+                ev.events = EPOLLIN | EPOLLRDHUP; ev.data.ptr = c;
+                if(epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev) < 0) {close(fd); free(c); continue;}
+                cy_conn_touch(c);
+            }
+        }
+        for (time_t now = cy_now(); w->first && now - w->first->seen >= CY_CONN_IDLE;)
+        {
+            fprintf(stderr, "cy_conn(-> idle for %ds, dropped <-)\n", CY_CONN_IDLE);
+            cy_conn_close(ep, w->first);
+        }
+        cy_out_reclaim(w);
+        if(w->held && cy_out_queued(w) <= CY_OUT_MAX / 2) cy_conn_release(ep, w);
+    }
+}
+
+void *cy_server_worker(void *arg)
+{
+    struct CY_WORKER *w = arg;
+    cy_server_loop(w);
+    return NULL;
+}
+
+// 10k+ sockets need more than the usual 1024 descriptors
+void cy_server_nofile(void)
+{
+    struct rlimit rl;
+    if(getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {rl.rlim_cur = rl.rlim_max; setrlimit(RLIMIT_NOFILE, &rl);}
+}
+
 void serror(const char *fmt)
 {
     perror(fmt);
@@ -164,8 +890,11 @@ void print_u128_hex(__uint128_t x) {
 int main(int argc, char *argv[])
 {
     if (argc < 3) {
-        fprintf(stderr, "Usage:\n  %s -sp <port>      (server)\n  %s <host> <port>   (client)\n",
-                argv[0], argv[0]);
+        fprintf(stderr, "Usage:\n  %s -sp <port> [<file>] [-R <root>]     (server, resumes into file)\n"
+                        "  %s -ep <port> [-R <root>]              (event loop server, framed stdout)\n"
+                        "  %s -mp <port> [<workers>] [-R <root>]  (one event loop per core, framed stdout)\n"
+                        "  %s <host> <port> [-m [<leaf KiB>]] [-H <hash>] [-r] [-c]  (client)\n",
+                argv[0], argv[0], argv[0], argv[0]);
         return 1;
     }
 
@@ -176,12 +905,60 @@ int main(int argc, char *argv[])
     hints.ai_family   = AF_INET;        // IPv4
     hints.ai_socktype = SOCK_STREAM;    // TCP
 
-    if (!strcmp(argv[1], "-sp")) {
+    if (argv[1][0] == '-' && cy_server_pin(argc, argv) < 0) return 1;
+
+    if (!strcmp(argv[1], "-ep")) {
+        // -------- EVENT LOOP SERVER MODE --------
+        struct CY_WORKER w = {.port = argv[2]};
+        cy_server_nofile();
+        if ((w.sd = cy_server_listen(argv[2], 0)) < 0) return 1;
+        fprintf(stderr, "listening ...\n");
+        cy_out_start(&w, 1);
+        cy_server_loop(&w);
+
+    } else if (!strcmp(argv[1], "-mp")) {
+        // -------- MULTI-CORE SERVER MODE --------
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        size_t nworkers = argc > 3 && argv[3][0] != '-' ? (size_t)strtoull(argv[3], NULL, 10) : ncpu > 0 ? (size_t)ncpu : 1;
+        if (!nworkers) nworkers = 1;
+        struct CY_WORKER *w = calloc(nworkers, sizeof(*w));
+        if (!w) serror("main(-> calloc <-)");
+        cy_server_nofile();
+        // all listeners are bound before any loop runs so no worker misses its share
+        for (size_t i = 0; i < nworkers; i++)
+        {
+            w[i].port = argv[2];
+            if ((w[i].sd = cy_server_listen(argv[2], 1)) < 0) serror("main(-> cy_server_listen <-)");
+        }
+        fprintf(stderr, "listening ... (%zu workers)\n", nworkers);
+        cy_out_start(w, nworkers);
+        // worker i stays on the i-th CPU this process may run on, keeping its pool and sockets warm
+        cpu_set_t allowed;
+        int ncpus = sched_getaffinity(0, sizeof(allowed), &allowed) == 0 ? CPU_COUNT(&allowed) : 0;
+        for (size_t i = 0; i < nworkers; i++)
+        {
+            pthread_attr_t attr;
+            pthread_attr_init(&attr);
+            if (ncpus > 0)
+            {
+                cpu_set_t one;
+                int k = (int)(i % (size_t)ncpus), cpu = 0;
+                for (; cpu < CPU_SETSIZE; cpu++) if (CPU_ISSET(cpu, &allowed) && k-- == 0) break;
+                CPU_ZERO(&one); CPU_SET(cpu, &one);
+                pthread_attr_setaffinity_np(&attr, sizeof(one), &one);
+            }
+            if (pthread_create(&w[i].tid, &attr, cy_server_worker, &w[i]) != 0) serror("main(-> pthread_create <-)");
+            pthread_attr_destroy(&attr);
+        }
+        for (size_t i = 0; i < nworkers; i++) pthread_join(w[i].tid, NULL);
+        free(w);
+
+    } else if (!strcmp(argv[1], "-sp")) {
         // -------- SERVER MODE --------
         hints.ai_flags = AI_PASSIVE;
 
-        if (getaddrinfo(NULL, argv[2], &hints, &servinfo) != 0)
-            return 1;  // forget detailed error handling
+        int rc = getaddrinfo(NULL, argv[2], &hints, &servinfo);
+        if (rc != 0) {fprintf(stderr, "main(-> getaddrinfo: %s <-)\n", gai_strerror(rc)); return 1;}
 
         int sd = socket(servinfo->ai_family, servinfo->ai_socktype, servinfo->ai_protocol);
         if (sd < 0) return 1;
@@ -198,9 +975,18 @@ int main(int argc, char *argv[])
             printf("Connection was unsuccessfull\n");
         else
             printf("Connection was successful\n");
+        // with a file the payload goes there instead of stdout, and a resume picks up from it
+        int file = argc > 3 && argv[3][0] != '-' ? open(argv[3], O_RDWR | O_CREAT, 0600) : -1;
+        if (argc > 3 && argv[3][0] != '-' && file < 0) serror("main(-> open <-)");
         struct CY_HEADER head; uint8_t *buff;
-        cy_buff_recv(new_fd, &head, &buff);
-        cy_buff_write(STDOUT_FILENO, head, buff + CY_HEADER_OFFSET);
+        cy_buff_recv(new_fd, &head, &buff, file);
+        if (file < 0) cy_buff_write(STDOUT_FILENO, head, buff + CY_HEADER_OFFSET);
+        else {
+            if (!(head.cy_hash_flag & CY_HASH_FLAG_MERKLE)) cy_buff_pwrite_all(file, buff + CY_HEADER_OFFSET, head.cy_data_len, 0);
+            if (ftruncate(file, (off_t)head.cy_data_len) < 0) serror("main(-> ftruncate <-)");
+            close(file);
+        }
+        free(buff);
 
         // clean up
         close(new_fd);
@@ -209,8 +995,8 @@ int main(int argc, char *argv[])
 
     } else {
         // -------- CLIENT MODE --------
-        if (getaddrinfo(argv[1], argv[2], &hints, &clientinfo) != 0)
-            return 1;
+        int rc = getaddrinfo(argv[1], argv[2], &hints, &clientinfo);
+        if (rc != 0) {fprintf(stderr, "main(-> getaddrinfo: %s <-)\n", gai_strerror(rc)); return 1;}
 
         int sd = socket(clientinfo->ai_family, clientinfo->ai_socktype, clientinfo->ai_protocol);
         if (sd < 0) return 1;
@@ -221,8 +1007,34 @@ int main(int argc, char *argv[])
             printf("Connected to server\n");
         struct CY_HEADER head;
         uint8_t *buff;
-        cy_buff_read(STDIN_FILENO, &head, &buff);
-        cy_buff_send(sd, head, buff);
+        size_t leaf = 0;
+        int crc = 0, resume = 0;
+        CY_HASH_TYPE type = CY_HASH_SHA256;
+        for (int i = 3; i < argc; i++) {
+            if (!strcmp(argv[i], "-c")) crc = 1;
+            else if (!strcmp(argv[i], "-r")) resume = 1;
+            else if (!strcmp(argv[i], "-m")) {
+                leaf = CY_MERKLE_LEAF;
+                if (i + 1 < argc && argv[i + 1][0] != '-') leaf = (size_t)strtoull(argv[++i], NULL, 10) * 1024;
+            }
+            else if (!strcmp(argv[i], "-H") && i + 1 < argc) {
+                size_t k = 0, n = sizeof(cy_hash_names) / sizeof(cy_hash_names[0]);
+                for (i++; k < n && strcmp(argv[i], cy_hash_names[k].name); k++);
+                if (k == n) {fprintf(stderr, "main(-> unknown hash %s <-)\n", argv[i]); return 1;}
+                type = cy_hash_names[k].type;
+            }
+        }
+        // a resume works on leaves, so it brings the tree along
+        if (resume && !leaf) leaf = CY_MERKLE_LEAF;
+        cy_buff_read(STDIN_FILENO, &head, &buff, crc);
+        if (leaf) {
+            if (leaf < CY_MERKLE_MIN_LEAF) leaf = CY_MERKLE_MIN_LEAF;
+            head.cy_hash_flag |= CY_HASH_FLAG_MERKLE;
+            head.cy_hash_type = type;
+        }
+        if (resume) head.cy_hash_flag |= CY_HASH_FLAG_RESUME;
+        if (crc) head.cy_hash_flag |= CY_HASH_FLAG_CRC32C;
+        cy_buff_send(sd, head, buff, leaf);
 
         close(sd);
         freeaddrinfo(clientinfo);
@@ -15,7 +15,13 @@
  */
 
 #include "cypher.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 
+#if defined(__x86_64__)
+  #include <immintrin.h>
+#endif
 
 
 
@@ -39,6 +45,10 @@
   #include <unistd.h>
   #include <fcntl.h>
   #include <errno.h>
+  #include <sys/resource.h>
+  #include <sys/stat.h>
+  #include <sys/mman.h>
+  #include <dirent.h>
 
   // If Linux with getrandom:
   #if defined(__linux__)
@@ -217,58 +227,64 @@ CY_STATE_FLAG random_u128_full(__uint128_t size, __uint128_t *out)
 
 
 
-static void gcd(mpz_srcptr a, mpz_srcptr b, mpz_ptr out)
+// a^-1 mod n from one extended gcd pass, GMP switches to Lehmer / half gcd on large operands
+static CY_STATE_FLAG EEA(mpz_srcptr a, mpz_srcptr n, mpz_ptr out)
 {
-    mpz_t tmpa, tmpb; mpz_inits(tmpa, tmpb, NULL);
-    mpz_set(tmpa, a); mpz_set(tmpb, b);
-
-    if(!mpz_cmp_ui(tmpa, 0)) {mpz_set(out, tmpb); return;}
-    if(!mpz_cmp_ui(tmpb, 0)) {mpz_set(out, tmpa); return;}
-
-    mpz_abs(tmpa, tmpa);
-    mpz_abs(tmpb, tmpb);
-
-    mpz_t r; mpz_init(r);
-    while (mpz_cmp_ui(tmpb, 0))
+    mpz_t g, x; mpz_inits(g, x, NULL);
+    mpz_gcdext(g, x, NULL, a, n);
+    if (mpz_cmp_ui(g, 1) != 0)
     {
-        mpz_mod(r, tmpa, tmpb);
-        mpz_swap(tmpa, tmpb);
-        mpz_swap(tmpb, r);
+        gmp_fprintf(stderr, "gcd(%Zd,%Zd) is different than 1\n", a, n);
+        mpz_clears(g, x, NULL); mpz_set_ui(out, 0); return CY_ERR;
     }
-    mpz_set(out, tmpa);
-    mpz_clears(tmpa, tmpb, r, NULL);
+    mpz_mod(out, x, n);
+    mpz_clears(g, x, NULL);
+    return CY_OK;
 }
 
-static CY_STATE_FLAG EEA(mpz_srcptr a, mpz_srcptr n, mpz_ptr out)
+/*
+ * Montgomery's trick: out[i] = a[i]^-1 mod n for all i with one inversion
+ * and 3(count - 1) multiplications. out may alias a. When the product is not
+ * a unit, falls back to one inversion per element, out[i] = 0 for the
+ * elements that have none, and returns CY_ERR_VALUE.
+ */
+CY_STATE_FLAG cy_mpz_inv_batch(const size_t count, const mpz_srcptr a[], mpz_srcptr n, mpz_ptr out[])
 {
-    gcd(a, n, out);
-    if (mpz_cmp_ui(out, 1) != 0)
-    {gmp_fprintf(stderr, "gcd(%Zd,%Zd) is different than 1\n", a, n); mpz_set_ui(out, 0); return CY_ERR;}
-
-    mpz_t tmpa, tmpn; mpz_inits(tmpa, tmpn, NULL);
-    mpz_set(tmpa, a); mpz_set(tmpn, n);
-
-    // __t represent t-2 and _t represent t-1
-    mpz_t __x, _x, mod, x, r; mpz_inits(__x, _x, x, mod, r, NULL);
-    mpz_set_ui(__x, 1); mpz_set_ui(_x, 0); mpz_set(mod, tmpn);
-
-    while (mpz_cmp_ui(tmpn, 0))
+    if(!count) return CY_OK;
+    if(!a || !out || !n || mpz_sgn(n) <= 0) return cy_state_manager(CY_ERR_ARG, __func__, ": bad arguments");
+
+    // c[i] = a[0] ... a[i] mod n
+    mpz_t *c = malloc(count * sizeof(c[0]));
+    if(!c) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    mpz_init(c[0]); mpz_mod(c[0], a[0], n);
+    for (size_t i = 1; i < count; i++) {mpz_init(c[i]); mpz_mul(c[i], c[i - 1], a[i]); mpz_mod(c[i], c[i], n);}
+
+    CY_STATE_FLAG st = CY_OK;
+    mpz_t inv, t; mpz_inits(inv, t, NULL);
+    if(mpz_invert(inv, c[count - 1], n))
+    {
+        for (size_t i = count - 1; i > 0; i--)
+        {
+            mpz_mul(t, inv, c[i - 1]); mpz_mod(t, t, n);
+            mpz_mul(inv, inv, a[i]); mpz_mod(inv, inv, n);
+            mpz_swap(out[i], t);
+        }
+        mpz_swap(out[0], inv);
+    }
+    else
     {
-        mpz_mod(r, tmpa, tmpn);
-        mpz_div(out, tmpa, tmpn); mpz_mul(out, _x, out); mpz_sub(x, __x, out);
-        mpz_swap(__x, _x); mpz_swap(_x, x);
-        mpz_swap(tmpa, tmpn); mpz_swap(tmpn, r);
+        for (size_t i = 0; i < count; i++) if(!mpz_invert(out[i], a[i], n)) {mpz_set_ui(out[i], 0); st = CY_ERR_VALUE;}
     }
-
-    mpz_mod(out, __x, mod); mpz_add(out, out, mod); mpz_mod(out, out, mod);
-    mpz_clears(tmpa, tmpn, x, _x, __x, mod, r,NULL);
-
-    return CY_OK;
+    mpz_clears(inv, t, NULL);
+    for (size_t i = 0; i < count; i++) mpz_clear(c[i]);
+    free(c);
+    return st;
 }
 
 static CY_STATE_FLAG __attribute__((unused)) cy_gf2_64_init(const char *coeff, const uint8_t deg, uint64_t *out)
 {
-    uint16_t exp2 = 1u<<deg; *out = 0;
+    if(deg > 63) return cy_state_manager(CY_ERR_ARG, __func__, ": degree above 63");
+    uint64_t exp2 = UINT64_C(1) << deg; *out = 0;
     for (uint8_t i = 0; i <= deg; i++)
     {
         *out = coeff[i] == '1' ? (*out | (exp2 >> i)) : *out;
@@ -277,13 +293,10 @@ static CY_STATE_FLAG __attribute__((unused)) cy_gf2_64_init(const char *coeff, c
     return CY_OK;
 }
 
+// degree of f, 0 for f = 0 as well
 static CY_STATE_FLAG cy_gf2_64_deg(uint64_t f, uint8_t *deg)
 {
-    __uint128_t exp2 = 1; exp2 <<= 64; *deg = 0;
-    for (uint8_t i = 0; i < 128; i++)
-    {
-        if(f & exp2 >> i) {*deg =  128 - i; return CY_OK;}
-    }
+    *deg = f ? (uint8_t)(63 - __builtin_clzll(f)) : 0;
     return CY_OK;
 }
 
@@ -301,11 +314,11 @@ static CY_STATE_FLAG cy_gf2_64_sub(uint64_t f, uint64_t g, uint64_t *out)
 
 static CY_STATE_FLAG cy_gf2_64_mul(uint64_t f, uint64_t g, __uint128_t *out)
 {
-    __uint128_t r = 0;
+    __uint128_t r = 0, ff = f;
     while (g){
-        if (g & 1) r ^= f;   // add current f if LSB of g is 1
+        if (g & 1) r ^= ff;  // add current f if LSB of g is 1
         g >>= 1;             // next bit of g
-        f <<= 1;             // corresponds to shifting by +1
+        ff <<= 1;            // corresponds to shifting by +1
     }
     *out = r;
 
@@ -315,15 +328,16 @@ static CY_STATE_FLAG cy_gf2_64_mul(uint64_t f, uint64_t g, __uint128_t *out)
 static CY_STATE_FLAG cy_gf2_64_div(uint64_t f, uint64_t g, uint64_t *q, uint64_t *r)
 {
     *q = 0; *r = f; uint64_t h = 0; uint8_t dr = 0, dg = 0, dh = 0;
+    if(!g) return cy_state_manager(CY_ERR_ARG, __func__, ": division by zero");
     cy_gf2_64_deg(g, &dg);
-    while(1)
+    while(*r)
     {
         cy_gf2_64_deg(*r, &dr);
         if(dr < dg) break;
         dh = dr - dg;
         h = g << dh;
         cy_gf2_64_sub(*r, h, r);
-        *q |= 1u<<dh;  
+        *q |= UINT64_C(1) << dh;
     }
     
     return CY_OK;
@@ -492,9 +506,28 @@ static CY_STATE_FLAG cy_rsa_prime_prob_gen(const mp_bitcnt_t bitsize, mpz_ptr p)
 {
     mpz_t n; mpz_init(n);
     mpz_setbit(n, bitsize);
+    CY_PRIMALITY_FLAG pf;
     do
     {cy_random_mpz(n, p);}
-    while(mpz_probab_prime_p(p, 100) == 0 );
+    while(cy_prime_bpsw(p, &pf) != CY_OK || pf != CY_PRIME);
+
+    mpz_clear(n);
+    return CY_OK;
+}
+
+// exactly bitsize bits with the two top bits set, so products of such primes keep their size
+static CY_STATE_FLAG cy_rsa_prime_gen_exact(const mp_bitcnt_t bitsize, mpz_ptr p)
+{
+    if(bitsize < 16) return CY_ERR_KEY_SIZE;
+    CY_PRIMALITY_FLAG pf;
+    mpz_t n; mpz_init(n);
+    mpz_setbit(n, bitsize);
+    do
+    {
+        if(cy_random_mpz(n, p) != CY_OK) {mpz_clear(n); return CY_ERR_RNG;}
+        mpz_setbit(p, bitsize - 1); mpz_setbit(p, bitsize - 2); mpz_setbit(p, 0);
+    }
+    while(cy_prime_bpsw(p, &pf) != CY_OK || pf != CY_PRIME);
 
     mpz_clear(n);
     return CY_OK;
@@ -628,6 +661,13 @@ void cy_aes_from_4by4_to_128(const uint8_t tab[4][4], __uint128_t *num)
     }
 }
 
+// secrets on the stack: a plain memset before return is a dead store the compiler may drop
+static void cy_wipe(void *p, const size_t len)
+{
+    volatile uint8_t *v = p;
+    for (size_t i = 0; i < len; i++) v[i] = 0;
+}
+
 /******************************************************** 
  * 
  * 
@@ -665,13 +705,47 @@ static CY_STATE_FLAG close_file(FILE *fp)
     return CY_OK;
 }
 
+// read only view of a whole file, released with cy_file_unmap
+static CY_STATE_FLAG cy_file_map(const char *path, const uint8_t **data, size_t *size)
+{
+    if(!path || !*path) return cy_state_manager(CY_ERR_ARG, __func__, ": path is NULL/empty");
+    *data = NULL; *size = 0;
+#ifdef _WIN32
+    HANDLE fh = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fh == INVALID_HANDLE_VALUE) return cy_state_manager(CY_ERR_OPEN, __func__, ": CreateFileA failed");
+    LARGE_INTEGER fsize;
+    if(!GetFileSizeEx(fh, &fsize)) {CloseHandle(fh); return cy_state_manager(CY_ERR_IO, __func__, ": GetFileSizeEx failed");}
+    if(fsize.QuadPart == 0) {CloseHandle(fh); return CY_OK;}
+    HANDLE mh = CreateFileMappingA(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(fh);
+    if(!mh) return cy_state_manager(CY_ERR_IO, __func__, ": CreateFileMappingA failed");
+    *data = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mh);
+    if(!*data) return cy_state_manager(CY_ERR_IO, __func__, ": MapViewOfFile failed");
+    *size = (size_t)fsize.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {perror("open"); return cy_state_manager(CY_ERR_OPEN, __func__, "");}
+    struct stat sb;
+    if(fstat(fd, &sb) != 0) {close(fd); return cy_state_manager(CY_ERR_IO, __func__, ": fstat failed");}
+    if(sb.st_size == 0) {close(fd); return CY_OK;}
+    void *p = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED) {perror("mmap"); return cy_state_manager(CY_ERR_IO, __func__, "");}
+    *data = p; *size = (size_t)sb.st_size;
+#endif
+    return CY_OK;
+}
 
-
-
-/***************
- * END HELPERS *
- ***************/
-
+static void cy_file_unmap(const uint8_t *data, const size_t size)
+{
+    if(!data) return;
+#ifdef _WIN32
+    (void)size; UnmapViewOfFile(data);
+#else
+    munmap((void *)data, size);
+#endif
+}
 
 
 
@@ -680,7 +754,7 @@ static CY_STATE_FLAG close_file(FILE *fp)
  * 
  * 
  * 
- *                    check Functions 
+ *                     Hash Functions 
  *
  * 
  * 
@@ -690,94 +764,419 @@ static CY_STATE_FLAG close_file(FILE *fp)
 
 
 
+static const uint32_t CY_SHA256_K[64] = 
+{
+    0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
+    0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
+    0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
+    0x983e5152,0xa831c66d,0xb00327c8,0xbf597fc7,0xc6e00bf3,0xd5a79147,0x06ca6351,0x14292967,
+    0x27b70a85,0x2e1b2138,0x4d2c6dfc,0x53380d13,0x650a7354,0x766a0abb,0x81c2c92e,0x92722c85,
+    0xa2bfe8a1,0xa81a664b,0xc24b8b70,0xc76c51a3,0xd192e819,0xd6990624,0xf40e3585,0x106aa070,
+    0x19a4c116,0x1e376c08,0x2748774c,0x34b0bcb5,0x391c0cb3,0x4ed8aa4a,0x5b9cca4f,0x682e6ff3,
+    0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
+};
 
+static const uint32_t CY_SHA256_IV[8] = 
+{0x6a09e667,0xbb67ae85,0x3c6ef372,0xa54ff53a,0x510e527f,0x9b05688c,0x1f83d9ab,0x5be0cd19};
 
+#define CY_ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
 
+static void cy_sha256_block_soft(uint32_t h[8], const uint8_t *p, size_t nblocks)
+{
+    for (; nblocks--; p += 64)
+    {
+        uint32_t w[64], s[8];
+        for (int i = 0; i < 16; i++)
+            w[i] = (uint32_t)p[4*i] << 24 | (uint32_t)p[4*i+1] << 16 | (uint32_t)p[4*i+2] << 8 | p[4*i+3];
+        for (int i = 16; i < 64; i++)
+        {
+            uint32_t s0 = CY_ROTR32(w[i-15], 7) ^ CY_ROTR32(w[i-15], 18) ^ (w[i-15] >> 3);
+            uint32_t s1 = CY_ROTR32(w[i-2], 17) ^ CY_ROTR32(w[i-2], 19) ^ (w[i-2] >> 10);
+            w[i] = w[i-16] + s0 + w[i-7] + s1;
+        }
+        memcpy(s, h, sizeof(s));
+        for (int i = 0; i < 64; i++)
+        {
+            uint32_t t1 = s[7] + (CY_ROTR32(s[4], 6) ^ CY_ROTR32(s[4], 11) ^ CY_ROTR32(s[4], 25))
+                        + ((s[4] & s[5]) ^ (~s[4] & s[6])) + CY_SHA256_K[i] + w[i];
+            uint32_t t2 = (CY_ROTR32(s[0], 2) ^ CY_ROTR32(s[0], 13) ^ CY_ROTR32(s[0], 22))
+                        + ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+            memmove(s + 1, s, 7 * sizeof(s[0]));
+            s[4] += t1; s[0] = t1 + t2;
+        }
+        for (int i = 0; i < 8; i++) h[i] += s[i];
+    }
+}
 
+#if defined(__x86_64__)
 
-/******************************************************** 
- * 
- * 
- * 
- * 
- *                     Key Functions 
- *
- * 
- * 
- * 
- *********************************************************/
+// state kept as {ABEF, CDGH} as sha256rnds2 expects, 4 rounds per message group
+__attribute__((target("sha,sse4.1")))
+static void cy_sha256_block_shani(uint32_t h[8], const uint8_t *p, size_t nblocks)
+{
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+    __m128i t = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)h), 0xB1);
+    __m128i s1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(h + 4)), 0x1B);
+    __m128i s0 = _mm_alignr_epi8(t, s1, 8);
+    s1 = _mm_blend_epi16(s1, t, 0xF0);
+    for (; nblocks--; p += 64)
+    {
+        __m128i m0, m1, m2, m3, k, a0 = s0, a1 = s1;
+        #define CY_SHANI_ROUNDS(g, m) \
+            k = _mm_add_epi32(m, _mm_loadu_si128((const __m128i *)(CY_SHA256_K + 4 * (g)))); \
+            s1 = _mm_sha256rnds2_epu32(s1, s0, k); \
+            s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(k, 0x0E));
+        // W[4g..4g+3] from the previous four groups, written over the oldest
+        #define CY_SHANI_SCHED(g, m, mn, mp2, mp1) \
+            m = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(m, mn), _mm_alignr_epi8(mp1, mp2, 4)), mp1); \
+            CY_SHANI_ROUNDS(g, m)
+        m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)p), bswap);        CY_SHANI_ROUNDS(0, m0)
+        m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p + 16)), bswap); CY_SHANI_ROUNDS(1, m1)
+        m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p + 32)), bswap); CY_SHANI_ROUNDS(2, m2)
+        m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p + 48)), bswap); CY_SHANI_ROUNDS(3, m3)
+        for (int g = 4; g < 16; g += 4)
+        {
+            CY_SHANI_SCHED(g,     m0, m1, m2, m3)
+            CY_SHANI_SCHED(g + 1, m1, m2, m3, m0)
+            CY_SHANI_SCHED(g + 2, m2, m3, m0, m1)
+            CY_SHANI_SCHED(g + 3, m3, m0, m1, m2)
+        }
+        #undef CY_SHANI_SCHED
+        #undef CY_SHANI_ROUNDS
+        s0 = _mm_add_epi32(s0, a0); s1 = _mm_add_epi32(s1, a1);
+    }
+    t = _mm_shuffle_epi32(s0, 0x1B);
+    s1 = _mm_shuffle_epi32(s1, 0xB1);
+    _mm_storeu_si128((__m128i *)h, _mm_blend_epi16(t, s1, 0xF0));
+    _mm_storeu_si128((__m128i *)(h + 4), _mm_alignr_epi8(s1, t, 8));
+}
 
+#define CY_V8_ROTR(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
 
+// 8 x 32 bytes from 8 messages to 8 big-endian words, lane l = message l
+__attribute__((target("avx2")))
+static inline void cy_sha256_x8_load(__m256i w[8], const uint8_t *const src[8], const size_t off)
+{
+    const __m256i bswap = _mm256_set_epi8(12,13,14,15, 8,9,10,11, 4,5,6,7, 0,1,2,3,
+                                          12,13,14,15, 8,9,10,11, 4,5,6,7, 0,1,2,3);
+    __m256i r[8], t[8], u[8];
+    for (int l = 0; l < 8; l++) r[l] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src[l] + off)), bswap);
+    for (int l = 0; l < 8; l += 2)
+    {t[l] = _mm256_unpacklo_epi32(r[l], r[l+1]); t[l+1] = _mm256_unpackhi_epi32(r[l], r[l+1]);}
+    for (int l = 0; l < 8; l += 4)
+    {
+        u[l]   = _mm256_unpacklo_epi64(t[l], t[l+2]);   u[l+1] = _mm256_unpackhi_epi64(t[l], t[l+2]);
+        u[l+2] = _mm256_unpacklo_epi64(t[l+1], t[l+3]); u[l+3] = _mm256_unpackhi_epi64(t[l+1], t[l+3]);
+    }
+    for (int i = 0; i < 4; i++)
+    {w[i] = _mm256_permute2x128_si256(u[i], u[i+4], 0x20); w[i+4] = _mm256_permute2x128_si256(u[i], u[i+4], 0x31);}
+}
 
+// up to 8 whole messages side by side, lanes that run out of blocks keep their state
+__attribute__((target("avx2")))
+static void cy_sha256_x8(const size_t n, const uint8_t *const in[], const size_t len[], uint8_t (*out)[32])
+{
+    static const uint8_t zero[64];
+    uint8_t tail[8][128];
+    size_t full[8] = {0}, total[8] = {0}, maxb = 0;
+    for (size_t l = 0; l < n; l++)
+    {
+        size_t r = len[l] % 64;
+        uint64_t bits = (uint64_t)len[l] * 8;
+        full[l] = len[l] / 64; total[l] = full[l] + (r < 56 ? 1 : 2);
+        memset(tail[l], 0, sizeof(tail[l]));
+        if(r) memcpy(tail[l], in[l] + 64 * full[l], r);
+        tail[l][r] = 0x80;
+        for (int i = 0; i < 8; i++) tail[l][64 * (total[l] - full[l]) - 1 - i] = (uint8_t)(bits >> (8 * i));
+        if(total[l] > maxb) maxb = total[l];
+    }
+    __m256i s[8], w[16];
+    for (int i = 0; i < 8; i++) s[i] = _mm256_set1_epi32((int)CY_SHA256_IV[i]);
+    for (size_t b = 0; b < maxb; b++)
+    {
+        const uint8_t *src[8];
+        int32_t live[8];
+        for (size_t l = 0; l < 8; l++)
+        {
+            live[l] = l < n && b < total[l] ? -1 : 0;
+            src[l] = !live[l] ? zero : b < full[l] ? in[l] + 64 * b : tail[l] + 64 * (b - full[l]);
+        }
+        cy_sha256_x8_load(w, src, 0); cy_sha256_x8_load(w + 8, src, 32);
+        __m256i a = s[0], bb = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+        for (int i = 0; i < 64; i++)
+        {
+            if(i >= 16)
+            {
+                __m256i x = w[(i - 15) & 15], y = w[(i - 2) & 15];
+                __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(CY_V8_ROTR(x, 7), CY_V8_ROTR(x, 18)), _mm256_srli_epi32(x, 3));
+                __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(CY_V8_ROTR(y, 17), CY_V8_ROTR(y, 19)), _mm256_srli_epi32(y, 10));
+                w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(w[i & 15], s0), _mm256_add_epi32(w[(i - 7) & 15], s1));
+            }
+            __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, _mm256_set1_epi32((int)CY_SHA256_K[i])), w[i & 15]);
+            t1 = _mm256_add_epi32(t1, _mm256_xor_si256(_mm256_xor_si256(CY_V8_ROTR(e, 6), CY_V8_ROTR(e, 11)), CY_V8_ROTR(e, 25)));
+            t1 = _mm256_add_epi32(t1, _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g)));
+            __m256i t2 = _mm256_xor_si256(_mm256_xor_si256(CY_V8_ROTR(a, 2), CY_V8_ROTR(a, 13)), CY_V8_ROTR(a, 22));
+            t2 = _mm256_add_epi32(t2, _mm256_or_si256(_mm256_and_si256(a, bb), _mm256_and_si256(c, _mm256_or_si256(a, bb))));
+            h = g; g = f; f = e; e = _mm256_add_epi32(d, t1);
+            d = c; c = bb; bb = a; a = _mm256_add_epi32(t1, t2);
+        }
+        const __m256i mask = _mm256_loadu_si256((const __m256i *)live);
+        const __m256i v[8] = {a, bb, c, d, e, f, g, h};
+        for (int i = 0; i < 8; i++) s[i] = _mm256_blendv_epi8(s[i], _mm256_add_epi32(s[i], v[i]), mask);
+    }
+    uint32_t st[8][8];
+    for (int i = 0; i < 8; i++) _mm256_storeu_si256((__m256i *)st[i], s[i]);
+    for (size_t l = 0; l < n; l++)
+        for (int i = 0; i < 8; i++)
+        {out[l][4*i] = (uint8_t)(st[i][l] >> 24); out[l][4*i+1] = (uint8_t)(st[i][l] >> 16); out[l][4*i+2] = (uint8_t)(st[i][l] >> 8); out[l][4*i+3] = (uint8_t)st[i][l];}
+}
 
-CY_STATE_FLAG cy_rsa_key_gen(const mp_bitcnt_t bitsize, mpz_t **pubkey, mpz_t **prvkey)
+static int cy_sha256_has_shani(void)
 {
-    mpz_t n, p, q, phi_n, e, d;
-    *pubkey = malloc(2 * sizeof((*pubkey)[0]));
-    *prvkey = malloc(2 * sizeof((*prvkey)[0]));
-    mpz_inits((*pubkey)[0], (*pubkey)[1], (*prvkey)[0], (*prvkey)[1], n, p, q, phi_n, e, d, NULL);
-    cy_rsa_prime_prob_gen(bitsize, p);
-    cy_rsa_prime_prob_gen(bitsize, q);
-    mpz_mul(n, p, q);
-    mpz_sub_ui(p, p, 1);
-    mpz_sub_ui(q, q, 1);
-    mpz_mul(phi_n, p, q);
-    cy_rsa_prime_prob_gen(bitsize / 10, e);
-    if(EEA(e, phi_n, d) == CY_ERR) return CY_ERR;
-    mpz_set((*pubkey)[0], e); mpz_set((*pubkey)[1], n);
-    mpz_set((*prvkey)[0], d); mpz_set((*prvkey)[1], n);
-    mpz_clears(e, d, n, p, q, phi_n, NULL);
-    return CY_OK;
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
 }
 
-CY_STATE_FLAG cy_rsa_key_imp(const char *path, mpz_t **key)
+static int cy_sha256_has_avx2(void)
 {
-    FILE *fp;
-    *key = malloc(2 * sizeof((*key)[0]));
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
 
-    mpz_inits((*key)[0], (*key)[1], NULL);
-    if(open_file(&fp, "rb", path) == CY_ERR) return CY_ERR;
-    gmp_fscanf(fp, "%Zd\n%Zd", (*key)[0], (*key)[1]);
-    if(close_file(fp) == CY_ERR) return CY_ERR;
+#else
+
+static void cy_sha256_block_shani(uint32_t h[8], const uint8_t *p, size_t nblocks) {(void)h; (void)p; (void)nblocks;}
+
+static void cy_sha256_x8(const size_t n, const uint8_t *const in[], const size_t len[], uint8_t (*out)[32]) 
+{(void)n; (void)in; (void)len; (void)out;}
+
+static int cy_sha256_has_shani(void) {return 0;}
+
+static int cy_sha256_has_avx2(void) {return 0;}
+
+#endif
+
+// picked once on the first cy_sha256_init, every state goes through it before a block
+static void (*cy_sha256_block_fn)(uint32_t h[8], const uint8_t *p, size_t nblocks) = cy_sha256_block_soft;
+static int cy_sha256_lanes;              // batches go eight wide
+static pthread_once_t cy_sha256_once = PTHREAD_ONCE_INIT;
+
+static void cy_sha256_resolve(void)
+{
+    if(cy_sha256_has_shani()) cy_sha256_block_fn = cy_sha256_block_shani;
+    // one SHA-NI stream still beats eight AVX2 lanes, so lanes only without it
+    else cy_sha256_lanes = cy_sha256_has_avx2();
+}
+
+static void cy_sha256_block(uint32_t h[8], const uint8_t *p, size_t nblocks)
+{
+    if(nblocks) cy_sha256_block_fn(h, p, nblocks);
+}
+
+void cy_sha256_init(CY_SHA256_STATE *st)
+{
+    pthread_once(&cy_sha256_once, cy_sha256_resolve);
+    memcpy(st->h, CY_SHA256_IV, sizeof(CY_SHA256_IV)); st->len = 0;
+}
+
+void cy_sha256_update(CY_SHA256_STATE *st, const uint8_t *in, size_t len)
+{
+    if(!len) return;
+    size_t fill = (size_t)(st->len % 64);
+    st->len += len;
+    if(fill)
+    {
+        size_t k = 64 - fill < len ? 64 - fill : len;
+        memcpy(st->buff + fill, in, k); in += k; len -= k;
+        if(fill + k < 64) return;
+        cy_sha256_block(st->h, st->buff, 1);
+    }
+    cy_sha256_block(st->h, in, len / 64);
+    memcpy(st->buff, in + len - len % 64, len % 64);
+}
+
+void cy_sha256_final(CY_SHA256_STATE *st, uint8_t out[32])
+{
+    uint8_t pad[72] = {0x80};
+    uint64_t bits = st->len * 8;
+    size_t padlen = (size_t)((st->len % 64) < 56 ? 56 - st->len % 64 : 120 - st->len % 64);
+    for (int i = 0; i < 8; i++) pad[padlen + i] = (uint8_t)(bits >> (56 - 8 * i));
+    cy_sha256_update(st, pad, padlen + 8);
+    for (int i = 0; i < 8; i++)
+    {out[4*i] = (uint8_t)(st->h[i] >> 24); out[4*i+1] = (uint8_t)(st->h[i] >> 16); out[4*i+2] = (uint8_t)(st->h[i] >> 8); out[4*i+3] = (uint8_t)st->h[i];}
+}
+
+void cy_sha256(const uint8_t *in, const size_t len, uint8_t out[32])
+{
+    CY_SHA256_STATE st;
+    cy_sha256_init(&st); cy_sha256_update(&st, in, len); cy_sha256_final(&st, out);
+}
+
+CY_STATE_FLAG cy_sha256_batch(const size_t count, const uint8_t *const in[], const size_t len[], uint8_t (*out)[32])
+{
+    if(count && (!in || !len || !out)) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    size_t i = 0;
+    pthread_once(&cy_sha256_once, cy_sha256_resolve);
+    if(count > 1 && cy_sha256_lanes)
+        for (; i < count; i += 8) cy_sha256_x8(count - i < 8 ? count - i : 8, in + i, len + i, out + i);
+    for (; i < count; i++) cy_sha256(in[i], len[i], out[i]);
     return CY_OK;
 }
 
-CY_STATE_FLAG cy_rsa_key_exp(const char *path, const mpz_t *key)
+CY_STATE_FLAG cy_hash_size(const CY_HASH_TYPE type, size_t *size)
 {
-    FILE *fp;
-    if(open_file(&fp, "wb", path) == CY_ERR) return CY_ERR;
-    gmp_fprintf(fp, "%Zd\n%Zd", key[0], key[1]);
-    if(close_file(fp) == CY_ERR) return CY_ERR;
+    switch (type)
+    {
+        case CY_HASH_SHA256: *size = CY_SHA256_SIZE; return CY_OK;
+        case CY_HASH_BLAKE3: *size = CY_BLAKE3_SIZE; return CY_OK;
+        case CY_HASH_SHA3_256: case CY_HASH_SHAKE128: *size = 32; return CY_OK;
+        case CY_HASH_SHA3_512: case CY_HASH_SHAKE256: *size = 64; return CY_OK;
+        default: return cy_state_manager(CY_ERR_UNSUPPORTED, __func__, ": unknown hash type");
+    }
+}
+
+CY_STATE_FLAG cy_hash_init(CY_HASH_CTX *ctx, const CY_HASH_TYPE type)
+{
+    switch (type)
+    {
+        case CY_HASH_SHA256: cy_sha256_init(&ctx->u.sha256); break;
+        case CY_HASH_BLAKE3: cy_blake3_init(&ctx->u.blake3); break;
+        case CY_HASH_SHA3_256: case CY_HASH_SHA3_512: case CY_HASH_SHAKE128: case CY_HASH_SHAKE256: cy_keccak_init(&ctx->u.keccak, type); break;
+        default: return cy_state_manager(CY_ERR_UNSUPPORTED, __func__, ": unknown hash type");
+    }
+    ctx->type = type;
     return CY_OK;
 }
 
-CY_STATE_FLAG cy_aes_key_gen(__uint128_t *key)
+CY_STATE_FLAG cy_hash_update(CY_HASH_CTX *ctx, const uint8_t *in, const size_t len)
 {
-    __uint128_t size = 0;
-    random_u128(17, &size);
-    if(random_u128_full(size, key) == CY_ERR) return cy_state_manager(CY_ERR_KEY, __func__, ": aes key generation failed");
-    *key *= size;
+    switch (ctx->type)
+    {
+        case CY_HASH_SHA256: cy_sha256_update(&ctx->u.sha256, in, len); return CY_OK;
+        case CY_HASH_BLAKE3: cy_blake3_update(&ctx->u.blake3, in, len); return CY_OK;
+        case CY_HASH_SHA3_256: case CY_HASH_SHA3_512: case CY_HASH_SHAKE128: case CY_HASH_SHAKE256: return cy_keccak_update(&ctx->u.keccak, in, len);
+        default: return cy_state_manager(CY_ERR_STATE, __func__, ": context not initialised");
+    }
+}
+
+CY_STATE_FLAG cy_hash_final(CY_HASH_CTX *ctx, uint8_t *out)
+{
+    switch (ctx->type)
+    {
+        case CY_HASH_SHA256: cy_sha256_final(&ctx->u.sha256, out); return CY_OK;
+        case CY_HASH_BLAKE3: cy_blake3_final(&ctx->u.blake3, out); return CY_OK;
+        case CY_HASH_SHA3_256: case CY_HASH_SHA3_512: case CY_HASH_SHAKE128: case CY_HASH_SHAKE256:
+        {
+            size_t size;
+            cy_hash_size(ctx->type, &size);
+            cy_keccak_squeeze(&ctx->u.keccak, out, size);
+            return CY_OK;
+        }
+        default: return cy_state_manager(CY_ERR_STATE, __func__, ": context not initialised");
+    }
+}
+
+CY_STATE_FLAG cy_hash(const CY_HASH_TYPE type, const uint8_t *in, const size_t len, uint8_t *out)
+{
+    CY_HASH_CTX ctx;
+    if(cy_hash_init(&ctx, type) != CY_OK) return CY_ERR;
+    cy_hash_update(&ctx, in, len);
+    return cy_hash_final(&ctx, out);
+}
+
+// ipad and opad blocks are absorbed once here, each MAC then starts from copies
+CY_STATE_FLAG cy_hmac_key_init(CY_HMAC_KEY *key, const uint8_t *k, const size_t klen)
+{
+    if(!key || (klen && !k)) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    uint8_t pad[64] = {0};
+    if(klen > 64) cy_sha256(k, klen, pad);
+    else if(klen) memcpy(pad, k, klen);
+    for (int i = 0; i < 64; i++) pad[i] ^= 0x36;
+    cy_sha256_init(&key->inner); cy_sha256_update(&key->inner, pad, 64);
+    for (int i = 0; i < 64; i++) pad[i] ^= 0x36 ^ 0x5c;
+    cy_sha256_init(&key->outer); cy_sha256_update(&key->outer, pad, 64);
+    cy_wipe(pad, sizeof(pad));
     return CY_OK;
 }
 
-CY_STATE_FLAG cy_aes_key_imp(const char *path, __uint128_t *key)
+void cy_hmac_init(CY_HMAC_CTX *ctx, const CY_HMAC_KEY *key)
 {
-    FILE *fp; uint8_t b[16]={0}; *key = 0;
-    if(open_file(&fp, "rb", path) == CY_ERR) return CY_ERR;
-    size_t size = fread(b, 1, 16, fp);
-    if(size == 0) return cy_state_manager(CY_ERR_IO, __func__, ": didnt read the key");
-    for (int i=0; i <16; i++) *key |= ((__uint128_t)(b[i]))<<(i * 8);
-    if(close_file(fp) == CY_ERR) return CY_ERR;
+    ctx->st = key->inner; ctx->key = key;
+}
+
+void cy_hmac_update(CY_HMAC_CTX *ctx, const uint8_t *in, const size_t len)
+{
+    cy_sha256_update(&ctx->st, in, len);
+}
+
+void cy_hmac_final(CY_HMAC_CTX *ctx, uint8_t out[32])
+{
+    uint8_t ih[32];
+    cy_sha256_final(&ctx->st, ih);
+    ctx->st = ctx->key->outer;
+    cy_sha256_update(&ctx->st, ih, sizeof(ih));
+    cy_sha256_final(&ctx->st, out);
+    cy_wipe(ih, sizeof(ih));
+}
+
+void cy_hmac_sha256(const CY_HMAC_KEY *key, const uint8_t *msg, const size_t len, uint8_t out[32])
+{
+    CY_HMAC_CTX ctx;
+    cy_hmac_init(&ctx, key); cy_hmac_update(&ctx, msg, len); cy_hmac_final(&ctx, out);
+    cy_wipe(&ctx, sizeof(ctx));
+}
+
+// RFC 5869, an empty salt means 32 zero bytes
+CY_STATE_FLAG cy_hkdf_extract(const uint8_t *salt, const size_t saltlen, const uint8_t *ikm, const size_t ikmlen, uint8_t prk[32])
+{
+    static const uint8_t zero[CY_SHA256_SIZE];
+    CY_HMAC_KEY key;
+    if(!prk || (ikmlen && !ikm)) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    if(cy_hmac_key_init(&key, saltlen ? salt : zero, saltlen ? saltlen : sizeof(zero)) != CY_OK) return CY_ERR;
+    cy_hmac_sha256(&key, ikm, ikmlen, prk);
+    cy_wipe(&key, sizeof(key));
     return CY_OK;
 }
 
-CY_STATE_FLAG cy_aes_key_exp(const char *path, __uint128_t key)
+// T(i) = HMAC(PRK, T(i-1) | info | i) on a key already holding the PRK pads
+static void cy_hkdf_expand_key(const CY_HMAC_KEY *key, const uint8_t *info, const size_t infolen, uint8_t *out, const size_t outlen)
 {
-    FILE *fp; uint8_t b[16]={0};
-    if(open_file(&fp, "wb", path) == CY_ERR) return CY_ERR;
-    for (int i=0; i <16; i++) b[i] = (uint8_t)((key >> (i * 8)) & 0xFF);
-    fwrite(b, 1, 16, fp);
-    if(close_file(fp) == CY_ERR) return CY_ERR;
+    uint8_t t[CY_SHA256_SIZE];
+    CY_HMAC_CTX ctx;
+    for (size_t done = 0, i = 1; done < outlen; done += sizeof(t), i++)
+    {
+        uint8_t c = (uint8_t)i;
+        cy_hmac_init(&ctx, key);
+        if(i > 1) cy_hmac_update(&ctx, t, sizeof(t));
+        cy_hmac_update(&ctx, info, infolen);
+        cy_hmac_update(&ctx, &c, 1);
+        cy_hmac_final(&ctx, t);
+        memcpy(out + done, t, outlen - done < sizeof(t) ? outlen - done : sizeof(t));
+    }
+    cy_wipe(t, sizeof(t)); cy_wipe(&ctx, sizeof(ctx));
+}
+
+CY_STATE_FLAG cy_hkdf_expand(const uint8_t prk[32], const uint8_t *info, const size_t infolen, uint8_t *out, const size_t outlen)
+{
+    const uint8_t *infos[1] = {info};
+    const size_t lens[1] = {infolen};
+    uint8_t *outs[1] = {out};
+    return cy_hkdf_expand_batch(prk, 1, infos, lens, outs, outlen);
+}
+
+// one PRK, many subkeys: the PRK pads are hashed once for the whole batch
+CY_STATE_FLAG cy_hkdf_expand_batch(const uint8_t prk[32], const size_t count, const uint8_t *const info[], const size_t infolen[], uint8_t *const out[], const size_t outlen)
+{
+    CY_HMAC_KEY key;
+    if(!prk || (count && (!info || !infolen || !out))) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    if(outlen > 255 * CY_SHA256_SIZE) return cy_state_manager(CY_ERR_SIZE, __func__, ": output longer than 255 blocks");
+    for (size_t i = 0; i < count; i++)
+    {
+        if(!out[i] || (infolen[i] && !info[i])) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    }
+    if(cy_hmac_key_init(&key, prk, CY_SHA256_SIZE) != CY_OK) return CY_ERR;
+    for (size_t i = 0; i < count; i++) cy_hkdf_expand_key(&key, info[i], infolen[i], out[i], outlen);
+    cy_wipe(&key, sizeof(key));
     return CY_OK;
 }
 
@@ -789,7 +1188,7 @@ CY_STATE_FLAG cy_aes_key_exp(const char *path, __uint128_t key)
  * 
  * 
  * 
- *                    Cypher Functions 
+ *                     Thread Functions 
  *
  * 
  * 
@@ -799,58 +1198,6205 @@ CY_STATE_FLAG cy_aes_key_exp(const char *path, __uint128_t key)
 
 
 
-void cy_rsa_encryption(const uint8_t c, const mpz_t *key, mpz_ptr cy_msg)
+typedef struct CY_THREAD_JOB
 {
-    mpz_set_ui(cy_msg, c);
-    mpz_powm(cy_msg, cy_msg, key[0], key[1]);
-}
+    void (*fn)(void *arg, size_t i);
+    void *arg;
+    size_t count;
+    atomic_size_t next;
+} CY_THREAD_JOB;
 
-void cy_rsa_decryption(const mpz_srcptr cy_msg, const mpz_t *key, uint8_t *c)
+static void *cy_thread_worker(void *arg)
 {
-    mpz_t out; mpz_init(out);
-    mpz_powm(out, cy_msg, key[0], key[1]);
-    *c = (uint8_t) mpz_get_ui(out);
-    mpz_clear(out);
+    CY_THREAD_JOB *job = arg;
+    for (size_t i; (i = atomic_fetch_add(&job->next, 1)) < job->count;) job->fn(job->arg, i);
+    return NULL;
 }
 
-void cy_aes_encryption(__uint128_t msg, __uint128_t key, __uint128_t *cy_msg)
+// runs fn(arg, i) for every i < count on up to nthreads threads, the caller being one of them
+static void cy_thread_for(const size_t nthreads, const size_t count, void (*fn)(void *arg, size_t i), void *arg)
 {
-    uint32_t expandkey[44]; uint8_t state[4][4]; *cy_msg = 0;
-    cy_aes_from_128_to_4by4(msg, state);
-    cy_aes_key_expansion(key, expandkey);
-    cy_aes_add_round_key(expandkey, state);
-
-    for (uint8_t i = 1; i < 10; i++)
-    {
-        cy_aes_substitute_bytes(CY_AES_SBOX, state);
-        cy_aes_shift_rows(state);
-        cy_aes_mix_columns(CY_AES_MIXCOL_MAT, state);
-        cy_aes_add_round_key(&expandkey[4 * i], state);
-    }
-    cy_aes_substitute_bytes(CY_AES_SBOX, state);
-    cy_aes_shift_rows(state);
-    cy_aes_add_round_key(&expandkey[40], state);
-    cy_aes_from_4by4_to_128(state, cy_msg);
+    CY_THREAD_JOB job = {fn, arg, count, 0};
+    size_t n = nthreads > count ? count : nthreads, started = 0;
+    pthread_t *tid = n > 1 ? malloc((n - 1) * sizeof(tid[0])) : NULL;
+    if(tid) for (; started < n - 1; started++) if(pthread_create(&tid[started], NULL, cy_thread_worker, &job)) break;
+    cy_thread_worker(&job);
+    for (size_t i = 0; i < started; i++) pthread_join(tid[i], NULL);
+    free(tid);
 }
 
-void cy_aes_decryption(__uint128_t cy_msg, __uint128_t key, __uint128_t *msg)
-{
-    uint32_t expandkey[44]; uint8_t state[4][4]; *msg = 0;
-    cy_aes_from_128_to_4by4(cy_msg, state);
-    cy_aes_key_expansion(key, expandkey);
-    cy_aes_add_round_key(expandkey + 40, state);
 
-    for (uint8_t i = 1; i < 10; i++)
-    {
-        cy_aes_invshift_rows(state);
-        cy_aes_substitute_bytes(CY_AES_INVSBOX, state);
-        cy_aes_add_round_key(expandkey + (40 - 4 * i), state);
-        cy_aes_mix_columns(CY_AES_INVMIXCOL_MAT, state);
-    }
-    cy_aes_invshift_rows(state);
-    cy_aes_substitute_bytes(CY_AES_INVSBOX, state);
-    cy_aes_add_round_key(expandkey, state);
-    cy_aes_from_4by4_to_128(state, msg);
+
+
+/***************
+ * END HELPERS *
+ ***************/
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                    check Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+/*
+ * Trial division by the odd primes below CY_TRIAL_LIMIT, taken from the shared
+ * sieve table. n is reduced once per group of primes whose product fits a
+ * word, then the word is worked on.
+ */
+#define CY_TRIAL_LIMIT 1024
+#define CY_TRIAL_PRIMES 172          // primes below CY_TRIAL_LIMIT, 2 included
+
+static CY_STATE_FLAG cy_sieve_hold(const uint64_t limit, const uint32_t **primes, size_t *count);
+
+// CY_COMPOSITE when a small prime divides n, CY_PRIME when n is one, CY_INCONCLUSIVE otherwise
+static CY_PRIMALITY_FLAG cy_prime_trial(mpz_srcptr n)
+{
+    if(mpz_cmp_ui(n, 2) < 0) return CY_COMPOSITE;
+    if(mpz_cmp_ui(n, 2) == 0) return CY_PRIME;
+    if(mpz_even_p(n)) return CY_COMPOSITE;
+    // without the table the full tests still decide n, only slower
+    const uint32_t *pr; size_t np;
+    if(cy_sieve_hold(CY_TRIAL_LIMIT, &pr, &np) != CY_OK) return CY_INCONCLUSIVE;
+    const int small = mpz_cmp_ui(n, pr[CY_TRIAL_PRIMES - 1]) <= 0;
+
+    // no factor below 1024 and n < 1024^2
+    CY_PRIMALITY_FLAG out = mpz_cmp_ui(n, CY_TRIAL_LIMIT * CY_TRIAL_LIMIT) < 0 ? CY_PRIME : CY_INCONCLUSIVE;
+    for (size_t i = 1; i < CY_TRIAL_PRIMES;)
+    {
+        size_t j = i;
+        uint64_t prod = 1;
+        while (j < CY_TRIAL_PRIMES && prod <= UINT64_MAX / pr[j]) prod *= pr[j++];
+        const uint64_t r = mpz_fdiv_ui(n, prod);
+        for (; i < j && r % pr[i]; i++);
+        if(i < j) {out = small && mpz_cmp_ui(n, pr[i]) == 0 ? CY_PRIME : CY_COMPOSITE; break;}
+    }
+    cy_sieve_table_release(pr);
+    return out;
+}
+
+/*
+ * Montgomery form modulo an odd n < 2^64, R = 2^64. The products stay in
+ * 128 bits and the reduction needs no division.
+ */
+typedef struct CY_MONT64
+{
+    uint64_t n, ninv, one;   // ninv = -n^-1 mod R, one = R mod n
+} CY_MONT64;
+
+static void cy_mont64_init(const uint64_t n, CY_MONT64 *m)
+{
+    uint64_t inv = n;                              // n * n = 1 mod 8
+    for (int i = 0; i < 5; i++) inv *= 2 - n * inv; // Newton, 3 -> 96 bits
+    m->n = n; m->ninv = -inv; m->one = (-n) % n;
+}
+
+static inline uint64_t cy_mont64_redc(const CY_MONT64 *m, const unsigned __int128 t)
+{
+    const uint64_t q = (uint64_t)t * m->ninv;
+    const unsigned __int128 r = (t >> 64) + (((unsigned __int128)q * m->n) >> 64) + ((uint64_t)t != 0);
+    return (uint64_t)(r >= m->n ? r - m->n : r);
+}
+
+static inline uint64_t cy_mont64_mul(const CY_MONT64 *m, const uint64_t a, const uint64_t b)
+{
+    return cy_mont64_redc(m, (unsigned __int128)a * b);
+}
+
+static inline uint64_t cy_mont64_to(const CY_MONT64 *m, const uint64_t a)
+{
+    return (uint64_t)(((unsigned __int128)(a % m->n) << 64) % m->n);
+}
+
+static CY_PRIMALITY_FLAG cy_mra_u64_mont(const CY_MONT64 *m, const uint64_t base)
+{
+    const uint64_t n = m->n;
+    if(base % n == 0) return CY_INCONCLUSIVE;
+    uint64_t d = n - 1; unsigned s = 0;
+    while (!(d & 1)) {d >>= 1; s++;}
+
+    const uint64_t minus_one = n - m->one;
+    uint64_t b = cy_mont64_to(m, base), x = m->one;
+    for (; d; d >>= 1, b = cy_mont64_mul(m, b, b)) if(d & 1) x = cy_mont64_mul(m, x, b);
+    if(x == m->one || x == minus_one) return CY_INCONCLUSIVE;
+    for (unsigned i = 1; i < s; i++)
+    {
+        x = cy_mont64_mul(m, x, x);
+        if(x == minus_one) return CY_INCONCLUSIVE;
+    }
+    return CY_COMPOSITE;
+}
+
+/*
+ * One strong Miller-Rabin round of odd n > 3 to the given base:
+ * CY_COMPOSITE or CY_INCONCLUSIVE (a strong probable prime to that base).
+ */
+CY_STATE_FLAG cy_mra_u64(const uint64_t n, const uint64_t base, CY_PRIMALITY_FLAG *out)
+{
+    if(!out) return cy_state_manager(CY_ERR_ARG, __func__, ": null output");
+    if(n < 5 || !(n & 1)) return cy_state_manager(CY_ERR_ARG, __func__, ": n must be odd and > 3");
+    CY_MONT64 m; cy_mont64_init(n, &m);
+    *out = cy_mra_u64_mont(&m, base);
+    return CY_OK;
+}
+
+/*
+ * Deterministic for every n < 2^64: the seven bases of Jim Sinclair leave
+ * no strong pseudoprime below 2^64.
+ */
+CY_STATE_FLAG cy_emra_u64(const uint64_t n, CY_PRIMALITY_FLAG *out)
+{
+    static const uint64_t bases[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+    if(!out) return cy_state_manager(CY_ERR_ARG, __func__, ": null output");
+    // bit p set for every prime p below 64
+    const uint64_t small = 0x28208a20a08a28acULL;
+    if(n < 64) {*out = (small >> n) & 1 ? CY_PRIME : CY_COMPOSITE; return CY_OK;}
+    for (uint64_t m = small; m; m &= m - 1)
+    {
+        if(n % (uint64_t)__builtin_ctzll(m) == 0) {*out = CY_COMPOSITE; return CY_OK;}
+    }
+    CY_MONT64 m; cy_mont64_init(n, &m);
+    for (size_t i = 0; i < sizeof(bases) / sizeof(bases[0]); i++)
+    {
+        if(cy_mra_u64_mont(&m, bases[i]) == CY_COMPOSITE) {*out = CY_COMPOSITE; return CY_OK;}
+    }
+    *out = CY_PRIME;
+    return CY_OK;
+}
+
+// strong base-2 Miller-Rabin of odd n > 3
+static int cy_prime_mr2(mpz_srcptr n)
+{
+    mpz_t d, x, nm1; mpz_inits(d, x, nm1, NULL);
+    mpz_sub_ui(nm1, n, 1);
+    const mp_bitcnt_t s = mpz_scan1(nm1, 0);
+    mpz_tdiv_q_2exp(d, nm1, s);
+    mpz_set_ui(x, 2);
+    mpz_powm(x, x, d, n);
+    int ok = mpz_cmp_ui(x, 1) == 0 || mpz_cmp(x, nm1) == 0;
+    for (mp_bitcnt_t i = 1; i < s && !ok; i++)
+    {
+        mpz_mul(x, x, x); mpz_mod(x, x, n);
+        if(mpz_cmp(x, nm1) == 0) ok = 1;
+        else if(mpz_cmp_ui(x, 1) == 0) break;
+    }
+    mpz_clears(d, x, nm1, NULL);
+    return ok;
+}
+
+// x / 2 mod odd n
+static void cy_prime_half(mpz_ptr x, mpz_srcptr n)
+{
+    if(mpz_odd_p(x)) mpz_add(x, x, n);
+    mpz_tdiv_q_2exp(x, x, 1);
+}
+
+/*
+ * Strong Lucas test of odd n > 3 that is not a square, Selfridge's parameters:
+ * the first D of 5, -7, 9, -11, ... with (D/n) = -1, P = 1, Q = (1 - D) / 4.
+ * With n + 1 = d 2^s, n passes when U_d = 0 or V_(d 2^r) = 0 for some r < s.
+ */
+static int cy_prime_lucas(mpz_srcptr n)
+{
+    mpz_t D, U, V, Qk, t, d; mpz_inits(D, U, V, Qk, t, d, NULL);
+    long dd = 5;
+    for (;;)
+    {
+        mpz_set_si(D, dd);
+        const int j = mpz_jacobi(D, n);
+        if(j == -1) break;
+        // a proper factor |D| of n
+        if(j == 0 && mpz_cmpabs_ui(n, (unsigned long)labs(dd)) != 0) {mpz_clears(D, U, V, Qk, t, d, NULL); return 0;}
+        dd = dd > 0 ? -(dd + 2) : -dd + 2;
+    }
+    const long Q = (1 - dd) / 4;
+
+    mpz_add_ui(d, n, 1);
+    const mp_bitcnt_t s = mpz_scan1(d, 0);
+    mpz_tdiv_q_2exp(d, d, s);
+
+    // left to right over d: U_2k = U_k V_k, V_2k = V_k^2 - 2 Q^k,
+    // U_(k+1) = (U_k + V_k) / 2, V_(k+1) = (D U_k + V_k) / 2
+    mpz_set_ui(U, 1); mpz_set_ui(V, 1); mpz_set_si(Qk, Q); mpz_mod(Qk, Qk, n);
+    for (mp_bitcnt_t b = mpz_sizeinbase(d, 2) - 1; b-- > 0;)
+    {
+        mpz_mul(U, U, V); mpz_mod(U, U, n);
+        mpz_mul(V, V, V); mpz_submul_ui(V, Qk, 2); mpz_mod(V, V, n);
+        mpz_mul(Qk, Qk, Qk); mpz_mod(Qk, Qk, n);
+        if(mpz_tstbit(d, b))
+        {
+            mpz_set(t, U);
+            mpz_add(U, U, V); mpz_mod(U, U, n); cy_prime_half(U, n);
+            mpz_mul(t, t, D); mpz_add(V, V, t); mpz_mod(V, V, n); cy_prime_half(V, n);
+            mpz_mul_si(Qk, Qk, Q); mpz_mod(Qk, Qk, n);
+        }
+    }
+    int ok = mpz_sgn(U) == 0 || mpz_sgn(V) == 0;
+    for (mp_bitcnt_t r = 1; r < s && !ok; r++)
+    {
+        mpz_mul(V, V, V); mpz_submul_ui(V, Qk, 2); mpz_mod(V, V, n);
+        mpz_mul(Qk, Qk, Qk); mpz_mod(Qk, Qk, n);
+        ok = mpz_sgn(V) == 0;
+    }
+    mpz_clears(D, U, V, Qk, t, d, NULL);
+    return ok;
+}
+
+/*
+ * Baillie-PSW: trial division, then a strong base-2 Miller-Rabin and a strong
+ * Lucas test. Below 2^64 the answer is exact (the u64 Miller-Rabin); above, no
+ * composite passing both is known, so CY_PRIME means a BPSW probable prime.
+ */
+CY_STATE_FLAG cy_prime_bpsw(mpz_srcptr n, CY_PRIMALITY_FLAG *out)
+{
+    if(!n || !out) return cy_state_manager(CY_ERR_ARG, __func__, ": bad arguments");
+    if((*out = cy_prime_trial(n)) != CY_INCONCLUSIVE) return CY_OK;
+    if(mpz_sizeinbase(n, 2) <= 64) return cy_emra_u64((uint64_t)mpz_getlimbn(n, 0), out);
+
+    *out = CY_COMPOSITE;
+    if(!cy_prime_mr2(n) || mpz_perfect_square_p(n) || !cy_prime_lucas(n)) return CY_OK;
+    *out = CY_PRIME;
+    return CY_OK;
+}
+
+typedef struct CY_PRIME_JOB
+{
+    const mpz_srcptr *n;
+    CY_PRIMALITY_FLAG *out;
+    atomic_int failed;
+} CY_PRIME_JOB;
+
+static void cy_prime_batch_item(void *arg, size_t i)
+{
+    CY_PRIME_JOB *job = arg;
+    if(cy_prime_bpsw(job->n[i], &job->out[i]) != CY_OK) atomic_store(&job->failed, 1);
+}
+
+// out[i] = cy_prime_bpsw(n[i]), candidates spread over nthreads
+CY_STATE_FLAG cy_prime_batch(const size_t count, const mpz_srcptr n[], const size_t nthreads, CY_PRIMALITY_FLAG out[])
+{
+    if(!count) return CY_OK;
+    if(!n || !out) return cy_state_manager(CY_ERR_ARG, __func__, ": bad arguments");
+    CY_PRIME_JOB job = {.n = n, .out = out};
+    atomic_init(&job.failed, 0);
+    cy_thread_for(nthreads ? nthreads : 1, count, cy_prime_batch_item, &job);
+    if(atomic_load(&job.failed)) return cy_state_manager(CY_ERR, __func__, ": a candidate failed");
+    return CY_OK;
+}
+
+/*
+ * Segmented sieve of Eratosthenes on the mod 30 wheel: one byte holds the 8
+ * candidates 30 b + {1, 7, 11, 13, 17, 19, 23, 29}, so a segment of
+ * CY_SIEVE_SEG_BYTES covers 30 times that many integers and stays in L1.
+ * The multiples p (30 c + w) of a sieving prime p = 30 q + r, w on the wheel,
+ * fall on byte p c + q w + (r w) / 30 and the bit of r w mod 30, so one pass
+ * of c clears 8 bytes at offsets fixed per prime.
+ */
+#define CY_SIEVE_SEG_BYTES (32 * 1024)
+#define CY_SIEVE_MAX ((uint64_t)1 << 48)
+#define CY_SIEVE_PRE_BYTES (7 * 11 * 13 * 17 * 19)  // period of the pre-sieved pattern
+#define CY_SIEVE_PRE_MAX 19
+
+static const uint8_t CY_WHEEL[8] = {1, 7, 11, 13, 17, 19, 23, 29};
+
+static const int8_t CY_WHEEL_INDEX[30] = 
+{
+    -1,  0, -1, -1, -1, -1, -1,  1, -1, -1, -1,  2, -1,  3, -1, -1, 
+    -1,  4, -1,  5, -1, -1, -1,  6, -1, -1, -1, -1, -1,  7
+};
+
+// [r][w] bit cleared in the byte of p (30 c + w), p = r mod 30
+static const uint8_t CY_WHEEL_MASK[8][8] = 
+{
+    {0xFE, 0xFD, 0xFB, 0xF7, 0xEF, 0xDF, 0xBF, 0x7F},
+    {0xFD, 0xDF, 0xEF, 0xFE, 0x7F, 0xF7, 0xFB, 0xBF},
+    {0xFB, 0xEF, 0xFE, 0xBF, 0xFD, 0x7F, 0xF7, 0xDF},
+    {0xF7, 0xFE, 0xBF, 0xDF, 0xFB, 0xFD, 0x7F, 0xEF},
+    {0xEF, 0x7F, 0xFD, 0xFB, 0xDF, 0xBF, 0xFE, 0xF7},
+    {0xDF, 0xF7, 0x7F, 0xFD, 0xBF, 0xFE, 0xEF, 0xFB},
+    {0xBF, 0xFB, 0xF7, 0x7F, 0xFE, 0xEF, 0xDF, 0xFD},
+    {0x7F, 0xBF, 0xDF, 0xEF, 0xF7, 0xFB, 0xFD, 0xFE}
+};
+
+// [r][w] = (r w) / 30
+static const uint8_t CY_WHEEL_OFF[8][8] = 
+{
+    { 0,  0,  0,  0,  0,  0,  0,  0},
+    { 0,  1,  2,  3,  3,  4,  5,  6},
+    { 0,  2,  4,  4,  6,  6,  8, 10},
+    { 0,  3,  4,  5,  7,  8,  9, 12},
+    { 0,  3,  6,  7,  9, 10, 13, 16},
+    { 0,  4,  6,  8, 10, 12, 14, 18},
+    { 0,  5,  8,  9, 13, 14, 17, 22},
+    { 0,  6, 10, 12, 16, 18, 22, 28}
+};
+
+typedef struct CY_SIEVE_SEG
+{
+    const uint32_t *prime;      // sieving primes from 7, ascending
+    size_t nprime, active;      // active: primes with p^2 below the segment end
+    size_t skip;                // primes up to CY_SIEVE_PRE_MAX, already in the pattern
+    uint64_t *next;             // per prime, byte p c of the current cycle
+    uint8_t *wheel;             // per prime, index of the next w in that cycle
+    uint8_t bits[CY_SIEVE_SEG_BYTES];
+    uint64_t byte, len;         // current segment
+} CY_SIEVE_SEG;
+
+// odd primes from 7 up to sqrt(hi), plain sieve of Eratosthenes
+static CY_STATE_FLAG cy_sieve_base(const uint64_t hi, uint32_t **prime, size_t *count)
+{
+    uint64_t r = 1;
+    while ((r + 1) * (r + 1) <= hi) r++;
+    uint8_t *comp = calloc(r + 1, 1);
+    uint32_t *p = malloc((r / 2 + 2) * sizeof(p[0]));
+    if(!comp || !p) {free(comp); free(p); return CY_ERR_OOM;}
+    size_t n = 0;
+    for (uint64_t i = 3; i <= r; i += 2)
+    {
+        if(comp[i]) continue;
+        if(i >= 7) p[n++] = (uint32_t)i;
+        for (uint64_t j = i * i; j <= r; j += 2 * i) comp[j] = 1;
+    }
+    free(comp);
+    *prime = p; *count = n;
+    return CY_OK;
+}
+
+// bytes with every multiple of 7 ... 19 cleared, copied in instead of crossed off
+static uint8_t *cy_sieve_pre;
+static pthread_once_t cy_sieve_pre_once = PTHREAD_ONCE_INIT;
+
+static void cy_sieve_pre_build(void)
+{
+    uint8_t *pre = malloc(CY_SIEVE_PRE_BYTES);
+    if(!pre) return;
+    memset(pre, 0xFF, CY_SIEVE_PRE_BYTES);
+    for (uint64_t p = 7; p <= CY_SIEVE_PRE_MAX; p += 2)
+    {
+        if(p % 3 == 0 || p % 5 == 0) continue;
+        for (int k = 0; k < 8; k++)
+        {
+            const uint8_t mask = CY_WHEEL_MASK[CY_WHEEL_INDEX[p % 30]][k];
+            for (uint64_t j = p * CY_WHEEL[k] / 30; j < CY_SIEVE_PRE_BYTES; j += p) pre[j] &= mask;
+        }
+    }
+    cy_sieve_pre = pre;
+}
+
+// positions every sieving prime at its first multiple p m >= 30 byte, m >= p
+static CY_STATE_FLAG cy_sieve_seg_init(CY_SIEVE_SEG *s, const uint32_t *prime, const size_t nprime, const uint64_t byte)
+{
+    pthread_once(&cy_sieve_pre_once, cy_sieve_pre_build);
+    if(!cy_sieve_pre) return CY_ERR_OOM;
+    s->prime = prime; s->nprime = nprime; s->active = 0;
+    for (s->skip = 0; s->skip < nprime && prime[s->skip] <= CY_SIEVE_PRE_MAX; s->skip++);
+    s->next = malloc((nprime ? nprime : 1) * sizeof(s->next[0]));
+    s->wheel = malloc(nprime ? nprime : 1);
+    if(!s->next || !s->wheel) {free(s->next); free(s->wheel); return CY_ERR_OOM;}
+    const uint64_t lo = 30 * byte;
+    for (size_t i = 0; i < nprime; i++)
+    {
+        const uint64_t p = prime[i];
+        uint64_t m = (lo + p - 1) / p;
+        if(m < p) m = p;
+        uint64_t c = m / 30; int k = 0;
+        while (k < 8 && 30 * c + CY_WHEEL[k] < m) k++;
+        if(k == 8) {c++; k = 0;}
+        s->next[i] = p * c; s->wheel[i] = (uint8_t)k;
+    }
+    s->byte = byte; s->len = 0;
+    return CY_OK;
+}
+
+static void cy_sieve_seg_free(CY_SIEVE_SEG *s) {free(s->next); free(s->wheel);}
+
+// sieves bytes [byte, byte + len), byte being where the previous segment ended
+static void cy_sieve_seg_run(CY_SIEVE_SEG *s, const uint64_t byte, const uint64_t len)
+{
+    uint8_t *bits = s->bits;
+    const uint64_t end = byte + len;
+    for (uint64_t done = 0, off = byte % CY_SIEVE_PRE_BYTES; done < len;)
+    {
+        const uint64_t n = len - done < CY_SIEVE_PRE_BYTES - off ? len - done : CY_SIEVE_PRE_BYTES - off;
+        memcpy(bits + done, cy_sieve_pre + off, n);
+        done += n; off = 0;
+    }
+    // 1 is not prime, 7 ... 19 are
+    if(byte == 0) bits[0] = (uint8_t)((bits[0] & 0xFE) | 0x3E);
+    while (s->active < s->nprime && (uint64_t)s->prime[s->active] * s->prime[s->active] < 30 * end) s->active++;
+
+    for (size_t i = s->skip; i < s->active; i++)
+    {
+        const uint64_t p = s->prime[i], q = p / 30;
+        const int r = CY_WHEEL_INDEX[p % 30];
+        const uint8_t *mask = CY_WHEEL_MASK[r];
+        uint64_t off[8];
+        for (int k = 0; k < 8; k++) off[k] = q * CY_WHEEL[k] + CY_WHEEL_OFF[r][k];
+
+        // relative to the segment, wraps when the cycle began in an earlier one
+        uint64_t j = s->next[i] - byte;
+        int k = s->wheel[i];
+        // rest of the cycle left by the previous segment
+        if(k)
+        {
+            for (; k < 8 && j + off[k] < len; k++) bits[j + off[k]] &= mask[k];
+            if(k < 8) {s->wheel[i] = (uint8_t)k; continue;}
+            j += p;
+        }
+        for (; j + off[7] < len; j += p)
+        {
+            bits[j + off[0]] &= mask[0]; bits[j + off[1]] &= mask[1];
+            bits[j + off[2]] &= mask[2]; bits[j + off[3]] &= mask[3];
+            bits[j + off[4]] &= mask[4]; bits[j + off[5]] &= mask[5];
+            bits[j + off[6]] &= mask[6]; bits[j + off[7]] &= mask[7];
+        }
+        for (k = 0; j + off[k] < len; k++) bits[j + off[k]] &= mask[k];
+        s->next[i] = j + byte; s->wheel[i] = (uint8_t)k;
+    }
+    s->byte = byte; s->len = len;
+}
+
+// bits of byte b standing for integers in [lo, hi)
+static uint8_t cy_sieve_edge(const uint64_t b, const uint64_t lo, const uint64_t hi)
+{
+    uint8_t keep = 0;
+    for (int k = 0; k < 8; k++)
+    {
+        const uint64_t v = 30 * b + CY_WHEEL[k];
+        if(v >= lo && v < hi) keep |= (uint8_t)(1u << k);
+    }
+    return keep;
+}
+
+static void cy_sieve_seg_clip(CY_SIEVE_SEG *s, const uint64_t lo, const uint64_t hi)
+{
+    if(!s->len) return;
+    s->bits[0] &= cy_sieve_edge(s->byte, lo, hi);
+    s->bits[s->len - 1] &= cy_sieve_edge(s->byte + s->len - 1, lo, hi);
+}
+
+static size_t cy_sieve_small(const uint64_t lo, const uint64_t hi)
+{
+    size_t n = 0;
+    for (uint64_t p = 2; p <= 5; p += (p == 2 ? 1 : 2)) n += p >= lo && p < hi;
+    return n;
+}
+
+typedef struct CY_SIEVE_JOB
+{
+    uint64_t lo, hi, byte0, byte1, nblock;
+    const uint32_t *prime;
+    size_t nprime;
+    size_t *count;           // per block
+    uint32_t **out;          // per block, NULL when only counting
+    atomic_int failed;
+} CY_SIEVE_JOB;
+
+static void cy_sieve_block(void *arg, size_t blk)
+{
+    CY_SIEVE_JOB *job = arg;
+    const uint64_t span = job->byte1 - job->byte0;
+    const uint64_t b0 = job->byte0 + span * blk / job->nblock, b1 = job->byte0 + span * (blk + 1) / job->nblock;
+    job->count[blk] = 0;
+    if(b0 == b1) return;
+
+    CY_SIEVE_SEG *s = malloc(sizeof(*s));
+    if(!s || cy_sieve_seg_init(s, job->prime, job->nprime, b0) != CY_OK) {free(s); atomic_store(&job->failed, 1); return;}
+    size_t n = 0, cap = 0;
+    uint32_t *out = NULL;
+    for (uint64_t b = b0; b < b1; b += CY_SIEVE_SEG_BYTES)
+    {
+        const uint64_t len = b1 - b < CY_SIEVE_SEG_BYTES ? b1 - b : CY_SIEVE_SEG_BYTES;
+        cy_sieve_seg_run(s, b, len);
+        cy_sieve_seg_clip(s, job->lo, job->hi);
+        if(!job->out)
+        {
+            uint64_t w; size_t i = 0;
+            for (; i + 8 <= len; i += 8) {memcpy(&w, s->bits + i, 8); n += (size_t)__builtin_popcountll(w);}
+            for (; i < len; i++) n += (size_t)__builtin_popcount(s->bits[i]);
+            continue;
+        }
+        for (uint64_t i = 0; i < len; i++)
+        {
+            for (unsigned v = s->bits[i]; v; v &= v - 1)
+            {
+                if(n == cap)
+                {
+                    uint32_t *t = realloc(out, (cap = cap ? 2 * cap : 4096) * sizeof(out[0]));
+                    if(!t) {free(out); cy_sieve_seg_free(s); free(s); atomic_store(&job->failed, 1); return;}
+                    out = t;
+                }
+                out[n++] = (uint32_t)(30 * (b + i) + CY_WHEEL[__builtin_ctz(v)]);
+            }
+        }
+    }
+    cy_sieve_seg_free(s); free(s);
+    job->count[blk] = n;
+    if(job->out) job->out[blk] = out;
+}
+
+// sieves [lo, hi) in nthreads * 4 blocks of whole bytes, counting or collecting per block
+static CY_STATE_FLAG cy_sieve_run(const uint64_t lo, const uint64_t hi, const size_t nthreads, size_t *count, uint32_t **primes)
+{
+    CY_SIEVE_JOB job = {.lo = lo, .hi = hi, .byte0 = lo / 30, .byte1 = (hi + 29) / 30};
+    uint32_t *base = NULL;
+    CY_STATE_FLAG st = cy_sieve_base(hi, &base, &job.nprime);
+    if(st != CY_OK) return st;
+    job.prime = base;
+    const uint64_t nseg = (job.byte1 - job.byte0 + CY_SIEVE_SEG_BYTES - 1) / CY_SIEVE_SEG_BYTES;
+    const size_t nt = nthreads ? nthreads : 1;
+    job.nblock = nseg < 4 * nt ? (nseg ? nseg : 1) : 4 * nt;
+    job.count = calloc(job.nblock, sizeof(job.count[0]));
+    if(primes) job.out = calloc(job.nblock, sizeof(job.out[0]));
+    if(!job.count || (primes && !job.out)) {free(base); free(job.count); free(job.out); return CY_ERR_OOM;}
+    atomic_init(&job.failed, 0);
+
+    cy_thread_for(nt, job.nblock, cy_sieve_block, &job);
+
+    const size_t small = cy_sieve_small(lo, hi);
+    size_t total = small;
+    for (size_t i = 0; i < job.nblock; i++) total += job.count[i];
+    if(atomic_load(&job.failed)) st = CY_ERR_OOM;
+    if(st == CY_OK && primes)
+    {
+        uint32_t *all = malloc((total ? total : 1) * sizeof(all[0]));
+        if(!all) st = CY_ERR_OOM;
+        else
+        {
+            size_t n = 0;
+            for (uint32_t p = 2; p <= 5; p += (p == 2 ? 1 : 2)) if(p >= lo && p < hi) all[n++] = p;
+            for (size_t i = 0; i < job.nblock; i++) {if(job.count[i]) memcpy(all + n, job.out[i], job.count[i] * sizeof(all[0])); n += job.count[i];}
+            *primes = all;
+        }
+    }
+    if(st == CY_OK) *count = total;
+    for (size_t i = 0; job.out && i < job.nblock; i++) free(job.out[i]);
+    free(job.out); free(job.count); free(base);
+    return st;
+}
+
+// number of primes in [lo, hi)
+CY_STATE_FLAG cy_sieve_count(const uint64_t lo, const uint64_t hi, const size_t nthreads, size_t *count)
+{
+    if(!count || lo > hi) return cy_state_manager(CY_ERR_ARG, __func__, ": bad arguments");
+    if(hi > CY_SIEVE_MAX) return cy_state_manager(CY_ERR_RANGE, __func__, ": sieve limited to 2^48");
+    CY_STATE_FLAG st = cy_sieve_run(lo, hi, nthreads, count, NULL);
+    if(st != CY_OK) return cy_state_manager(st, __func__, "");
+    return CY_OK;
+}
+
+/*
+ * Shared tables of the primes below a limit, read-only once built. Readers
+ * count on the table they took, a table replaced or freed while held is kept
+ * on the retired list until its last reader lets go.
+ */
+typedef struct CY_SIEVE_TAB
+{
+    uint32_t *prime;
+    size_t count, refs;
+    uint64_t limit;
+    struct CY_SIEVE_TAB *next;
+} CY_SIEVE_TAB;
+
+static struct
+{
+    pthread_mutex_t lock;
+    CY_SIEVE_TAB *cur, *retired;
+} cy_sieve_cache = {PTHREAD_MUTEX_INITIALIZER, NULL, NULL};
+
+// under the lock: frees an unused table, retires a held one
+static void cy_sieve_tab_drop(CY_SIEVE_TAB *t)
+{
+    if(!t) return;
+    if(!t->refs) {free(t->prime); free(t); return;}
+    t->next = cy_sieve_cache.retired; cy_sieve_cache.retired = t;
+}
+
+// makes the current table cover limit, sieving outside the lock
+static CY_STATE_FLAG cy_sieve_tab_build(const uint64_t limit, const size_t nthreads)
+{
+    pthread_mutex_lock(&cy_sieve_cache.lock);
+    const int covered = cy_sieve_cache.cur && cy_sieve_cache.cur->limit >= limit;
+    pthread_mutex_unlock(&cy_sieve_cache.lock);
+    if(covered) return CY_OK;
+
+    CY_SIEVE_TAB *t = calloc(1, sizeof(*t));
+    if(!t) return CY_ERR_OOM;
+    CY_STATE_FLAG st = cy_sieve_run(0, limit, nthreads, &t->count, &t->prime);
+    if(st != CY_OK) {free(t); return st;}
+    t->limit = limit;
+
+    pthread_mutex_lock(&cy_sieve_cache.lock);
+    if(cy_sieve_cache.cur && cy_sieve_cache.cur->limit >= limit) cy_sieve_tab_drop(t);   // another thread got there first
+    else {cy_sieve_tab_drop(cy_sieve_cache.cur); cy_sieve_cache.cur = t;}
+    pthread_mutex_unlock(&cy_sieve_cache.lock);
+    return CY_OK;
+}
+
+// takes a reference on the current table when it covers limit
+static CY_STATE_FLAG cy_sieve_take(const uint64_t limit, const uint32_t **primes, size_t *count)
+{
+    CY_STATE_FLAG st = CY_ERR_STATE;
+    pthread_mutex_lock(&cy_sieve_cache.lock);
+    CY_SIEVE_TAB *t = cy_sieve_cache.cur;
+    if(t && t->limit >= limit) {t->refs++; *primes = t->prime; *count = t->count; st = CY_OK;}
+    pthread_mutex_unlock(&cy_sieve_cache.lock);
+    return st;
+}
+
+// library callers: a table covering limit, built on first use, released with cy_sieve_table_release
+static CY_STATE_FLAG cy_sieve_hold(const uint64_t limit, const uint32_t **primes, size_t *count)
+{
+    if(cy_sieve_take(limit, primes, count) == CY_OK) return CY_OK;
+    CY_STATE_FLAG st = cy_sieve_tab_build(limit, 1);
+    return st == CY_OK ? cy_sieve_take(limit, primes, count) : st;
+}
+
+/*
+ * Builds the shared table of primes below limit (at most 2^32). A limit
+ * already covered returns at once, a larger one replaces the table; readers
+ * of the old one keep it until they release it.
+ */
+CY_STATE_FLAG cy_sieve_table_init(const uint64_t limit, const size_t nthreads)
+{
+    if(limit > ((uint64_t)1 << 32)) return cy_state_manager(CY_ERR_RANGE, __func__, ": table limited to 2^32");
+    CY_STATE_FLAG st = cy_sieve_tab_build(limit, nthreads);
+    if(st != CY_OK) return cy_state_manager(st, __func__, "");
+    return CY_OK;
+}
+
+// every successful call holds the table until the matching cy_sieve_table_release
+CY_STATE_FLAG cy_sieve_table(const uint32_t **primes, size_t *count)
+{
+    if(!primes || !count) return cy_state_manager(CY_ERR_ARG, __func__, ": bad arguments");
+    if(cy_sieve_take(0, primes, count) != CY_OK) return cy_state_manager(CY_ERR_STATE, __func__, ": cy_sieve_table_init first");
+    return CY_OK;
+}
+
+void cy_sieve_table_release(const uint32_t *primes)
+{
+    if(!primes) return;
+    pthread_mutex_lock(&cy_sieve_cache.lock);
+    if(cy_sieve_cache.cur && cy_sieve_cache.cur->prime == primes) cy_sieve_cache.cur->refs--;
+    else
+    {
+        for (CY_SIEVE_TAB **t = &cy_sieve_cache.retired; *t; t = &(*t)->next)
+        {
+            if((*t)->prime != primes) continue;
+            CY_SIEVE_TAB *r = *t;
+            if(!--r->refs) {*t = r->next; free(r->prime); free(r);}
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cy_sieve_cache.lock);
+}
+
+// drops the current table, its memory goes once the last reader releases it
+void cy_sieve_table_free(void)
+{
+    pthread_mutex_lock(&cy_sieve_cache.lock);
+    cy_sieve_tab_drop(cy_sieve_cache.cur);
+    cy_sieve_cache.cur = NULL;
+    pthread_mutex_unlock(&cy_sieve_cache.lock);
+}
+
+struct CY_SIEVE_ITER
+{
+    uint64_t lo, hi, pos;       // pos: next byte in the segment
+    uint8_t word;               // bits of pos - 1 still to hand out
+    uint64_t small;             // 2, 3, 5 still to hand out
+    uint32_t *base;
+    CY_SIEVE_SEG seg;
+};
+
+CY_STATE_FLAG cy_sieve_iter_init(const uint64_t lo, const uint64_t hi, CY_SIEVE_ITER **it)
+{
+    if(!it || lo > hi) return cy_state_manager(CY_ERR_ARG, __func__, ": bad arguments");
+    if(hi > CY_SIEVE_MAX) return cy_state_manager(CY_ERR_RANGE, __func__, ": sieve limited to 2^48");
+    CY_SIEVE_ITER *t = malloc(sizeof(*t));
+    if(!t) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    size_t nbase;
+    if(cy_sieve_base(hi, &t->base, &nbase) != CY_OK) {free(t); return cy_state_manager(CY_ERR_OOM, __func__, "");}
+    if(cy_sieve_seg_init(&t->seg, t->base, nbase, lo / 30) != CY_OK) {free(t->base); free(t); return cy_state_manager(CY_ERR_OOM, __func__, "");}
+    t->lo = lo; t->hi = hi; t->pos = 0; t->word = 0; t->small = 2;
+    t->seg.byte = lo / 30; t->seg.len = 0;
+    *it = t;
+    return CY_OK;
+}
+
+// next prime of the range in ascending order, CY_INFO_EOF past the end
+CY_STATE_FLAG cy_sieve_iter_next(CY_SIEVE_ITER *it, uint64_t *p)
+{
+    if(!it || !p) return cy_state_manager(CY_ERR_ARG, __func__, ": bad arguments");
+    for (; it->small <= 5; it->small += (it->small == 2 ? 1 : 2))
+    {
+        if(it->small >= it->lo && it->small < it->hi) {*p = it->small; it->small += (it->small == 2 ? 1 : 2); return CY_OK;}
+    }
+    for (;;)
+    {
+        if(it->word)
+        {
+            *p = 30 * (it->seg.byte + it->pos - 1) + CY_WHEEL[__builtin_ctz(it->word)];
+            it->word &= (uint8_t)(it->word - 1);
+            return CY_OK;
+        }
+        if(it->pos == it->seg.len)
+        {
+            const uint64_t byte = it->seg.byte + it->seg.len, end = (it->hi + 29) / 30;
+            if(byte >= end) return CY_INFO_EOF;
+            cy_sieve_seg_run(&it->seg, byte, end - byte < CY_SIEVE_SEG_BYTES ? end - byte : CY_SIEVE_SEG_BYTES);
+            cy_sieve_seg_clip(&it->seg, it->lo, it->hi);
+            it->pos = 0;
+        }
+        it->word = it->seg.bits[it->pos++];
+    }
+}
+
+void cy_sieve_iter_free(CY_SIEVE_ITER *it)
+{
+    if(!it) return;
+    cy_sieve_seg_free(&it->seg);
+    free(it->base);
+    free(it);
+}
+
+/*
+ * Primes of [lo, hi) for the library's own loops: read off the shared table
+ * while hi fits in it, sieved on the fly by an iterator beyond.
+ */
+typedef struct CY_PRIME_RUN
+{
+    const uint32_t *tab;
+    size_t i, n;
+    uint64_t hi;
+    CY_SIEVE_ITER *it;
+} CY_PRIME_RUN;
+
+static CY_STATE_FLAG cy_prime_run_init(CY_PRIME_RUN *r, const uint64_t lo, const uint64_t hi)
+{
+    memset(r, 0, sizeof(*r));
+    r->hi = hi;
+    if(hi <= ((uint64_t)1 << 32) && cy_sieve_hold(hi, &r->tab, &r->n) == CY_OK)
+    {
+        // first prime >= lo
+        size_t a = 0, b = r->n;
+        while (a < b) {const size_t m = a + (b - a) / 2; if(r->tab[m] < lo) a = m + 1; else b = m;}
+        r->i = a;
+        return CY_OK;
+    }
+    return cy_sieve_iter_init(lo, hi, &r->it);
+}
+
+static CY_STATE_FLAG cy_prime_run_next(CY_PRIME_RUN *r, uint64_t *p)
+{
+    if(!r->tab) return cy_sieve_iter_next(r->it, p);
+    if(r->i == r->n || r->tab[r->i] >= r->hi) return CY_INFO_EOF;
+    *p = r->tab[r->i++];
+    return CY_OK;
+}
+
+static void cy_prime_run_free(CY_PRIME_RUN *r)
+{
+    if(r->tab) cy_sieve_table_release(r->tab);
+    else cy_sieve_iter_free(r->it);
+    memset(r, 0, sizeof(*r));
+}
+
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                     Key Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+/*
+ * {exp, n} keys are plain malloc'd mpz_t[2] arrays, callers may still mpz_clear
+ * and free() them by hand. CRT private keys travel as CY_KEY so the element
+ * count always comes with the array.
+ */
+CY_STATE_FLAG cy_rsa_key_alloc(const size_t size, mpz_t **key)
+{
+    if(!key) return cy_state_manager(CY_ERR_ARG, __func__, ": key is NULL");
+    *key = NULL;
+    if(size < 2 || size > CY_RSA_PRV_SIZE(CY_RSA_MAX_PRIMES)) return cy_state_manager(CY_ERR_SIZE, __func__, ": not a key length");
+    *key = malloc(size * sizeof((*key)[0]));
+    if(!*key) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    for (size_t i = 0; i < size; i++) mpz_init((*key)[i]);
+    return CY_OK;
+}
+
+static CY_STATE_FLAG cy_rsa_prv_key_alloc(const uint8_t u, CY_KEY *prvkey)
+{
+    prvkey->size = 0;
+    if(cy_rsa_key_alloc(CY_RSA_PRV_SIZE(u), &prvkey->key) != CY_OK) return CY_ERR_OOM;
+    prvkey->size = CY_RSA_PRV_SIZE(u);
+    mpz_set_ui(prvkey->key[CY_RSA_PRV_U], u);
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_key_gen(const mp_bitcnt_t bitsize, mpz_t **pubkey, mpz_t **prvkey)
+{
+    mpz_t n, p, q, phi_n, e, d;
+    *pubkey = *prvkey = NULL;
+    if(cy_rsa_key_alloc(2, pubkey) != CY_OK || cy_rsa_key_alloc(2, prvkey) != CY_OK)
+    {cy_rsa_key_free(*pubkey); *pubkey = NULL; return CY_ERR_OOM;}
+    mpz_inits(n, p, q, phi_n, e, d, NULL);
+    cy_rsa_prime_prob_gen(bitsize, p);
+    cy_rsa_prime_prob_gen(bitsize, q);
+    mpz_mul(n, p, q);
+    mpz_sub_ui(p, p, 1);
+    mpz_sub_ui(q, q, 1);
+    mpz_mul(phi_n, p, q);
+    cy_rsa_prime_prob_gen(bitsize / 10, e);
+    if(EEA(e, phi_n, d) == CY_ERR)
+    {
+        mpz_clears(e, d, n, p, q, phi_n, NULL);
+        cy_rsa_key_free(*pubkey); cy_rsa_key_free(*prvkey);
+        *pubkey = *prvkey = NULL;
+        return CY_ERR;
+    }
+    mpz_set((*pubkey)[0], e); mpz_set((*pubkey)[1], n);
+    mpz_set((*prvkey)[0], d); mpz_set((*prvkey)[1], n);
+    mpz_clears(e, d, n, p, q, phi_n, NULL);
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_key_imp(const char *path, mpz_t **key)
+{
+    FILE *fp;
+    if(!key) return cy_state_manager(CY_ERR_ARG, __func__, ": key is NULL");
+    *key = NULL;
+    if(open_file(&fp, "rb", path) == CY_ERR) return CY_ERR;
+    if(cy_rsa_key_alloc(2, key) != CY_OK) {close_file(fp); return CY_ERR;}
+
+    int got = gmp_fscanf(fp, "%Zd\n%Zd", (*key)[0], (*key)[1]);
+    if(close_file(fp) == CY_ERR || got != 2)
+    {
+        cy_rsa_key_free(*key); *key = NULL;
+        return cy_state_manager(CY_ERR_FORMAT, __func__, ": not an {exp, n} key");
+    }
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_key_exp(const char *path, const mpz_t *key)
+{
+    FILE *fp;
+    if(open_file(&fp, "wb", path) == CY_ERR) return CY_ERR;
+    gmp_fprintf(fp, "%Zd\n%Zd", key[0], key[1]);
+    if(close_file(fp) == CY_ERR) return CY_ERR;
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_key_gen_mp(const mp_bitcnt_t bitsize, const uint8_t nprimes, mpz_t **pubkey, CY_KEY *prvkey)
+{
+    if(!pubkey || !prvkey) return cy_state_manager(CY_ERR_ARG, __func__, ": key is NULL");
+    if(nprimes < 2 || nprimes > CY_RSA_MAX_PRIMES) return cy_state_manager(CY_ERR_RANGE, __func__, ": 2 to 4 primes");
+    if(bitsize / nprimes < 64) return cy_state_manager(CY_ERR_KEY_SIZE, __func__, ": primes would be under 64 bits");
+
+    *pubkey = NULL; prvkey->key = NULL; prvkey->size = 0;
+    if(cy_rsa_key_alloc(2, pubkey) != CY_OK || cy_rsa_prv_key_alloc(nprimes, prvkey) != CY_OK)
+    {cy_rsa_key_free(*pubkey); *pubkey = NULL; return CY_ERR_OOM;}
+
+    mpz_t *k = prvkey->key, lambda, r1, acc;
+    mpz_inits(lambda, r1, acc, NULL);
+    mpz_set_ui(k[CY_RSA_PRV_E], 65537);
+
+    CY_STATE_FLAG st = CY_OK;
+    do
+    {
+        // r_1 takes the remainder bits so the sizes add up to bitsize
+        mpz_set_ui(k[1], 1); mpz_set_ui(lambda, 1);
+        for (uint8_t i = 0; i < nprimes && st == CY_OK; i++)
+        {
+            mp_bitcnt_t pbits = bitsize / nprimes + (i == 0 ? bitsize % nprimes : 0);
+            mpz_ptr r = k[CY_RSA_PRV_PRIME(i)];
+            int fresh = 0;
+            while (!fresh && st == CY_OK)
+            {
+                st = cy_rsa_prime_gen_exact(pbits, r);
+                mpz_sub_ui(r1, r, 1);
+                mpz_gcd(acc, r1, k[CY_RSA_PRV_E]);
+                fresh = !mpz_cmp_ui(acc, 1);
+                for (uint8_t j = 0; j < i && fresh; j++) fresh = mpz_cmp(r, k[CY_RSA_PRV_PRIME(j)]) != 0;
+            }
+            mpz_mul(k[1], k[1], r);
+            mpz_lcm(lambda, lambda, r1);
+        }
+    }
+    while(st == CY_OK && mpz_sizeinbase(k[1], 2) != bitsize);
+
+    if(st == CY_OK && EEA(k[CY_RSA_PRV_E], lambda, k[0]) != CY_OK) st = CY_ERR_KEY_VALUE;
+    if(st == CY_OK)
+    {
+        // Garner coefficients in the RFC 8017 order: r_2 first, then r_1, r_3, ...
+        mpz_set(acc, k[CY_RSA_PRV_PRIME(1)]);
+        for (uint8_t i = 0; i < nprimes && st == CY_OK; i++)
+        {
+            mpz_ptr r = k[CY_RSA_PRV_PRIME(i)];
+            mpz_sub_ui(r1, r, 1);
+            mpz_mod(k[CY_RSA_PRV_EXP(i)], k[0], r1);
+            if(i == 1) continue;
+            if(EEA(acc, r, k[CY_RSA_PRV_COEF(i == 0 ? 1 : i)]) != CY_OK) st = CY_ERR_KEY_VALUE;
+            if(i == 0) mpz_set_ui(k[CY_RSA_PRV_COEF(0)], 0);
+            mpz_mul(acc, acc, r);
+        }
+    }
+    mpz_clears(lambda, r1, acc, NULL);
+    if(st != CY_OK)
+    {
+        cy_rsa_key_free(*pubkey); cy_rsa_prv_key_free(prvkey);
+        *pubkey = NULL;
+        return cy_state_manager(st, __func__, ": multi-prime key generation failed");
+    }
+
+    mpz_set((*pubkey)[0], k[CY_RSA_PRV_E]); mpz_set((*pubkey)[1], k[1]);
+    return CY_OK;
+}
+
+// a CRT key must carry a sane prime count, callers check this before reading past {d, n}
+static CY_STATE_FLAG cy_rsa_prv_key_check(const CY_KEY *prvkey, uint8_t *u)
+{
+    if(!prvkey || !prvkey->key) return CY_ERR_ARG;
+    // the array length decides first, a plain {d, n} pair has no key[CY_RSA_PRV_U] to read
+    if(prvkey->size < CY_RSA_PRV_SIZE(2)) return CY_ERR_KEY_VALUE;
+    const mpz_t *k = prvkey->key;
+    if(mpz_cmp_ui(k[CY_RSA_PRV_U], 2) < 0 || mpz_cmp_ui(k[CY_RSA_PRV_U], CY_RSA_MAX_PRIMES) > 0 ||
+       CY_RSA_PRV_SIZE(mpz_get_ui(k[CY_RSA_PRV_U])) != prvkey->size)
+        return CY_ERR_KEY_VALUE;
+    *u = (uint8_t) mpz_get_ui(k[CY_RSA_PRV_U]);
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_prv_key_imp(const char *path, CY_KEY *prvkey)
+{
+    FILE *fp; mpz_t head[CY_RSA_PRV_SIZE(0)];
+    if(!prvkey) return cy_state_manager(CY_ERR_ARG, __func__, ": key is NULL");
+    prvkey->key = NULL; prvkey->size = 0;
+    if(open_file(&fp, "rb", path) == CY_ERR) return CY_ERR;
+
+    mpz_inits(head[0], head[1], head[2], head[3], NULL);
+    int got = gmp_fscanf(fp, "%Zd\n%Zd\n%Zd\n%Zd", head[0], head[1], head[2], head[3]);
+    if(got != 4 || mpz_cmp_ui(head[3], 2) < 0 || mpz_cmp_ui(head[3], CY_RSA_MAX_PRIMES) > 0)
+    {
+        mpz_clears(head[0], head[1], head[2], head[3], NULL);
+        close_file(fp);
+        return cy_state_manager(CY_ERR_FORMAT, __func__, ": not a CRT private key");
+    }
+
+    if(cy_rsa_prv_key_alloc((uint8_t)mpz_get_ui(head[3]), prvkey) != CY_OK)
+    {mpz_clears(head[0], head[1], head[2], head[3], NULL); close_file(fp); return CY_ERR_OOM;}
+    const size_t size = prvkey->size;
+    for (size_t i = 0; i < 4; i++) {mpz_swap(prvkey->key[i], head[i]); mpz_clear(head[i]);}
+
+    for (size_t i = 4; i < size; i++)
+        if(got == (int)i) got += gmp_fscanf(fp, "\n%Zd", prvkey->key[i]);
+    if(close_file(fp) == CY_ERR || got != (int)size)
+    {
+        cy_rsa_prv_key_free(prvkey);
+        return cy_state_manager(CY_ERR_FORMAT, __func__, ": truncated CRT private key");
+    }
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_prv_key_exp(const char *path, const CY_KEY *prvkey)
+{
+    FILE *fp; uint8_t u = 0;
+    if(cy_rsa_prv_key_check(prvkey, &u) != CY_OK) return cy_state_manager(CY_ERR_KEY, __func__, ": not a CRT private key");
+    if(open_file(&fp, "wb", path) == CY_ERR) return CY_ERR;
+    gmp_fprintf(fp, "%Zd\n%Zd", prvkey->key[0], prvkey->key[1]);
+    for (size_t i = 2; i < prvkey->size; i++) gmp_fprintf(fp, "\n%Zd", prvkey->key[i]);
+    if(close_file(fp) == CY_ERR) return CY_ERR;
+    return CY_OK;
+}
+
+void cy_rsa_prv_key_free(CY_KEY *prvkey)
+{
+    if(!prvkey || !prvkey->key) return;
+    for (size_t i = 0; i < prvkey->size; i++) mpz_clear(prvkey->key[i]);
+    free(prvkey->key);
+    prvkey->key = NULL; prvkey->size = 0;
+}
+
+CY_STATE_FLAG cy_aes_key_gen(__uint128_t *key)
+{
+    __uint128_t size = 0;
+    random_u128(17, &size);
+    if(random_u128_full(size, key) == CY_ERR) return cy_state_manager(CY_ERR_KEY, __func__, ": aes key generation failed");
+    *key *= size;
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_aes_key_imp(const char *path, __uint128_t *key)
+{
+    FILE *fp; uint8_t b[16]={0}; *key = 0;
+    if(open_file(&fp, "rb", path) == CY_ERR) return CY_ERR;
+    size_t size = fread(b, 1, 16, fp);
+    if(size == 0) return cy_state_manager(CY_ERR_IO, __func__, ": didnt read the key");
+    for (int i=0; i <16; i++) *key |= ((__uint128_t)(b[i]))<<(i * 8);
+    if(close_file(fp) == CY_ERR) return CY_ERR;
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_aes_key_exp(const char *path, __uint128_t key)
+{
+    FILE *fp; uint8_t b[16]={0};
+    if(open_file(&fp, "wb", path) == CY_ERR) return CY_ERR;
+    for (int i=0; i <16; i++) b[i] = (uint8_t)((key >> (i * 8)) & 0xFF);
+    fwrite(b, 1, 16, fp);
+    if(close_file(fp) == CY_ERR) return CY_ERR;
+    return CY_OK;
+}
+
+// {exp, n} pairs only, CRT keys go through cy_rsa_prv_key_free
+void cy_rsa_key_free(mpz_t *key)
+{
+    if(!key) return;
+    mpz_clears(key[0], key[1], NULL);
+    free(key);
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                   Key Pool Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+#define CY_RSA_POOL_MAX_SIZES 8
+#define CY_RSA_POOL_MAX_FAILS 8
+#define CY_RSA_POOL_MAGIC "CYPOOL02"
+
+typedef struct CY_RSA_POOL_SLOT
+{
+    mp_bitcnt_t bitsize;
+    size_t capacity, head, count, pending;
+    size_t spooled; // the oldest keys that are also in the last exported spool
+    uint64_t issued; // keys handed out so far, tells a spool export that the ring moved
+    mpz_t **pub, **prv; // ring of capacity keypairs, head is the oldest
+} CY_RSA_POOL_SLOT;
+
+struct CY_RSA_POOL
+{
+    pthread_mutex_t lock;
+    pthread_cond_t refill;
+    CY_RSA_POOL_SLOT slot[CY_RSA_POOL_MAX_SIZES];
+    size_t nslot;
+    pthread_t *thread;
+    size_t nthread, ndead; // ndead workers gave up after CY_RSA_POOL_MAX_FAILS
+    char *spool; // path of the last exported spool while it still matches the pool
+    int stop;
+};
+
+static CY_RSA_POOL_SLOT *cy_rsa_pool_slot(CY_RSA_POOL *pool, const mp_bitcnt_t bitsize)
+{
+    for (size_t i = 0; i < pool->nslot; i++)
+        if(pool->slot[i].bitsize == bitsize) return &pool->slot[i];
+    return NULL;
+}
+
+// caller holds pool->lock, returns CY_ERR_SPACE when the ring is already full
+static CY_STATE_FLAG cy_rsa_pool_push(CY_RSA_POOL_SLOT *slot, mpz_t *pubkey, mpz_t *prvkey)
+{
+    if(slot->count == slot->capacity) return CY_ERR_SPACE;
+    size_t tail = (slot->head + slot->count) % slot->capacity;
+    slot->pub[tail] = pubkey; slot->prv[tail] = prvkey;
+    slot->count++;
+    return CY_OK;
+}
+
+// caller holds pool->lock
+static void cy_rsa_pool_spool_drop(CY_RSA_POOL *pool)
+{
+    if(pool->spool) {remove(pool->spool); free(pool->spool); pool->spool = NULL;}
+    for (size_t i = 0; i < pool->nslot; i++) pool->slot[i].spooled = 0;
+}
+
+static void *cy_rsa_pool_worker(void *arg)
+{
+    CY_RSA_POOL *pool = arg;
+
+#if !defined(_WIN32)
+    // idle priority: on Linux the nice value only applies to the calling thread
+    setpriority(PRIO_PROCESS, 0, 19);
+#endif
+
+    unsigned fails = 0;
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->stop)
+    {
+        CY_RSA_POOL_SLOT *slot = NULL;
+        for (size_t i = 0; i < pool->nslot && !slot; i++)
+            if(pool->slot[i].count + pool->slot[i].pending < pool->slot[i].capacity) slot = &pool->slot[i];
+        if(!slot) {pthread_cond_wait(&pool->refill, &pool->lock); continue;}
+
+        slot->pending++;
+        mp_bitcnt_t bitsize = slot->bitsize;
+        pthread_mutex_unlock(&pool->lock);
+
+        mpz_t *pubkey = NULL, *prvkey = NULL;
+        CY_STATE_FLAG st = cy_rsa_key_gen(bitsize, &pubkey, &prvkey);
+
+        pthread_mutex_lock(&pool->lock);
+        slot->pending--;
+        if(st != CY_OK)
+        {
+            // back off 20 ms, 40 ms, ... and give up on a generator that keeps failing
+            if(++fails == CY_RSA_POOL_MAX_FAILS) {pool->ndead++; break;}
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            long ms = 10L << fails;
+            ts.tv_sec += ms / 1000; ts.tv_nsec += (ms % 1000) * 1000000L;
+            if(ts.tv_nsec >= 1000000000L) {ts.tv_sec++; ts.tv_nsec -= 1000000000L;}
+            if(!pool->stop) pthread_cond_timedwait(&pool->refill, &pool->lock, &ts);
+            continue;
+        }
+        fails = 0;
+        if(pool->stop || cy_rsa_pool_push(slot, pubkey, prvkey) != CY_OK)
+        {cy_rsa_key_free(pubkey); cy_rsa_key_free(prvkey);}
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+CY_STATE_FLAG cy_rsa_pool_init(const size_t nthreads, CY_RSA_POOL **pool)
+{
+    if(!pool) return cy_state_manager(CY_ERR_ARG, __func__, ": pool is NULL");
+    if(!nthreads) return cy_state_manager(CY_ERR_ARG, __func__, ": need at least one refill thread");
+
+    *pool = calloc(1, sizeof(**pool));
+    if(!*pool) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    (*pool)->thread = calloc(nthreads, sizeof((*pool)->thread[0]));
+    if(!(*pool)->thread) {free(*pool); *pool = NULL; return cy_state_manager(CY_ERR_OOM, __func__, "");}
+
+    pthread_mutex_init(&(*pool)->lock, NULL);
+    pthread_cond_init(&(*pool)->refill, NULL);
+    for (size_t i = 0; i < nthreads; i++)
+    {
+        if(pthread_create(&(*pool)->thread[i], NULL, cy_rsa_pool_worker, *pool) != 0)
+        {
+            cy_rsa_pool_free(*pool); *pool = NULL;
+            return cy_state_manager(CY_ERR_INTERNAL, __func__, ": pthread_create failed");
+        }
+        (*pool)->nthread++;
+    }
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_pool_add(CY_RSA_POOL *pool, const mp_bitcnt_t bitsize, const size_t capacity)
+{
+    if(!pool) return cy_state_manager(CY_ERR_ARG, __func__, ": pool is NULL");
+    if(!capacity) return cy_state_manager(CY_ERR_SIZE, __func__, ": capacity is 0");
+
+    pthread_mutex_lock(&pool->lock);
+    if(cy_rsa_pool_slot(pool, bitsize))
+    {pthread_mutex_unlock(&pool->lock); return cy_state_manager(CY_ERR_STATE, __func__, ": bitsize already pooled");}
+    if(pool->nslot == CY_RSA_POOL_MAX_SIZES)
+    {pthread_mutex_unlock(&pool->lock); return cy_state_manager(CY_ERR_SPACE, __func__, ": too many bitsizes");}
+
+    CY_RSA_POOL_SLOT *slot = &pool->slot[pool->nslot];
+    memset(slot, 0, sizeof(*slot));
+    slot->pub = calloc(capacity, sizeof(slot->pub[0]));
+    slot->prv = calloc(capacity, sizeof(slot->prv[0]));
+    if(!slot->pub || !slot->prv)
+    {
+        free(slot->pub); free(slot->prv);
+        pthread_mutex_unlock(&pool->lock);
+        return cy_state_manager(CY_ERR_OOM, __func__, "");
+    }
+    slot->bitsize = bitsize; slot->capacity = capacity;
+    pool->nslot++;
+    pthread_cond_broadcast(&pool->refill);
+    pthread_mutex_unlock(&pool->lock);
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_pool_key_gen(CY_RSA_POOL *pool, const mp_bitcnt_t bitsize, mpz_t **pubkey, mpz_t **prvkey)
+{
+    if(!pool) return cy_state_manager(CY_ERR_ARG, __func__, ": pool is NULL");
+    if(!pubkey || !prvkey) return cy_state_manager(CY_ERR_ARG, __func__, ": key is NULL");
+
+    pthread_mutex_lock(&pool->lock);
+    CY_RSA_POOL_SLOT *slot = cy_rsa_pool_slot(pool, bitsize);
+    if(slot && slot->count)
+    {
+        *pubkey = slot->pub[slot->head]; *prvkey = slot->prv[slot->head];
+        slot->pub[slot->head] = slot->prv[slot->head] = NULL;
+        slot->head = (slot->head + 1) % slot->capacity;
+        slot->count--; slot->issued++;
+        // a spooled key is leaving the pool: drop the spool so it cannot come back on the next start
+        if(slot->spooled) cy_rsa_pool_spool_drop(pool);
+        pthread_cond_signal(&pool->refill);
+        pthread_mutex_unlock(&pool->lock);
+        return CY_OK;
+    }
+    size_t ndead = pool->ndead;
+    pthread_mutex_unlock(&pool->lock);
+
+    if(slot && ndead == pool->nthread)
+        return cy_state_manager(CY_ERR_INTERNAL, __func__, ": every refill worker gave up");
+    // pool miss (empty or bitsize not pooled): pay the generation on the caller
+    return cy_rsa_key_gen(bitsize, pubkey, prvkey);
+}
+
+CY_STATE_FLAG cy_rsa_pool_state(CY_RSA_POOL *pool)
+{
+    if(!pool) return cy_state_manager(CY_ERR_ARG, __func__, ": pool is NULL");
+
+    pthread_mutex_lock(&pool->lock);
+    size_t ndead = pool->ndead;
+    pthread_mutex_unlock(&pool->lock);
+    if(ndead) return cy_state_manager(CY_ERR_INTERNAL, __func__, ": a refill worker gave up after repeated failures");
+    return CY_OK;
+}
+
+static CY_STATE_FLAG cy_spool_put(uint8_t **buff, size_t *size, size_t *cap, const void *src, const size_t len)
+{
+    if(*size + len > *cap)
+    {
+        size_t ncap = (*cap ? *cap : 4096);
+        while (ncap < *size + len) ncap *= 2;
+        // no realloc: the old block holds key material and is wiped before it goes back
+        uint8_t *tmp = malloc(ncap);
+        if(!tmp) return CY_ERR_OOM;
+        if(*buff) {memcpy(tmp, *buff, *size); cy_wipe(*buff, *cap); free(*buff);}
+        *buff = tmp; *cap = ncap;
+    }
+    memcpy(*buff + *size, src, len);
+    *size += len;
+    return CY_OK;
+}
+
+static void cy_spool_u64_exp(const uint64_t v, uint8_t b[8])
+{
+    for (size_t i = 0; i < 8; i++) b[7 - i] = (uint8_t)(v >> (i * 8));
+}
+
+static uint64_t cy_spool_u64_imp(const uint8_t b[8])
+{
+    uint64_t v = 0;
+    for (size_t i = 0; i < 8; i++) v |= (uint64_t)b[7 - i] << (i * 8);
+    return v;
+}
+
+static CY_STATE_FLAG cy_spool_put_mpz(uint8_t **buff, size_t *size, size_t *cap, mpz_srcptr z)
+{
+    size_t len = mpz_sgn(z) ? (mpz_sizeinbase(z, 2) + 7) / 8 : 0;
+    uint8_t b[8]; cy_spool_u64_exp(len, b);
+    if(cy_spool_put(buff, size, cap, b, 8) != CY_OK) return CY_ERR_OOM;
+    uint8_t *tmp = malloc(len ? len : 1);
+    if(!tmp) return CY_ERR_OOM;
+    size_t written = 0;
+    mpz_export(tmp, &written, 1, 1, 1, 0, z);
+    CY_STATE_FLAG st = cy_spool_put(buff, size, cap, tmp, written);
+    cy_wipe(tmp, len ? len : 1);
+    free(tmp);
+    return st;
+}
+
+static CY_STATE_FLAG cy_spool_get_mpz(const uint8_t *buff, const size_t size, size_t *off, mpz_ptr z)
+{
+    if(*off + 8 > size) return CY_ERR_FORMAT;
+    uint64_t len = cy_spool_u64_imp(buff + *off); *off += 8;
+    if(len > size - *off) return CY_ERR_FORMAT;
+    mpz_import(z, len, 1, 1, 1, 0, buff + *off); *off += len;
+    return CY_OK;
+}
+
+// encrypt-then-MAC: HMAC-SHA-256 over IV and ciphertext under a key derived from the AES key
+static CY_STATE_FLAG cy_spool_mac(const __uint128_t key, const uint8_t *buff, const size_t size, uint8_t tag[32])
+{
+    static const uint8_t info[] = "cypher rsa pool spool mac";
+    uint8_t ikm[16], prk[32], mk[32];
+    CY_HMAC_KEY hk;
+    for (size_t i = 0; i < 16; i++) ikm[i] = (uint8_t)(key >> (i * 8));
+    CY_STATE_FLAG st = cy_hkdf_extract(NULL, 0, ikm, sizeof(ikm), prk);
+    if(st == CY_OK) st = cy_hkdf_expand(prk, info, sizeof(info) - 1, mk, sizeof(mk));
+    if(st == CY_OK) st = cy_hmac_key_init(&hk, mk, sizeof(mk));
+    if(st == CY_OK) cy_hmac_sha256(&hk, buff, size, tag);
+    cy_wipe(ikm, sizeof(ikm)); cy_wipe(prk, sizeof(prk)); cy_wipe(mk, sizeof(mk)); cy_wipe(&hk, sizeof(hk));
+    return st;
+}
+
+// AES-128 in counter mode over the spool body, the first 16 bytes are the IV
+static void cy_spool_ctr(const __uint128_t key, const __uint128_t iv, uint8_t *buff, const size_t size)
+{
+    for (size_t off = 0, i = 0; off < size; off += 16, i++)
+    {
+        __uint128_t stream = 0;
+        cy_aes_encryption(iv + i, key, &stream);
+        for (size_t j = 0; j < 16 && off + j < size; j++) buff[off + j] ^= (uint8_t)(stream >> (j * 8));
+    }
+}
+
+CY_STATE_FLAG cy_rsa_pool_spool_exp(CY_RSA_POOL *pool, const char *path, const __uint128_t key)
+{
+    if(!pool) return cy_state_manager(CY_ERR_ARG, __func__, ": pool is NULL");
+
+    uint8_t *buff = NULL; size_t size = 0, cap = 0; uint8_t b[16];
+    __uint128_t iv = 0;
+    if(random_u128_full(sizeof(iv), &iv) == CY_ERR) return cy_state_manager(CY_ERR_RNG, __func__, "");
+    for (size_t i = 0; i < 16; i++) b[i] = (uint8_t)(iv >> (i * 8));
+    CY_STATE_FLAG st = cy_spool_put(&buff, &size, &cap, b, 16);
+    if(st == CY_OK) st = cy_spool_put(&buff, &size, &cap, CY_RSA_POOL_MAGIC, 8);
+
+    pthread_mutex_lock(&pool->lock);
+    for (size_t i = 0; i < pool->nslot && st == CY_OK; i++)
+    {
+        CY_RSA_POOL_SLOT *slot = &pool->slot[i];
+        for (size_t k = 0; k < slot->count && st == CY_OK; k++)
+        {
+            size_t at = (slot->head + k) % slot->capacity;
+            cy_spool_u64_exp(slot->bitsize, b);
+            st = cy_spool_put(&buff, &size, &cap, b, 8);
+            if(st == CY_OK) st = cy_spool_put_mpz(&buff, &size, &cap, slot->pub[at][0]);
+            if(st == CY_OK) st = cy_spool_put_mpz(&buff, &size, &cap, slot->pub[at][1]);
+            if(st == CY_OK) st = cy_spool_put_mpz(&buff, &size, &cap, slot->prv[at][0]);
+        }
+    }
+    // the keys stay pooled, the spool is only valid until one of them is handed out
+    size_t spooled[CY_RSA_POOL_MAX_SIZES] = {0}, nslot = pool->nslot;
+    uint64_t issued[CY_RSA_POOL_MAX_SIZES] = {0};
+    for (size_t i = 0; i < nslot; i++) {spooled[i] = pool->slot[i].count; issued[i] = pool->slot[i].issued;}
+    pthread_mutex_unlock(&pool->lock);
+    if(st != CY_OK) {cy_wipe(buff, cap); free(buff); return cy_state_manager(st, __func__, ": spool serialization failed");}
+
+    cy_spool_ctr(key, iv, buff + 16, size - 16);
+    uint8_t tag[32];
+    st = cy_spool_mac(key, buff, size, tag);
+    if(st == CY_OK) st = cy_spool_put(&buff, &size, &cap, tag, sizeof(tag));
+    if(st != CY_OK) {free(buff); return cy_state_manager(st, __func__, ": spool authentication failed");}
+
+    char *owned = malloc(strlen(path) + 1);
+    if(!owned) {free(buff); return cy_state_manager(CY_ERR_OOM, __func__, "");}
+    strcpy(owned, path);
+
+    FILE *fp;
+    if(open_file(&fp, "wb", path) == CY_ERR) {free(owned); free(buff); return CY_ERR;}
+    size_t n = fwrite(buff, 1, size, fp);
+    free(buff);
+    if(close_file(fp) == CY_ERR || n != size)
+    {remove(path); free(owned); return cy_state_manager(CY_ERR_IO, __func__, ": short write");}
+
+    // keys handed out between the snapshot and now are still in the file, it is stale already
+    pthread_mutex_lock(&pool->lock);
+    int stale = 0;
+    for (size_t i = 0; i < nslot; i++) stale |= pool->slot[i].issued != issued[i];
+    if(!stale)
+    {
+        // an older spool at another path is superseded, the keys it shares with this one must not come back twice
+        if(pool->spool && strcmp(pool->spool, path)) remove(pool->spool);
+        free(pool->spool);
+        pool->spool = owned; owned = NULL;
+        for (size_t i = 0; i < nslot; i++) pool->slot[i].spooled = spooled[i];
+    }
+    else {remove(path); cy_rsa_pool_spool_drop(pool);}
+    pthread_mutex_unlock(&pool->lock);
+    free(owned);
+    if(stale) return cy_state_manager(CY_ERR_STATE, __func__, ": pool changed while spooling, retry");
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_pool_spool_imp(CY_RSA_POOL *pool, const char *path, const __uint128_t key)
+{
+    if(!pool) return cy_state_manager(CY_ERR_ARG, __func__, ": pool is NULL");
+
+    FILE *fp;
+    if(open_file(&fp, "rb", path) == CY_ERR) return CY_ERR;
+    if(_fseeki64(fp, 0, SEEK_END) != 0) {close_file(fp); return cy_state_manager(CY_ERR_IO, __func__, ": seek failed");}
+    __int64_t fsize = _ftelli64(fp);
+    rewind(fp);
+    if(fsize < 24 + 32) {close_file(fp); return cy_state_manager(CY_ERR_FORMAT, __func__, ": spool too short");}
+
+    size_t size = (size_t)fsize;
+    uint8_t *buff = malloc(size);
+    if(!buff) {close_file(fp); return cy_state_manager(CY_ERR_OOM, __func__, "");}
+    size_t got = fread(buff, 1, size, fp);
+    if(close_file(fp) == CY_ERR || got != size) {free(buff); return cy_state_manager(CY_ERR_IO, __func__, ": short read");}
+
+    // nothing is decrypted or parsed before the tag checks out
+    uint8_t tag[32], diff = 0;
+    size -= sizeof(tag);
+    if(cy_spool_mac(key, buff, size, tag) != CY_OK) {free(buff); return cy_state_manager(CY_ERR, __func__, ": spool authentication failed");}
+    for (size_t i = 0; i < sizeof(tag); i++) diff |= tag[i] ^ buff[size + i];
+    if(diff) {free(buff); return cy_state_manager(CY_ERR_KEY, __func__, ": wrong spool key or corrupted spool");}
+
+    __uint128_t iv = 0;
+    for (size_t i = 0; i < 16; i++) iv |= (__uint128_t)buff[i] << (i * 8);
+    cy_spool_ctr(key, iv, buff + 16, size - 16);
+    if(memcmp(buff + 16, CY_RSA_POOL_MAGIC, 8))
+    {cy_wipe(buff, size); free(buff); return cy_state_manager(CY_ERR_FORMAT, __func__, ": unknown spool version");}
+
+    // first pass only counts and validates, nothing reaches the pool from a spool that does not parse
+    CY_STATE_FLAG st = CY_OK;
+    size_t off = 24, count = 0;
+    mpz_t e, n, d; mpz_inits(e, n, d, NULL);
+    while (off < size && st == CY_OK)
+    {
+        if(off + 8 > size) {st = CY_ERR_FORMAT; break;}
+        off += 8;
+        st = cy_spool_get_mpz(buff, size, &off, e);
+        if(st == CY_OK) st = cy_spool_get_mpz(buff, size, &off, n);
+        if(st == CY_OK) st = cy_spool_get_mpz(buff, size, &off, d);
+        if(st == CY_OK) count++;
+    }
+    mpz_clears(e, n, d, NULL);
+
+    mp_bitcnt_t *bits = NULL; mpz_t **pub = NULL, **prv = NULL;
+    if(st == CY_OK && count)
+    {
+        bits = malloc(count * sizeof(bits[0]));
+        pub = calloc(count, sizeof(pub[0])); prv = calloc(count, sizeof(prv[0]));
+        if(!bits || !pub || !prv) st = CY_ERR_OOM;
+    }
+    off = 24;
+    for (size_t i = 0; i < count && st == CY_OK; i++)
+    {
+        bits[i] = (mp_bitcnt_t)cy_spool_u64_imp(buff + off); off += 8;
+        if(cy_rsa_key_alloc(2, &pub[i]) != CY_OK || cy_rsa_key_alloc(2, &prv[i]) != CY_OK) {st = CY_ERR_OOM; break;}
+        cy_spool_get_mpz(buff, size, &off, pub[i][0]);
+        cy_spool_get_mpz(buff, size, &off, pub[i][1]);
+        cy_spool_get_mpz(buff, size, &off, prv[i][0]);
+        mpz_set(prv[i][1], pub[i][1]);
+    }
+    cy_wipe(buff, size);
+    free(buff);
+
+    // the spooled keys now live in memory only, never hand the same key out twice
+    if(st == CY_OK && remove(path) != 0) st = CY_ERR_IO;
+    if(st == CY_OK)
+    {
+        pthread_mutex_lock(&pool->lock);
+        for (size_t i = 0; i < count; i++)
+        {
+            CY_RSA_POOL_SLOT *slot = cy_rsa_pool_slot(pool, bits[i]);
+            if(slot && cy_rsa_pool_push(slot, pub[i], prv[i]) == CY_OK) pub[i] = prv[i] = NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    for (size_t i = 0; pub && i < count; i++) {cy_rsa_key_free(pub[i]); cy_rsa_key_free(prv[i]);}
+    free(bits); free(pub); free(prv);
+    if(st == CY_ERR_IO) return cy_state_manager(st, __func__, ": could not consume spool");
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": spool parse failed");
+    return CY_OK;
+}
+
+void cy_rsa_pool_free(CY_RSA_POOL *pool)
+{
+    if(!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->refill);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 0; i < pool->nthread; i++) pthread_join(pool->thread[i], NULL);
+
+    for (size_t i = 0; i < pool->nslot; i++)
+    {
+        CY_RSA_POOL_SLOT *slot = &pool->slot[i];
+        for (size_t k = 0; k < slot->count; k++)
+        {
+            size_t at = (slot->head + k) % slot->capacity;
+            cy_rsa_key_free(slot->pub[at]); cy_rsa_key_free(slot->prv[at]);
+        }
+        free(slot->pub); free(slot->prv);
+    }
+    pthread_cond_destroy(&pool->refill);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->spool);
+    free(pool->thread);
+    free(pool);
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                    Cypher Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+void cy_rsa_encryption(const uint8_t c, const mpz_t *key, mpz_ptr cy_msg)
+{
+    mpz_set_ui(cy_msg, c);
+    mpz_powm(cy_msg, cy_msg, key[0], key[1]);
+}
+
+void cy_rsa_decryption(const mpz_srcptr cy_msg, const mpz_t *key, uint8_t *c)
+{
+    mpz_t out; mpz_init(out);
+    mpz_powm(out, cy_msg, key[0], key[1]);
+    *c = (uint8_t) mpz_get_ui(out);
+    mpz_clear(out);
+}
+
+// Garner recombination of m_i = c^x_i mod r_i, r_2 first as RFC 8017 does,
+// x_i = d_i or, when root is set, root^-1 mod (r_i - 1)
+static CY_STATE_FLAG cy_rsa_crt_exp(const mpz_srcptr in, const CY_KEY *key, mpz_srcptr root, mpz_ptr out)
+{
+    uint8_t u = 0;
+    if(cy_rsa_prv_key_check(key, &u) != CY_OK) return CY_ERR_KEY;
+    const mpz_t *prvkey = key->key;
+
+    CY_STATE_FLAG st = CY_OK;
+    mpz_t m, mi, h, R, x; mpz_inits(m, mi, h, R, x, NULL);
+    for (uint8_t k = 0; k < u && st == CY_OK; k++)
+    {
+        uint8_t i = k == 0 ? 1 : k == 1 ? 0 : k;
+        mpz_srcptr r = prvkey[CY_RSA_PRV_PRIME(i)];
+        if(root)
+        {
+            mpz_sub_ui(h, r, 1);
+            if(!mpz_invert(x, root, h)) {st = CY_ERR_KEY_VALUE; break;}
+        }
+        else mpz_set(x, prvkey[CY_RSA_PRV_EXP(i)]);
+        // mpz_powm_sec wants an odd modulus and a positive exponent
+        if(mpz_sgn(x) <= 0 || mpz_even_p(r)) {st = CY_ERR_KEY_VALUE; break;}
+
+        mpz_mod(h, in, r);
+        mpz_powm_sec(k ? mi : m, h, x, r);
+        if(!k) {mpz_set(R, r); continue;}
+        mpz_sub(h, mi, m);
+        mpz_mul(h, h, prvkey[CY_RSA_PRV_COEF(i == 0 ? 1 : i)]);
+        mpz_mod(h, h, r);
+        mpz_addmul(m, R, h);
+        mpz_mul(R, R, r);
+    }
+    if(st == CY_OK) mpz_swap(out, m);
+    mpz_clears(m, mi, h, R, x, NULL);
+    return st;
+}
+
+CY_STATE_FLAG cy_rsa_crt_powm(const mpz_srcptr in, const CY_KEY *prvkey, mpz_ptr out)
+{
+    CY_STATE_FLAG st = cy_rsa_crt_exp(in, prvkey, NULL, out);
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": not a CRT private key");
+    return CY_OK;
+}
+
+void cy_rsa_crt_decryption(const mpz_srcptr cy_msg, const CY_KEY *prvkey, uint8_t *c)
+{
+    mpz_t out; mpz_init(out);
+    if(cy_rsa_crt_powm(cy_msg, prvkey, out) == CY_OK) *c = (uint8_t) mpz_get_ui(out);
+    mpz_clear(out);
+}
+
+// Fiat's batching needs one modulus, distinct pairwise coprime exponents and units as inputs
+static int cy_rsa_batch_ready(const size_t count, const mpz_srcptr in[], const CY_KEY *prvkey[])
+{
+    uint8_t u = 0;
+    if(count < 2) return 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if(cy_rsa_prv_key_check(prvkey[i], &u) != CY_OK) return 0;
+        if(mpz_cmp(prvkey[i]->key[1], prvkey[0]->key[1])) return 0;
+        if(!mpz_fits_ulong_p(prvkey[i]->key[CY_RSA_PRV_E]) || mpz_cmp_ui(prvkey[i]->key[CY_RSA_PRV_E], 3) < 0) return 0;
+        if(mpz_sgn(in[i]) <= 0 || mpz_cmp(in[i], prvkey[0]->key[1]) >= 0) return 0;
+    }
+
+    int ready = 1;
+    mpz_t g; mpz_init(g);
+    for (size_t i = 0; i < count && ready; i++)
+    {
+        mpz_gcd(g, in[i], prvkey[0]->key[1]);
+        ready = !mpz_cmp_ui(g, 1);
+        for (size_t j = i + 1; j < count && ready; j++)
+        {
+            mpz_gcd(g, prvkey[i]->key[CY_RSA_PRV_E], prvkey[j]->key[CY_RSA_PRV_E]);
+            ready = !mpz_cmp_ui(g, 1);
+        }
+    }
+    mpz_clear(g);
+    return ready;
+}
+
+// one CRT exponentiation per item, result[i] says which outputs hold a value
+static CY_STATE_FLAG cy_rsa_batch_each(const size_t count, const mpz_srcptr in[], const CY_KEY *prvkey[], mpz_ptr out[], CY_STATE_FLAG result[])
+{
+    CY_STATE_FLAG st = CY_OK;
+    for (size_t i = 0; i < count; i++)
+    {
+        result[i] = cy_rsa_crt_exp(in[i], prvkey[i], NULL, out[i]);
+        if(result[i] != CY_OK) st = CY_ERR_VALUE;
+    }
+    return st;
+}
+
+static CY_STATE_FLAG cy_rsa_batch_fiat(const size_t count, const mpz_srcptr in[], const CY_KEY *prvkey[], mpz_ptr out[])
+{
+    // product tree: level 0 holds the leaves, a lone node at the end of a level is carried up
+    size_t nlevel = 1;
+    for (size_t w = count; w > 1; w = (w + 1) / 2) nlevel++;
+    size_t *width = calloc(nlevel, sizeof(width[0]));
+    mpz_t **e = calloc(nlevel, sizeof(e[0])), **v = calloc(nlevel, sizeof(v[0]));
+    if(!width || !e || !v) {free(width); free(e); free(v); return cy_state_manager(CY_ERR_OOM, __func__, "");}
+
+    CY_STATE_FLAG st = CY_OK;
+    mpz_srcptr n = prvkey[0]->key[1];
+    mpz_t X, y, z; mpz_inits(X, y, z, NULL);
+    width[0] = count;
+    for (size_t l = 1; l < nlevel; l++) width[l] = (width[l - 1] + 1) / 2;
+    for (size_t l = 0; l < nlevel && st == CY_OK; l++)
+    {
+        e[l] = malloc(width[l] * sizeof(e[l][0]));
+        v[l] = malloc(width[l] * sizeof(v[l][0]));
+        if(!e[l] || !v[l]) {st = CY_ERR_OOM; width[l] = 0; break;}
+        for (size_t j = 0; j < width[l]; j++) mpz_inits(e[l][j], v[l][j], NULL);
+    }
+    for (size_t l = 0; l < nlevel && st == CY_OK; l++)
+    {
+        for (size_t j = 0; j < width[l]; j++)
+        {
+            if(!l) {mpz_set(e[0][j], prvkey[j]->key[CY_RSA_PRV_E]); mpz_set(v[0][j], in[j]); continue;}
+            size_t a = 2 * j, b = 2 * j + 1;
+            if(b == width[l - 1]) {mpz_set(e[l][j], e[l - 1][a]); mpz_set(v[l][j], v[l - 1][a]); continue;}
+            // v = v_a^e_b * v_b^e_a, so v^(1 / (e_a e_b)) = v_a^(1 / e_a) * v_b^(1 / e_b)
+            mpz_mul(e[l][j], e[l - 1][a], e[l - 1][b]);
+            mpz_powm(v[l][j], v[l - 1][a], e[l - 1][b], n);
+            mpz_powm(z, v[l - 1][b], e[l - 1][a], n);
+            mpz_mul(v[l][j], v[l][j], z);
+            mpz_mod(v[l][j], v[l][j], n);
+        }
+    }
+
+    // the only full size exponentiation of the batch
+    if(st == CY_OK) st = cy_rsa_crt_exp(v[nlevel - 1][0], prvkey[0], e[nlevel - 1][0], v[nlevel - 1][0]);
+
+    // per level the two inversions mod n of every node go through one batch inversion each
+    mpz_t *Xs = malloc(width[0] * sizeof(Xs[0])), *ys = malloc(width[0] * sizeof(ys[0]));
+    mpz_ptr *yp = malloc(width[0] * sizeof(yp[0]));
+    if(!Xs || !ys || !yp) {free(Xs); free(ys); free(yp); Xs = ys = NULL; yp = NULL; if(st == CY_OK) st = CY_ERR_OOM;}
+    else for (size_t j = 0; j < width[0]; j++) {mpz_inits(Xs[j], ys[j], NULL); yp[j] = ys[j];}
+
+    for (size_t l = nlevel - 1; l > 0 && st == CY_OK; l--)
+    {
+        const size_t pairs = width[l - 1] / 2;
+        for (size_t j = 0; j < pairs; j++)
+        {
+            size_t a = 2 * j, b = 2 * j + 1;
+            // X = 0 mod e_a, X = 1 mod e_b, then r^X = v_a^(X / e_a) * v_b^((X - 1) / e_b) * r_b
+            mpz_invert(X, e[l - 1][a], e[l - 1][b]);
+            mpz_mul(Xs[j], X, e[l - 1][a]);
+            mpz_powm(y, v[l - 1][a], X, n);
+            mpz_sub_ui(z, Xs[j], 1);
+            mpz_divexact(z, z, e[l - 1][b]);
+            mpz_powm(z, v[l - 1][b], z, n);
+            mpz_mul(ys[j], y, z);
+        }
+        if(pairs && cy_mpz_inv_batch(pairs, (const mpz_srcptr *)yp, n, yp) != CY_OK) {st = CY_ERR_INTERNAL; break;}
+        for (size_t j = 0; j < pairs; j++)
+        {
+            mpz_powm(z, v[l][j], Xs[j], n);
+            mpz_mul(z, z, ys[j]);
+            mpz_mod(v[l - 1][2 * j + 1], z, n);
+            mpz_set(ys[j], v[l - 1][2 * j + 1]);
+        }
+        if(pairs && cy_mpz_inv_batch(pairs, (const mpz_srcptr *)yp, n, yp) != CY_OK) {st = CY_ERR_INTERNAL; break;}
+        for (size_t j = 0; j < pairs; j++)
+        {
+            mpz_mul(z, ys[j], v[l][j]);
+            mpz_mod(v[l - 1][2 * j], z, n);
+        }
+        if(width[l - 1] & 1) mpz_set(v[l - 1][width[l - 1] - 1], v[l][width[l] - 1]);
+    }
+    if(Xs) for (size_t j = 0; j < width[0]; j++) mpz_clears(Xs[j], ys[j], NULL);
+    free(Xs); free(ys); free(yp);
+    mpz_clears(X, y, z, NULL);
+
+    for (size_t j = 0; j < count && st == CY_OK; j++) mpz_set(out[j], v[0][j]);
+    for (size_t l = 0; l < nlevel; l++)
+    {
+        for (size_t j = 0; j < width[l]; j++) mpz_clears(e[l][j], v[l][j], NULL);
+        free(e[l]); free(v[l]);
+    }
+    free(width); free(e); free(v);
+    return st;
+}
+
+CY_STATE_FLAG cy_rsa_batch_powm(const size_t count, const mpz_srcptr in[], const CY_KEY *prvkey[], mpz_ptr out[], CY_STATE_FLAG result[])
+{
+    if(!in || !prvkey || !out || !result) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL array");
+
+    // a batch Fiat cannot take, or one it fails on, is done item by item
+    if(cy_rsa_batch_ready(count, in, prvkey) && cy_rsa_batch_fiat(count, in, prvkey, out) == CY_OK)
+    {
+        for (size_t i = 0; i < count; i++) result[i] = CY_OK;
+        return CY_OK;
+    }
+    if(cy_rsa_batch_each(count, in, prvkey, out, result) != CY_OK)
+        return cy_state_manager(CY_ERR_VALUE, __func__, ": an item's key is not a CRT private key, see result[]");
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_batch_decryption(const size_t count, const mpz_srcptr cy_msg[], const CY_KEY *prvkey[], uint8_t c[], CY_STATE_FLAG result[])
+{
+    mpz_t *out = malloc((count ? count : 1) * sizeof(out[0]));
+    mpz_ptr *outp = malloc((count ? count : 1) * sizeof(outp[0]));
+    if(!out || !outp) {free(out); free(outp); return cy_state_manager(CY_ERR_OOM, __func__, "");}
+    for (size_t i = 0; i < count; i++) {mpz_init(out[i]); outp[i] = out[i];}
+
+    CY_STATE_FLAG st = cy_rsa_batch_powm(count, cy_msg, prvkey, outp, result);
+    for (size_t i = 0; i < count; i++)
+    {
+        if(result && result[i] == CY_OK) c[i] = (uint8_t) mpz_get_ui(out[i]);
+        mpz_clear(out[i]);
+    }
+    free(out); free(outp);
+    return st;
+}
+
+void cy_aes_sched_init(const __uint128_t key, CY_AES_SCHED *sched)
+{
+    cy_aes_key_expansion(key, sched->w);
+}
+
+void cy_aes_encryption(__uint128_t msg, __uint128_t key, __uint128_t *cy_msg)
+{
+    CY_AES_SCHED sched;
+    cy_aes_sched_init(key, &sched);
+    cy_aes_sched_encryption(msg, &sched, cy_msg);
+}
+
+void cy_aes_decryption(__uint128_t cy_msg, __uint128_t key, __uint128_t *msg)
+{
+    CY_AES_SCHED sched;
+    cy_aes_sched_init(key, &sched);
+    cy_aes_sched_decryption(cy_msg, &sched, msg);
+}
+
+void cy_aes_sched_encryption(const __uint128_t msg, const CY_AES_SCHED *sched, __uint128_t *cy_msg)
+{
+    const uint32_t *expandkey = sched->w; uint8_t state[4][4]; *cy_msg = 0;
+    cy_aes_from_128_to_4by4(msg, state);
+    cy_aes_add_round_key(expandkey, state);
+
+    for (uint8_t i = 1; i < 10; i++)
+    {
+        cy_aes_substitute_bytes(CY_AES_SBOX, state);
+        cy_aes_shift_rows(state);
+        cy_aes_mix_columns(CY_AES_MIXCOL_MAT, state);
+        cy_aes_add_round_key(&expandkey[4 * i], state);
+    }
+    cy_aes_substitute_bytes(CY_AES_SBOX, state);
+    cy_aes_shift_rows(state);
+    cy_aes_add_round_key(&expandkey[40], state);
+    cy_aes_from_4by4_to_128(state, cy_msg);
+}
+
+void cy_aes_sched_decryption(const __uint128_t cy_msg, const CY_AES_SCHED *sched, __uint128_t *msg)
+{
+    const uint32_t *expandkey = sched->w; uint8_t state[4][4]; *msg = 0;
+    cy_aes_from_128_to_4by4(cy_msg, state);
+    cy_aes_add_round_key(expandkey + 40, state);
+
+    for (uint8_t i = 1; i < 10; i++)
+    {
+        cy_aes_invshift_rows(state);
+        cy_aes_substitute_bytes(CY_AES_INVSBOX, state);
+        cy_aes_add_round_key(expandkey + (40 - 4 * i), state);
+        cy_aes_mix_columns(CY_AES_INVMIXCOL_MAT, state);
+    }
+    cy_aes_invshift_rows(state);
+    cy_aes_substitute_bytes(CY_AES_INVSBOX, state);
+    cy_aes_add_round_key(expandkey, state);
+    cy_aes_from_4by4_to_128(state, msg);
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                  RSA Context Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+typedef struct CY_MONT
+{
+    mp_size_t nl;    // limbs of the modulus, R = B^nl
+    mp_limb_t *n;    // modulus
+    mp_limb_t *r2;   // R^2 mod n, maps into the Montgomery domain
+    mp_limb_t *one;  // R mod n, the Montgomery 1
+    mp_limb_t ninv;  // -n^-1 mod B
+} CY_MONT;
+
+typedef struct CY_RSA_SCRATCH
+{
+    atomic_int busy;
+    mpz_t m, mi, h, R; // CRT recombination, sized once for n
+    mp_limb_t *table; // odd powers base^1, base^3, ..., or every power base^0 .. base^(2^win - 1) when secret
+    mp_limb_t *acc, *base, *t, *sel; // nl, nl, 2*nl and nl limbs
+} CY_RSA_SCRATCH;
+
+typedef struct CY_RSA_WINDOW
+{
+    uint32_t nsqr;    // squarings before the multiplication
+    uint8_t odd;      // table index, the window value is 2*odd + 1
+} CY_RSA_WINDOW;
+
+struct CY_RSA_CTX
+{
+    uint8_t nprime;   // 0 for a plain {exp, n} context
+    CY_RSA_CTX *prime[CY_RSA_MAX_PRIMES];   // per prime contexts, c^d_i mod r_i
+    mpz_t coef[CY_RSA_MAX_PRIMES];          // Garner coefficients, same layout as the key
+    mpz_t r[CY_RSA_MAX_PRIMES];
+    CY_MONT mont;
+    uint8_t win;      // sliding window width in bits, fixed window width when secret
+    uint8_t secret;   // private exponent: fixed windows and a full table scan per multiply
+    size_t nwindow;
+    CY_RSA_WINDOW *window; // exponent recoded once, most significant first
+    uint8_t *digit;   // secret exponent as win bit digits, most significant first
+    uint32_t tail;    // squarings after the last window (trailing zero bits)
+    size_t nslot;
+    CY_RSA_SCRATCH *slot;
+};
+
+static void cy_mont_redc(const CY_MONT *mont, mp_ptr r, mp_ptr t);
+
+// r2 = R^2 mod n when the caller has it precomputed (key containers), NULL to derive it here
+static CY_STATE_FLAG cy_mont_init(mpz_srcptr n, mpz_srcptr r2, CY_MONT *mont)
+{
+    memset(mont, 0, sizeof(*mont));
+    if(mpz_sgn(n) <= 0 || mpz_even_p(n)) return CY_ERR_KEY_VALUE;
+
+    mp_size_t nl = (mp_size_t)mpz_size(n);
+    mont->nl = nl;
+    mont->n   = calloc((size_t)nl, sizeof(mp_limb_t));
+    mont->r2  = calloc((size_t)nl, sizeof(mp_limb_t));
+    mont->one = calloc((size_t)nl, sizeof(mp_limb_t));
+    if(!mont->n || !mont->r2 || !mont->one) return CY_ERR_OOM;
+
+    mpn_copyi(mont->n, mpz_limbs_read(n), nl);
+
+    // Newton iteration for n0^-1 mod B, each step doubles the correct low bits
+    mp_limb_t n0 = mont->n[0], inv = 1;
+    for (int i = 0; i < 7; i++) inv *= 2 - n0 * inv;
+    mont->ninv = -inv;
+
+    mpz_t r; mpz_init(r);
+    mpz_set_ui(r, 0); mpz_setbit(r, (mp_bitcnt_t)nl * GMP_NUMB_BITS); mpz_mod(r, r, n);
+    mpn_copyi(mont->one, mpz_limbs_read(r), (mp_size_t)mpz_size(r));
+
+    if(r2 && mpz_sgn(r2) > 0 && mpz_cmp(r2, n) < 0)
+    {
+        // a stored R^2 is only taken when REDC(R^2) lands on R mod n, computed independently above
+        mp_ptr t = calloc(2 * (size_t)nl, sizeof(mp_limb_t));
+        if(!t) {mpz_clear(r); return CY_ERR_OOM;}
+        mpn_copyi(t, mpz_limbs_read(r2), (mp_size_t)mpz_size(r2));
+        cy_mont_redc(mont, t, t);
+        int ok = mpn_cmp(t, mont->one, nl) == 0;
+        free(t);
+        if(ok) {mpn_copyi(mont->r2, mpz_limbs_read(r2), (mp_size_t)mpz_size(r2)); mpz_clear(r); return CY_OK;}
+    }
+
+    mpz_set_ui(r, 0); mpz_setbit(r, 2 * (mp_bitcnt_t)nl * GMP_NUMB_BITS); mpz_mod(r, r, n);
+    mpn_copyi(mont->r2, mpz_limbs_read(r), (mp_size_t)mpz_size(r));
+    mpz_clear(r);
+    return CY_OK;
+}
+
+static void cy_mont_free(CY_MONT *mont)
+{
+    free(mont->n); free(mont->r2); free(mont->one);
+    memset(mont, 0, sizeof(*mont));
+}
+
+// r = t / R mod n for t < n*R, t is 2*nl limbs and gets clobbered
+static void cy_mont_redc(const CY_MONT *mont, mp_ptr r, mp_ptr t)
+{
+    const mp_size_t nl = mont->nl;
+    for (mp_size_t i = 0; i < nl; i++)
+    {
+        // t[i] becomes 0, park the carry there until the final add
+        mp_limb_t m = t[i] * mont->ninv;
+        t[i] = mpn_addmul_1(t + i, mont->n, nl, m);
+    }
+    mp_limb_t cy = mpn_add_n(r, t + nl, t, nl);
+    // the final subtraction is a select, not a branch, so it does not time the operands
+    mp_ptr d = r == t ? t + nl : t;
+    mp_limb_t bw = mpn_sub_n(d, r, mont->n, nl);
+    mp_limb_t mask = -(mp_limb_t)(cy | (bw ^ 1));
+    for (mp_size_t i = 0; i < nl; i++) r[i] = (d[i] & mask) | (r[i] & ~mask);
+}
+
+static void cy_mont_mul(const CY_MONT *mont, mp_ptr r, mp_srcptr a, mp_srcptr b, mp_ptr t)
+{
+    if(a == b) mpn_sqr(t, a, mont->nl);
+    else mpn_mul_n(t, a, b, mont->nl);
+    cy_mont_redc(mont, r, t);
+}
+
+static CY_STATE_FLAG cy_rsa_ctx_scratch_init(const CY_RSA_CTX *ctx, CY_RSA_SCRATCH *slot)
+{
+    const mp_size_t nl = ctx->mont.nl;
+    atomic_init(&slot->busy, 0);
+    mpz_inits(slot->m, slot->mi, slot->h, slot->R, NULL);
+    if(ctx->nprime)
+    {
+        // CRT contexts only recombine, the exponentiations run in the per prime contexts
+        mp_bitcnt_t bits = 2 * (mp_bitcnt_t)nl * GMP_NUMB_BITS + GMP_NUMB_BITS;
+        mpz_realloc2(slot->m, bits); mpz_realloc2(slot->mi, bits); mpz_realloc2(slot->h, bits); mpz_realloc2(slot->R, bits);
+        return CY_OK;
+    }
+    slot->table = malloc(((size_t)1 << (ctx->secret ? ctx->win : ctx->win - 1)) * (size_t)nl * sizeof(mp_limb_t));
+    slot->acc   = malloc(5 * (size_t)nl * sizeof(mp_limb_t));
+    if(!slot->table || !slot->acc) return CY_ERR_OOM;
+    slot->base = slot->acc + nl;
+    slot->t    = slot->acc + 2 * nl;
+    slot->sel  = slot->acc + 4 * nl;
+    return CY_OK;
+}
+
+static void cy_rsa_ctx_scratch_free(CY_RSA_SCRATCH *slot)
+{
+    mpz_clears(slot->m, slot->mi, slot->h, slot->R, NULL);
+    free(slot->table); free(slot->acc);
+    slot->table = slot->acc = NULL;
+}
+
+// pick an idle slot without locking, a transient one is allocated when every slot is busy
+static CY_RSA_SCRATCH *cy_rsa_ctx_acquire(CY_RSA_CTX *ctx)
+{
+    for (size_t i = 0; i < ctx->nslot; i++)
+    {
+        int idle = 0;
+        if(atomic_compare_exchange_strong(&ctx->slot[i].busy, &idle, 1)) return &ctx->slot[i];
+    }
+    CY_RSA_SCRATCH *slot = malloc(sizeof(*slot));
+    if(!slot) return NULL;
+    if(cy_rsa_ctx_scratch_init(ctx, slot) != CY_OK)
+    {cy_rsa_ctx_scratch_free(slot); free(slot); return NULL;}
+    atomic_store(&slot->busy, 1);
+    return slot;
+}
+
+static void cy_rsa_ctx_release(CY_RSA_CTX *ctx, CY_RSA_SCRATCH *slot)
+{
+    if(slot >= ctx->slot && slot < ctx->slot + ctx->nslot) {atomic_store(&slot->busy, 0); return;}
+    cy_rsa_ctx_scratch_free(slot); free(slot);
+}
+
+static CY_STATE_FLAG cy_rsa_ctx_setup(mpz_srcptr exp, mpz_srcptr n, mpz_srcptr r2, const uint8_t secret, const size_t nslot, CY_RSA_CTX **ctx)
+{
+    if(!ctx) return CY_ERR_ARG;
+    *ctx = calloc(1, sizeof(**ctx));
+    if(!*ctx) return CY_ERR_OOM;
+
+    CY_STATE_FLAG st = cy_mont_init(n, r2, &(*ctx)->mont);
+    if(st != CY_OK) {cy_rsa_ctx_free(*ctx); *ctx = NULL; return st;}
+
+    size_t bits = mpz_sizeinbase(exp, 2);
+    (*ctx)->win = bits > 3072 ? 7 : bits > 1024 ? 6 : bits > 384 ? 5 : bits > 128 ? 4 : bits > 24 ? 3 : bits > 8 ? 2 : 1;
+    (*ctx)->window = calloc(bits + 1, sizeof((*ctx)->window[0]));
+    (*ctx)->slot = calloc(nslot, sizeof((*ctx)->slot[0]));
+    if(!(*ctx)->window || !(*ctx)->slot) {cy_rsa_ctx_free(*ctx); *ctx = NULL; return CY_ERR_OOM;}
+    (*ctx)->nslot = nslot;
+
+    // a context cannot tell e from d, the caller says which one it holds
+    if(secret)
+    {
+        (*ctx)->secret = 1;
+        (*ctx)->win = bits > 1024 ? 5 : 4;
+        (*ctx)->nwindow = (bits + (*ctx)->win - 1) / (*ctx)->win;
+        (*ctx)->digit = calloc((*ctx)->nwindow, 1);
+        if(!(*ctx)->digit) {cy_rsa_ctx_free(*ctx); *ctx = NULL; return CY_ERR_OOM;}
+        for (size_t i = 0; i < (*ctx)->nwindow; i++)
+            for (uint8_t b = (*ctx)->win; b--;)
+            {
+                mp_bitcnt_t at = (mp_bitcnt_t)((*ctx)->nwindow - 1 - i) * (*ctx)->win + b;
+                (*ctx)->digit[i] = (uint8_t)(((*ctx)->digit[i] << 1) | mpz_tstbit(exp, at));
+            }
+        for (size_t i = 0; i < nslot; i++)
+        {
+            st = cy_rsa_ctx_scratch_init(*ctx, &(*ctx)->slot[i]);
+            if(st != CY_OK) {cy_rsa_ctx_free(*ctx); *ctx = NULL; return st;}
+        }
+        return CY_OK;
+    }
+
+    // sliding windows: each one starts and ends on a set bit, zeros in between are squarings
+    uint32_t nsqr = 0;
+    for (ssize_t i = (ssize_t)bits - 1; i >= 0;)
+    {
+        if(!mpz_tstbit(exp, (mp_bitcnt_t)i)) {nsqr++; i--; continue;}
+        ssize_t j = i - (*ctx)->win + 1 < 0 ? 0 : i - (*ctx)->win + 1;
+        while (!mpz_tstbit(exp, (mp_bitcnt_t)j)) j++;
+        uint32_t value = 0;
+        for (ssize_t k = i; k >= j; k--) value = (value << 1) | (uint32_t)mpz_tstbit(exp, (mp_bitcnt_t)k);
+        CY_RSA_WINDOW *w = &(*ctx)->window[(*ctx)->nwindow++];
+        w->nsqr = nsqr + (uint32_t)(i - j + 1); w->odd = (uint8_t)(value >> 1);
+        nsqr = 0; i = j - 1;
+    }
+    (*ctx)->tail = nsqr;
+
+    for (size_t i = 0; i < nslot; i++)
+    {
+        st = cy_rsa_ctx_scratch_init(*ctx, &(*ctx)->slot[i]);
+        if(st != CY_OK) {cy_rsa_ctx_free(*ctx); *ctx = NULL; return st;}
+    }
+    return CY_OK;
+}
+
+// r = base^exp mod n with everything in the slot, base must already be reduced (< n)
+static void cy_rsa_ctx_exp(const CY_RSA_CTX *ctx, CY_RSA_SCRATCH *slot, mp_srcptr base, mp_ptr r)
+{
+    const CY_MONT *mont = &ctx->mont;
+    const mp_size_t nl = mont->nl;
+    const size_t tsize = (size_t)1 << (ctx->win - 1);
+    mp_ptr table = slot->table, acc = slot->acc, t = slot->t;
+
+    if(ctx->secret)
+    {
+        // fixed windows: the same squarings and multiplies for every exponent, and each
+        // table entry is read on every lookup so the cache footprint ignores the digit
+        const size_t nentry = (size_t)1 << ctx->win;
+        mpn_copyi(table, mont->one, nl);
+        cy_mont_mul(mont, table + nl, base, mont->r2, t);
+        for (size_t k = 2; k < nentry; k++) cy_mont_mul(mont, table + k * nl, table + (k - 1) * nl, table + nl, t);
+
+        mpn_sec_tabselect(acc, table, nl, (mp_size_t)nentry, ctx->digit[0]);
+        for (size_t i = 1; i < ctx->nwindow; i++)
+        {
+            for (uint8_t b = 0; b < ctx->win; b++) cy_mont_mul(mont, acc, acc, acc, t);
+            mpn_sec_tabselect(slot->sel, table, nl, (mp_size_t)nentry, ctx->digit[i]);
+            cy_mont_mul(mont, acc, acc, slot->sel, t);
+        }
+        mpn_copyi(t, acc, nl); mpn_zero(t + nl, nl);
+        cy_mont_redc(mont, r, t);
+        return;
+    }
+
+    // table[k] = base^(2k+1) in the Montgomery domain, acc holds base^2 meanwhile
+    cy_mont_mul(mont, table, base, mont->r2, t);
+    cy_mont_mul(mont, acc, table, table, t);
+    for (size_t k = 1; k < tsize; k++)
+        cy_mont_mul(mont, table + k * nl, table + (k - 1) * nl, acc, t);
+
+    mpn_copyi(acc, mont->one, nl);
+    for (size_t i = 0; i < ctx->nwindow; i++)
+    {
+        const CY_RSA_WINDOW *w = &ctx->window[i];
+        if(i == 0) {mpn_copyi(acc, table + w->odd * nl, nl); continue;}
+        for (uint32_t b = 0; b < w->nsqr; b++) cy_mont_mul(mont, acc, acc, acc, t);
+        cy_mont_mul(mont, acc, acc, table + w->odd * nl, t);
+    }
+    if(ctx->nwindow) for (uint32_t b = 0; b < ctx->tail; b++) cy_mont_mul(mont, acc, acc, acc, t);
+
+    // leave the Montgomery domain: redc(acc * 1)
+    mpn_copyi(t, acc, nl); mpn_zero(t + nl, nl);
+    cy_mont_redc(mont, r, t);
+}
+
+// secret: key[0] is a private exponent, it then runs in constant time
+CY_STATE_FLAG cy_rsa_ctx_init(const mpz_t *key, const uint8_t secret, CY_RSA_CTX **ctx)
+{
+    if(!key) return cy_state_manager(CY_ERR_ARG, __func__, ": key is NULL");
+    CY_STATE_FLAG st = cy_rsa_ctx_setup(key[0], key[1], NULL, secret, 1, ctx);
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": rsa context setup failed");
+    return CY_OK;
+}
+
+// slot->m = in^d mod n from the per prime contexts, Garner order as cy_rsa_crt_powm
+static CY_STATE_FLAG cy_rsa_ctx_crt_exp(CY_RSA_CTX *ctx, CY_RSA_SCRATCH *slot, mpz_srcptr in)
+{
+    mpz_mod(slot->h, in, ctx->r[1]);
+    if(cy_rsa_ctx_powm(ctx->prime[1], slot->h, slot->m) != CY_OK) return CY_ERR;
+    mpz_set(slot->R, ctx->r[1]);
+    for (uint8_t i = 0; i < ctx->nprime; i++)
+    {
+        if(i == 1) continue;
+        mpz_mod(slot->h, in, ctx->r[i]);
+        if(cy_rsa_ctx_powm(ctx->prime[i], slot->h, slot->mi) != CY_OK) return CY_ERR;
+        mpz_sub(slot->h, slot->mi, slot->m);
+        mpz_mul(slot->h, slot->h, ctx->coef[i]);
+        mpz_mod(slot->h, slot->h, ctx->r[i]);
+        mpz_addmul(slot->m, slot->R, slot->h);
+        mpz_mul(slot->R, slot->R, ctx->r[i]);
+    }
+    return CY_OK;
+}
+
+// r2[i] = R^2 mod r_i or NULL, see cy_mont_init
+static CY_STATE_FLAG cy_rsa_ctx_crt_setup(const CY_KEY *key, const mpz_srcptr r2[], const size_t nslot, CY_RSA_CTX **ctx)
+{
+    uint8_t u = 0;
+    if(!ctx) return CY_ERR_ARG;
+    if(cy_rsa_prv_key_check(key, &u) != CY_OK) return CY_ERR_KEY;
+    const mpz_t *prvkey = key->key;
+
+    *ctx = calloc(1, sizeof(**ctx));
+    if(!*ctx) return CY_ERR_OOM;
+    (*ctx)->nprime = u;
+    (*ctx)->mont.nl = (mp_size_t)mpz_size(prvkey[1]);
+    for (uint8_t i = 0; i < CY_RSA_MAX_PRIMES; i++) mpz_inits((*ctx)->coef[i], (*ctx)->r[i], NULL);
+
+    CY_STATE_FLAG st = CY_OK;
+    for (uint8_t i = 0; i < u && st == CY_OK; i++)
+    {
+        mpz_set((*ctx)->r[i], prvkey[CY_RSA_PRV_PRIME(i)]);
+        // coef[0] is used for r_1 and holds qInv, matching the Garner loop
+        mpz_set((*ctx)->coef[i], prvkey[CY_RSA_PRV_COEF(i == 0 ? 1 : i)]);
+        st = cy_rsa_ctx_setup(prvkey[CY_RSA_PRV_EXP(i)], prvkey[CY_RSA_PRV_PRIME(i)], r2 ? r2[i] : NULL, 1, nslot, &(*ctx)->prime[i]);
+    }
+    if(st == CY_OK)
+    {
+        (*ctx)->slot = calloc(nslot, sizeof((*ctx)->slot[0]));
+        if(!(*ctx)->slot) st = CY_ERR_OOM;
+        else (*ctx)->nslot = nslot;
+        for (size_t i = 0; i < (*ctx)->nslot && st == CY_OK; i++) st = cy_rsa_ctx_scratch_init(*ctx, &(*ctx)->slot[i]);
+    }
+    if(st != CY_OK) {cy_rsa_ctx_free(*ctx); *ctx = NULL;}
+    return st;
+}
+
+CY_STATE_FLAG cy_rsa_ctx_crt_init(const CY_KEY *prvkey, CY_RSA_CTX **ctx)
+{
+    CY_STATE_FLAG st = cy_rsa_ctx_crt_setup(prvkey, NULL, 1, ctx);
+    if(st == CY_ERR_KEY) return cy_state_manager(st, __func__, ": not a CRT private key");
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": rsa context setup failed");
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_ctx_powm(CY_RSA_CTX *ctx, mpz_srcptr in, mpz_ptr out)
+{
+    if(!ctx) return cy_state_manager(CY_ERR_ARG, __func__, ": ctx is NULL");
+    if(mpz_sgn(in) < 0) return cy_state_manager(CY_ERR_ARG, __func__, ": negative input");
+    const mp_size_t nl = ctx->mont.nl;
+
+    CY_RSA_SCRATCH *slot = cy_rsa_ctx_acquire(ctx);
+    if(!slot) return cy_state_manager(CY_ERR_OOM, __func__, "");
+
+    if(ctx->nprime)
+    {
+        CY_STATE_FLAG st = cy_rsa_ctx_crt_exp(ctx, slot, in);
+        if(st == CY_OK) mpz_set(out, slot->m);
+        cy_rsa_ctx_release(ctx, slot);
+        return st;
+    }
+
+    mp_size_t inl = (mp_size_t)mpz_size(in);
+    if(inl < nl || (inl == nl && mpn_cmp(mpz_limbs_read(in), ctx->mont.n, nl) < 0))
+    {
+        mpn_copyi(slot->base, mpz_limbs_read(in), inl);
+        mpn_zero(slot->base + inl, nl - inl);
+    }
+    else
+    {
+        // out of range input, reduce it first (not the hot path)
+        mp_ptr q = malloc((size_t)(inl - nl + 1) * sizeof(mp_limb_t));
+        if(!q) {cy_rsa_ctx_release(ctx, slot); return cy_state_manager(CY_ERR_OOM, __func__, "");}
+        mpn_tdiv_qr(q, slot->base, 0, mpz_limbs_read(in), inl, ctx->mont.n, nl);
+        free(q);
+    }
+
+    mp_ptr r = mpz_limbs_write(out, nl);
+    cy_rsa_ctx_exp(ctx, slot, slot->base, r);
+    mpz_limbs_finish(out, nl);
+    cy_rsa_ctx_release(ctx, slot);
+    return CY_OK;
+}
+
+void cy_rsa_ctx_encryption(const uint8_t c, CY_RSA_CTX *ctx, mpz_ptr cy_msg)
+{
+    mpz_set_ui(cy_msg, c);
+    cy_rsa_ctx_powm(ctx, cy_msg, cy_msg);
+}
+
+void cy_rsa_ctx_decryption(const mpz_srcptr cy_msg, CY_RSA_CTX *ctx, uint8_t *c)
+{
+    if(!ctx) {cy_state_manager(CY_ERR_ARG, __func__, ": ctx is NULL"); return;}
+    if(mpz_sgn(cy_msg) < 0) {cy_state_manager(CY_ERR_ARG, __func__, ": negative input"); return;}
+    const mp_size_t nl = ctx->mont.nl;
+    mp_size_t inl = (mp_size_t)mpz_size(cy_msg);
+    if(ctx->nprime)
+    {
+        CY_RSA_SCRATCH *slot = cy_rsa_ctx_acquire(ctx);
+        if(!slot) {cy_state_manager(CY_ERR_OOM, __func__, ""); return;}
+        if(cy_rsa_ctx_crt_exp(ctx, slot, cy_msg) == CY_OK) *c = (uint8_t) mpz_get_ui(slot->m);
+        cy_rsa_ctx_release(ctx, slot);
+        return;
+    }
+    if(inl > nl || (inl == nl && mpn_cmp(mpz_limbs_read(cy_msg), ctx->mont.n, nl) >= 0))
+    {
+        // reduction needs a quotient buffer, route it through the generic path
+        mpz_t out; mpz_init(out);
+        cy_rsa_ctx_powm(ctx, cy_msg, out);
+        *c = (uint8_t) mpz_get_ui(out);
+        mpz_clear(out);
+        return;
+    }
+
+    CY_RSA_SCRATCH *slot = cy_rsa_ctx_acquire(ctx);
+    if(!slot) {cy_state_manager(CY_ERR_OOM, __func__, ""); return;}
+    mpn_copyi(slot->base, mpz_limbs_read(cy_msg), inl);
+    mpn_zero(slot->base + inl, nl - inl);
+    // the base is consumed into the table, reuse it for the result
+    cy_rsa_ctx_exp(ctx, slot, slot->base, slot->base);
+    *c = (uint8_t) slot->base[0];
+    cy_rsa_ctx_release(ctx, slot);
+}
+
+void cy_rsa_ctx_free(CY_RSA_CTX *ctx)
+{
+    if(!ctx) return;
+    if(ctx->nprime)
+    {
+        for (uint8_t i = 0; i < CY_RSA_MAX_PRIMES; i++)
+        {cy_rsa_ctx_free(ctx->prime[i]); mpz_clears(ctx->coef[i], ctx->r[i], NULL);}
+    }
+    for (size_t i = 0; i < ctx->nslot; i++) cy_rsa_ctx_scratch_free(&ctx->slot[i]);
+    free(ctx->slot);
+    free(ctx->window); free(ctx->digit);
+    cy_mont_free(&ctx->mont);
+    free(ctx);
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                 Multi-Buffer Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+/*
+ * Eight independent exponentiations side by side, one per 64-bit lane,
+ * numbers split in 52-bit limbs so AVX-512 IFMA can multiply them.
+ * Almost Montgomery multiplication (results < 2n) with R = 2^(52 L) and
+ * 4n < R, which fits 4096-bit moduli in 80 limbs.
+ */
+#define CY_MB_LANES 8
+#define CY_MB_MAX_LIMBS 80
+#define CY_MB_WIN 5
+#define CY_MB_MASK52 ((UINT64_C(1) << 52) - 1)
+
+typedef struct CY_MB_JOB
+{
+    size_t L;                          // 52-bit limbs in use
+    size_t nwin;                       // CY_MB_WIN-bit windows of the longest exponent
+    uint64_t *n, *r2, *k0, *base, *out; // [L][8] limb-major, k0 is [8]
+    uint64_t *digit;                   // [nwin][8], most significant window first
+} CY_MB_JOB;
+
+static void cy_mb_limbs_exp(mpz_srcptr z, const size_t L, uint64_t *v, const size_t lane)
+{
+    const mp_limb_t *d = mpz_limbs_read(z);
+    const size_t zl = mpz_size(z);
+    for (size_t j = 0; j < L; j++)
+    {
+        size_t bit = j * 52, w = bit / 64, off = bit % 64;
+        uint64_t x = w < zl ? (uint64_t)d[w] >> off : 0;
+        if(off > 12 && w + 1 < zl) x |= (uint64_t)d[w + 1] << (64 - off);
+        v[j * CY_MB_LANES + lane] = x & CY_MB_MASK52;
+    }
+}
+
+static void cy_mb_limbs_imp(const uint64_t *v, const size_t L, const size_t lane, mpz_ptr z)
+{
+    const size_t zl = (L * 52 + 63) / 64;
+    mp_limb_t *d = mpz_limbs_write(z, (mp_size_t)zl);
+    memset(d, 0, zl * sizeof(d[0]));
+    for (size_t j = 0; j < L; j++)
+    {
+        uint64_t x = v[j * CY_MB_LANES + lane];
+        size_t bit = j * 52, w = bit / 64, off = bit % 64;
+        d[w] |= (mp_limb_t)(x << off);
+        if(off > 12 && w + 1 < zl) d[w + 1] |= (mp_limb_t)(x >> (64 - off));
+    }
+    mpz_limbs_finish(z, (mp_size_t)zl);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#define CY_MB_TARGET __attribute__((target("avx512f,avx512ifma")))
+
+// r = a * b / R mod n per lane, a, b < 2n in, r < 2n out, limbs normalized to 52 bits
+static CY_MB_TARGET void cy_mb_amm(uint64_t *r, const uint64_t *a, const uint64_t *b, const uint64_t *n, const __m512i k0, const size_t L)
+{
+    const __m512i zero = _mm512_setzero_si512(), mask = _mm512_set1_epi64((long long)CY_MB_MASK52);
+    __m512i t[CY_MB_MAX_LIMBS + 1], bj[CY_MB_MAX_LIMBS], nj[CY_MB_MAX_LIMBS];
+    for (size_t j = 0; j < L; j++)
+    {
+        t[j] = zero;
+        bj[j] = _mm512_loadu_si512(b + j * CY_MB_LANES);
+        nj[j] = _mm512_loadu_si512(n + j * CY_MB_LANES);
+    }
+    t[L] = zero;
+
+    for (size_t i = 0; i < L; i++)
+    {
+        const __m512i ai = _mm512_loadu_si512(a + i * CY_MB_LANES);
+        for (size_t j = 0; j < L; j++) t[j] = _mm512_madd52lo_epu64(t[j], ai, bj[j]);
+        const __m512i m = _mm512_madd52lo_epu64(zero, t[0], k0);
+        for (size_t j = 0; j < L; j++) t[j] = _mm512_madd52lo_epu64(t[j], m, nj[j]);
+
+        // low 52 bits of t[0] are now zero: shift one limb down, high halves land one limb up
+        const __m512i carry = _mm512_srli_epi64(t[0], 52);
+        for (size_t j = 0; j < L; j++)
+            t[j] = _mm512_madd52hi_epu64(_mm512_madd52hi_epu64(t[j + 1], ai, bj[j]), m, nj[j]);
+        t[0] = _mm512_add_epi64(t[0], carry);
+    }
+
+    for (size_t j = 0; j + 1 < L; j++)
+    {
+        t[j + 1] = _mm512_add_epi64(t[j + 1], _mm512_srli_epi64(t[j], 52));
+        _mm512_storeu_si512(r + j * CY_MB_LANES, _mm512_and_si512(t[j], mask));
+    }
+    _mm512_storeu_si512(r + (L - 1) * CY_MB_LANES, t[L - 1]);
+}
+
+static CY_MB_TARGET CY_STATE_FLAG cy_mb_powm_ifma(const CY_MB_JOB *job)
+{
+    const size_t L = job->L, V = L * CY_MB_LANES, tsize = (size_t)1 << CY_MB_WIN;
+    const __m512i k0 = _mm512_loadu_si512(job->k0);
+    uint64_t *table = malloc((tsize + 3) * V * sizeof(uint64_t));
+    if(!table) return CY_ERR_OOM;
+    uint64_t *acc = table + tsize * V, *sel = acc + V, *one = sel + V;
+
+    memset(one, 0, V * sizeof(uint64_t));
+    for (size_t l = 0; l < CY_MB_LANES; l++) one[l] = 1;
+
+    // table[k] = base^k in the Montgomery domain, table[0] = R mod n
+    cy_mb_amm(table, job->r2, one, job->n, k0, L);
+    cy_mb_amm(table + V, job->base, job->r2, job->n, k0, L);
+    for (size_t k = 2; k < tsize; k++) cy_mb_amm(table + k * V, table + (k - 1) * V, table + V, job->n, k0, L);
+
+    for (size_t w = 0; w < job->nwin; w++)
+    {
+        // constant time gather: every lane picks its own table entry
+        const __m512i idx = _mm512_loadu_si512(job->digit + w * CY_MB_LANES);
+        for (size_t j = 0; j < L; j++)
+        {
+            __m512i v = _mm512_setzero_si512();
+            for (size_t k = 0; k < tsize; k++)
+            {
+                __mmask8 hit = _mm512_cmpeq_epi64_mask(idx, _mm512_set1_epi64((long long)k));
+                v = _mm512_mask_mov_epi64(v, hit, _mm512_loadu_si512(table + k * V + j * CY_MB_LANES));
+            }
+            _mm512_storeu_si512(sel + j * CY_MB_LANES, v);
+        }
+        if(!w) {memcpy(acc, sel, V * sizeof(uint64_t)); continue;}
+        for (int b = 0; b < CY_MB_WIN; b++) cy_mb_amm(acc, acc, acc, job->n, k0, L);
+        cy_mb_amm(acc, acc, sel, job->n, k0, L);
+    }
+    cy_mb_amm(job->out, acc, one, job->n, k0, L);
+    free(table);
+    return CY_OK;
+}
+
+static int cy_mb_has_ifma(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma");
+}
+
+#else
+
+static CY_STATE_FLAG cy_mb_powm_ifma(const CY_MB_JOB *job) {(void)job; return CY_ERR_UNSUPPORTED;}
+
+static int cy_mb_has_ifma(void) {return 0;}
+
+#endif
+
+static size_t cy_mb_sort_key_bits(const mpz_t **key, const size_t i)
+{
+    return mpz_sizeinbase(key[i][1], 2);
+}
+
+// runs up to 8 items (lanes beyond count repeat item 0), false when the IFMA path cannot take them
+static int cy_mb_chunk(const size_t count, const size_t idx[], const mpz_srcptr in[], const mpz_t *key[], mpz_ptr out[])
+{
+    size_t maxbits = 0, maxexp = 1;
+    for (size_t l = 0; l < count; l++)
+    {
+        mpz_srcptr n = key[idx[l]][1];
+        if(mpz_sgn(n) <= 0 || mpz_even_p(n) || mpz_cmp_ui(n, 1) == 0 || mpz_sgn(key[idx[l]][0]) < 0) return 0;
+        if(mpz_sizeinbase(n, 2) > maxbits) maxbits = mpz_sizeinbase(n, 2);
+        if(mpz_sizeinbase(key[idx[l]][0], 2) > maxexp) maxexp = mpz_sizeinbase(key[idx[l]][0], 2);
+    }
+    CY_MB_JOB job;
+    job.L = (maxbits + 2 + 51) / 52;
+    if(job.L > CY_MB_MAX_LIMBS) return 0;
+    job.nwin = (maxexp + CY_MB_WIN - 1) / CY_MB_WIN;
+
+    const size_t V = job.L * CY_MB_LANES;
+    uint64_t *mem = calloc(4 * V + CY_MB_LANES + job.nwin * CY_MB_LANES, sizeof(uint64_t));
+    if(!mem) return 0;
+    job.n = mem; job.r2 = mem + V; job.base = mem + 2 * V; job.out = mem + 3 * V;
+    job.k0 = mem + 4 * V; job.digit = job.k0 + CY_MB_LANES;
+
+    mpz_t t, b52; mpz_inits(t, b52, NULL);
+    mpz_setbit(b52, 52);
+    for (size_t l = 0; l < CY_MB_LANES; l++)
+    {
+        size_t i = idx[l < count ? l : 0];
+        mpz_srcptr n = key[i][1], e = key[i][0];
+        cy_mb_limbs_exp(n, job.L, job.n, l);
+        mpz_set_ui(t, 0); mpz_setbit(t, 2 * 52 * job.L); mpz_mod(t, t, n);
+        cy_mb_limbs_exp(t, job.L, job.r2, l);
+        mpz_mod(t, in[i], n);
+        cy_mb_limbs_exp(t, job.L, job.base, l);
+        // k0 = -n^-1 mod 2^52
+        mpz_invert(t, n, b52); mpz_sub(t, b52, t);
+        job.k0[l] = (uint64_t)mpz_get_ui(t) & CY_MB_MASK52;
+        for (size_t w = 0; w < job.nwin; w++)
+        {
+            uint64_t d = 0;
+            for (int b = CY_MB_WIN - 1; b >= 0; b--)
+                d = (d << 1) | (uint64_t)mpz_tstbit(e, (job.nwin - 1 - w) * CY_MB_WIN + (mp_bitcnt_t)b);
+            job.digit[w * CY_MB_LANES + l] = d;
+        }
+    }
+
+    // on failure nothing is written back and the caller runs the chunk through mpz_powm
+    int done = cy_mb_powm_ifma(&job) == CY_OK;
+    for (size_t l = 0; l < count && done; l++)
+    {
+        cy_mb_limbs_imp(job.out, job.L, l, t);
+        mpz_mod(out[idx[l]], t, key[idx[l]][1]);
+    }
+    mpz_clears(t, b52, NULL);
+    free(mem);
+    return done;
+}
+
+CY_STATE_FLAG cy_rsa_mb_powm(const size_t count, const mpz_srcptr in[], const mpz_t *key[], mpz_ptr out[])
+{
+    if(!in || !key || !out) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL array");
+
+    size_t *idx = malloc((count ? count : 1) * sizeof(idx[0]));
+    if(!idx) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    for (size_t i = 0; i < count; i++) idx[i] = i;
+
+    // similar sizes share a chunk so no lane pays for a bigger modulus
+    for (size_t i = 1; i < count; i++)
+    {
+        size_t x = idx[i], j = i;
+        for (; j > 0 && cy_mb_sort_key_bits(key, idx[j - 1]) > cy_mb_sort_key_bits(key, x); j--) idx[j] = idx[j - 1];
+        idx[j] = x;
+    }
+
+    const int ifma = count > 1 && cy_mb_has_ifma();
+    for (size_t at = 0; at < count; at += CY_MB_LANES)
+    {
+        size_t m = count - at < CY_MB_LANES ? count - at : CY_MB_LANES;
+        if(ifma && m > 1 && cy_mb_chunk(m, idx + at, in, key, out)) continue;
+        for (size_t l = 0; l < m; l++)
+        {
+            size_t i = idx[at + l];
+            mpz_powm(out[i], in[i], key[i][0], key[i][1]);
+        }
+    }
+    free(idx);
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_mb_decryption(const size_t count, const mpz_srcptr cy_msg[], const mpz_t *key[], uint8_t c[])
+{
+    mpz_t *out = malloc((count ? count : 1) * sizeof(out[0]));
+    mpz_ptr *outp = malloc((count ? count : 1) * sizeof(outp[0]));
+    if(!out || !outp) {free(out); free(outp); return cy_state_manager(CY_ERR_OOM, __func__, "");}
+    for (size_t i = 0; i < count; i++) {mpz_init(out[i]); outp[i] = out[i];}
+
+    CY_STATE_FLAG st = cy_rsa_mb_powm(count, cy_msg, key, outp);
+    for (size_t i = 0; i < count; i++)
+    {
+        if(st == CY_OK) c[i] = (uint8_t) mpz_get_ui(out[i]);
+        mpz_clear(out[i]);
+    }
+    free(out); free(outp);
+    return st;
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                 Fixed Bignum Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+/*
+ * RSA-sized integers with the limb count known at compile time: no heap,
+ * loops the compiler can unroll, one set of functions per DECL_FIXED_BIGNUM.
+ * The modulus must be odd with its top bit set, which RSA moduli of the
+ * matching size always are.
+ */
+#define DECL_FIXED_BIGNUM(BITS)                                                                                         \
+static inline uint64_t cy_u##BITS##_sub(uint64_t *r, const uint64_t *a, const uint64_t *b)                              \
+{                                                                                                                       \
+    uint64_t borrow = 0;                                                                                                \
+    for (size_t j = 0; j < (BITS) / 64; j++)                                                                            \
+    {                                                                                                                   \
+        unsigned __int128 d = (unsigned __int128)a[j] - b[j] - borrow;                                                  \
+        r[j] = (uint64_t)d; borrow = (uint64_t)(d >> 64) & 1;                                                           \
+    }                                                                                                                   \
+    return borrow;                                                                                                      \
+}                                                                                                                       \
+                                                                                                                        \
+/* r = t - n when hi or t >= n, without branching on the value */                                                       \
+static inline void cy_u##BITS##_reduce(uint64_t *r, const uint64_t *t, const uint64_t hi, const uint64_t *n)            \
+{                                                                                                                       \
+    uint64_t d[(BITS) / 64];                                                                                            \
+    uint64_t borrow = cy_u##BITS##_sub(d, t, n);                                                                        \
+    uint64_t take = (uint64_t)0 - ((hi | (borrow ^ 1)) & 1);                                                            \
+    for (size_t j = 0; j < (BITS) / 64; j++) r[j] = (d[j] & take) | (t[j] & ~take);                                     \
+}                                                                                                                       \
+                                                                                                                        \
+CY_STATE_FLAG cy_u##BITS##_imp(mpz_srcptr z, CY_U##BITS *x)                                                             \
+{                                                                                                                       \
+    if(mpz_sgn(z) < 0 || mpz_sizeinbase(z, 2) > (BITS))                                                                 \
+        return cy_state_manager(CY_ERR_RANGE, __func__, ": value does not fit");                                        \
+    memset(x->limb, 0, sizeof(x->limb));                                                                                \
+    mpz_export(x->limb, NULL, -1, sizeof(uint64_t), 0, 0, z);                                                           \
+    return CY_OK;                                                                                                       \
+}                                                                                                                       \
+                                                                                                                        \
+void cy_u##BITS##_exp(const CY_U##BITS *x, mpz_ptr z)                                                                   \
+{                                                                                                                       \
+    mpz_import(z, (BITS) / 64, -1, sizeof(uint64_t), 0, 0, x->limb);                                                    \
+}                                                                                                                       \
+                                                                                                                        \
+CY_STATE_FLAG cy_u##BITS##_mont_init(const CY_U##BITS *n, CY_U##BITS##_MONT *mont)                                      \
+{                                                                                                                       \
+    const size_t N = (BITS) / 64;                                                                                       \
+    if(!(n->limb[0] & 1) || !(n->limb[N - 1] >> 63))                                                                    \
+        return cy_state_manager(CY_ERR_VALUE, __func__, ": modulus must be odd and full size");                         \
+    mont->n = *n;                                                                                                       \
+                                                                                                                        \
+    uint64_t inv = n->limb[0];                                                                                          \
+    for (int i = 0; i < 5; i++) inv *= 2 - n->limb[0] * inv;                                                            \
+    mont->ninv = (uint64_t)0 - inv;                                                                                     \
+                                                                                                                        \
+    /* R mod n = R - n as n > R / 2, doubled 64 N times gives R^2 mod n */                                              \
+    uint64_t zero[(BITS) / 64] = {0};                                                                                   \
+    cy_u##BITS##_sub(mont->r2.limb, zero, n->limb);                                                                     \
+    for (size_t i = 0; i < (BITS); i++)                                                                                 \
+    {                                                                                                                   \
+        uint64_t hi = mont->r2.limb[N - 1] >> 63;                                                                       \
+        for (size_t j = N - 1; j > 0; j--) mont->r2.limb[j] = (mont->r2.limb[j] << 1) | (mont->r2.limb[j - 1] >> 63);   \
+        mont->r2.limb[0] <<= 1;                                                                                         \
+        cy_u##BITS##_reduce(mont->r2.limb, mont->r2.limb, hi, n->limb);                                                 \
+    }                                                                                                                   \
+    return CY_OK;                                                                                                       \
+}                                                                                                                       \
+                                                                                                                        \
+/* CIOS with the product and reduction rows fused, a and b < n, r may alias either */                                   \
+void cy_u##BITS##_mont_mul(const CY_U##BITS##_MONT *mont, const CY_U##BITS *a, const CY_U##BITS *b, CY_U##BITS *r)      \
+{                                                                                                                       \
+    const size_t N = (BITS) / 64;                                                                                       \
+    const uint64_t *n = mont->n.limb;                                                                                   \
+    uint64_t t[(BITS) / 64 + 1] = {0};                                                                                  \
+    for (size_t i = 0; i < N; i++)                                                                                      \
+    {                                                                                                                   \
+        const uint64_t bi = b->limb[i];                                                                                 \
+        unsigned __int128 p = (unsigned __int128)a->limb[0] * bi + t[0];                                                \
+        const uint64_t m = (uint64_t)p * mont->ninv;                                                                    \
+        unsigned __int128 q = (unsigned __int128)m * n[0] + (uint64_t)p;                                                \
+        uint64_t c1 = (uint64_t)(p >> 64), c2 = (uint64_t)(q >> 64);                                                    \
+        for (size_t j = 1; j < N; j++)                                                                                  \
+        {                                                                                                               \
+            p = (unsigned __int128)a->limb[j] * bi + t[j] + c1;                                                         \
+            q = (unsigned __int128)m * n[j] + (uint64_t)p + c2;                                                         \
+            t[j - 1] = (uint64_t)q;                                                                                     \
+            c1 = (uint64_t)(p >> 64); c2 = (uint64_t)(q >> 64);                                                         \
+        }                                                                                                               \
+        p = (unsigned __int128)t[N] + c1 + c2;                                                                          \
+        t[N - 1] = (uint64_t)p; t[N] = (uint64_t)(p >> 64);                                                             \
+    }                                                                                                                   \
+    cy_u##BITS##_reduce(r->limb, t, t[N], n);                                                                           \
+}                                                                                                                       \
+                                                                                                                        \
+/* full square, off-diagonal products once and doubled, then REDC */                                                    \
+void cy_u##BITS##_mont_sqr(const CY_U##BITS##_MONT *mont, const CY_U##BITS *a, CY_U##BITS *r)                           \
+{                                                                                                                       \
+    const size_t N = (BITS) / 64;                                                                                       \
+    const uint64_t *n = mont->n.limb;                                                                                   \
+    uint64_t t[2 * ((BITS) / 64) + 1] = {0};                                                                            \
+    for (size_t i = 0; i < N; i++)                                                                                      \
+    {                                                                                                                   \
+        unsigned __int128 c = 0;                                                                                        \
+        for (size_t j = i + 1; j < N; j++)                                                                              \
+        {                                                                                                               \
+            c += (unsigned __int128)a->limb[i] * a->limb[j] + t[i + j];                                                 \
+            t[i + j] = (uint64_t)c; c >>= 64;                                                                           \
+        }                                                                                                               \
+        t[i + N] = (uint64_t)c;                                                                                         \
+    }                                                                                                                   \
+    uint64_t top = 0;                                                                                                   \
+    for (size_t j = 0; j < 2 * N; j++)                                                                                  \
+    {                                                                                                                   \
+        uint64_t v = t[j];                                                                                              \
+        t[j] = (v << 1) | top; top = v >> 63;                                                                           \
+    }                                                                                                                   \
+    unsigned __int128 c = 0;                                                                                            \
+    for (size_t i = 0; i < N; i++)                                                                                      \
+    {                                                                                                                   \
+        unsigned __int128 sq = (unsigned __int128)a->limb[i] * a->limb[i];                                              \
+        c += (unsigned __int128)t[2 * i] + (uint64_t)sq;                                                                \
+        t[2 * i] = (uint64_t)c; c >>= 64;                                                                               \
+        c += (unsigned __int128)t[2 * i + 1] + (uint64_t)(sq >> 64);                                                    \
+        t[2 * i + 1] = (uint64_t)c; c >>= 64;                                                                           \
+    }                                                                                                                   \
+                                                                                                                        \
+    uint64_t hi = 0;                                                                                                    \
+    for (size_t i = 0; i < N; i++)                                                                                      \
+    {                                                                                                                   \
+        uint64_t m = t[i] * mont->ninv;                                                                                 \
+        c = 0;                                                                                                          \
+        for (size_t j = 0; j < N; j++)                                                                                  \
+        {                                                                                                               \
+            c += (unsigned __int128)m * n[j] + t[i + j];                                                                \
+            t[i + j] = (uint64_t)c; c >>= 64;                                                                           \
+        }                                                                                                               \
+        for (size_t j = i + N; j < 2 * N && c; j++)                                                                     \
+        {                                                                                                               \
+            c += t[j];                                                                                                  \
+            t[j] = (uint64_t)c; c >>= 64;                                                                               \
+        }                                                                                                               \
+        hi += (uint64_t)c;                                                                                              \
+    }                                                                                                                   \
+    cy_u##BITS##_reduce(r->limb, t + N, hi, n);                                                                         \
+}                                                                                                                       \
+                                                                                                                        \
+/* fixed 4-bit windows over every exponent bit, table read with a full masked scan */                                   \
+void cy_u##BITS##_powm(const CY_U##BITS##_MONT *mont, const CY_U##BITS *base, const CY_U##BITS *exp, CY_U##BITS *out)   \
+{                                                                                                                       \
+    const size_t N = (BITS) / 64;                                                                                       \
+    CY_U##BITS table[16], acc, sel, one;                                                                                \
+    memset(&one, 0, sizeof(one)); one.limb[0] = 1;                                                                      \
+                                                                                                                        \
+    cy_u##BITS##_mont_mul(mont, &mont->r2, &one, &table[0]);                                                            \
+    cy_u##BITS##_mont_mul(mont, base, &mont->r2, &table[1]);                                                            \
+    for (size_t k = 2; k < 16; k++)                                                                                     \
+    {                                                                                                                   \
+        if(k & 1) cy_u##BITS##_mont_mul(mont, &table[k - 1], &table[1], &table[k]);                                     \
+        else cy_u##BITS##_mont_sqr(mont, &table[k / 2], &table[k]);                                                     \
+    }                                                                                                                   \
+                                                                                                                        \
+    acc = table[0];                                                                                                     \
+    for (size_t w = (BITS) / 4; w-- > 0;)                                                                               \
+    {                                                                                                                   \
+        const uint64_t d = (exp->limb[w / 16] >> ((w % 16) * 4)) & 0xF;                                                 \
+        for (size_t b = 0; b < 4; b++) cy_u##BITS##_mont_sqr(mont, &acc, &acc);                                         \
+        memset(&sel, 0, sizeof(sel));                                                                                   \
+        for (uint64_t k = 0; k < 16; k++)                                                                               \
+        {                                                                                                               \
+            const uint64_t hit = (uint64_t)0 - (uint64_t)(k == d);                                                      \
+            for (size_t j = 0; j < N; j++) sel.limb[j] |= table[k].limb[j] & hit;                                       \
+        }                                                                                                               \
+        cy_u##BITS##_mont_mul(mont, &acc, &sel, &acc);                                                                  \
+    }                                                                                                                   \
+    cy_u##BITS##_mont_mul(mont, &acc, &one, out);                                                                       \
+}
+DECL_FIXED_BIGNUM(2048)
+DECL_FIXED_BIGNUM(3072)
+DECL_FIXED_BIGNUM(4096)
+
+#define CY_RSA_FIXED_CASE(BITS)                                                                                         \
+    case (BITS):                                                                                                        \
+    {                                                                                                                   \
+        CY_U##BITS##_MONT mont; CY_U##BITS x, e;                                                                        \
+        if(cy_u##BITS##_imp(key[1], &mont.n) != CY_OK || cy_u##BITS##_imp(key[0], &e) != CY_OK) return CY_ERR;         \
+        if(cy_u##BITS##_mont_init(&mont.n, &mont) != CY_OK) return CY_ERR;                                              \
+        mpz_mod(out, in, key[1]);                                                                                       \
+        cy_u##BITS##_imp(out, &x);                                                                                      \
+        cy_u##BITS##_powm(&mont, &x, &e, &x);                                                                           \
+        cy_u##BITS##_exp(&x, out);                                                                                      \
+        return CY_OK;                                                                                                   \
+    }
+
+CY_STATE_FLAG cy_rsa_fixed_powm(const mpz_srcptr in, const mpz_t *key, mpz_ptr out)
+{
+    if(mpz_sgn(key[0]) < 0 || mpz_even_p(key[1]) || mpz_sizeinbase(key[0], 2) > mpz_sizeinbase(key[1], 2))
+    {
+        mpz_powm(out, in, key[0], key[1]);
+        return CY_OK;
+    }
+    switch (mpz_sizeinbase(key[1], 2))
+    {
+        CY_RSA_FIXED_CASE(2048)
+        CY_RSA_FIXED_CASE(3072)
+        CY_RSA_FIXED_CASE(4096)
+        default:
+            mpz_powm(out, in, key[0], key[1]);
+            return CY_OK;
+    }
+}
+
+void cy_rsa_fixed_decryption(const mpz_srcptr cy_msg, const mpz_t *key, uint8_t *c)
+{
+    mpz_t out; mpz_init(out);
+    cy_rsa_fixed_powm(cy_msg, key, out);
+    *c = (uint8_t) mpz_get_ui(out);
+    mpz_clear(out);
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                Key Container Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+/*
+ * Binary container, version 1:
+ *   "CYRSAKEY" | u8 version | u8 flags | u8 nkey | u8 nr2 | nkey numbers | nr2 numbers
+ * numbers use the spool encoding (u64 big-endian byte length, big-endian magnitude).
+ * With CY_RSA_BIN_MONT the trailing numbers are R^2 mod m, R = B^limbs(m), for
+ * n ({exp, n} keys) or each prime r_i (CRT keys), so contexts skip two divisions.
+ */
+#define CY_RSA_BIN_MAGIC "CYRSAKEY"
+#define CY_RSA_BIN_VERSION 1
+
+static CY_STATE_FLAG cy_rsa_bin_r2(mpz_srcptr m, mpz_ptr r2)
+{
+    if(mpz_sgn(m) <= 0) return CY_ERR_KEY_VALUE;
+    mpz_set_ui(r2, 0); mpz_setbit(r2, 2 * (mp_bitcnt_t)mpz_size(m) * GMP_NUMB_BITS);
+    mpz_mod(r2, r2, m);
+    return CY_OK;
+}
+
+// parses a mapped container, r2 gets CY_RSA_MAX_PRIMES entries, only the first *nr2 meaningful
+static CY_STATE_FLAG cy_rsa_bin_parse(const uint8_t *data, const size_t size, CY_KEY *key, uint8_t *flags, mpz_t r2[CY_RSA_MAX_PRIMES], uint8_t *nr2)
+{
+    const size_t head = sizeof(CY_RSA_BIN_MAGIC) - 1 + 4;
+    if(!data || size < head || memcmp(data, CY_RSA_BIN_MAGIC, head - 4)) return CY_ERR_FORMAT;
+    const uint8_t *h = data + head - 4;
+    if(h[0] != CY_RSA_BIN_VERSION) return CY_ERR_UNSUPPORTED;
+    *flags = h[1];
+    const uint8_t nkey = h[2];
+    *nr2 = h[3];
+
+    if((*flags & CY_RSA_BIN_CRT) && (*flags & CY_RSA_BIN_PUB)) return CY_ERR_FORMAT;
+    if(*flags & CY_RSA_BIN_CRT)
+    {if(nkey < CY_RSA_PRV_SIZE(2) || nkey > CY_RSA_PRV_SIZE(CY_RSA_MAX_PRIMES) || (nkey - 4) % 3) return CY_ERR_FORMAT;}
+    else if(nkey != 2) return CY_ERR_FORMAT;
+    const uint8_t nmod = (*flags & CY_RSA_BIN_CRT) ? (uint8_t)((nkey - 4) / 3) : 1;
+    if(*nr2 != ((*flags & CY_RSA_BIN_MONT) ? nmod : 0)) return CY_ERR_FORMAT;
+
+    if(cy_rsa_key_alloc(nkey, &key->key) != CY_OK) return CY_ERR_OOM;
+    key->size = nkey;
+    size_t off = head;
+    CY_STATE_FLAG st = CY_OK;
+    for (uint8_t i = 0; i < nkey && st == CY_OK; i++) st = cy_spool_get_mpz(data, size, &off, key->key[i]);
+    for (uint8_t i = 0; i < *nr2 && st == CY_OK; i++) st = cy_spool_get_mpz(data, size, &off, r2[i]);
+    if(st == CY_OK && off != size) st = CY_ERR_FORMAT;
+    if(st == CY_OK && (*flags & CY_RSA_BIN_CRT) && mpz_cmp_ui(key->key[CY_RSA_PRV_U], nmod)) st = CY_ERR_FORMAT;
+    if(st != CY_OK) cy_rsa_prv_key_free(key);
+    return st;
+}
+
+// without CY_RSA_BIN_CRT only key->key[0] and key->key[1] are written
+CY_STATE_FLAG cy_rsa_key_bin_exp(const char *path, const CY_KEY *prvkey, const uint8_t flags)
+{
+    uint8_t u = 0;
+    if(!prvkey || !prvkey->key || prvkey->size < 2) return cy_state_manager(CY_ERR_ARG, __func__, ": key is NULL");
+    if((flags & CY_RSA_BIN_CRT) && cy_rsa_prv_key_check(prvkey, &u) != CY_OK)
+        return cy_state_manager(CY_ERR_KEY, __func__, ": not a CRT private key");
+    const mpz_t *key = prvkey->key;
+
+    const uint8_t nkey = (flags & CY_RSA_BIN_CRT) ? (uint8_t)CY_RSA_PRV_SIZE(u) : 2;
+    const uint8_t nr2 = (flags & CY_RSA_BIN_MONT) ? ((flags & CY_RSA_BIN_CRT) ? u : 1) : 0;
+    const uint8_t head[4] = {CY_RSA_BIN_VERSION, (uint8_t)(flags & (CY_RSA_BIN_CRT | CY_RSA_BIN_MONT | CY_RSA_BIN_PUB)), nkey, nr2};
+
+    uint8_t *buff = NULL; size_t size = 0, cap = 0;
+    CY_STATE_FLAG st = cy_spool_put(&buff, &size, &cap, CY_RSA_BIN_MAGIC, sizeof(CY_RSA_BIN_MAGIC) - 1);
+    if(st == CY_OK) st = cy_spool_put(&buff, &size, &cap, head, sizeof(head));
+    for (uint8_t i = 0; i < nkey && st == CY_OK; i++) st = cy_spool_put_mpz(&buff, &size, &cap, key[i]);
+
+    mpz_t r2; mpz_init(r2);
+    for (uint8_t i = 0; i < nr2 && st == CY_OK; i++)
+    {
+        st = cy_rsa_bin_r2((flags & CY_RSA_BIN_CRT) ? key[CY_RSA_PRV_PRIME(i)] : key[1], r2);
+        if(st == CY_OK) st = cy_spool_put_mpz(&buff, &size, &cap, r2);
+    }
+    mpz_clear(r2);
+    // the container may hold a private key, every exit wipes it first
+    if(st != CY_OK) {cy_wipe(buff, cap); free(buff); return cy_state_manager(st, __func__, ": encoding failed");}
+
+    FILE *fp;
+    if(open_file(&fp, "wb", path) == CY_ERR) {cy_wipe(buff, cap); free(buff); return CY_ERR;}
+    size_t w = fwrite(buff, 1, size, fp);
+    cy_wipe(buff, cap); free(buff);
+    if(close_file(fp) == CY_ERR) return CY_ERR;
+    if(w != size) return cy_state_manager(CY_ERR_IO, __func__, ": short write");
+    return CY_OK;
+}
+
+// key is a {exp, n} pair (size 2) or a CRT private key, CY_RSA_BIN_CRT in *flags (may be NULL) says
+// which; release it with cy_rsa_prv_key_free either way
+CY_STATE_FLAG cy_rsa_key_bin_imp(const char *path, CY_KEY *key, uint8_t *flags)
+{
+    const uint8_t *data; size_t size; uint8_t f = 0, nr2 = 0; mpz_t r2[CY_RSA_MAX_PRIMES];
+    if(!key) return cy_state_manager(CY_ERR_ARG, __func__, ": key is NULL");
+    key->key = NULL; key->size = 0;
+    if(cy_file_map(path, &data, &size) != CY_OK) return CY_ERR;
+
+    for (uint8_t i = 0; i < CY_RSA_MAX_PRIMES; i++) mpz_init(r2[i]);
+    CY_STATE_FLAG st = cy_rsa_bin_parse(data, size, key, &f, r2, &nr2);
+    for (uint8_t i = 0; i < CY_RSA_MAX_PRIMES; i++) mpz_clear(r2[i]);
+    cy_file_unmap(data, size);
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": not a key container");
+    if(flags) *flags = f;
+    return CY_OK;
+}
+
+// loads a container straight into a context, reusing stored R^2 values when present
+CY_STATE_FLAG cy_rsa_ctx_bin_imp(const char *path, CY_RSA_CTX **ctx)
+{
+    const uint8_t *data; size_t size; uint8_t f = 0, nr2 = 0; mpz_t r2[CY_RSA_MAX_PRIMES];
+    mpz_srcptr r2p[CY_RSA_MAX_PRIMES]; CY_KEY key = {NULL, 0};
+    if(!ctx) return cy_state_manager(CY_ERR_ARG, __func__, ": ctx is NULL");
+    if(cy_file_map(path, &data, &size) != CY_OK) return CY_ERR;
+
+    for (uint8_t i = 0; i < CY_RSA_MAX_PRIMES; i++) {mpz_init(r2[i]); r2p[i] = r2[i];}
+    CY_STATE_FLAG st = cy_rsa_bin_parse(data, size, &key, &f, r2, &nr2);
+    cy_file_unmap(data, size);
+    if(st == CY_OK)
+    {
+        if(f & CY_RSA_BIN_CRT) st = cy_rsa_ctx_crt_setup(&key, nr2 ? r2p : NULL, 1, ctx);
+        else st = cy_rsa_ctx_setup(key.key[0], key.key[1], nr2 ? r2p[0] : NULL, !(f & CY_RSA_BIN_PUB), 1, ctx);
+        cy_rsa_prv_key_free(&key);
+    }
+    for (uint8_t i = 0; i < CY_RSA_MAX_PRIMES; i++) mpz_clear(r2[i]);
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": rsa context setup failed");
+    return CY_OK;
+}
+
+/*
+ * PKCS#1 (RFC 8017 appendix A.1) DER:
+ *   RSAPublicKey  ::= SEQUENCE { n, e }
+ *   RSAPrivateKey ::= SEQUENCE { version, n, e, d, p, q, dP, dQ, qInv, otherPrimeInfos OPTIONAL }
+ * The CRT key layout already follows the RFC order, r_1 = p, r_2 = q, COEF(1) = qInv.
+ */
+#define CY_DER_INT 0x02
+#define CY_DER_SEQ 0x30
+
+static CY_STATE_FLAG cy_der_put_head(uint8_t **buff, size_t *size, size_t *cap, const uint8_t tag, const size_t len)
+{
+    uint8_t h[10]; size_t hl = 0;
+    h[hl++] = tag;
+    if(len < 0x80) h[hl++] = (uint8_t)len;
+    else
+    {
+        size_t nb = 0;
+        for (size_t l = len; l; l >>= 8) nb++;
+        h[hl++] = (uint8_t)(0x80 | nb);
+        for (size_t i = nb; i-- > 0;) h[hl++] = (uint8_t)(len >> (8 * i));
+    }
+    return cy_spool_put(buff, size, cap, h, hl);
+}
+
+static CY_STATE_FLAG cy_der_put_int(uint8_t **buff, size_t *size, size_t *cap, mpz_srcptr z)
+{
+    if(mpz_sgn(z) < 0) return CY_ERR_VALUE;
+    size_t len = mpz_sgn(z) ? (mpz_sizeinbase(z, 2) + 7) / 8 : 0;
+    // positive INTEGERs get a 0x00 in front when the top bit is set, zero is a single 0x00
+    const int pad = !len || mpz_tstbit(z, 8 * len - 1);
+    uint8_t *tmp = malloc(len + 1);
+    if(!tmp) return CY_ERR_OOM;
+    tmp[0] = 0;
+    if(len) mpz_export(tmp + 1, NULL, 1, 1, 1, 0, z);
+    CY_STATE_FLAG st = cy_der_put_head(buff, size, cap, CY_DER_INT, len + (size_t)pad);
+    if(st == CY_OK) st = cy_spool_put(buff, size, cap, tmp + 1 - pad, len + (size_t)pad);
+    cy_wipe(tmp, len + 1);
+    free(tmp);
+    return st;
+}
+
+// wraps body in a SEQUENCE and appends it
+static CY_STATE_FLAG cy_der_put_seq(uint8_t **buff, size_t *size, size_t *cap, const uint8_t *body, const size_t len)
+{
+    CY_STATE_FLAG st = cy_der_put_head(buff, size, cap, CY_DER_SEQ, len);
+    return st == CY_OK ? cy_spool_put(buff, size, cap, body, len) : st;
+}
+
+static CY_STATE_FLAG cy_der_get_head(const uint8_t *buff, const size_t size, size_t *off, const uint8_t tag, size_t *len)
+{
+    if(*off + 2 > size || buff[*off] != tag) return CY_ERR_FORMAT;
+    size_t l = buff[*off + 1]; *off += 2;
+    if(l & 0x80)
+    {
+        // DER lengths are minimal: no leading zero byte and the long form only from 0x80 up
+        size_t nb = l & 0x7F; l = 0;
+        if(nb == 0 || nb > sizeof(size_t) || *off + nb > size || !buff[*off]) return CY_ERR_FORMAT;
+        for (size_t i = 0; i < nb; i++) l = (l << 8) | buff[(*off)++];
+        if(l < 0x80) return CY_ERR_FORMAT;
+    }
+    if(l > size - *off) return CY_ERR_FORMAT;
+    *len = l;
+    return CY_OK;
+}
+
+static CY_STATE_FLAG cy_der_get_int(const uint8_t *buff, const size_t size, size_t *off, mpz_ptr z)
+{
+    size_t len;
+    if(cy_der_get_head(buff, size, off, CY_DER_INT, &len) != CY_OK || !len || (buff[*off] & 0x80)) return CY_ERR_FORMAT;
+    // a leading 0x00 is only there to clear the sign bit of the next byte
+    if(len > 1 && !buff[*off] && !(buff[*off + 1] & 0x80)) return CY_ERR_FORMAT;
+    mpz_import(z, len, 1, 1, 1, 0, buff + *off); *off += len;
+    return CY_OK;
+}
+
+static CY_STATE_FLAG cy_der_write(const char *path, const uint8_t *buff, const size_t size)
+{
+    FILE *fp;
+    if(open_file(&fp, "wb", path) == CY_ERR) return CY_ERR;
+    size_t w = fwrite(buff, 1, size, fp);
+    if(close_file(fp) == CY_ERR) return CY_ERR;
+    return w == size ? CY_OK : CY_ERR_IO;
+}
+
+CY_STATE_FLAG cy_rsa_pub_key_der_exp(const char *path, const mpz_t *pubkey)
+{
+    uint8_t *body = NULL, *der = NULL; size_t bsize = 0, bcap = 0, dsize = 0, dcap = 0;
+    if(!pubkey) return cy_state_manager(CY_ERR_ARG, __func__, ": key is NULL");
+    CY_STATE_FLAG st = cy_der_put_int(&body, &bsize, &bcap, pubkey[1]);
+    if(st == CY_OK) st = cy_der_put_int(&body, &bsize, &bcap, pubkey[0]);
+    if(st == CY_OK) st = cy_der_put_seq(&der, &dsize, &dcap, body, bsize);
+    if(st == CY_OK) st = cy_der_write(path, der, dsize);
+    free(body); free(der);
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": DER export failed");
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_pub_key_der_imp(const char *path, mpz_t **pubkey)
+{
+    const uint8_t *data; size_t size, off = 0, len;
+    if(!pubkey) return cy_state_manager(CY_ERR_ARG, __func__, ": key is NULL");
+    if(cy_file_map(path, &data, &size) != CY_OK) return CY_ERR;
+
+    if(cy_rsa_key_alloc(2, pubkey) != CY_OK) {cy_file_unmap(data, size); return CY_ERR_OOM;}
+    CY_STATE_FLAG st = cy_der_get_head(data, size, &off, CY_DER_SEQ, &len);
+    if(st == CY_OK && off + len != size) st = CY_ERR_FORMAT;
+    if(st == CY_OK) st = cy_der_get_int(data, size, &off, (*pubkey)[1]);
+    if(st == CY_OK) st = cy_der_get_int(data, size, &off, (*pubkey)[0]);
+    if(st == CY_OK && off != size) st = CY_ERR_FORMAT;
+    cy_file_unmap(data, size);
+    if(st != CY_OK) {cy_rsa_key_free(*pubkey); *pubkey = NULL; return cy_state_manager(st, __func__, ": not a PKCS#1 public key");}
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_prv_key_der_exp(const char *path, const CY_KEY *key)
+{
+    uint8_t u = 0;
+    uint8_t *body = NULL, *other = NULL, *info = NULL, *der = NULL;
+    size_t bsize = 0, bcap = 0, osize = 0, ocap = 0, isize = 0, icap = 0, dsize = 0, dcap = 0;
+    if(cy_rsa_prv_key_check(key, &u) != CY_OK) return cy_state_manager(CY_ERR_KEY, __func__, ": not a CRT private key");
+    const mpz_t *prvkey = key->key;
+
+    mpz_t version; mpz_init_set_ui(version, u > 2);
+    mpz_srcptr field[9] = {version, prvkey[1], prvkey[CY_RSA_PRV_E], prvkey[0], prvkey[CY_RSA_PRV_PRIME(0)],
+                           prvkey[CY_RSA_PRV_PRIME(1)], prvkey[CY_RSA_PRV_EXP(0)], prvkey[CY_RSA_PRV_EXP(1)], prvkey[CY_RSA_PRV_COEF(1)]};
+    CY_STATE_FLAG st = CY_OK;
+    for (size_t i = 0; i < 9 && st == CY_OK; i++) st = cy_der_put_int(&body, &bsize, &bcap, field[i]);
+    for (uint8_t i = 2; i < u && st == CY_OK; i++)
+    {
+        isize = 0;
+        st = cy_der_put_int(&info, &isize, &icap, prvkey[CY_RSA_PRV_PRIME(i)]);
+        if(st == CY_OK) st = cy_der_put_int(&info, &isize, &icap, prvkey[CY_RSA_PRV_EXP(i)]);
+        if(st == CY_OK) st = cy_der_put_int(&info, &isize, &icap, prvkey[CY_RSA_PRV_COEF(i)]);
+        if(st == CY_OK) st = cy_der_put_seq(&other, &osize, &ocap, info, isize);
+    }
+    if(st == CY_OK && u > 2) st = cy_der_put_seq(&body, &bsize, &bcap, other, osize);
+    if(st == CY_OK) st = cy_der_put_seq(&der, &dsize, &dcap, body, bsize);
+    if(st == CY_OK) st = cy_der_write(path, der, dsize);
+    mpz_clear(version);
+    cy_wipe(body, bcap); cy_wipe(other, ocap); cy_wipe(info, icap); cy_wipe(der, dcap);
+    free(body); free(other); free(info); free(der);
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": DER export failed");
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_prv_key_der_imp(const char *path, CY_KEY *prvkey)
+{
+    const uint8_t *data; size_t size, off = 0, len;
+    if(!prvkey) return cy_state_manager(CY_ERR_ARG, __func__, ": key is NULL");
+    prvkey->key = NULL; prvkey->size = 0;
+    if(cy_file_map(path, &data, &size) != CY_OK) return CY_ERR;
+
+    mpz_t field[9], other[3 * (CY_RSA_MAX_PRIMES - 2)];
+    for (size_t i = 0; i < 9; i++) mpz_init(field[i]);
+    for (size_t i = 0; i < 3 * (CY_RSA_MAX_PRIMES - 2); i++) mpz_init(other[i]);
+    uint8_t u = 2;
+
+    CY_STATE_FLAG st = cy_der_get_head(data, size, &off, CY_DER_SEQ, &len);
+    if(st == CY_OK && off + len != size) st = CY_ERR_FORMAT;
+    for (size_t i = 0; i < 9 && st == CY_OK; i++) st = cy_der_get_int(data, size, &off, field[i]);
+    if(st == CY_OK && mpz_cmp_ui(field[0], 1) > 0) st = CY_ERR_UNSUPPORTED;
+    if(st == CY_OK && off < size)
+    {
+        // otherPrimeInfos: SEQUENCE OF SEQUENCE {prime, exponent, coefficient}
+        size_t end;
+        st = cy_der_get_head(data, size, &off, CY_DER_SEQ, &len);
+        for (end = off + len; st == CY_OK && off < end; u++)
+        {
+            if(u == CY_RSA_MAX_PRIMES) {st = CY_ERR_UNSUPPORTED; break;}
+            size_t ilen = 0;
+            st = cy_der_get_head(data, size, &off, CY_DER_SEQ, &ilen);
+            if(st == CY_OK && ilen > end - off) st = CY_ERR_FORMAT;
+            // each OtherPrimeInfo holds exactly its three INTEGERs, parsed within its own length
+            const size_t iend = off + ilen;
+            for (size_t k = 0; k < 3 && st == CY_OK; k++) st = cy_der_get_int(data, iend, &off, other[3 * (u - 2) + k]);
+            if(st == CY_OK && off != iend) st = CY_ERR_FORMAT;
+        }
+        if(st == CY_OK && off != end) st = CY_ERR_FORMAT;
+    }
+    if(st == CY_OK && (off != size || (u > 2) != (mpz_cmp_ui(field[0], 1) == 0))) st = CY_ERR_FORMAT;
+    cy_file_unmap(data, size);
+
+    if(st == CY_OK) st = cy_rsa_prv_key_alloc(u, prvkey);
+    if(st == CY_OK)
+    {
+        mpz_t *k = prvkey->key;
+        mpz_set(k[0], field[3]); mpz_set(k[1], field[1]); mpz_set(k[CY_RSA_PRV_E], field[2]);
+        mpz_set(k[CY_RSA_PRV_PRIME(0)], field[4]); mpz_set(k[CY_RSA_PRV_PRIME(1)], field[5]);
+        mpz_set(k[CY_RSA_PRV_EXP(0)], field[6]); mpz_set(k[CY_RSA_PRV_EXP(1)], field[7]);
+        mpz_set(k[CY_RSA_PRV_COEF(1)], field[8]);
+        for (uint8_t i = 2; i < u; i++)
+        {
+            mpz_set(k[CY_RSA_PRV_PRIME(i)], other[3 * (i - 2)]);
+            mpz_set(k[CY_RSA_PRV_EXP(i)], other[3 * (i - 2) + 1]);
+            mpz_set(k[CY_RSA_PRV_COEF(i)], other[3 * (i - 2) + 2]);
+        }
+    }
+    for (size_t i = 0; i < 9; i++) mpz_clear(field[i]);
+    for (size_t i = 0; i < 3 * (CY_RSA_MAX_PRIMES - 2); i++) mpz_clear(other[i]);
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": not a PKCS#1 private key");
+    return CY_OK;
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                    Keystore Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+/*
+ * Keys by ID (the file name) in an open addressing table that is never
+ * modified once published. A reload builds a new table and swaps the
+ * pointer. Readers only touch two atomic counters: they register in the
+ * current epoch's counter, the writer flips the epoch after the swap and
+ * frees the old table once the previous epoch's counter drains.
+ */
+#define CY_KS_RSA 1
+#define CY_KS_AES 2
+
+typedef struct CY_KS_ENTRY
+{
+    char *id;               // NULL marks an empty bucket
+    uint64_t hash;
+    uint8_t type;           // CY_KS_RSA or CY_KS_AES
+    CY_KEY key;             // {exp, n} (size 2) or CRT private key, as loaded
+    CY_RSA_CTX *ctx;
+    CY_AES_SCHED aes;
+} CY_KS_ENTRY;
+
+typedef struct CY_KS_TABLE
+{
+    size_t mask;            // capacity - 1, capacity a power of two
+    size_t count;
+    CY_KS_ENTRY *entry;
+} CY_KS_TABLE;
+
+struct CY_KEYSTORE
+{
+    _Atomic(CY_KS_TABLE *) table;
+    atomic_uint epoch;
+    atomic_size_t reader[2];
+    pthread_mutex_t writer;
+    size_t nslot;           // scratch slots per RSA context, one per expected concurrent caller
+};
+
+// FNV-1a
+static uint64_t cy_ks_hash(const char *id)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (; *id; id++) h = (h ^ (uint8_t)*id) * 0x100000001b3ULL;
+    return h;
+}
+
+static void cy_ks_entry_free(CY_KS_ENTRY *e)
+{
+    cy_rsa_prv_key_free(&e->key);
+    cy_rsa_ctx_free(e->ctx);
+    free(e->id);
+    cy_wipe(e, sizeof(*e));
+}
+
+static void cy_ks_table_free(CY_KS_TABLE *t)
+{
+    if(!t) return;
+    for (size_t i = 0; t->entry && i <= t->mask; i++) if(t->entry[i].id) cy_ks_entry_free(&t->entry[i]);
+    free(t->entry); free(t);
+}
+
+static CY_KS_ENTRY *cy_ks_find(const CY_KS_TABLE *t, const char *id, const uint64_t h)
+{
+    for (size_t i = (size_t)h & t->mask;; i = (i + 1) & t->mask)
+    {
+        CY_KS_ENTRY *e = &t->entry[i];
+        if(!e->id) return NULL;
+        if(e->hash == h && strcmp(e->id, id) == 0) return e;
+    }
+}
+
+// moves *src into t, keeping the load factor at or below 1/2
+static CY_STATE_FLAG cy_ks_insert(CY_KS_TABLE *t, CY_KS_ENTRY *src)
+{
+    if(2 * (t->count + 1) > t->mask + 1)
+    {
+        size_t cap = 2 * (t->mask + 1);
+        CY_KS_ENTRY *old = t->entry, *entry = calloc(cap, sizeof(entry[0]));
+        if(!entry) return CY_ERR_OOM;
+        size_t omask = t->mask;
+        t->entry = entry; t->mask = cap - 1;
+        for (size_t i = 0; old && i <= omask; i++)
+        {
+            if(!old[i].id) continue;
+            size_t j = (size_t)old[i].hash & t->mask;
+            while (t->entry[j].id) j = (j + 1) & t->mask;
+            t->entry[j] = old[i];
+        }
+        if(old) cy_wipe(old, (omask + 1) * sizeof(old[0]));
+        free(old);
+    }
+    if(cy_ks_find(t, src->id, src->hash)) return CY_ERR_VALUE;
+    size_t j = (size_t)src->hash & t->mask;
+    while (t->entry[j].id) j = (j + 1) & t->mask;
+    t->entry[j] = *src; t->count++;
+    cy_wipe(src, sizeof(*src));
+    return CY_OK;
+}
+
+static int cy_ks_text_numbers(const uint8_t *data, const size_t size)
+{
+    int n = 0, in = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        if(data[i] >= '0' && data[i] <= '9') {if(!in) n++; in = 1;}
+        else if(data[i] == ' ' || data[i] == '\n' || data[i] == '\r' || data[i] == '\t') in = 0;
+        else return -1;
+    }
+    return n;
+}
+
+// the file name suffix is the type tag for formats without a magic of their own
+static int cy_ks_suffix(const char *path, const char *ext)
+{
+    size_t plen = strlen(path), elen = strlen(ext);
+    return plen > elen && strcmp(path + plen - elen, ext) == 0;
+}
+
+/*
+ * One key file into an entry, the type is never guessed from the bytes alone:
+ * "CYRSAKEY" binary container, *.der PKCS#1 DER, *.aes 16 raw bytes of AES-128,
+ * anything else only as decimal text (2 numbers = {exp, n}, more = CRT).
+ * Files that fit none of these are left alone (CY_ERR_UNSUPPORTED, quietly).
+ */
+static CY_STATE_FLAG cy_ks_load_file(const char *path, const size_t nslot, CY_KS_ENTRY *e)
+{
+    const uint8_t *data; size_t size;
+    if(cy_file_map(path, &data, &size) != CY_OK) return CY_ERR_OPEN;
+
+    CY_STATE_FLAG st = CY_ERR_UNSUPPORTED;
+    const int der = cy_ks_suffix(path, ".der"), aes = cy_ks_suffix(path, ".aes");
+    int nums = der || aes ? -1 : cy_ks_text_numbers(data, size);
+    uint8_t crt = 0;
+    if(!der && !aes && size >= 8 && memcmp(data, CY_RSA_BIN_MAGIC, 8) == 0)
+    {
+        uint8_t flags = 0, nr2 = 0; mpz_t r2[CY_RSA_MAX_PRIMES]; mpz_srcptr r2p[CY_RSA_MAX_PRIMES];
+        for (uint8_t i = 0; i < CY_RSA_MAX_PRIMES; i++) {mpz_init(r2[i]); r2p[i] = r2[i];}
+        st = cy_rsa_bin_parse(data, size, &e->key, &flags, r2, &nr2);
+        if(st == CY_OK)
+        {
+            crt = flags & CY_RSA_BIN_CRT;
+            st = crt ? cy_rsa_ctx_crt_setup(&e->key, nr2 ? r2p : NULL, nslot, &e->ctx)
+                     : cy_rsa_ctx_setup(e->key.key[0], e->key.key[1], nr2 ? r2p[0] : NULL, !(flags & CY_RSA_BIN_PUB), nslot, &e->ctx);
+        }
+        for (uint8_t i = 0; i < CY_RSA_MAX_PRIMES; i++) mpz_clear(r2[i]);
+    }
+    else if(nums >= 2)
+    {
+        crt = nums > 2;
+        if(crt) st = cy_rsa_prv_key_imp(path, &e->key);
+        else if((st = cy_rsa_key_imp(path, &e->key.key)) == CY_OK) e->key.size = 2;
+        if(st == CY_OK)
+        {
+            // a bare {exp, n} pair does not say which exponent it is, assume the private one
+            st = crt ? cy_rsa_ctx_crt_setup(&e->key, NULL, nslot, &e->ctx) : cy_rsa_ctx_setup(e->key.key[0], e->key.key[1], NULL, 1, nslot, &e->ctx);
+        }
+    }
+    else if(der && size > 4 && data[0] == CY_DER_SEQ)
+    {
+        // RSAPrivateKey starts with a one byte version INTEGER, RSAPublicKey with the modulus
+        size_t off = 0, len;
+        crt = cy_der_get_head(data, size, &off, CY_DER_SEQ, &len) == CY_OK && off + 2 < size && data[off] == CY_DER_INT && data[off + 1] == 1;
+        if(crt) st = cy_rsa_prv_key_der_imp(path, &e->key);
+        else if((st = cy_rsa_pub_key_der_imp(path, &e->key.key)) == CY_OK) e->key.size = 2;
+        if(st == CY_OK)
+        {
+            st = crt ? cy_rsa_ctx_crt_setup(&e->key, NULL, nslot, &e->ctx) : cy_rsa_ctx_setup(e->key.key[0], e->key.key[1], NULL, 0, nslot, &e->ctx);
+        }
+    }
+    else if(aes && size == 16)
+    {
+        __uint128_t key = 0;
+        for (int i = 0; i < 16; i++) key |= ((__uint128_t)(data[i])) << (i * 8);
+        cy_aes_sched_init(key, &e->aes);
+        cy_wipe(&key, sizeof(key));
+        e->type = CY_KS_AES;
+        st = CY_OK;
+    }
+    cy_file_unmap(data, size);
+    if(st == CY_OK && !e->type) e->type = CY_KS_RSA;
+    return st;
+}
+
+CY_STATE_FLAG cy_keystore_init(const size_t nslot, CY_KEYSTORE **ks)
+{
+    if(!ks) return cy_state_manager(CY_ERR_ARG, __func__, ": ks is NULL");
+    *ks = calloc(1, sizeof(**ks));
+    CY_KS_TABLE *t = calloc(1, sizeof(*t));
+    CY_KS_ENTRY *entry = calloc(16, sizeof(entry[0]));
+    if(!*ks || !t || !entry) {free(*ks); free(t); free(entry); *ks = NULL; return cy_state_manager(CY_ERR_OOM, __func__, "");}
+    t->entry = entry; t->mask = 15;
+    atomic_init(&(*ks)->table, t);
+    atomic_init(&(*ks)->epoch, 0);
+    atomic_init(&(*ks)->reader[0], 0); atomic_init(&(*ks)->reader[1], 0);
+    pthread_mutex_init(&(*ks)->writer, NULL);
+    (*ks)->nslot = nslot ? nslot : 1;
+    return CY_OK;
+}
+
+// publishes t and returns the table it replaced once no reader can still see it
+static CY_KS_TABLE *cy_ks_publish(CY_KEYSTORE *ks, CY_KS_TABLE *t)
+{
+    CY_KS_TABLE *old = atomic_exchange(&ks->table, t);
+    unsigned prev = atomic_fetch_add(&ks->epoch, 1) & 1;
+    while (atomic_load(&ks->reader[prev])) sched_yield();
+    return old;
+}
+
+// replaces the whole store with the key files of dir, on any error the current keys stay
+CY_STATE_FLAG cy_keystore_load(CY_KEYSTORE *ks, const char *dir)
+{
+    if(!ks || !dir || !*dir) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    CY_KS_TABLE *t = calloc(1, sizeof(*t));
+    if(!t) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    t->entry = calloc(16, sizeof(t->entry[0])); t->mask = 15;
+    if(!t->entry) {free(t); return cy_state_manager(CY_ERR_OOM, __func__, "");}
+
+    CY_STATE_FLAG st = CY_OK;
+    const size_t dlen = strlen(dir);
+    char *path = NULL;
+#ifdef _WIN32
+    char *pattern = malloc(dlen + 3);
+    WIN32_FIND_DATAA fd; HANDLE fh = INVALID_HANDLE_VALUE;
+    if(pattern) {memcpy(pattern, dir, dlen); memcpy(pattern + dlen, "\\*", 3); fh = FindFirstFileA(pattern, &fd);}
+    free(pattern);
+    if(fh == INVALID_HANDLE_VALUE) {cy_ks_table_free(t); return cy_state_manager(CY_ERR_OPEN, __func__, ": cannot list directory");}
+    for (BOOL more = TRUE; more && st == CY_OK; more = FindNextFileA(fh, &fd))
+    {
+        if(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        const char *name = fd.cFileName;
+#else
+    DIR *dp = opendir(dir);
+    if(!dp) {perror("opendir"); cy_ks_table_free(t); return cy_state_manager(CY_ERR_OPEN, __func__, "");}
+    for (struct dirent *de; st == CY_OK && (de = readdir(dp));)
+    {
+        const char *name = de->d_name;
+        if(name[0] == '.') continue;
+#endif
+        size_t nlen = strlen(name);
+        char *tmp = realloc(path, dlen + nlen + 2);
+        if(!tmp) {st = CY_ERR_OOM; break;}
+        path = tmp;
+        memcpy(path, dir, dlen); path[dlen] = '/'; memcpy(path + dlen + 1, name, nlen + 1);
+
+        CY_KS_ENTRY e; memset(&e, 0, sizeof(e));
+        CY_STATE_FLAG fst = cy_ks_load_file(path, ks->nslot, &e);
+        if(fst == CY_ERR_UNSUPPORTED || fst == CY_ERR_OPEN) {cy_ks_entry_free(&e); continue;}
+        if(fst == CY_OK)
+        {
+            e.id = malloc(nlen + 1);
+            if(!e.id) fst = CY_ERR_OOM;
+            else {memcpy(e.id, name, nlen + 1); e.hash = cy_ks_hash(name); fst = cy_ks_insert(t, &e);}
+        }
+        cy_ks_entry_free(&e);
+        st = fst;
+    }
+#ifdef _WIN32
+    FindClose(fh);
+#else
+    closedir(dp);
+#endif
+    free(path);
+    if(st != CY_OK) {cy_ks_table_free(t); return cy_state_manager(st, __func__, ": keystore reload failed, keeping current keys");}
+
+    pthread_mutex_lock(&ks->writer);
+    CY_KS_TABLE *old = cy_ks_publish(ks, t);
+    pthread_mutex_unlock(&ks->writer);
+    cy_ks_table_free(old);
+    return CY_OK;
+}
+
+// read side: lookups are valid until the matching cy_keystore_leave, never blocks
+unsigned cy_keystore_enter(CY_KEYSTORE *ks)
+{
+    for (;;)
+    {
+        unsigned e = atomic_load(&ks->epoch) & 1;
+        atomic_fetch_add(&ks->reader[e], 1);
+        if((atomic_load(&ks->epoch) & 1) == e) return e;
+        atomic_fetch_sub(&ks->reader[e], 1);
+    }
+}
+
+void cy_keystore_leave(CY_KEYSTORE *ks, const unsigned epoch)
+{
+    atomic_fetch_sub(&ks->reader[epoch & 1], 1);
+}
+
+// ctx and key (either may be NULL) point into the store, use them between enter and leave
+CY_STATE_FLAG cy_keystore_rsa(CY_KEYSTORE *ks, const char *id, CY_RSA_CTX **ctx, const CY_KEY **key)
+{
+    if(!ks || !id) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    const CY_KS_ENTRY *e = cy_ks_find(atomic_load(&ks->table), id, cy_ks_hash(id));
+    if(!e || e->type != CY_KS_RSA) return cy_state_manager(CY_ERR_KEY, __func__, ": no RSA key with this id");
+    if(ctx) *ctx = e->ctx;
+    if(key) *key = &e->key;
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_keystore_aes(CY_KEYSTORE *ks, const char *id, const CY_AES_SCHED **sched)
+{
+    if(!ks || !id || !sched) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    const CY_KS_ENTRY *e = cy_ks_find(atomic_load(&ks->table), id, cy_ks_hash(id));
+    if(!e || e->type != CY_KS_AES) return cy_state_manager(CY_ERR_KEY, __func__, ": no AES key with this id");
+    *sched = &e->aes;
+    return CY_OK;
+}
+
+size_t cy_keystore_count(CY_KEYSTORE *ks)
+{
+    const unsigned e = cy_keystore_enter(ks);
+    size_t n = atomic_load(&ks->table)->count;
+    cy_keystore_leave(ks, e);
+    return n;
+}
+
+void cy_keystore_free(CY_KEYSTORE *ks)
+{
+    if(!ks) return;
+    cy_ks_table_free(atomic_load(&ks->table));
+    pthread_mutex_destroy(&ks->writer);
+    free(ks);
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                   Signature Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+// EMSA-PSS (RFC 8017) with SHA-256, MGF1-SHA-256 and a 32-byte salt
+#define CY_PSS_HLEN 32
+#define CY_PSS_SLEN 32
+
+// buff ^= MGF1(seed, len)
+static void cy_rsa_pss_mgf1(const uint8_t seed[CY_PSS_HLEN], uint8_t *buff, const size_t len)
+{
+    uint8_t in[CY_PSS_HLEN + 4], mask[CY_PSS_HLEN];
+    memcpy(in, seed, CY_PSS_HLEN);
+    for (uint32_t ctr = 0; (size_t)ctr * CY_PSS_HLEN < len; ctr++)
+    {
+        in[CY_PSS_HLEN] = (uint8_t)(ctr >> 24); in[CY_PSS_HLEN + 1] = (uint8_t)(ctr >> 16);
+        in[CY_PSS_HLEN + 2] = (uint8_t)(ctr >> 8); in[CY_PSS_HLEN + 3] = (uint8_t)ctr;
+        cy_sha256(in, sizeof(in), mask);
+        for (size_t i = 0; i < CY_PSS_HLEN && ctr * CY_PSS_HLEN + i < len; i++) buff[ctr * CY_PSS_HLEN + i] ^= mask[i];
+    }
+}
+
+// H = SHA-256(0x00 * 8 || SHA-256(msg) || salt)
+static void cy_rsa_pss_hash(const uint8_t *msg, const size_t len, const uint8_t salt[CY_PSS_SLEN], uint8_t h[CY_PSS_HLEN])
+{
+    uint8_t m[8 + CY_PSS_HLEN + CY_PSS_SLEN] = {0};
+    cy_sha256(msg, len, m + 8);
+    memcpy(m + 8 + CY_PSS_HLEN, salt, CY_PSS_SLEN);
+    cy_sha256(m, sizeof(m), h);
+}
+
+// s^e mod n, e = 65537 as 16 squarings and one multiply
+static void cy_rsa_pub_exp(mpz_srcptr in, const mpz_t *pubkey, mpz_ptr out)
+{
+    if(mpz_cmp_ui(pubkey[0], 65537) != 0) {mpz_powm(out, in, pubkey[0], pubkey[1]); return;}
+    mpz_t t; mpz_init(t);
+    mpz_mod(t, in, pubkey[1]);
+    mpz_set(out, t);
+    for (int i = 0; i < 16; i++) {mpz_mul(out, out, out); mpz_tdiv_r(out, out, pubkey[1]);}
+    mpz_mul(out, out, t); mpz_tdiv_r(out, out, pubkey[1]);
+    mpz_clear(t);
+}
+
+// quiet check, the batch reports per item instead of printing
+static CY_STATE_FLAG cy_rsa_pss_check(const uint8_t *msg, const size_t len, const mpz_t *pubkey, mpz_srcptr sig)
+{
+    if(!pubkey || !sig || (!msg && len)) return CY_ERR_ARG;
+    if(mpz_sgn(sig) < 0 || mpz_cmp(sig, pubkey[1]) >= 0) return CY_ERR_VALUE;
+
+    const size_t embits = mpz_sizeinbase(pubkey[1], 2) - 1, emlen = (embits + 7) / 8;
+    if(emlen < CY_PSS_HLEN + CY_PSS_SLEN + 2) return CY_ERR_KEY_SIZE;
+
+    mpz_t m; mpz_init(m);
+    cy_rsa_pub_exp(sig, pubkey, m);
+    CY_STATE_FLAG st = CY_ERR_VALUE;
+    uint8_t *em = calloc(emlen, 1);
+    if(!em) {mpz_clear(m); return CY_ERR_OOM;}
+    if(mpz_sizeinbase(m, 2) > emlen * 8) goto done;
+    size_t mlen = (mpz_sizeinbase(m, 2) + 7) / 8;
+    if(mpz_sgn(m)) mpz_export(em + emlen - mlen, NULL, 1, 1, 1, 0, m);
+
+    const size_t dblen = emlen - CY_PSS_HLEN - 1;
+    const uint8_t topmask = (uint8_t)(0xFF >> (8 * emlen - embits));
+    if(em[emlen - 1] != 0xBC || (em[0] & ~topmask)) goto done;
+    cy_rsa_pss_mgf1(em + dblen, em, dblen);
+    em[0] &= topmask;
+    for (size_t i = 0; i < dblen - CY_PSS_SLEN - 1; i++) if(em[i]) goto done;
+    if(em[dblen - CY_PSS_SLEN - 1] != 0x01) goto done;
+
+    uint8_t h[CY_PSS_HLEN];
+    cy_rsa_pss_hash(msg, len, em + dblen - CY_PSS_SLEN, h);
+    if(memcmp(h, em + dblen, CY_PSS_HLEN) == 0) st = CY_OK;
+
+    done:
+    free(em); mpz_clear(m);
+    return st;
+}
+
+CY_STATE_FLAG cy_rsa_pss_sign(const uint8_t *msg, const size_t len, const CY_KEY *prvkey, mpz_ptr sig)
+{
+    uint8_t u = 0;
+    if(!sig || (!msg && len)) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    if(cy_rsa_prv_key_check(prvkey, &u) != CY_OK) return cy_state_manager(CY_ERR_KEY, __func__, ": not a CRT private key");
+    const size_t embits = mpz_sizeinbase(prvkey->key[1], 2) - 1, emlen = (embits + 7) / 8;
+    if(emlen < CY_PSS_HLEN + CY_PSS_SLEN + 2) return cy_state_manager(CY_ERR_KEY_SIZE, __func__, ": modulus too small");
+
+    uint8_t *em = calloc(emlen, 1);
+    if(!em) return cy_state_manager(CY_ERR_OOM, __func__, "");
+
+    const size_t dblen = emlen - CY_PSS_HLEN - 1;
+    uint8_t *salt = em + dblen - CY_PSS_SLEN;
+    if(BCryptGenRandom(NULL, salt, CY_PSS_SLEN, BCRYPT_USE_SYSTEM_PREFERRED_RNG) != 0)
+    {free(em); return cy_state_manager(CY_ERR_RNG, __func__, "");}
+    cy_rsa_pss_hash(msg, len, salt, em + dblen);
+    em[dblen - CY_PSS_SLEN - 1] = 0x01;
+    cy_rsa_pss_mgf1(em + dblen, em, dblen);
+    em[0] &= (uint8_t)(0xFF >> (8 * emlen - embits));
+    em[emlen - 1] = 0xBC;
+
+    mpz_t m; mpz_init(m);
+    mpz_import(m, emlen, 1, 1, 1, 0, em);
+    free(em);
+    // fixed window CRT context: the signing exponent never drives a branch or a table index
+    CY_RSA_CTX *ctx = NULL;
+    CY_STATE_FLAG st = cy_rsa_ctx_crt_setup(prvkey, NULL, 1, &ctx);
+    if(st == CY_OK) st = cy_rsa_ctx_powm(ctx, m, sig);
+    cy_rsa_ctx_free(ctx);
+    mpz_clear(m);
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": signing failed");
+
+    // a faulty CRT half would leak a factor of n through the signature, check before releasing it
+    const mpz_t pub[2] = {{*prvkey->key[CY_RSA_PRV_E]}, {*prvkey->key[1]}};
+    if(cy_rsa_pss_check(msg, len, pub, sig) != CY_OK)
+    {mpz_set_ui(sig, 0); return cy_state_manager(CY_ERR_INTERNAL, __func__, ": signature self check failed");}
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_rsa_pss_verify(const uint8_t *msg, const size_t len, const mpz_t *pubkey, mpz_srcptr sig)
+{
+    CY_STATE_FLAG st = cy_rsa_pss_check(msg, len, pubkey, sig);
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": invalid signature");
+    return CY_OK;
+}
+
+typedef struct CY_PSS_BATCH
+{
+    const uint8_t **msg;
+    const size_t *len;
+    const mpz_t **pubkey;
+    const mpz_srcptr *sig;
+    CY_STATE_FLAG *result;
+} CY_PSS_BATCH;
+
+static void cy_rsa_pss_batch_item(void *arg, size_t i)
+{
+    CY_PSS_BATCH *b = arg;
+    b->result[i] = cy_rsa_pss_check(b->msg[i], b->len[i], b->pubkey[i], b->sig[i]);
+}
+
+// result[i] is CY_OK or why item i failed, returns CY_ERR_VALUE if any item failed
+CY_STATE_FLAG cy_rsa_pss_verify_batch(const size_t count, const uint8_t *msg[], const size_t len[], const mpz_t *pubkey[], 
+                                      const mpz_srcptr sig[], const size_t nthreads, CY_STATE_FLAG result[])
+{
+    if(!msg || !len || !pubkey || !sig || !result) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL array");
+    CY_PSS_BATCH b = {msg, len, pubkey, sig, result};
+    cy_thread_for(nthreads ? nthreads : 1, count, cy_rsa_pss_batch_item, &b);
+    for (size_t i = 0; i < count; i++) if(result[i] != CY_OK) return CY_ERR_VALUE;
+    return CY_OK;
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                     Audit Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+/*
+ * Bernstein's batch GCD: product tree P = n_1 ... n_k, remainder tree
+ * down to P mod n_i^2, then g_i = gcd(n_i, (P mod n_i^2) / n_i).
+ * g_i != 1 means n_i shares a prime with another modulus (g_i = n_i for duplicates
+ * or moduli sharing both primes). Quasi linear instead of k^2 / 2 gcds.
+ */
+#define CY_BGCD_GROUP (1 << 15)    // moduli per group in the streaming variant, bounds its memory
+
+typedef struct CY_BGCD_JOB
+{
+    mpz_t *in, *out, *par;    // level below, level being built, parents (remainder pass)
+    size_t nin;
+    int sq;                   // remainder pass reduces mod in[i]^2 rather than in[i]
+} CY_BGCD_JOB;
+
+static void cy_bgcd_mul_item(void *arg, size_t i)
+{
+    CY_BGCD_JOB *job = arg;
+    if(2 * i + 1 < job->nin) mpz_mul(job->out[i], job->in[2 * i], job->in[2 * i + 1]);
+    else mpz_set(job->out[i], job->in[2 * i]);
+}
+
+// out[i] = par[i / 2] mod in[i]^2, or mod in[i] without sq
+static void cy_bgcd_rem_item(void *arg, size_t i)
+{
+    CY_BGCD_JOB *job = arg;
+    if(!job->sq) {mpz_mod(job->out[i], job->par[i / 2], job->in[i]); return;}
+    mpz_mul(job->out[i], job->in[i], job->in[i]);
+    mpz_mod(job->out[i], job->par[i / 2], job->out[i]);
+}
+
+// leaves: out[i] = gcd(n_i, (P mod n_i^2) / n_i), computed in place from the remainder
+static void cy_bgcd_leaf_item(void *arg, size_t i)
+{
+    CY_BGCD_JOB *job = arg;
+    mpz_divexact(job->out[i], job->out[i], job->in[i]);
+    mpz_gcd(job->out[i], job->out[i], job->in[i]);
+}
+
+static mpz_t *cy_bgcd_alloc(const size_t n)
+{
+    mpz_t *v = malloc((n ? n : 1) * sizeof(v[0]));
+    if(v) for (size_t i = 0; i < n; i++) mpz_init(v[i]);
+    return v;
+}
+
+static void cy_bgcd_free(mpz_t *v, const size_t n)
+{
+    if(!v) return;
+    for (size_t i = 0; i < n; i++) mpz_clear(v[i]);
+    free(v);
+}
+
+// in memory, g[i] = gcd(n[i], product of the others)
+CY_STATE_FLAG cy_rsa_batch_gcd(const size_t count, const mpz_srcptr n[], const size_t nthreads, mpz_ptr g[])
+{
+    if(!n || !g) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL array");
+    if(count < 2) {for (size_t i = 0; i < count; i++) mpz_set_ui(g[i], 1); return CY_OK;}
+    const size_t nt = nthreads ? nthreads : 1;
+
+    mpz_t *level[64]; size_t size[64], depth = 0;
+    level[0] = cy_bgcd_alloc(count); size[0] = count;
+    if(!level[0]) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    for (size_t i = 0; i < count; i++) mpz_set(level[0][i], n[i]);
+
+    CY_STATE_FLAG st = CY_OK;
+    for (; size[depth] > 1; depth++)
+    {
+        size[depth + 1] = (size[depth] + 1) / 2;
+        level[depth + 1] = cy_bgcd_alloc(size[depth + 1]);
+        if(!level[depth + 1]) {st = CY_ERR_OOM; break;}
+        CY_BGCD_JOB job = {level[depth], level[depth + 1], NULL, size[depth], 0};
+        cy_thread_for(nt, size[depth + 1], cy_bgcd_mul_item, &job);
+    }
+
+    // each level's nodes are replaced by their remainders on the way down
+    for (size_t d = depth; st == CY_OK && d-- > 0;)
+    {
+        mpz_t *rem = cy_bgcd_alloc(size[d]);
+        if(!rem) {st = CY_ERR_OOM; break;}
+        CY_BGCD_JOB job = {level[d], rem, level[d + 1], size[d], 1};
+        cy_thread_for(nt, size[d], cy_bgcd_rem_item, &job);
+        if(d == 0)
+        {
+            cy_thread_for(nt, size[0], cy_bgcd_leaf_item, &job);
+            for (size_t i = 0; i < count; i++) mpz_swap(g[i], rem[i]);
+        }
+        cy_bgcd_free(level[d + 1], size[d + 1]); level[d + 1] = NULL;
+        if(d) {cy_bgcd_free(level[d], size[d]); level[d] = rem;}
+        else cy_bgcd_free(rem, size[0]);
+    }
+    for (size_t d = 0; d <= depth; d++) cy_bgcd_free(level[d], size[d]);
+    if(st != CY_OK) return cy_state_manager(st, __func__, "");
+    return CY_OK;
+}
+
+// reads up to max raw mpz from fp, returns how many
+static size_t cy_bgcd_read(FILE *fp, mpz_t *v, const size_t max)
+{
+    size_t i = 0;
+    while (i < max && mpz_inp_raw(v[i], fp)) i++;
+    return i;
+}
+
+// acc[i] = (P mod n_i^2) / n_i mod n_i, the product of the group's other moduli mod n_i
+static void cy_bgcd_own_item(void *arg, size_t i)
+{
+    CY_BGCD_JOB *job = arg;
+    mpz_divexact(job->out[i], job->out[i], job->in[i]);
+    mpz_mod(job->out[i], job->out[i], job->in[i]);
+}
+
+// acc[i] = acc[i] * (P_j mod n_i) mod n_i
+static void cy_bgcd_acc_item(void *arg, size_t i)
+{
+    CY_BGCD_JOB *job = arg;
+    mpz_mul(job->out[i], job->out[i], job->par[i]);
+    mpz_mod(job->out[i], job->out[i], job->in[i]);
+}
+
+static void cy_bgcd_gcd_item(void *arg, size_t i)
+{
+    CY_BGCD_JOB *job = arg;
+    mpz_gcd(job->out[i], job->out[i], job->in[i]);
+}
+
+// product tree over the group in level[0], levels 1 .. *depth allocated here (NULL past a failure)
+static CY_STATE_FLAG cy_bgcd_ptree(const size_t nt, mpz_t *level[64], size_t size[64], size_t *depth)
+{
+    for (*depth = 0; size[*depth] > 1; (*depth)++)
+    {
+        size[*depth + 1] = (size[*depth] + 1) / 2;
+        level[*depth + 1] = cy_bgcd_alloc(size[*depth + 1]);
+        if(!level[*depth + 1]) return CY_ERR_OOM;
+        CY_BGCD_JOB job = {level[*depth], level[*depth + 1], NULL, size[*depth], 0};
+        cy_thread_for(nt, size[*depth + 1], cy_bgcd_mul_item, &job);
+    }
+    return CY_OK;
+}
+
+// out[i] = x mod n_i (n_i^2 with sq) for the group in level[0], down the group's product tree
+static CY_STATE_FLAG cy_bgcd_rtree(const size_t nt, mpz_srcptr x, mpz_t *level[64], const size_t size[64], const size_t depth, const int sq, mpz_t *out)
+{
+    mpz_t *cur = cy_bgcd_alloc(1);
+    if(!cur) return CY_ERR_OOM;
+    mpz_set(cur[0], x);
+    size_t ncur = 1;
+    for (size_t d = depth + 1; d-- > 0;)
+    {
+        mpz_t *next = d ? cy_bgcd_alloc(size[d]) : out;
+        if(!next) {cy_bgcd_free(cur, ncur); return CY_ERR_OOM;}
+        CY_BGCD_JOB job = {level[d], next, cur, size[d], sq};
+        cy_thread_for(nt, size[d], cy_bgcd_rem_item, &job);
+        cy_bgcd_free(cur, ncur);
+        cur = next; ncur = size[d];
+    }
+    return CY_OK;
+}
+
+/*
+ * Streaming variant for corpora that do not fit in memory: one decimal modulus
+ * per line in in_path. The moduli are cut into groups of CY_BGCD_GROUP, only one
+ * group's product tree is ever in memory. Each group's own remainder tree gives
+ * the product of its other moduli mod n_i; then the product P_j of every other
+ * group (kept in a temporary file) goes down the same tree mod n_i and is
+ * multiplied in. Memory stays at a few group trees however large the corpus,
+ * for k groups the work is k^2 remainder trees of one group each.
+ * Writes "index gcd" lines (0 based input line) for every modulus with a shared factor.
+ */
+CY_STATE_FLAG cy_rsa_batch_gcd_file(const char *in_path, const char *out_path, const size_t nthreads, size_t *nweak)
+{
+    FILE *in, *out = NULL, *mod = NULL, *root = NULL;
+    mpz_t *level[64] = {NULL}, *acc = NULL, *r = NULL, P;
+    size_t size[64] = {0}, depth = 0, count = 0, weak = 0;
+    const size_t nt = nthreads ? nthreads : 1;
+    CY_STATE_FLAG st = CY_OK;
+    mpz_init(P);
+
+    if(open_file(&in, "rb", in_path) == CY_ERR) {mpz_clear(P); return cy_state_manager(CY_ERR_OPEN, __func__, ": batch gcd failed");}
+    mod = tmpfile(); root = tmpfile();
+    if(!mod || !root) st = CY_ERR_IO;
+    while (st == CY_OK && gmp_fscanf(in, "%Zd", P) == 1)
+    {
+        if(mpz_sgn(P) <= 0) {st = CY_ERR_VALUE; break;}
+        if(!mpz_out_raw(mod, P)) st = CY_ERR_IO;
+        count++;
+    }
+    close_file(in);
+    if(st == CY_OK && count < 2) st = CY_ERR_SIZE;
+
+    const size_t gsize = count < CY_BGCD_GROUP ? count : CY_BGCD_GROUP, ngroup = count ? (count + gsize - 1) / gsize : 0;
+    if(st == CY_OK)
+    {
+        level[0] = cy_bgcd_alloc(gsize); acc = cy_bgcd_alloc(gsize); r = cy_bgcd_alloc(gsize);
+        if(!level[0] || !acc || !r) st = CY_ERR_OOM;
+    }
+
+    // every group's product P_j once, in input order
+    if(st == CY_OK) rewind(mod);
+    for (size_t j = 0; j < ngroup && st == CY_OK; j++)
+    {
+        size[0] = cy_bgcd_read(mod, level[0], gsize);
+        if(!size[0]) {st = CY_ERR_IO; break;}
+        st = cy_bgcd_ptree(nt, level, size, &depth);
+        if(st == CY_OK && !mpz_out_raw(root, level[depth][0])) st = CY_ERR_IO;
+        for (size_t d = 1; d < 64 && level[d]; d++) {cy_bgcd_free(level[d], size[d]); level[d] = NULL;}
+    }
+
+    if(st == CY_OK && open_file(&out, "wb", out_path) == CY_ERR) st = CY_ERR_OPEN;
+    if(st == CY_OK) rewind(mod);
+    for (size_t i = 0; i < ngroup && st == CY_OK; i++)
+    {
+        size[0] = cy_bgcd_read(mod, level[0], gsize);
+        if(!size[0]) {st = CY_ERR_IO; break;}
+        st = cy_bgcd_ptree(nt, level, size, &depth);
+
+        // inside the group, then every other group's product on top
+        CY_BGCD_JOB job = {level[0], acc, r, size[0], 0};
+        if(st == CY_OK) st = cy_bgcd_rtree(nt, level[depth][0], level, size, depth, 1, acc);
+        if(st == CY_OK) cy_thread_for(nt, size[0], cy_bgcd_own_item, &job);
+        rewind(root);
+        for (size_t j = 0; j < ngroup && st == CY_OK; j++)
+        {
+            if(!mpz_inp_raw(P, root)) {st = CY_ERR_IO; break;}
+            if(j == i) continue;
+            st = cy_bgcd_rtree(nt, P, level, size, depth, 0, r);
+            if(st == CY_OK) cy_thread_for(nt, size[0], cy_bgcd_acc_item, &job);
+        }
+        for (size_t d = 1; d < 64 && level[d]; d++) {cy_bgcd_free(level[d], size[d]); level[d] = NULL;}
+        if(st != CY_OK) break;
+
+        cy_thread_for(nt, size[0], cy_bgcd_gcd_item, &job);
+        for (size_t k = 0; k < size[0]; k++)
+            if(mpz_cmp_ui(acc[k], 1) != 0) {gmp_fprintf(out, "%zu %Zd\n", i * gsize + k, acc[k]); weak++;}
+    }
+    if(out && close_file(out) == CY_ERR && st == CY_OK) st = CY_ERR_CLOSE;
+
+    if(mod) fclose(mod);
+    if(root) fclose(root);
+    cy_bgcd_free(level[0], gsize); cy_bgcd_free(acc, gsize); cy_bgcd_free(r, gsize);
+    mpz_clear(P);
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": batch gcd failed");
+    if(nweak) *nweak = weak;
+    return CY_OK;
+}
+
+/*
+ * Factoring for single moduli, the weaknesses that fall out fast: Fermat for
+ * |p - q| small, Pollard p - 1 (two stages) for p - 1 smooth, Brent's rho for
+ * a small factor. f = 1 everywhere means nothing was found within the budget.
+ */
+#define CY_PM1_GAPS 256   // stage 2 keeps a^2, a^4, ..., a^512 for the prime gaps
+
+typedef struct CY_FACTOR_CTL
+{
+    atomic_int *stop;     // set once any attempt succeeds
+    double deadline;      // monotonic seconds, 0 for none
+} CY_FACTOR_CTL;
+
+static double cy_factor_clock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int cy_factor_halt(const CY_FACTOR_CTL *ctl)
+{
+    if(!ctl) return 0;
+    return (ctl->stop && atomic_load(ctl->stop)) || (ctl->deadline > 0 && cy_factor_clock() > ctl->deadline);
+}
+
+// f = g when 1 < g < n
+static int cy_factor_keep(mpz_srcptr g, mpz_srcptr n, mpz_ptr f)
+{
+    if(mpz_cmp_ui(g, 1) <= 0 || mpz_cmp(g, n) >= 0) return 0;
+    mpz_set(f, g);
+    return 1;
+}
+
+// n = a^2 - b^2 = (a - b)(a + b), a walking up from sqrt(n)
+static int cy_factor_fermat_run(mpz_srcptr n, const uint64_t max_iter, const CY_FACTOR_CTL *ctl, mpz_ptr f)
+{
+    if(mpz_even_p(n)) {mpz_set_ui(f, 2); return mpz_cmp_ui(n, 2) > 0;}
+    mpz_t a, b2, t; mpz_inits(a, b2, t, NULL);
+    int found = 0;
+    mpz_sqrtrem(a, b2, n);
+    if(!mpz_sgn(b2)) {mpz_set(f, a); found = 1;}
+    else
+    {
+        mpz_add_ui(a, a, 1);
+        mpz_mul(b2, a, a); mpz_sub(b2, b2, n);
+        for (uint64_t i = 0; i < max_iter && !found; i++)
+        {
+            if(!(i & 4095) && cy_factor_halt(ctl)) break;
+            if(mpz_perfect_square_p(b2))
+            {
+                mpz_sqrt(t, b2); mpz_sub(t, a, t);
+                found = cy_factor_keep(t, n, f);
+                if(!found) break;           // a - b = 1, n is prime
+            }
+            // (a + 1)^2 - n = b2 + 2 a + 1
+            mpz_addmul_ui(b2, a, 2); mpz_add_ui(b2, b2, 1);
+            mpz_add_ui(a, a, 1);
+        }
+    }
+    mpz_clears(a, b2, t, NULL);
+    return found;
+}
+
+/*
+ * Stage 1: a = 2^E, E the product of the prime powers up to B1. Stage 2: one
+ * extra prime q in (B1, B2], gathering prod (a^q - 1), consecutive a^q a
+ * small prime gap apart so each costs two products.
+ */
+static int cy_factor_pm1_run(mpz_srcptr n, const uint64_t B1, const uint64_t B2, const CY_FACTOR_CTL *ctl, mpz_ptr f)
+{
+    CY_PRIME_RUN run;
+    if(cy_prime_run_init(&run, 2, B1 + 1) != CY_OK) return 0;
+    mpz_t a, g, x, acc; mpz_inits(a, g, x, acc, NULL);
+    mpz_set_ui(a, 2);
+    int found = 0, done = 0;
+    uint64_t p, count = 0;
+    while (!found && !done && cy_prime_run_next(&run, &p) == CY_OK)
+    {
+        uint64_t pk = p;
+        while (pk <= B1 / p) pk *= p;
+        mpz_powm_ui(a, a, pk, n);
+        if(++count % 256) continue;
+        if(cy_factor_halt(ctl)) done = 1;
+        mpz_sub_ui(g, a, 1); mpz_gcd(g, g, n);
+        found = cy_factor_keep(g, n, f);
+        if(!mpz_cmp(g, n)) done = 1;        // every factor at once, give up
+    }
+    cy_prime_run_free(&run);
+    if(!found && !done)
+    {
+        mpz_sub_ui(g, a, 1); mpz_gcd(g, g, n);
+        found = cy_factor_keep(g, n, f);
+        if(!mpz_cmp(g, n)) done = 1;
+    }
+
+    if(!found && !done && B2 > B1 && cy_prime_run_init(&run, B1 + 1, B2 + 1) == CY_OK)
+    {
+        mpz_t *d = malloc(CY_PM1_GAPS * sizeof(d[0]));    // d[k] = a^(2 k + 2)
+        if(d)
+        {
+            mpz_init(d[0]); mpz_mul(d[0], a, a); mpz_mod(d[0], d[0], n);
+            for (size_t k = 1; k < CY_PM1_GAPS; k++) {mpz_init(d[k]); mpz_mul(d[k], d[k - 1], d[0]); mpz_mod(d[k], d[k], n);}
+            uint64_t prev = 0;
+            mpz_set_ui(acc, 1);
+            count = 0;
+            while (!found && cy_prime_run_next(&run, &p) == CY_OK)
+            {
+                const uint64_t gap = p - prev;
+                if(!prev || gap > 2 * CY_PM1_GAPS) mpz_powm_ui(x, a, p, n);
+                else {mpz_mul(x, x, d[gap / 2 - 1]); mpz_mod(x, x, n);}
+                prev = p;
+                mpz_sub_ui(g, x, 1);
+                mpz_mul(acc, acc, g); mpz_mod(acc, acc, n);
+                if(++count % 2048) continue;
+                mpz_gcd(g, acc, n);
+                found = cy_factor_keep(g, n, f);
+                if(!mpz_cmp(g, n) || cy_factor_halt(ctl)) break;
+            }
+            if(!found) {mpz_gcd(g, acc, n); found = cy_factor_keep(g, n, f);}
+            for (size_t k = 0; k < CY_PM1_GAPS; k++) mpz_clear(d[k]);
+            free(d);
+        }
+        cy_prime_run_free(&run);
+    }
+    mpz_clears(a, g, x, acc, NULL);
+    return found;
+}
+
+/*
+ * Brent's rho on x^2 + c: cycle found by doubling r, |x - y| multiplied over
+ * runs of CY_RHO_M steps so one gcd covers the run, the run replayed one step
+ * at a time when the gcd overshoots to n.
+ */
+#define CY_RHO_M 128
+
+static int cy_factor_rho_run(mpz_srcptr n, const unsigned long c, const uint64_t max_iter, const CY_FACTOR_CTL *ctl, mpz_ptr f)
+{
+    if(mpz_even_p(n)) {mpz_set_ui(f, 2); return mpz_cmp_ui(n, 2) > 0;}
+    mpz_t x, y, ys, q, g, t; mpz_inits(x, y, ys, q, g, t, NULL);
+    if(cy_random_mpz(n, y) != CY_OK) mpz_set_ui(y, 2);
+    mpz_set_ui(q, 1); mpz_set_ui(g, 1);
+    uint64_t r = 1, steps = 0;
+    int stopped = 0;
+    while (mpz_cmp_ui(g, 1) == 0 && !stopped)
+    {
+        mpz_set(x, y);
+        for (uint64_t i = 0; i < r && !stopped; i++)
+        {
+            mpz_mul(y, y, y); mpz_add_ui(y, y, c); mpz_mod(y, y, n);
+            if(!(++steps & 4095) && cy_factor_halt(ctl)) stopped = 1;
+        }
+        for (uint64_t k = 0; !stopped && k < r && mpz_cmp_ui(g, 1) == 0; k += CY_RHO_M)
+        {
+            mpz_set(ys, y);
+            const uint64_t m = r - k < CY_RHO_M ? r - k : CY_RHO_M;
+            for (uint64_t i = 0; i < m; i++)
+            {
+                mpz_mul(y, y, y); mpz_add_ui(y, y, c); mpz_mod(y, y, n);
+                mpz_sub(t, x, y); mpz_mul(q, q, t); mpz_mod(q, q, n);
+            }
+            mpz_gcd(g, q, n);
+            steps += m;
+            if(steps >= max_iter || cy_factor_halt(ctl)) {stopped = 1; break;}
+        }
+        r *= 2;
+    }
+    if(!mpz_cmp(g, n))
+    {
+        do
+        {
+            mpz_mul(ys, ys, ys); mpz_add_ui(ys, ys, c); mpz_mod(ys, ys, n);
+            mpz_sub(t, x, ys); mpz_gcd(g, t, n);
+        } while (mpz_cmp_ui(g, 1) == 0);
+    }
+    const int found = cy_factor_keep(g, n, f);
+    mpz_clears(x, y, ys, q, g, t, NULL);
+    return found;
+}
+
+CY_STATE_FLAG cy_factor_fermat(mpz_srcptr n, const uint64_t max_iter, mpz_ptr f)
+{
+    if(!n || !f || mpz_cmp_ui(n, 2) < 0) return cy_state_manager(CY_ERR_ARG, __func__, ": n >= 2 required");
+    if(!cy_factor_fermat_run(n, max_iter, NULL, f)) mpz_set_ui(f, 1);
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_factor_pm1(mpz_srcptr n, const uint64_t B1, const uint64_t B2, mpz_ptr f)
+{
+    if(!n || !f || mpz_cmp_ui(n, 2) < 0 || B1 < 2) return cy_state_manager(CY_ERR_ARG, __func__, ": n >= 2 and B1 >= 2 required");
+    if(B2 > CY_SIEVE_MAX) return cy_state_manager(CY_ERR_RANGE, __func__, ": B2 above the sieve limit");
+    if(!cy_factor_pm1_run(n, B1, B2, NULL, f)) mpz_set_ui(f, 1);
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_factor_rho(mpz_srcptr n, const uint64_t max_iter, mpz_ptr f)
+{
+    if(!n || !f || mpz_cmp_ui(n, 2) < 0) return cy_state_manager(CY_ERR_ARG, __func__, ": n >= 2 required");
+    for (unsigned long c = 1; c <= 3; c++) if(cy_factor_rho_run(n, c, max_iter, NULL, f)) return CY_OK;
+    mpz_set_ui(f, 1);
+    return CY_OK;
+}
+
+typedef struct CY_FACTOR_JOB
+{
+    mpz_srcptr n;
+    unsigned task[64];          // method per task, rho tasks differ in c
+    size_t ntask;
+    double start, slice, deadline;
+    atomic_int stop;
+    pthread_mutex_t lock;
+    mpz_t f;
+    unsigned method;
+} CY_FACTOR_JOB;
+
+static void cy_factor_task(void *arg, size_t i)
+{
+    CY_FACTOR_JOB *job = arg;
+    if(atomic_load(&job->stop)) return;
+    // tasks queued behind others get their own slice of the budget
+    const double now = cy_factor_clock();
+    CY_FACTOR_CTL ctl = {&job->stop, job->deadline};
+    if(job->slice > 0 && now + job->slice < ctl.deadline) ctl.deadline = now + job->slice;
+
+    mpz_t f; mpz_init(f);
+    int found = 0;
+    switch (job->task[i])
+    {
+    case CY_FACTOR_FERMAT: found = cy_factor_fermat_run(job->n, UINT64_MAX, &ctl, f); break;
+    case CY_FACTOR_PM1: found = cy_factor_pm1_run(job->n, 1000000, 100000000, &ctl, f); break;
+    default: found = cy_factor_rho_run(job->n, 1 + i, UINT64_MAX, &ctl, f); break;
+    }
+    if(found)
+    {
+        pthread_mutex_lock(&job->lock);
+        if(!job->method) {mpz_set(job->f, f); job->method = job->task[i];}
+        pthread_mutex_unlock(&job->lock);
+        atomic_store(&job->stop, 1);
+    }
+    mpz_clear(f);
+}
+
+/*
+ * Runs the selected CY_FACTOR_* methods side by side for at most seconds,
+ * after trial division by the primes below 2^16. f = 1 and method = 0 when n
+ * is prime or nothing turned up, else f is a proper factor and method names
+ * the one that found it (0 for trial division).
+ */
+CY_STATE_FLAG cy_factor_find(mpz_srcptr n, const unsigned methods, const size_t nthreads, const double seconds, mpz_ptr f, unsigned *method)
+{
+    if(!n || !f || !method || mpz_cmp_ui(n, 2) < 0 || seconds <= 0) return cy_state_manager(CY_ERR_ARG, __func__, ": bad arguments");
+    *method = 0; mpz_set_ui(f, 1);
+    CY_PRIMALITY_FLAG pf;
+    if(cy_prime_bpsw(n, &pf) != CY_OK) return cy_state_manager(CY_ERR, __func__, "");
+    if(pf == CY_PRIME) return CY_OK;
+
+    CY_PRIME_RUN run;
+    uint64_t p;
+    if(cy_prime_run_init(&run, 2, 1 << 16) != CY_OK) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    while (cy_prime_run_next(&run, &p) == CY_OK)
+    {
+        if(mpz_divisible_ui_p(n, p) && mpz_cmp_ui(n, p) > 0) {mpz_set_ui(f, p); break;}
+    }
+    cy_prime_run_free(&run);
+    if(mpz_cmp_ui(f, 1) > 0) return CY_OK;
+
+    CY_FACTOR_JOB job;
+    memset(&job, 0, sizeof(job));
+    job.n = n;
+    const size_t nt = nthreads ? nthreads : 1;
+    if(methods & CY_FACTOR_FERMAT) job.task[job.ntask++] = CY_FACTOR_FERMAT;
+    if(methods & CY_FACTOR_PM1) job.task[job.ntask++] = CY_FACTOR_PM1;
+    if(methods & CY_FACTOR_RHO)
+    {
+        // the threads left over all run rho with their own c
+        size_t nrho = nt > job.ntask ? nt - job.ntask : 1;
+        while (nrho-- && job.ntask < sizeof(job.task) / sizeof(job.task[0])) job.task[job.ntask++] = CY_FACTOR_RHO;
+    }
+    if(!job.ntask) return cy_state_manager(CY_ERR_ARG, __func__, ": no method selected");
+
+    job.start = cy_factor_clock();
+    job.deadline = job.start + seconds;
+    const size_t rounds = (job.ntask + nt - 1) / nt;
+    job.slice = rounds > 1 ? seconds / (double)rounds : 0;
+    atomic_init(&job.stop, 0);
+    pthread_mutex_init(&job.lock, NULL);
+    mpz_init(job.f);
+
+    cy_thread_for(nt, job.ntask, cy_factor_task, &job);
+
+    if(job.method) {mpz_set(f, job.f); *method = job.method;}
+    mpz_clear(job.f);
+    pthread_mutex_destroy(&job.lock);
+    return CY_OK;
+}
+
+// cy_factor_find on the modulus of a key file cy_rsa_key_imp reads
+CY_STATE_FLAG cy_rsa_key_audit(const char *path, const unsigned methods, const size_t nthreads, const double seconds, mpz_ptr f, unsigned *method)
+{
+    if(!path) return cy_state_manager(CY_ERR_ARG, __func__, ": null path");
+    mpz_t *key = NULL;
+    CY_STATE_FLAG st = cy_rsa_key_imp(path, &key);
+    if(st == CY_OK) st = cy_factor_find(key[1], methods, nthreads, seconds, f, method);
+    cy_rsa_key_free(key);
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": audit failed");
+    return CY_OK;
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                      CRT Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+/*
+ * Fixed moduli m_0..m_{k-1}, pairwise coprime, set up once:
+ * - Garner: c_i = (m_0 ... m_{i-1})^-1 mod m_i and the prefix products, used up to
+ *   CY_CRT_GARNER_MAX moduli where the quadratic mixed radix loop is cheapest.
+ * - product tree plus inv_i = (M / m_i)^-1 mod m_i, x = sum a_i inv_i M / m_i combined
+ *   pairwise up the tree, X = X_a M_b + X_b M_a, for larger sets.
+ * The same tree reduces x back to its residues (remainder tree).
+ */
+#define CY_CRT_GARNER_MAX 16
+
+struct CY_CRT
+{
+    size_t count;
+    size_t nlevel;
+    size_t *width;
+    mpz_t **tree;     // tree[0] = moduli, tree[nlevel - 1][0] = M
+    mpz_t *coef;      // Garner c_i, coef[0] unused
+    mpz_t *prefix;    // m_0 ... m_{i-1}, prefix[0] = 1
+    mpz_t *inv;       // (M / m_i)^-1 mod m_i
+};
+
+void cy_crt_free(CY_CRT *crt)
+{
+    if(!crt) return;
+    for (size_t l = 0; crt->tree && l < crt->nlevel; l++)
+    {
+        for (size_t j = 0; crt->tree[l] && j < crt->width[l]; j++) mpz_clear(crt->tree[l][j]);
+        free(crt->tree[l]);
+    }
+    for (size_t i = 0; i < crt->count; i++)
+    {
+        if(crt->coef) mpz_clear(crt->coef[i]);
+        if(crt->prefix) mpz_clear(crt->prefix[i]);
+        if(crt->inv) mpz_clear(crt->inv[i]);
+    }
+    free(crt->tree); free(crt->width); free(crt->coef); free(crt->prefix); free(crt->inv);
+    free(crt);
+}
+
+CY_STATE_FLAG cy_crt_init(const size_t count, const mpz_srcptr m[], CY_CRT **crt)
+{
+    if(!crt || !m || !count) return cy_state_manager(CY_ERR_ARG, __func__, ": no moduli");
+    for (size_t i = 0; i < count; i++)
+        if(mpz_cmp_ui(m[i], 2) < 0) return cy_state_manager(CY_ERR_VALUE, __func__, ": moduli must be at least 2");
+
+    CY_CRT *c = calloc(1, sizeof(*c));
+    if(!c) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    c->count = count;
+    c->nlevel = 1;
+    for (size_t w = count; w > 1; w = (w + 1) / 2) c->nlevel++;
+    c->width = calloc(c->nlevel, sizeof(c->width[0]));
+    c->tree = calloc(c->nlevel, sizeof(c->tree[0]));
+    c->coef = malloc(count * sizeof(c->coef[0]));
+    c->prefix = malloc(count * sizeof(c->prefix[0]));
+    c->inv = malloc(count * sizeof(c->inv[0]));
+    if(!c->width || !c->tree || !c->coef || !c->prefix || !c->inv)
+    {free(c->coef); free(c->prefix); free(c->inv); c->coef = c->prefix = c->inv = NULL; c->count = 0; cy_crt_free(c); return cy_state_manager(CY_ERR_OOM, __func__, "");}
+    for (size_t i = 0; i < count; i++) mpz_inits(c->coef[i], c->prefix[i], c->inv[i], NULL);
+
+    CY_STATE_FLAG st = CY_OK;
+    c->width[0] = count;
+    for (size_t l = 0; l < c->nlevel && st == CY_OK; l++)
+    {
+        if(l) c->width[l] = (c->width[l - 1] + 1) / 2;
+        c->tree[l] = malloc(c->width[l] * sizeof(c->tree[l][0]));
+        if(!c->tree[l]) {c->width[l] = 0; st = CY_ERR_OOM; break;}
+        for (size_t j = 0; j < c->width[l]; j++)
+        {
+            mpz_init(c->tree[l][j]);
+            if(!l) mpz_set(c->tree[0][j], m[j]);
+            else if(2 * j + 1 < c->width[l - 1]) mpz_mul(c->tree[l][j], c->tree[l - 1][2 * j], c->tree[l - 1][2 * j + 1]);
+            else mpz_set(c->tree[l][j], c->tree[l - 1][2 * j]);
+        }
+    }
+
+    // Garner constants, a missing inverse means two moduli share a factor
+    mpz_set_ui(c->prefix[0], 1);
+    for (size_t i = 1; i < count && st == CY_OK; i++)
+    {
+        mpz_mul(c->prefix[i], c->prefix[i - 1], m[i - 1]);
+        if(!mpz_invert(c->coef[i], c->prefix[i], m[i])) st = CY_ERR_VALUE;
+    }
+
+    // (M / m_i) mod m_i from M mod m_i^2 down the remainder tree
+    if(st == CY_OK && count > CY_CRT_GARNER_MAX)
+    {
+        mpz_t *r = malloc(count * sizeof(r[0])), sq;
+        if(!r) st = CY_ERR_OOM;
+        else
+        {
+            mpz_init(sq);
+            for (size_t i = 0; i < count; i++) mpz_init(r[i]);
+            mpz_set(r[0], c->tree[c->nlevel - 1][0]);
+            for (size_t l = c->nlevel - 1; l-- > 0;)
+            {
+                for (size_t j = c->width[l]; j-- > 0;)
+                {
+                    mpz_mul(sq, c->tree[l][j], c->tree[l][j]);
+                    mpz_mod(r[j], r[j / 2], sq);
+                }
+            }
+            for (size_t i = 0; i < count && st == CY_OK; i++)
+            {
+                mpz_divexact(r[i], r[i], m[i]);
+                if(!mpz_invert(c->inv[i], r[i], m[i])) st = CY_ERR_VALUE;
+            }
+            for (size_t i = 0; i < count; i++) mpz_clear(r[i]);
+            mpz_clear(sq);
+            free(r);
+        }
+    }
+    if(st != CY_OK)
+    {
+        cy_crt_free(c);
+        return cy_state_manager(st, __func__, st == CY_ERR_VALUE ? ": moduli are not pairwise coprime" : "");
+    }
+    *crt = c;
+    return CY_OK;
+}
+
+// x mod M, 0 <= x < M, with x = a_i mod m_i
+CY_STATE_FLAG cy_crt_solve(const CY_CRT *crt, const mpz_srcptr a[], mpz_ptr out)
+{
+    if(!crt || !a || !out) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    const size_t k = crt->count;
+    mpz_t t; mpz_init(t);
+
+    if(k <= CY_CRT_GARNER_MAX)
+    {
+        mpz_t x; mpz_init(x);
+        mpz_mod(x, a[0], crt->tree[0][0]);
+        for (size_t i = 1; i < k; i++)
+        {
+            mpz_sub(t, a[i], x);
+            mpz_mul(t, t, crt->coef[i]);
+            mpz_mod(t, t, crt->tree[0][i]);
+            mpz_addmul(x, t, crt->prefix[i]);
+        }
+        mpz_swap(out, x);
+        mpz_clears(x, t, NULL);
+        return CY_OK;
+    }
+
+    // bottom up in one array, node j of level l + 1 lands in slot j
+    mpz_t *X = malloc(k * sizeof(X[0]));
+    if(!X) {mpz_clear(t); return cy_state_manager(CY_ERR_OOM, __func__, "");}
+    for (size_t i = 0; i < k; i++)
+    {
+        mpz_init(X[i]);
+        mpz_mul(X[i], a[i], crt->inv[i]);
+        mpz_mod(X[i], X[i], crt->tree[0][i]);
+    }
+    for (size_t l = 1; l < crt->nlevel; l++)
+    {
+        for (size_t j = 0; j < crt->width[l]; j++)
+        {
+            if(2 * j + 1 == crt->width[l - 1]) {mpz_swap(X[j], X[2 * j]); continue;}
+            mpz_mul(t, X[2 * j], crt->tree[l - 1][2 * j + 1]);
+            mpz_mul(X[j], X[2 * j + 1], crt->tree[l - 1][2 * j]);
+            mpz_add(X[j], X[j], t);
+        }
+    }
+    mpz_mod(out, X[0], crt->tree[crt->nlevel - 1][0]);
+    for (size_t i = 0; i < k; i++) mpz_clear(X[i]);
+    free(X); mpz_clear(t);
+    return CY_OK;
+}
+
+typedef struct CY_CRT_BATCH
+{
+    const CY_CRT *crt;
+    const mpz_srcptr **a;
+    mpz_ptr *out;
+    atomic_int st;
+} CY_CRT_BATCH;
+
+static void cy_crt_batch_item(void *arg, size_t i)
+{
+    CY_CRT_BATCH *b = arg;
+    if(cy_crt_solve(b->crt, b->a[i], b->out[i]) != CY_OK) atomic_store(&b->st, CY_ERR);
+}
+
+// out[v] from the residue vector a[v], vectors spread over nthreads
+CY_STATE_FLAG cy_crt_solve_batch(const CY_CRT *crt, const size_t nvec, const mpz_srcptr *a[], const size_t nthreads, mpz_ptr out[])
+{
+    if(!crt || !a || !out) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    CY_CRT_BATCH b = {crt, a, out, CY_OK};
+    cy_thread_for(nthreads ? nthreads : 1, nvec, cy_crt_batch_item, &b);
+    return (CY_STATE_FLAG)atomic_load(&b.st);
+}
+
+// out[i] = x mod m_i through the remainder tree
+CY_STATE_FLAG cy_crt_reduce(const CY_CRT *crt, mpz_srcptr x, mpz_ptr out[])
+{
+    if(!crt || !x || !out) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    const size_t k = crt->count;
+    mpz_t *r = malloc(k * sizeof(r[0]));
+    if(!r) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    for (size_t i = 0; i < k; i++) mpz_init(r[i]);
+    mpz_mod(r[0], x, crt->tree[crt->nlevel - 1][0]);
+    for (size_t l = crt->nlevel - 1; l-- > 0;)
+        for (size_t j = crt->width[l]; j-- > 0;) mpz_mod(r[j], r[j / 2], crt->tree[l][j]);
+    for (size_t i = 0; i < k; i++) {mpz_swap(out[i], r[i]); mpz_clear(r[i]);}
+    free(r);
+    return CY_OK;
+}
+
+void cy_crt_modulus(const CY_CRT *crt, mpz_ptr M)
+{
+    mpz_set(M, crt->tree[crt->nlevel - 1][0]);
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                      DLP Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+/*
+ * x with g^x = h mod p, g of order q. Moduli below 2^63 run on uint64_t
+ * with 128-bit products, everything else on mpz.
+ */
+#define CY_DLP_U64_BITS 63
+#define CY_DLP_BSGS_MAX ((uint64_t)1 << 26)  // baby steps kept in memory
+#define CY_DLP_RHO_R 32                      // r-adding walk partitions
+
+static inline uint64_t cy_u64_mulmod(const uint64_t a, const uint64_t b, const uint64_t m)
+{
+    return (uint64_t)((unsigned __int128)a * b % m);
+}
+
+static uint64_t cy_u64_powmod(uint64_t b, uint64_t e, const uint64_t m)
+{
+    uint64_t r = 1 % m;
+    for (b %= m; e; e >>= 1, b = cy_u64_mulmod(b, b, m)) if(e & 1) r = cy_u64_mulmod(r, b, m);
+    return r;
+}
+
+// floor(sqrt(n)), one result bit per round
+static uint64_t cy_u64_isqrt(uint64_t n)
+{
+    uint64_t r = 0;
+    for (uint64_t bit = (uint64_t)1 << 62; bit; bit >>= 2)
+    {
+        if(n >= r + bit) {n -= r + bit; r = (r >> 1) + bit;}
+        else r >>= 1;
+    }
+    return r;
+}
+
+static inline uint64_t cy_dlp_mix(const uint64_t v)
+{
+    uint64_t h = v * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 29);
+}
+
+// open addressing, key and value side by side so a probe touches one line,
+// the top bit of val marks the slot as used (values stay below CY_DLP_BSGS_MAX)
+#define CY_DLP_USED ((uint64_t)1 << 63)
+typedef struct CY_DLP_SLOT {uint64_t key, val;} CY_DLP_SLOT;
+
+typedef struct CY_DLP_TABLE
+{
+    CY_DLP_SLOT *slot;
+    size_t mask;
+} CY_DLP_TABLE;
+
+static CY_STATE_FLAG cy_dlp_table_init(CY_DLP_TABLE *t, const uint64_t n)
+{
+    size_t cap = 16;
+    while (cap < 2 * n) cap <<= 1;
+    t->slot = calloc(cap, sizeof(t->slot[0]));
+    t->mask = cap - 1;
+    return t->slot ? CY_OK : CY_ERR_OOM;
+}
+
+static void cy_dlp_table_free(CY_DLP_TABLE *t) {free(t->slot);}
+
+static inline size_t cy_dlp_table_home(const CY_DLP_TABLE *t, const uint64_t key) {return (size_t)cy_dlp_mix(key) & t->mask;}
+
+// multi keeps every value for a key (mpz callers key on a truncated value),
+// otherwise the first one, the smallest baby step, is kept
+static void cy_dlp_table_put(CY_DLP_TABLE *t, const uint64_t key, const uint64_t val, const int multi)
+{
+    size_t i = cy_dlp_table_home(t, key);
+    for (; t->slot[i].val & CY_DLP_USED; i = (i + 1) & t->mask) if(!multi && t->slot[i].key == key) return;
+    t->slot[i].key = key; t->slot[i].val = val | CY_DLP_USED;
+}
+
+// next value stored under key from probe position *i on, start at cy_dlp_table_home
+static int cy_dlp_table_next(const CY_DLP_TABLE *t, const uint64_t key, size_t *i, uint64_t *val)
+{
+    for (; t->slot[*i].val & CY_DLP_USED; *i = (*i + 1) & t->mask)
+    {
+        if(t->slot[*i].key != key) continue;
+        *val = t->slot[*i].val & ~CY_DLP_USED;
+        *i = (*i + 1) & t->mask;
+        return 1;
+    }
+    return 0;
+}
+
+static CY_STATE_FLAG cy_dlp_bsgs_u64(const uint64_t g, const uint64_t h, const uint64_t p, const uint64_t q, uint64_t *x)
+{
+    uint64_t m = cy_u64_isqrt(q);
+    if(m * m < q) m++;
+    if(m > CY_DLP_BSGS_MAX) return CY_ERR_SIZE;
+
+    CY_DLP_TABLE t;
+    if(cy_dlp_table_init(&t, m) != CY_OK) return CY_ERR_OOM;
+    uint64_t y = 1 % p;
+    for (uint64_t j = 0; j < m; j++, y = cy_u64_mulmod(y, g, p)) cy_dlp_table_put(&t, y, j, 0);
+
+    // giant step g^-m = g^(q - m mod q)
+    const uint64_t giant = cy_u64_powmod(g, (q - m % q) % q, p);
+    CY_STATE_FLAG st = CY_ERR_VALUE;
+    y = h % p;
+    for (uint64_t i = 0; i <= m; i++, y = cy_u64_mulmod(y, giant, p))
+    {
+        uint64_t j;
+        size_t k = cy_dlp_table_home(&t, y);
+        if(cy_dlp_table_next(&t, y, &k, &j)) {*x = (uint64_t)(((unsigned __int128)i * m + j) % q); st = CY_OK; break;}
+    }
+    cy_dlp_table_free(&t);
+    return st;
+}
+
+static uint64_t cy_dlp_limb(mpz_srcptr z) {return (uint64_t)mpz_getlimbn(z, 0);}
+
+static CY_STATE_FLAG cy_dlp_bsgs_mpz(mpz_srcptr g, mpz_srcptr h, mpz_srcptr p, mpz_srcptr q, mpz_ptr x)
+{
+    mpz_t m, y, giant, t; mpz_inits(m, y, giant, t, NULL);
+    mpz_sqrtrem(m, t, q);
+    if(mpz_sgn(t)) mpz_add_ui(m, m, 1);
+    if(mpz_cmp_ui(m, CY_DLP_BSGS_MAX) > 0) {mpz_clears(m, y, giant, t, NULL); return CY_ERR_SIZE;}
+    const uint64_t mm = mpz_get_ui(m);
+
+    CY_DLP_TABLE tab;
+    if(cy_dlp_table_init(&tab, mm) != CY_OK) {mpz_clears(m, y, giant, t, NULL); return CY_ERR_OOM;}
+    // keyed on the low limb with every baby step kept, each hit is confirmed by recomputing g^j
+    mpz_set_ui(y, 1);
+    for (uint64_t j = 0; j < mm; j++) {cy_dlp_table_put(&tab, cy_dlp_limb(y), j, 1); mpz_mul(y, y, g); mpz_mod(y, y, p);}
+
+    mpz_mod(t, m, q); mpz_sub(t, q, t); mpz_mod(t, t, q);
+    mpz_powm(giant, g, t, p);
+    CY_STATE_FLAG st = CY_ERR_VALUE;
+    mpz_mod(y, h, p);
+    for (uint64_t i = 0; i <= mm && st != CY_OK; i++)
+    {
+        uint64_t j;
+        const uint64_t key = cy_dlp_limb(y);
+        size_t k = cy_dlp_table_home(&tab, key);
+        while (st != CY_OK && cy_dlp_table_next(&tab, key, &k, &j))
+        {
+            mpz_powm_ui(t, g, j, p);
+            if(mpz_cmp(t, y) == 0) {mpz_set_ui(x, i); mpz_mul_ui(x, x, mm); mpz_add_ui(x, x, j); mpz_mod(x, x, q); st = CY_OK;}
+        }
+        mpz_mul(y, y, giant); mpz_mod(y, y, p);
+    }
+    cy_dlp_table_free(&tab);
+    mpz_clears(m, y, giant, t, NULL);
+    return st;
+}
+
+CY_STATE_FLAG cy_dlp_bsgs(mpz_srcptr g, mpz_srcptr h, mpz_srcptr p, mpz_srcptr q, mpz_ptr x)
+{
+    if(!g || !h || !p || !q || !x || mpz_cmp_ui(p, 2) < 0 || mpz_sgn(q) <= 0) return cy_state_manager(CY_ERR_ARG, __func__, ": bad arguments");
+    CY_STATE_FLAG st;
+    if(mpz_sizeinbase(p, 2) <= CY_DLP_U64_BITS)
+    {
+        uint64_t r = 0;
+        mpz_t gg, hh; mpz_inits(gg, hh, NULL); mpz_mod(gg, g, p); mpz_mod(hh, h, p);
+        st = cy_dlp_bsgs_u64(mpz_get_ui(gg), mpz_get_ui(hh), mpz_get_ui(p), mpz_get_ui(q), &r);
+        mpz_clears(gg, hh, NULL);
+        if(st == CY_OK) mpz_set_ui(x, r);
+    }
+    else st = cy_dlp_bsgs_mpz(g, h, p, q, x);
+    if(st == CY_ERR_SIZE) return cy_state_manager(st, __func__, ": order too large for baby steps in memory");
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": no logarithm");
+    return CY_OK;
+}
+
+/*
+ * Pollard rho, van Oorschot-Wiener style: every thread runs r-adding walks
+ * y = g^a h^b from random starts, distinguished points (hash bits zero) go to a
+ * shared table, and two walks meeting at one with different b give
+ * x = (a1 - a2) / (b2 - b1) mod q. q must be prime.
+ */
+typedef struct CY_DLP_DP
+{
+    mpz_t y, a, b;
+    uint8_t used;
+} CY_DLP_DP;
+
+typedef struct CY_DLP_RHO
+{
+    mpz_srcptr g, h, p, q;
+    int u64;                            // fast path, every value fits a uint64_t
+    uint64_t g64, h64, p64, q64;
+    mpz_t ma[CY_DLP_RHO_R], mb[CY_DLP_RHO_R], mul[CY_DLP_RHO_R];
+    uint64_t ma64[CY_DLP_RHO_R], mb64[CY_DLP_RHO_R], mul64[CY_DLP_RHO_R];
+    uint64_t dmask;                     // distinguished when (hash >> 5) & dmask == 0
+    pthread_mutex_t lock;
+    CY_DLP_DP *dp;                      // open addressing on the point's low limb
+    size_t dpmask, ndp;
+    atomic_int done;                    // solved, or a walk hit err
+    CY_STATE_FLAG err;                  // under lock
+    mpz_t x;
+} CY_DLP_RHO;
+
+// a1 + b1 x = a2 + b2 x mod q, under rho->lock
+static void cy_dlp_rho_collide(CY_DLP_RHO *rho, mpz_srcptr a1, mpz_srcptr b1, mpz_srcptr a2, mpz_srcptr b2)
+{
+    mpz_t num, den; mpz_inits(num, den, NULL);
+    mpz_sub(num, a1, a2); mpz_sub(den, b2, b1); mpz_mod(den, den, rho->q);
+    if(mpz_sgn(den) && mpz_invert(den, den, rho->q))
+    {
+        mpz_mul(num, num, den); mpz_mod(num, num, rho->q);
+        mpz_powm(den, rho->g, num, rho->p);
+        mpz_t hh; mpz_init(hh); mpz_mod(hh, rho->h, rho->p);
+        if(mpz_cmp(den, hh) == 0) {mpz_set(rho->x, num); atomic_store(&rho->done, 1);}
+        mpz_clear(hh);
+    }
+    mpz_clears(num, den, NULL);
+}
+
+// stores a distinguished point, or solves on a match
+static CY_STATE_FLAG cy_dlp_rho_store(CY_DLP_RHO *rho, mpz_srcptr y, mpz_srcptr a, mpz_srcptr b)
+{
+    CY_STATE_FLAG st = CY_OK;
+    pthread_mutex_lock(&rho->lock);
+    if(2 * (rho->ndp + 1) > rho->dpmask + 1)
+    {
+        size_t cap = 2 * (rho->dpmask + 1);
+        CY_DLP_DP *old = rho->dp, *dp = calloc(cap, sizeof(dp[0]));
+        if(!dp)
+        {
+            // without room for points no walk can finish, stop them all
+            rho->err = CY_ERR_OOM; atomic_store(&rho->done, 1);
+            pthread_mutex_unlock(&rho->lock);
+            return CY_ERR_OOM;
+        }
+        for (size_t i = 0; i <= rho->dpmask; i++)
+        {
+            if(!old[i].used) continue;
+            size_t j = (size_t)cy_dlp_mix(cy_dlp_limb(old[i].y)) & (cap - 1);
+            while (dp[j].used) j = (j + 1) & (cap - 1);
+            dp[j] = old[i];
+        }
+        free(old); rho->dp = dp; rho->dpmask = cap - 1;
+    }
+    size_t i = (size_t)cy_dlp_mix(cy_dlp_limb(y)) & rho->dpmask;
+    for (; rho->dp[i].used; i = (i + 1) & rho->dpmask)
+    {
+        if(mpz_cmp(rho->dp[i].y, y)) continue;
+        cy_dlp_rho_collide(rho, a, b, rho->dp[i].a, rho->dp[i].b);
+        pthread_mutex_unlock(&rho->lock);
+        return st;
+    }
+    mpz_init_set(rho->dp[i].y, y); mpz_init_set(rho->dp[i].a, a); mpz_init_set(rho->dp[i].b, b);
+    rho->dp[i].used = 1;
+    rho->ndp++;
+    pthread_mutex_unlock(&rho->lock);
+    return st;
+}
+
+static void cy_dlp_rho_walk(void *arg, size_t id)
+{
+    CY_DLP_RHO *rho = arg;
+    (void)id;
+    mpz_t y, a, b, t; mpz_inits(y, a, b, t, NULL);
+    // walks go on past their points, a fresh start only after this many steps without one (a cycle)
+    const uint64_t limit = 32 * (rho->dmask + 1);
+
+    while (!atomic_load(&rho->done))
+    {
+        if(cy_random_mpz(rho->q, a) != CY_OK || cy_random_mpz(rho->q, b) != CY_OK) break;
+        mpz_powm(y, rho->g, a, rho->p); mpz_powm(t, rho->h, b, rho->p);
+        mpz_mul(y, y, t); mpz_mod(y, y, rho->p);
+
+        if(rho->u64)
+        {
+            uint64_t y64 = mpz_get_ui(y), a64 = mpz_get_ui(a), b64 = mpz_get_ui(b);
+            for (uint64_t s = 0; s < limit && !atomic_load(&rho->done); s++)
+            {
+                uint64_t hs = cy_dlp_mix(y64);
+                if(!((hs >> 5) & rho->dmask))
+                {
+                    mpz_set_ui(y, y64); mpz_set_ui(a, a64); mpz_set_ui(b, b64);
+                    if(cy_dlp_rho_store(rho, y, a, b) != CY_OK) break;
+                    s = 0;
+                }
+                unsigned k = (unsigned)(hs & (CY_DLP_RHO_R - 1));
+                y64 = cy_u64_mulmod(y64, rho->mul64[k], rho->p64);
+                a64 = (uint64_t)(((unsigned __int128)a64 + rho->ma64[k]) % rho->q64);
+                b64 = (uint64_t)(((unsigned __int128)b64 + rho->mb64[k]) % rho->q64);
+            }
+            continue;
+        }
+        for (uint64_t s = 0; s < limit && !atomic_load(&rho->done); s++)
+        {
+            uint64_t hs = cy_dlp_mix(cy_dlp_limb(y));
+            if(!((hs >> 5) & rho->dmask))
+            {
+                if(cy_dlp_rho_store(rho, y, a, b) != CY_OK) break;
+                s = 0;
+            }
+            unsigned k = (unsigned)(hs & (CY_DLP_RHO_R - 1));
+            mpz_mul(y, y, rho->mul[k]); mpz_mod(y, y, rho->p);
+            mpz_add(a, a, rho->ma[k]); if(mpz_cmp(a, rho->q) >= 0) mpz_sub(a, a, rho->q);
+            mpz_add(b, b, rho->mb[k]); if(mpz_cmp(b, rho->q) >= 0) mpz_sub(b, b, rho->q);
+        }
+    }
+    mpz_clears(y, a, b, t, NULL);
+}
+
+CY_STATE_FLAG cy_dlp_rho(mpz_srcptr g, mpz_srcptr h, mpz_srcptr p, mpz_srcptr q, const size_t nthreads, mpz_ptr x)
+{
+    if(!g || !h || !p || !q || !x || mpz_cmp_ui(p, 2) < 0 || mpz_cmp_ui(q, 2) < 0) return cy_state_manager(CY_ERR_ARG, __func__, ": bad arguments");
+    CY_PRIMALITY_FLAG pf;
+    if(cy_prime_bpsw(q, &pf) != CY_OK || pf != CY_PRIME) return cy_state_manager(CY_ERR_VALUE, __func__, ": order must be prime");
+
+    // g must generate the subgroup of order q, h outside <g> would never collide
+    mpz_t t; mpz_init(t);
+    mpz_mod(t, g, p);
+    if(mpz_cmp_ui(t, 1) <= 0) {mpz_clear(t); return cy_state_manager(CY_ERR_VALUE, __func__, ": g is 0 or 1 mod p");}
+    mpz_powm(t, g, q, p);
+    if(mpz_cmp_ui(t, 1) != 0) {mpz_clear(t); return cy_state_manager(CY_ERR_VALUE, __func__, ": g does not have order q");}
+    mpz_powm(t, h, q, p);
+    if(mpz_cmp_ui(t, 1) != 0) {mpz_clear(t); return cy_state_manager(CY_ERR_VALUE, __func__, ": h is not in the subgroup of order q");}
+    mpz_mod(t, h, p);
+    if(mpz_cmp_ui(t, 1) == 0) {mpz_clear(t); mpz_set_ui(x, 0); return CY_OK;}
+
+    CY_DLP_RHO rho;
+    memset(&rho, 0, sizeof(rho));
+    rho.g = g; rho.h = h; rho.p = p; rho.q = q;
+    rho.u64 = mpz_sizeinbase(p, 2) <= CY_DLP_U64_BITS;
+    rho.p64 = rho.u64 ? mpz_get_ui(p) : 0; rho.q64 = rho.u64 ? mpz_get_ui(q) : 0;
+    // about sqrt(q) / 2^dbits points end up stored
+    size_t dbits = mpz_sizeinbase(q, 2) / 8;
+    rho.dmask = ((uint64_t)1 << (dbits > 24 ? 24 : dbits)) - 1;
+
+    CY_STATE_FLAG st = CY_OK;
+    for (int k = 0; k < CY_DLP_RHO_R; k++)
+    {
+        mpz_inits(rho.ma[k], rho.mb[k], rho.mul[k], NULL);
+        if(cy_random_mpz(q, rho.ma[k]) != CY_OK || cy_random_mpz(q, rho.mb[k]) != CY_OK) st = CY_ERR_RNG;
+        mpz_powm(rho.mul[k], g, rho.ma[k], p); mpz_powm(t, h, rho.mb[k], p);
+        mpz_mul(rho.mul[k], rho.mul[k], t); mpz_mod(rho.mul[k], rho.mul[k], p);
+        rho.ma64[k] = mpz_get_ui(rho.ma[k]); rho.mb64[k] = mpz_get_ui(rho.mb[k]); rho.mul64[k] = mpz_get_ui(rho.mul[k]);
+    }
+    rho.dp = calloc(1024, sizeof(rho.dp[0])); rho.dpmask = 1023;
+    if(!rho.dp) st = CY_ERR_OOM;
+    mpz_init(rho.x);
+    pthread_mutex_init(&rho.lock, NULL);
+    atomic_init(&rho.done, 0);
+
+    if(st == CY_OK)
+    {
+        const size_t nt = nthreads ? nthreads : 1;
+        cy_thread_for(nt, nt, cy_dlp_rho_walk, &rho);
+        if(rho.err != CY_OK) st = rho.err;
+        else if(atomic_load(&rho.done)) mpz_set(x, rho.x);
+        else st = CY_ERR_RNG;
+    }
+
+    for (size_t i = 0; rho.dp && i <= rho.dpmask; i++) if(rho.dp[i].used) mpz_clears(rho.dp[i].y, rho.dp[i].a, rho.dp[i].b, NULL);
+    free(rho.dp);
+    for (int k = 0; k < CY_DLP_RHO_R; k++) mpz_clears(rho.ma[k], rho.mb[k], rho.mul[k], NULL);
+    pthread_mutex_destroy(&rho.lock);
+    mpz_clears(rho.x, t, NULL);
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": rho failed");
+    return CY_OK;
+}
+
+// prime order subproblem: baby steps while they fit, rho beyond
+static CY_STATE_FLAG cy_dlp_prime(mpz_srcptr g, mpz_srcptr h, mpz_srcptr p, mpz_srcptr q, const size_t nthreads, mpz_ptr x)
+{
+    if(mpz_sizeinbase(q, 2) <= 40) return cy_dlp_bsgs(g, h, p, q, x);
+    return cy_dlp_rho(g, h, p, q, nthreads, x);
+}
+
+// n = prod f[i]^e[i] by trial division, the cofactor left must be 1 or prime
+static CY_STATE_FLAG cy_dlp_order_factor(mpz_srcptr order, mpz_t f[], unsigned long e[], size_t *nf, const size_t max)
+{
+    mpz_t n; mpz_init_set(n, order); *nf = 0;
+    for (unsigned long d = 2; mpz_cmp_ui(n, 1) > 0 && d < (1UL << 20); d += (d == 2 ? 1 : 2))
+    {
+        if(!mpz_divisible_ui_p(n, d)) continue;
+        if(*nf == max) {mpz_clear(n); return CY_ERR_SIZE;}
+        mpz_set_ui(f[*nf], d); e[*nf] = 0;
+        while (mpz_divisible_ui_p(n, d)) {mpz_divexact_ui(n, n, d); e[*nf]++;}
+        (*nf)++;
+    }
+    if(mpz_cmp_ui(n, 1) > 0)
+    {
+        CY_PRIMALITY_FLAG pf;
+        if(cy_prime_bpsw(n, &pf) != CY_OK || pf != CY_PRIME || *nf == max) {mpz_clear(n); return CY_ERR_UNSUPPORTED;}
+        mpz_set(f[*nf], n); e[(*nf)++] = 1;
+    }
+    mpz_clear(n);
+    return CY_OK;
+}
+
+/*
+ * Pohlig-Hellman: order (p - 1 when NULL) split into prime powers q^e, each digit of
+ * x mod q^e found in the subgroup of order q, then the pieces joined by the CRT engine.
+ * order only has to be a multiple of g's order: it is cut down to the exact order
+ * first, so g need not be a primitive root. x comes back reduced mod that order.
+ */
+CY_STATE_FLAG cy_dlp_solve(mpz_srcptr g, mpz_srcptr h, mpz_srcptr p, mpz_srcptr order, const size_t nthreads, mpz_ptr x)
+{
+    enum {CY_DLP_MAX_FACTORS = 64};
+    if(!g || !h || !p || !x || mpz_cmp_ui(p, 2) < 0) return cy_state_manager(CY_ERR_ARG, __func__, ": bad arguments");
+
+    mpz_t n, f[CY_DLP_MAX_FACTORS], res[CY_DLP_MAX_FACTORS], mod[CY_DLP_MAX_FACTORS];
+    unsigned long e[CY_DLP_MAX_FACTORS]; size_t nf = 0;
+    mpz_init(n);
+    if(order) mpz_set(n, order); else mpz_sub_ui(n, p, 1);
+    for (size_t i = 0; i < CY_DLP_MAX_FACTORS; i++) mpz_inits(f[i], res[i], mod[i], NULL);
+
+    CY_STATE_FLAG st = cy_dlp_order_factor(n, f, e, &nf, CY_DLP_MAX_FACTORS);
+    mpz_t cof, gi, hi, gam, hk, t; mpz_inits(cof, gi, hi, gam, hk, t, NULL);
+    if(st == CY_OK)
+    {
+        // n must kill g, then every prime g^(n/q) = 1 allows is divided out of it
+        mpz_powm(t, g, n, p);
+        if(mpz_cmp_ui(t, 1) != 0) st = CY_ERR_ARG;
+        size_t k = 0;
+        for (size_t i = 0; i < nf && st == CY_OK; i++)
+        {
+            while (e[i])
+            {
+                mpz_divexact(cof, n, f[i]);
+                mpz_powm(t, g, cof, p);
+                if(mpz_cmp_ui(t, 1) != 0) break;
+                mpz_set(n, cof); e[i]--;
+            }
+            if(e[i]) {mpz_swap(f[k], f[i]); e[k++] = e[i];}
+        }
+        nf = k;
+    }
+    for (size_t i = 0; i < nf && st == CY_OK; i++)
+    {
+        // g_i, h_i live in the subgroup of order q^e
+        mpz_pow_ui(mod[i], f[i], e[i]);
+        mpz_divexact(cof, n, mod[i]);
+        mpz_powm(gi, g, cof, p); mpz_powm(hi, h, cof, p);
+        mpz_divexact(t, mod[i], f[i]);
+        mpz_powm(gam, gi, t, p);                   // order q
+        mpz_set_ui(res[i], 0);
+        mpz_t qk; mpz_init_set_ui(qk, 1);
+        for (unsigned long k = 0; k < e[i] && st == CY_OK; k++)
+        {
+            // h_k = (g_i^-x h_i)^(q^(e-1-k))
+            mpz_sub(t, mod[i], res[i]);
+            mpz_powm(hk, gi, t, p);
+            mpz_mul(hk, hk, hi); mpz_mod(hk, hk, p);
+            mpz_divexact(t, mod[i], qk); mpz_divexact(t, t, f[i]);
+            mpz_powm(hk, hk, t, p);
+            if(mpz_cmp_ui(hk, 1) == 0) mpz_set_ui(t, 0);
+            else st = cy_dlp_prime(gam, hk, p, f[i], nthreads, t);
+            mpz_addmul(res[i], t, qk);
+            mpz_mul(qk, qk, f[i]);
+        }
+        mpz_clear(qk);
+    }
+
+    if(st == CY_OK)
+    {
+        mpz_srcptr mp[CY_DLP_MAX_FACTORS], rp[CY_DLP_MAX_FACTORS];
+        for (size_t i = 0; i < nf; i++) {mp[i] = mod[i]; rp[i] = res[i];}
+        CY_CRT *crt = NULL;
+        if(nf == 0) mpz_set_ui(x, 0);
+        else if((st = cy_crt_init(nf, mp, &crt)) == CY_OK) st = cy_crt_solve(crt, rp, x);
+        cy_crt_free(crt);
+    }
+    if(st == CY_OK)
+    {
+        mpz_powm(t, g, x, p); mpz_mod(hk, h, p);
+        if(mpz_cmp(t, hk)) st = CY_ERR_VALUE;
+    }
+    mpz_clears(n, cof, gi, hi, gam, hk, t, NULL);
+    for (size_t i = 0; i < CY_DLP_MAX_FACTORS; i++) mpz_clears(f[i], res[i], mod[i], NULL);
+    if(st == CY_ERR_UNSUPPORTED) return cy_state_manager(st, __func__, ": group order is not smooth enough to split");
+    if(st == CY_ERR_ARG) return cy_state_manager(st, __func__, ": g^order is not 1");
+    if(st != CY_OK) return cy_state_manager(st, __func__, ": no logarithm");
+    return CY_OK;
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                   GF(2)[x] Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+/*
+ * Polynomials over GF(2) as little-endian word arrays, x^i at bit i % 64 of
+ * w[i / 64], n counting words up to the top nonzero one. Outputs may alias
+ * inputs everywhere.
+ */
+#define CY_GF2X_KARA_MIN 16   // words, Karatsuba above, carry-less schoolbook below
+
+static size_t cy_gf2x_norm(const uint64_t *w, size_t n)
+{
+    while (n && !w[n - 1]) n--;
+    return n;
+}
+
+static CY_STATE_FLAG cy_gf2x_grow(CY_GF2X *f, const size_t n)
+{
+    if(n <= f->cap) return CY_OK;
+    uint64_t *w = realloc(f->w, n * sizeof(w[0]));
+    if(!w) return CY_ERR_OOM;
+    f->w = w; f->cap = n;
+    return CY_OK;
+}
+
+// moves words (owned, n of them) into f
+static void cy_gf2x_take(CY_GF2X *f, uint64_t *w, const size_t n, const size_t cap)
+{
+    free(f->w);
+    f->w = w; f->cap = cap; f->n = cy_gf2x_norm(w, n);
+}
+
+void cy_gf2x_init(CY_GF2X *f)
+{
+    f->w = NULL; f->n = 0; f->cap = 0;
+}
+
+void cy_gf2x_free(CY_GF2X *f)
+{
+    if(!f) return;
+    free(f->w);
+    cy_gf2x_init(f);
+}
+
+CY_STATE_FLAG cy_gf2x_set(CY_GF2X *f, const CY_GF2X *g)
+{
+    if(f == g) return CY_OK;
+    if(cy_gf2x_grow(f, g->n) != CY_OK) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    if(g->n) memcpy(f->w, g->w, g->n * sizeof(f->w[0]));
+    f->n = g->n;
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_gf2x_set_words(CY_GF2X *f, const uint64_t *w, const size_t n)
+{
+    if(n && !w) return cy_state_manager(CY_ERR_ARG, __func__, ": null words");
+    if(cy_gf2x_grow(f, n) != CY_OK) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    if(n) memmove(f->w, w, n * sizeof(f->w[0]));
+    f->n = cy_gf2x_norm(f->w, n);
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_gf2x_set_coeff(CY_GF2X *f, const size_t i, const int bit)
+{
+    const size_t k = i / 64;
+    if(k >= f->n)
+    {
+        if(!bit) return CY_OK;
+        if(cy_gf2x_grow(f, k + 1) != CY_OK) return cy_state_manager(CY_ERR_OOM, __func__, "");
+        memset(f->w + f->n, 0, (k + 1 - f->n) * sizeof(f->w[0]));
+        f->n = k + 1;
+    }
+    if(bit) f->w[k] |= UINT64_C(1) << (i % 64);
+    else f->w[k] &= ~(UINT64_C(1) << (i % 64));
+    f->n = cy_gf2x_norm(f->w, f->n);
+    return CY_OK;
+}
+
+int cy_gf2x_coeff(const CY_GF2X *f, const size_t i)
+{
+    return i / 64 < f->n ? (int)(f->w[i / 64] >> (i % 64) & 1) : 0;
+}
+
+// -1 for the zero polynomial
+long cy_gf2x_deg(const CY_GF2X *f)
+{
+    return f->n ? (long)(64 * f->n - 1 - (size_t)__builtin_clzll(f->w[f->n - 1])) : -1;
+}
+
+CY_STATE_FLAG cy_gf2x_add(const CY_GF2X *f, const CY_GF2X *g, CY_GF2X *out)
+{
+    if(f->n < g->n) {const CY_GF2X *t = f; f = g; g = t;}
+    if(cy_gf2x_grow(out, f->n) != CY_OK) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    for (size_t i = 0; i < g->n; i++) out->w[i] = f->w[i] ^ g->w[i];
+    if(out != f) for (size_t i = g->n; i < f->n; i++) out->w[i] = f->w[i];
+    out->n = cy_gf2x_norm(out->w, f->n);
+    return CY_OK;
+}
+
+// dst ^= src x^shift, dst long enough for the top word
+static void cy_gf2x_xor_shift(uint64_t *dst, const uint64_t *src, const size_t n, const size_t shift)
+{
+    const size_t ws = shift / 64; const unsigned bs = shift % 64;
+    if(!bs) {for (size_t i = 0; i < n; i++) dst[ws + i] ^= src[i]; return;}
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        dst[ws + i] ^= (src[i] << bs) | carry;
+        carry = src[i] >> (64 - bs);
+    }
+    if(carry) dst[ws + n] ^= carry;
+}
+
+// 64 x 64 carry-less product with a 4-bit window
+static void cy_clmul64_soft(const uint64_t a, const uint64_t b, uint64_t *lo, uint64_t *hi)
+{
+    __uint128_t u[16], r = 0;
+    u[0] = 0; u[1] = a;
+    for (int i = 2; i < 16; i += 2) {u[i] = u[i / 2] << 1; u[i + 1] = u[i] ^ a;}
+    for (int s = 60; s >= 0; s -= 4) r = (r << 4) ^ u[(b >> s) & 15];
+    *lo = (uint64_t)r; *hi = (uint64_t)(r >> 64);
+}
+
+// r[0, na + nb) = a b, schoolbook
+static void cy_gf2x_mul_base_soft(uint64_t *r, const uint64_t *a, const size_t na, const uint64_t *b, const size_t nb)
+{
+    memset(r, 0, (na + nb) * sizeof(r[0]));
+    for (size_t i = 0; i < na; i++)
+    {
+        for (size_t j = 0; j < nb; j++)
+        {
+            uint64_t lo, hi;
+            cy_clmul64_soft(a[i], b[j], &lo, &hi);
+            r[i + j] ^= lo; r[i + j + 1] ^= hi;
+        }
+    }
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("pclmul,sse2")))
+static void cy_gf2x_mul_base_pclmul(uint64_t *r, const uint64_t *a, const size_t na, const uint64_t *b, const size_t nb)
+{
+    memset(r, 0, (na + nb) * sizeof(r[0]));
+    for (size_t i = 0; i < na; i++)
+    {
+        const __m128i x = _mm_cvtsi64_si128((long long)a[i]);
+        for (size_t j = 0; j < nb; j++)
+        {
+            const __m128i p = _mm_clmulepi64_si128(x, _mm_cvtsi64_si128((long long)b[j]), 0x00);
+            r[i + j] ^= (uint64_t)_mm_cvtsi128_si64(p);
+            r[i + j + 1] ^= (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(p, p));
+        }
+    }
+}
+
+static int cy_gf2x_pclmul;
+static pthread_once_t cy_gf2x_pclmul_once = PTHREAD_ONCE_INIT;
+
+static void cy_gf2x_pclmul_detect(void)
+{
+    __builtin_cpu_init();
+    cy_gf2x_pclmul = __builtin_cpu_supports("pclmul");
+}
+
+// the cpu is probed on the first call only, base products are called a lot
+static int cy_gf2x_has_pclmul(void)
+{
+    pthread_once(&cy_gf2x_pclmul_once, cy_gf2x_pclmul_detect);
+    return cy_gf2x_pclmul;
+}
+
+#else
+
+static void cy_gf2x_mul_base_pclmul(uint64_t *r, const uint64_t *a, const size_t na, const uint64_t *b, const size_t nb)
+{cy_gf2x_mul_base_soft(r, a, na, b, nb);}
+
+static int cy_gf2x_has_pclmul(void) {return 0;}
+
+#endif
+
+static void cy_gf2x_mul_base(uint64_t *r, const uint64_t *a, const size_t na, const uint64_t *b, const size_t nb)
+{
+    if(cy_gf2x_has_pclmul()) cy_gf2x_mul_base_pclmul(r, a, na, b, nb);
+    else cy_gf2x_mul_base_soft(r, a, na, b, nb);
+}
+
+/*
+ * r[0, 2n) = a b, both n words. With a = a0 + a1 X, X = x^(64 h):
+ * a b = a0 b0 + (a0 b0 + a1 b1 + (a0 + a1)(b0 + b1)) X + a1 b1 X^2.
+ * t holds 8 n words of scratch.
+ */
+static void cy_gf2x_mul_kara(uint64_t *r, const uint64_t *a, const uint64_t *b, const size_t n, uint64_t *t)
+{
+    if(n < CY_GF2X_KARA_MIN) {cy_gf2x_mul_base(r, a, n, b, n); return;}
+    const size_t h = n / 2, hh = n - h;
+    uint64_t *sa = t, *sb = t + hh, *m = t + 2 * hh, *next = t + 4 * hh;
+
+    cy_gf2x_mul_kara(r, a, b, h, next);
+    cy_gf2x_mul_kara(r + 2 * h, a + h, b + h, hh, next);
+
+    for (size_t i = 0; i < hh; i++)
+    {
+        sa[i] = a[h + i] ^ (i < h ? a[i] : 0);
+        sb[i] = b[h + i] ^ (i < h ? b[i] : 0);
+    }
+    cy_gf2x_mul_kara(m, sa, sb, hh, next);
+    for (size_t i = 0; i < 2 * h; i++) m[i] ^= r[i];
+    for (size_t i = 0; i < 2 * hh; i++) m[i] ^= r[2 * h + i];
+    for (size_t i = 0; i < 2 * hh; i++) r[h + i] ^= m[i];
+}
+
+// r[0, na + nb) = a b, r clear of a and b
+static CY_STATE_FLAG cy_gf2x_mul_words(uint64_t *r, const uint64_t *a, size_t na, const uint64_t *b, size_t nb)
+{
+    if(na < nb) {const uint64_t *t = a; a = b; b = t; size_t tn = na; na = nb; nb = tn;}
+    if(nb < CY_GF2X_KARA_MIN) {cy_gf2x_mul_base(r, a, na, b, nb); return CY_OK;}
+
+    // the long operand in nb-word blocks, each a balanced product
+    uint64_t *t = malloc((10 * nb + 2) * sizeof(t[0]));
+    if(!t) return CY_ERR_OOM;
+    uint64_t *p = t + 8 * nb;
+    memset(r, 0, (na + nb) * sizeof(r[0]));
+    for (size_t i = 0; i < na; i += nb)
+    {
+        const size_t c = na - i < nb ? na - i : nb;
+        if(c == nb) cy_gf2x_mul_kara(p, a + i, b, nb, t);
+        else cy_gf2x_mul_base(p, b, nb, a + i, c);
+        for (size_t k = 0; k < c + nb; k++) r[i + k] ^= p[k];
+    }
+    free(t);
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_gf2x_mul(const CY_GF2X *f, const CY_GF2X *g, CY_GF2X *out)
+{
+    if(!f->n || !g->n) {out->n = 0; return CY_OK;}
+    const size_t n = f->n + g->n;
+    uint64_t *r = malloc(n * sizeof(r[0]));
+    if(!r || cy_gf2x_mul_words(r, f->w, f->n, g->w, g->n) != CY_OK) {free(r); return cy_state_manager(CY_ERR_OOM, __func__, "");}
+    cy_gf2x_take(out, r, n, n);
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_gf2x_sqr(const CY_GF2X *f, CY_GF2X *out)
+{
+    // squaring spreads the bits, x^i -> x^2i, a carry-less square per word
+    const size_t n = 2 * f->n;
+    uint64_t *r = malloc((n ? n : 1) * sizeof(r[0]));
+    if(!r) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    for (size_t i = 0; i < f->n; i++) cy_gf2x_mul_base(r + 2 * i, f->w + i, 1, f->w + i, 1);
+    cy_gf2x_take(out, r, n, n ? n : 1);
+    return CY_OK;
+}
+
+/*
+ * Long division, f = q g + r with deg r < deg g, one shifted xor of g per
+ * quotient bit. q or r may be NULL.
+ */
+CY_STATE_FLAG cy_gf2x_divrem(const CY_GF2X *f, const CY_GF2X *g, CY_GF2X *q, CY_GF2X *r)
+{
+    if(!g->n) return cy_state_manager(CY_ERR_ARG, __func__, ": division by zero");
+    const long df = cy_gf2x_deg(f), dg = cy_gf2x_deg(g);
+    const size_t nr = f->n + 1, nq = df >= dg ? (size_t)(df - dg) / 64 + 1 : 1;
+    uint64_t *rw = calloc(nr, sizeof(rw[0])), *qw = calloc(nq, sizeof(qw[0]));
+    if(!rw || !qw) {free(rw); free(qw); return cy_state_manager(CY_ERR_OOM, __func__, "");}
+    if(f->n) memcpy(rw, f->w, f->n * sizeof(rw[0]));
+
+    for (long d = df; d >= dg; d--)
+    {
+        if(!(rw[d / 64] >> (d % 64) & 1)) continue;
+        cy_gf2x_xor_shift(rw, g->w, g->n, (size_t)(d - dg));
+        qw[(d - dg) / 64] |= UINT64_C(1) << ((d - dg) % 64);
+    }
+    // q or r may alias g, take frees its words, so its size is read first
+    const size_t gn = g->n;
+    if(q) cy_gf2x_take(q, qw, nq, nq); else free(qw);
+    if(r) cy_gf2x_take(r, rw, gn < nr ? gn : nr, nr); else free(rw);
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_gf2x_gcd(const CY_GF2X *f, const CY_GF2X *g, CY_GF2X *out)
+{
+    CY_GF2X a, b; cy_gf2x_init(&a); cy_gf2x_init(&b);
+    CY_STATE_FLAG st = cy_gf2x_set(&a, f);
+    if(st == CY_OK) st = cy_gf2x_set(&b, g);
+    while (st == CY_OK && b.n)
+    {
+        st = cy_gf2x_divrem(&a, &b, NULL, &a);
+        CY_GF2X t = a; a = b; b = t;
+    }
+    if(st == CY_OK) st = cy_gf2x_set(out, &a);
+    cy_gf2x_free(&a); cy_gf2x_free(&b);
+    if(st != CY_OK) return cy_state_manager(st, __func__, "");
+    return CY_OK;
+}
+
+/*
+ * d = gcd(f, g) = s f + t g, s and t may be NULL. For an f prime to g,
+ * s is f^-1 mod g.
+ */
+CY_STATE_FLAG cy_gf2x_eea(const CY_GF2X *f, const CY_GF2X *g, CY_GF2X *d, CY_GF2X *s, CY_GF2X *t)
+{
+    // invariants r0 = s0 f + t0 g, r1 = s1 f + t1 g
+    CY_GF2X r0, r1, s0, s1, t0, t1, q, m;
+    CY_GF2X *all[] = {&r0, &r1, &s0, &s1, &t0, &t1, &q, &m};
+    for (size_t i = 0; i < 8; i++) cy_gf2x_init(all[i]);
+    CY_STATE_FLAG st = cy_gf2x_set(&r0, f);
+    if(st == CY_OK) st = cy_gf2x_set(&r1, g);
+    if(st == CY_OK) st = cy_gf2x_set_coeff(&s0, 0, 1);
+    if(st == CY_OK) st = cy_gf2x_set_coeff(&t1, 0, 1);
+
+    while (st == CY_OK && r1.n)
+    {
+        st = cy_gf2x_divrem(&r0, &r1, &q, &r0);
+        if(st == CY_OK) st = cy_gf2x_mul(&q, &s1, &m);
+        if(st == CY_OK) st = cy_gf2x_add(&s0, &m, &s0);
+        if(st == CY_OK) st = cy_gf2x_mul(&q, &t1, &m);
+        if(st == CY_OK) st = cy_gf2x_add(&t0, &m, &t0);
+        CY_GF2X x = r0; r0 = r1; r1 = x;
+        x = s0; s0 = s1; s1 = x;
+        x = t0; t0 = t1; t1 = x;
+    }
+    if(st == CY_OK && d) st = cy_gf2x_set(d, &r0);
+    if(st == CY_OK && s) st = cy_gf2x_set(s, &s0);
+    if(st == CY_OK && t) st = cy_gf2x_set(t, &t0);
+    for (size_t i = 0; i < 8; i++) cy_gf2x_free(all[i]);
+    if(st != CY_OK) return cy_state_manager(st, __func__, "");
+    return CY_OK;
+}
+
+/*
+ * Barrett reduction modulo m of degree k: with mu = x^2k / m, any a of degree
+ * below 2k has a mod m = a + m ((a / x^k) mu / x^k), exact over GF(2).
+ */
+struct CY_GF2X_MOD
+{
+    CY_GF2X m, mu;
+    long k;
+};
+
+CY_STATE_FLAG cy_gf2x_mod_init(const CY_GF2X *m, CY_GF2X_MOD **ctx)
+{
+    if(!m || !ctx || cy_gf2x_deg(m) < 1) return cy_state_manager(CY_ERR_ARG, __func__, ": modulus of degree >= 1 required");
+    CY_GF2X_MOD *c = malloc(sizeof(*c));
+    if(!c) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    cy_gf2x_init(&c->m); cy_gf2x_init(&c->mu);
+    c->k = cy_gf2x_deg(m);
+    CY_GF2X x2k; cy_gf2x_init(&x2k);
+    CY_STATE_FLAG st = cy_gf2x_set(&c->m, m);
+    if(st == CY_OK) st = cy_gf2x_set_coeff(&x2k, (size_t)(2 * c->k), 1);
+    if(st == CY_OK) st = cy_gf2x_divrem(&x2k, m, &c->mu, NULL);
+    cy_gf2x_free(&x2k);
+    if(st != CY_OK) {cy_gf2x_mod_free(c); return cy_state_manager(st, __func__, "");}
+    *ctx = c;
+    return CY_OK;
+}
+
+void cy_gf2x_mod_free(CY_GF2X_MOD *ctx)
+{
+    if(!ctx) return;
+    cy_gf2x_free(&ctx->m); cy_gf2x_free(&ctx->mu);
+    free(ctx);
+}
+
+// f / x^s
+static CY_STATE_FLAG cy_gf2x_shr(const CY_GF2X *f, const size_t s, CY_GF2X *out)
+{
+    const size_t ws = s / 64; const unsigned bs = s % 64;
+    if(ws >= f->n) {out->n = 0; return CY_OK;}
+    const size_t n = f->n - ws;
+    if(cy_gf2x_grow(out, n) != CY_OK) return CY_ERR_OOM;
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t w = f->w[ws + i] >> bs;
+        if(bs && ws + i + 1 < f->n) w |= f->w[ws + i + 1] << (64 - bs);
+        out->w[i] = w;
+    }
+    out->n = cy_gf2x_norm(out->w, n);
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_gf2x_mod_reduce(const CY_GF2X_MOD *ctx, const CY_GF2X *a, CY_GF2X *out)
+{
+    const long da = cy_gf2x_deg(a);
+    if(da < ctx->k) return cy_gf2x_set(out, a);
+    if(da >= 2 * ctx->k) return cy_gf2x_divrem(a, &ctx->m, NULL, out);
+
+    CY_GF2X t; cy_gf2x_init(&t);
+    CY_STATE_FLAG st = cy_gf2x_shr(a, (size_t)ctx->k, &t);
+    if(st == CY_OK) st = cy_gf2x_mul(&t, &ctx->mu, &t);
+    if(st == CY_OK) st = cy_gf2x_shr(&t, (size_t)ctx->k, &t);
+    if(st == CY_OK) st = cy_gf2x_mul(&t, &ctx->m, &t);
+    if(st == CY_OK) st = cy_gf2x_add(&t, a, out);
+    cy_gf2x_free(&t);
+    if(st != CY_OK) return cy_state_manager(st, __func__, "");
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_gf2x_mod_mul(const CY_GF2X_MOD *ctx, const CY_GF2X *a, const CY_GF2X *b, CY_GF2X *out)
+{
+    CY_STATE_FLAG st = a == b ? cy_gf2x_sqr(a, out) : cy_gf2x_mul(a, b, out);
+    if(st != CY_OK) return st;
+    return cy_gf2x_mod_reduce(ctx, out, out);
+}
+
+/*
+ * Ben-Or: f of degree n is irreducible iff gcd(f, x^(2^i) - x) = 1 for
+ * i = 1 ... n / 2. Random polynomials usually fail at a small i.
+ */
+CY_STATE_FLAG cy_gf2x_irreducible(const CY_GF2X *f, int *irr)
+{
+    if(!f || !irr) return cy_state_manager(CY_ERR_ARG, __func__, ": bad arguments");
+    const long n = cy_gf2x_deg(f);
+    *irr = n >= 1;
+    if(n <= 1) return CY_OK;
+    // x divides f
+    if(!(f->w[0] & 1)) {*irr = 0; return CY_OK;}
+
+    CY_GF2X_MOD *ctx = NULL;
+    CY_GF2X u, v, g; cy_gf2x_init(&u); cy_gf2x_init(&v); cy_gf2x_init(&g);
+    CY_STATE_FLAG st = cy_gf2x_mod_init(f, &ctx);
+    if(st == CY_OK) st = cy_gf2x_set_coeff(&u, 1, 1);
+    for (long i = 1; st == CY_OK && i <= n / 2; i++)
+    {
+        // u = x^(2^i) mod f
+        if((st = cy_gf2x_mod_mul(ctx, &u, &u, &u)) != CY_OK) break;
+        if((st = cy_gf2x_set(&v, &u)) != CY_OK || (st = cy_gf2x_set_coeff(&v, 1, !cy_gf2x_coeff(&v, 1))) != CY_OK) break;
+        if((st = cy_gf2x_gcd(f, &v, &g)) != CY_OK) break;
+        if(cy_gf2x_deg(&g) != 0) {*irr = 0; break;}
+    }
+    cy_gf2x_mod_free(ctx);
+    cy_gf2x_free(&u); cy_gf2x_free(&v); cy_gf2x_free(&g);
+    if(st != CY_OK) return cy_state_manager(st, __func__, "");
+    return CY_OK;
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                     BLAKE3 Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+#define CY_BLAKE3_CHUNK 1024
+#define CY_BLAKE3_CHUNK_START 0x01
+#define CY_BLAKE3_CHUNK_END   0x02
+#define CY_BLAKE3_PARENT      0x04
+#define CY_BLAKE3_ROOT        0x08
+#define CY_BLAKE3_LANES 16      // widest multi-lane compressor
+#define CY_BLAKE3_TASK 1024     // most chunks per thread task, a 32 KiB stack buffer of CVs
+
+static const uint32_t CY_BLAKE3_IV[8] = 
+{0x6a09e667,0xbb67ae85,0x3c6ef372,0xa54ff53a,0x510e527f,0x9b05688c,0x1f83d9ab,0x5be0cd19};
+
+// message word order of each of the 7 rounds
+static const uint8_t CY_BLAKE3_SCHED[7][16] = 
+{
+    {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15},
+    {2,6,3,10,7,0,4,13,1,11,12,5,9,14,15,8},
+    {3,4,10,12,13,2,7,14,6,5,9,0,11,15,8,1},
+    {10,7,12,9,14,3,13,15,4,0,11,2,5,8,1,6},
+    {12,13,9,11,15,10,14,8,7,2,5,3,0,1,6,4},
+    {9,14,11,5,8,12,15,1,13,3,0,10,2,6,4,7},
+    {11,15,5,0,1,9,8,6,14,10,2,12,3,4,7,13}
+};
+
+static inline uint32_t cy_blake3_load(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline void cy_blake3_store(uint8_t out[32], const uint32_t cv[8])
+{
+    for (int i = 0; i < 8; i++)
+    {out[4*i] = (uint8_t)cv[i]; out[4*i+1] = (uint8_t)(cv[i] >> 8); out[4*i+2] = (uint8_t)(cv[i] >> 16); out[4*i+3] = (uint8_t)(cv[i] >> 24);}
+}
+
+// G and a round work unchanged on uint32_t and on GCC vectors of uint32_t
+#define CY_BLAKE3_G(v, a, b, c, d, x, y) \
+    v[a] = v[a] + v[b] + (x); v[d] = CY_ROTR32(v[d] ^ v[a], 16); \
+    v[c] = v[c] + v[d];       v[b] = CY_ROTR32(v[b] ^ v[c], 12); \
+    v[a] = v[a] + v[b] + (y); v[d] = CY_ROTR32(v[d] ^ v[a], 8);  \
+    v[c] = v[c] + v[d];       v[b] = CY_ROTR32(v[b] ^ v[c], 7);
+
+#define CY_BLAKE3_ROUND(v, m, s) \
+    CY_BLAKE3_G(v, 0, 4,  8, 12, m[s[0]],  m[s[1]])  \
+    CY_BLAKE3_G(v, 1, 5,  9, 13, m[s[2]],  m[s[3]])  \
+    CY_BLAKE3_G(v, 2, 6, 10, 14, m[s[4]],  m[s[5]])  \
+    CY_BLAKE3_G(v, 3, 7, 11, 15, m[s[6]],  m[s[7]])  \
+    CY_BLAKE3_G(v, 0, 5, 10, 15, m[s[8]],  m[s[9]])  \
+    CY_BLAKE3_G(v, 1, 6, 11, 12, m[s[10]], m[s[11]]) \
+    CY_BLAKE3_G(v, 2, 7,  8, 13, m[s[12]], m[s[13]]) \
+    CY_BLAKE3_G(v, 3, 4,  9, 14, m[s[14]], m[s[15]])
+
+// new chaining value of one block, the first 8 output words
+static void cy_blake3_compress(uint32_t cv[8], const uint8_t block[64], const uint32_t blen, const uint64_t counter, const uint32_t flags)
+{
+    uint32_t m[16], v[16];
+    for (int i = 0; i < 16; i++) m[i] = cy_blake3_load(block + 4 * i);
+    memcpy(v, cv, 8 * sizeof(uint32_t)); memcpy(v + 8, CY_BLAKE3_IV, 4 * sizeof(uint32_t));
+    v[12] = (uint32_t)counter; v[13] = (uint32_t)(counter >> 32); v[14] = blen; v[15] = flags;
+    for (int r = 0; r < 7; r++) {CY_BLAKE3_ROUND(v, m, CY_BLAKE3_SCHED[r])}
+    for (int i = 0; i < 8; i++) cv[i] = v[i] ^ v[i + 8];
+}
+
+/*
+ * W inputs of the same block count side by side, input l at in + l * stride,
+ * counter + l when inc is set. A macro so the one body serves each vector width.
+ */
+#define CY_BLAKE3_MANY(name, VT, W, IDX, attr) \
+attr static void name(const uint8_t *in, const size_t stride, const size_t blocks, const uint64_t counter, const int inc, \
+                      const uint32_t flags, const uint32_t fstart, const uint32_t fend, uint8_t *out) \
+{ \
+    const VT idx = IDX; \
+    VT h[8], v[16], m[16], lo, hi; \
+    for (int i = 0; i < 8; i++) h[i] = (VT){0} + CY_BLAKE3_IV[i]; \
+    for (int l = 0; l < W; l++) \
+    {lo[l] = (uint32_t)(counter + (uint64_t)(inc ? l : 0)); hi[l] = (uint32_t)((counter + (uint64_t)(inc ? l : 0)) >> 32);} \
+    for (size_t b = 0; b < blocks; b++) \
+    { \
+        for (int q = 0; q < 16 / W; q++) \
+        { \
+            VT *r = m + q * W;  /* W x W words, rows to columns by swapping blocks at each scale */ \
+            for (int l = 0; l < W; l++) memcpy(&r[l], in + l * stride + 64 * b + 4 * W * q, sizeof(VT)); \
+            for (int s = 0; (1 << s) < W; s++) \
+            { \
+                const int k = 1 << s; \
+                const VT bit = (idx >> s) & 1, ml = idx + bit * (W - k), mh = idx + (1 - bit) * k + bit * W; \
+                for (int i = 0; i < W; i++) \
+                    if(!(i & k)) {VT x = r[i], y = r[i + k]; r[i] = __builtin_shuffle(x, y, ml); r[i + k] = __builtin_shuffle(x, y, mh);} \
+            } \
+        } \
+        memcpy(v, h, sizeof(h)); \
+        for (int i = 0; i < 4; i++) v[8 + i] = (VT){0} + CY_BLAKE3_IV[i]; \
+        v[12] = lo; v[13] = hi; v[14] = (VT){0} + 64; \
+        v[15] = (VT){0} + (flags | (b == 0 ? fstart : 0) | (b + 1 == blocks ? fend : 0)); \
+        _Pragma("GCC unroll 7") \
+        for (int r = 0; r < 7; r++) {CY_BLAKE3_ROUND(v, m, CY_BLAKE3_SCHED[r])} \
+        for (int i = 0; i < 8; i++) h[i] = v[i] ^ v[i + 8]; \
+    } \
+    for (int l = 0; l < W; l++) \
+    { \
+        uint32_t cv[8]; \
+        for (int i = 0; i < 8; i++) cv[i] = h[i][l]; \
+        cy_blake3_store(out + 32 * l, cv); \
+    } \
+}
+
+typedef uint32_t CY_BLAKE3_V4 __attribute__((vector_size(16)));
+CY_BLAKE3_MANY(cy_blake3_many4, CY_BLAKE3_V4, 4, ((CY_BLAKE3_V4){0,1,2,3}), )
+
+#if defined(__x86_64__)
+
+typedef uint32_t CY_BLAKE3_V8 __attribute__((vector_size(32)));
+typedef uint32_t CY_BLAKE3_V16 __attribute__((vector_size(64)));
+CY_BLAKE3_MANY(cy_blake3_many8, CY_BLAKE3_V8, 8, ((CY_BLAKE3_V8){0,1,2,3,4,5,6,7}), __attribute__((target("avx2"))))
+CY_BLAKE3_MANY(cy_blake3_many16, CY_BLAKE3_V16, 16, ((CY_BLAKE3_V16){0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15}), __attribute__((target("avx512f"))))
+
+static size_t cy_blake3_width(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") ? 16 : __builtin_cpu_supports("avx2") ? 8 : 4;
+}
+
+#else
+
+static void cy_blake3_many8(const uint8_t *in, const size_t stride, const size_t blocks, const uint64_t counter, const int inc, 
+                            const uint32_t flags, const uint32_t fstart, const uint32_t fend, uint8_t *out)
+{(void)in; (void)stride; (void)blocks; (void)counter; (void)inc; (void)flags; (void)fstart; (void)fend; (void)out;}
+
+static void cy_blake3_many16(const uint8_t *in, const size_t stride, const size_t blocks, const uint64_t counter, const int inc, 
+                             const uint32_t flags, const uint32_t fstart, const uint32_t fend, uint8_t *out)
+{(void)in; (void)stride; (void)blocks; (void)counter; (void)inc; (void)flags; (void)fstart; (void)fend; (void)out;}
+
+// the lanes load message words in host order
+static size_t cy_blake3_width(void) {return __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ? 4 : 0;}
+
+#endif
+
+// CVs of n whole inputs of `blocks` blocks each, widest lanes first, the tail one at a time
+static void cy_blake3_many(const uint8_t *in, const size_t stride, size_t n, const size_t blocks, uint64_t counter, const int inc, 
+                           const uint32_t flags, const uint32_t fstart, const uint32_t fend, uint8_t *out)
+{
+    const size_t width = cy_blake3_width();
+    for (size_t w = width; w >= 4; w /= 2)
+        for (; n >= w; n -= w, in += w * stride, out += 32 * w, counter += inc ? w : 0)
+        {
+            if(w == 16) cy_blake3_many16(in, stride, blocks, counter, inc, flags, fstart, fend, out);
+            else if(w == 8) cy_blake3_many8(in, stride, blocks, counter, inc, flags, fstart, fend, out);
+            else cy_blake3_many4(in, stride, blocks, counter, inc, flags, fstart, fend, out);
+        }
+    for (; n; n--, in += stride, out += 32, counter += inc ? 1 : 0)
+    {
+        uint32_t cv[8];
+        memcpy(cv, CY_BLAKE3_IV, sizeof(cv));
+        for (size_t b = 0; b < blocks; b++)
+            cy_blake3_compress(cv, in + 64 * b, 64, counter, flags | (b == 0 ? fstart : 0) | (b + 1 == blocks ? fend : 0));
+        cy_blake3_store(out, cv);
+    }
+}
+
+// CV of a chunk of at most 1024 bytes, a short last block is zero padded
+static void cy_blake3_chunk(const uint8_t *in, const size_t len, const uint64_t counter, const uint32_t root, uint8_t out[32])
+{
+    uint32_t cv[8];
+    size_t blocks = len ? (len + 63) / 64 : 1;
+    memcpy(cv, CY_BLAKE3_IV, sizeof(cv));
+    for (size_t b = 0; b < blocks; b++)
+    {
+        uint8_t block[64] = {0};
+        size_t blen = len - 64 * b < 64 ? len - 64 * b : 64;
+        memcpy(block, in + 64 * b, blen);
+        cy_blake3_compress(cv, block, (uint32_t)blen, counter, (b == 0 ? CY_BLAKE3_CHUNK_START : 0) | (b + 1 == blocks ? CY_BLAKE3_CHUNK_END | root : 0));
+    }
+    cy_blake3_store(out, cv);
+}
+
+static void cy_blake3_parent(const uint8_t block[64], const uint32_t root, uint8_t out[32])
+{
+    uint32_t cv[8];
+    memcpy(cv, CY_BLAKE3_IV, sizeof(cv));
+    cy_blake3_compress(cv, block, 64, 0, CY_BLAKE3_PARENT | root);
+    cy_blake3_store(out, cv);
+}
+
+/*
+ * Merging neighbours level by level and carrying an odd last node up builds
+ * the BLAKE3 tree, whose left subtrees are always complete, so any aligned
+ * power of two run of chunks reduces on its own. Stops once n <= stop.
+ */
+static size_t cy_blake3_reduce(uint8_t *cvs, size_t n, const size_t stop)
+{
+    while (n > stop)
+    {
+        size_t pairs = n / 2;
+        cy_blake3_many(cvs, 64, pairs, 1, 0, 0, CY_BLAKE3_PARENT, 0, 0, cvs);
+        if(n & 1) memmove(cvs + 32 * pairs, cvs + 32 * (n - 1), 32);
+        n = pairs + (n & 1);
+    }
+    return n;
+}
+
+// chunk CVs of in[0, len) starting at chunk `counter`, reduced to at most stop nodes
+static size_t cy_blake3_subtree(const uint8_t *in, const size_t len, const uint64_t counter, uint8_t *cvs, const size_t stop)
+{
+    size_t full = len / CY_BLAKE3_CHUNK, n = full;
+    cy_blake3_many(in, CY_BLAKE3_CHUNK, full, CY_BLAKE3_CHUNK / 64, counter, 1, 0, CY_BLAKE3_CHUNK_START, CY_BLAKE3_CHUNK_END, cvs);
+    if(len % CY_BLAKE3_CHUNK) cy_blake3_chunk(in + full * CY_BLAKE3_CHUNK, len % CY_BLAKE3_CHUNK, counter + full, 0, cvs + 32 * n++);
+    return cy_blake3_reduce(cvs, n, stop);
+}
+
+typedef struct CY_BLAKE3_JOB
+{
+    const uint8_t *in;
+    size_t len, task;   // task = chunks per task, a power of two
+    uint8_t *cvs;
+} CY_BLAKE3_JOB;
+
+static void cy_blake3_task(void *arg, size_t t)
+{
+    CY_BLAKE3_JOB *job = arg;
+    uint8_t cvs[32 * CY_BLAKE3_TASK];
+    size_t off = t * job->task * CY_BLAKE3_CHUNK, len = job->len - off;
+    if(len > job->task * CY_BLAKE3_CHUNK) len = job->task * CY_BLAKE3_CHUNK;
+    cy_blake3_subtree(job->in + off, len, (uint64_t)t * job->task, cvs, 1);
+    memcpy(job->cvs + 32 * t, cvs, 32);
+}
+
+CY_STATE_FLAG cy_blake3(const uint8_t *in, const size_t len, const size_t nthreads, uint8_t out[32])
+{
+    if(!out || (len && !in)) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    if(len <= CY_BLAKE3_CHUNK) {cy_blake3_chunk(in, len, 0, CY_BLAKE3_ROOT, out); return CY_OK;}
+    size_t chunks = (len + CY_BLAKE3_CHUNK - 1) / CY_BLAKE3_CHUNK, task = CY_BLAKE3_TASK;
+    // smaller tasks until every thread gets a few, never below one lane group
+    while (task > CY_BLAKE3_LANES && chunks / task < 4 * (nthreads ? nthreads : 1)) task /= 2;
+    size_t ntasks = (chunks + task - 1) / task;
+    if(ntasks == 1)
+    {
+        uint8_t cvs[32 * CY_BLAKE3_TASK];
+        cy_blake3_subtree(in, len, 0, cvs, 2);
+        cy_blake3_parent(cvs, CY_BLAKE3_ROOT, out);
+        return CY_OK;
+    }
+    CY_BLAKE3_JOB job = {in, len, task, malloc(32 * ntasks)};
+    if(!job.cvs) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    cy_thread_for(nthreads ? nthreads : 1, ntasks, cy_blake3_task, &job);
+    cy_blake3_reduce(job.cvs, ntasks, 2);
+    cy_blake3_parent(job.cvs, CY_BLAKE3_ROOT, out);
+    free(job.cvs);
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_blake3_file(const char *path, const size_t nthreads, uint8_t out[32])
+{
+    const uint8_t *data = NULL;
+    size_t size = 0;
+    if(!path || !out) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    if(cy_file_map(path, &data, &size) != CY_OK) return CY_ERR;
+    CY_STATE_FLAG st = cy_blake3(data, size, nthreads, out);
+    cy_file_unmap(data, size);
+    return st;
+}
+
+void cy_blake3_init(CY_BLAKE3_STATE *st)
+{
+    memcpy(st->cv, CY_BLAKE3_IV, sizeof(st->cv));
+    st->chunk = 0; st->blen = 0; st->blocks = 0; st->stack_len = 0;
+}
+
+// with `chunks` chunks done the stack holds one subtree per set bit, merging any extra pair
+static void cy_blake3_merge(CY_BLAKE3_STATE *st, const uint64_t chunks)
+{
+    while (st->stack_len > (uint8_t)__builtin_popcountll(chunks))
+    {
+        st->stack_len--;
+        cy_blake3_parent(st->stack[st->stack_len - 1], 0, st->stack[st->stack_len - 1]);
+    }
+}
+
+// lazy merging: a pair is only combined once a later chunk proves it is not the root
+static void cy_blake3_push(CY_BLAKE3_STATE *st, const uint8_t cv[32], const uint64_t counter)
+{
+    cy_blake3_merge(st, counter);
+    memcpy(st->stack[st->stack_len++], cv, 32);
+}
+
+void cy_blake3_update(CY_BLAKE3_STATE *st, const uint8_t *in, size_t len)
+{
+    while (len)
+    {
+        if(st->blocks * 64 + st->blen == CY_BLAKE3_CHUNK)
+        {
+            uint8_t cv[32];
+            cy_blake3_compress(st->cv, st->buff, 64, st->chunk, CY_BLAKE3_CHUNK_END);
+            cy_blake3_store(cv, st->cv);
+            cy_blake3_push(st, cv, st->chunk);
+            memcpy(st->cv, CY_BLAKE3_IV, sizeof(st->cv));
+            st->chunk++; st->blen = 0; st->blocks = 0;
+        }
+        if(st->blocks == 0 && st->blen == 0 && len > CY_BLAKE3_CHUNK)
+        {
+            // whole chunks straight from the input, the last one stays buffered
+            uint8_t cvs[32 * CY_BLAKE3_LANES];
+            size_t n = (len - 1) / CY_BLAKE3_CHUNK;
+            if(n > CY_BLAKE3_LANES) n = CY_BLAKE3_LANES;
+            cy_blake3_many(in, CY_BLAKE3_CHUNK, n, CY_BLAKE3_CHUNK / 64, st->chunk, 1, 0, CY_BLAKE3_CHUNK_START, CY_BLAKE3_CHUNK_END, cvs);
+            for (size_t i = 0; i < n; i++) cy_blake3_push(st, cvs + 32 * i, st->chunk++);
+            in += n * CY_BLAKE3_CHUNK; len -= n * CY_BLAKE3_CHUNK;
+            continue;
+        }
+        if(st->blen == 64)
+        {
+            cy_blake3_compress(st->cv, st->buff, 64, st->chunk, st->blocks == 0 ? CY_BLAKE3_CHUNK_START : 0);
+            st->blocks++; st->blen = 0;
+        }
+        size_t k = 64 - (size_t)st->blen < len ? 64 - (size_t)st->blen : len;
+        memcpy(st->buff + st->blen, in, k);
+        st->blen += (uint8_t)k; in += k; len -= k;
+    }
+    // the open chunk holds bytes, so every pair on the stack is below the root
+    cy_blake3_merge(st, st->chunk);
+}
+
+void cy_blake3_final(const CY_BLAKE3_STATE *st, uint8_t out[32])
+{
+    uint32_t cv[8];
+    uint8_t block[64] = {0};
+    memcpy(cv, st->cv, sizeof(cv));
+    memcpy(block, st->buff, st->blen);
+    uint32_t flags = (st->blocks == 0 ? CY_BLAKE3_CHUNK_START : 0) | CY_BLAKE3_CHUNK_END;
+    cy_blake3_compress(cv, block, st->blen, st->chunk, flags | (st->stack_len ? 0 : CY_BLAKE3_ROOT));
+    cy_blake3_store(out, cv);
+    for (size_t i = st->stack_len; i-- > 0;)
+    {
+        memcpy(block, st->stack[i], 32); memcpy(block + 32, out, 32);
+        cy_blake3_parent(block, i ? 0 : CY_BLAKE3_ROOT, out);
+    }
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                     Keccak Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+static const uint64_t CY_KECCAK_RC[24] = 
+{
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL, 0x8000000080008000ULL,
+    0x000000000000808BULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008AULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800AULL, 0x800000008000000AULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+// rho offset of lane x + 5y and where pi moves it, (x, y) -> (y, 2x + 3y)
+static const uint8_t CY_KECCAK_RHO[25] = {0,1,62,28,27, 36,44,6,55,20, 3,10,43,25,39, 41,45,15,21,8, 18,2,61,56,14};
+static const uint8_t CY_KECCAK_PI[25] = {0,10,20,5,15, 16,1,11,21,6, 7,17,2,12,22, 23,8,18,3,13, 14,24,9,19,4};
+
+#define CY_ROTL64(x, n) (((x) << (n)) | ((x) >> ((64 - (n)) & 63)))
+
+/*
+ * Lanes 1, 2, 8, 12, 17 and 20 stay complemented through the rounds, which
+ * leaves chi one NOT per plane instead of five.
+ */
+static void cy_keccak_f1600(uint64_t st[25])
+{
+    static const uint8_t comp[6] = {1, 2, 8, 12, 17, 20};
+    uint64_t a[25], b[25], c[5], d[5];
+    memcpy(a, st, sizeof(a));   // a local copy the compiler can keep out of memory
+    for (int i = 0; i < 6; i++) a[comp[i]] = ~a[comp[i]];
+    for (int r = 0; r < 24; r++)
+    {
+        #pragma GCC unroll 5
+        for (int x = 0; x < 5; x++) c[x] = a[x] ^ a[x + 5] ^ a[x + 10] ^ a[x + 15] ^ a[x + 20];
+        #pragma GCC unroll 5
+        for (int x = 0; x < 5; x++) d[x] = c[(x + 4) % 5] ^ CY_ROTL64(c[(x + 1) % 5], 1);
+        #pragma GCC unroll 25
+        for (int i = 0; i < 25; i++) b[CY_KECCAK_PI[i]] = CY_ROTL64(a[i] ^ d[i % 5], CY_KECCAK_RHO[i]);
+        a[0] = b[0] ^ (b[1] | b[2]); a[1] = b[1] ^ (~b[2] | b[3]); a[2] = b[2] ^ (b[3] & b[4]); a[3] = b[3] ^ (b[4] | b[0]); a[4] = b[4] ^ (b[0] & b[1]);
+        a[5] = b[5] ^ (b[6] | b[7]); a[6] = b[6] ^ (b[7] & b[8]); a[7] = b[7] ^ (b[8] | ~b[9]); a[8] = b[8] ^ (b[9] | b[5]); a[9] = b[9] ^ (b[5] & b[6]);
+        a[10] = b[10] ^ (b[11] | b[12]); a[11] = b[11] ^ (b[12] & b[13]); a[12] = b[12] ^ (~b[13] & b[14]); a[13] = ~b[13] ^ (b[14] | b[10]); a[14] = b[14] ^ (b[10] & b[11]);
+        a[15] = b[15] ^ (b[16] & b[17]); a[16] = b[16] ^ (b[17] | b[18]); a[17] = b[17] ^ (~b[18] | b[19]); a[18] = ~b[18] ^ (b[19] & b[15]); a[19] = b[19] ^ (b[15] | b[16]);
+        a[20] = b[20] ^ (~b[21] & b[22]); a[21] = ~b[21] ^ (b[22] | b[23]); a[22] = b[22] ^ (b[23] & b[24]); a[23] = b[23] ^ (b[24] | b[20]); a[24] = b[24] ^ (b[20] & b[21]);
+        a[0] ^= CY_KECCAK_RC[r];
+    }
+    for (int i = 0; i < 6; i++) a[comp[i]] = ~a[comp[i]];
+    memcpy(st, a, sizeof(a));
+}
+
+static inline uint64_t cy_keccak_load(const uint8_t *p)
+{
+    uint64_t w = 0;
+    for (int i = 7; i >= 0; i--) w = w << 8 | p[i];
+    return w;
+}
+
+#if defined(__x86_64__)
+
+#define CY_V4_ROTL64(x, n) _mm256_or_si256(_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - (n)))
+
+// four independent states, lane i of state l in 64-bit element l of a[i]
+__attribute__((target("avx2")))
+static void cy_keccak_f1600_x4(__m256i a[25])
+{
+    __m256i b[25], c[5], d[5];
+    for (int r = 0; r < 24; r++)
+    {
+        #pragma GCC unroll 5
+        for (int x = 0; x < 5; x++)
+            c[x] = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a[x], a[x + 5]), _mm256_xor_si256(a[x + 10], a[x + 15])), a[x + 20]);
+        #pragma GCC unroll 5
+        for (int x = 0; x < 5; x++) d[x] = _mm256_xor_si256(c[(x + 4) % 5], CY_V4_ROTL64(c[(x + 1) % 5], 1));
+        b[0] = _mm256_xor_si256(a[0], d[0]);
+        #pragma GCC unroll 24
+        for (int i = 1; i < 25; i++) b[CY_KECCAK_PI[i]] = CY_V4_ROTL64(_mm256_xor_si256(a[i], d[i % 5]), CY_KECCAK_RHO[i]);
+        #pragma GCC unroll 5
+        for (int y = 0; y < 25; y += 5)
+            #pragma GCC unroll 5
+            for (int x = 0; x < 5; x++)
+                a[y + x] = _mm256_xor_si256(b[y + x], _mm256_andnot_si256(b[y + (x + 1) % 5], b[y + (x + 2) % 5]));
+        a[0] = _mm256_xor_si256(a[0], _mm256_set1_epi64x((long long)CY_KECCAK_RC[r]));
+    }
+}
+
+/*
+ * Absorbs up to 4 messages side by side. A lane whose last block is done is
+ * copied out to st[l] ready to squeeze, later permutations of it are unused.
+ */
+__attribute__((target("avx2")))
+static void cy_keccak_absorb_x4(const size_t n, const uint8_t *const in[], const size_t len[], CY_KECCAK_STATE st[])
+{
+    const size_t rate = st[0].rate;
+    size_t blocks[4] = {0}, maxb = 0;
+    uint8_t tail[4][168];
+    for (size_t l = 0; l < n; l++)
+    {
+        size_t r = len[l] % rate;
+        blocks[l] = len[l] / rate + 1;
+        memset(tail[l], 0, rate);
+        if(r) memcpy(tail[l], in[l] + len[l] - r, r);
+        tail[l][r] ^= st[l].pad; tail[l][rate - 1] ^= 0x80;
+        if(blocks[l] > maxb) maxb = blocks[l];
+    }
+    __m256i a[25];
+    for (int i = 0; i < 25; i++) a[i] = _mm256_setzero_si256();
+    for (size_t b = 0; b < maxb; b++)
+    {
+        const uint8_t *src[4] = {NULL, NULL, NULL, NULL};
+        for (size_t l = 0; l < n; l++)
+            if(b < blocks[l]) src[l] = b + 1 < blocks[l] ? in[l] + rate * b : tail[l];
+        for (size_t i = 0; i < rate / 8; i++)
+        {
+            uint64_t w[4] = {0};
+            for (int l = 0; l < 4; l++) if(src[l]) w[l] = cy_keccak_load(src[l] + 8 * i);
+            a[i] = _mm256_xor_si256(a[i], _mm256_loadu_si256((const __m256i *)w));
+        }
+        cy_keccak_f1600_x4(a);
+        for (size_t l = 0; l < n; l++)
+            if(b + 1 == blocks[l])
+                for (int i = 0; i < 25; i++)
+                {
+                    uint64_t w[4];
+                    _mm256_storeu_si256((__m256i *)w, a[i]);
+                    st[l].a[i] = w[l];
+                }
+    }
+    for (size_t l = 0; l < n; l++) {st[l].pos = 0; st[l].squeezing = 1;}
+}
+
+static int cy_keccak_has_avx2(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+static void cy_keccak_absorb_x4(const size_t n, const uint8_t *const in[], const size_t len[], CY_KECCAK_STATE st[])
+{(void)n; (void)in; (void)len; (void)st;}
+
+static int cy_keccak_has_avx2(void) {return 0;}
+
+#endif
+
+// rate = 200 - 2 * security bytes, SHA-3 and SHAKE differ in the domain bits before pad10*1
+CY_STATE_FLAG cy_keccak_init(CY_KECCAK_STATE *st, const CY_HASH_TYPE type)
+{
+    if(!st) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    switch (type)
+    {
+        case CY_HASH_SHA3_256: st->rate = 136; st->pad = 0x06; break;
+        case CY_HASH_SHA3_512: st->rate = 72;  st->pad = 0x06; break;
+        case CY_HASH_SHAKE128: st->rate = 168; st->pad = 0x1f; break;
+        case CY_HASH_SHAKE256: st->rate = 136; st->pad = 0x1f; break;
+        default: return cy_state_manager(CY_ERR_UNSUPPORTED, __func__, ": not a Keccak hash type");
+    }
+    memset(st->a, 0, sizeof(st->a));
+    st->pos = 0; st->squeezing = 0;
+    return CY_OK;
+}
+
+CY_STATE_FLAG cy_keccak_update(CY_KECCAK_STATE *st, const uint8_t *in, size_t len)
+{
+    if(st->squeezing) return cy_state_manager(CY_ERR_STATE, __func__, ": absorbing after squeezing");
+    for (; len && st->pos % 8; len--, st->pos++) st->a[st->pos / 8] ^= (uint64_t)*in++ << (8 * (st->pos % 8));
+    if(st->pos == st->rate) {cy_keccak_f1600(st->a); st->pos = 0;}
+    // whole words, a permutation each time the rate fills
+    for (; len >= 8; in += 8, len -= 8)
+    {
+        st->a[st->pos / 8] ^= cy_keccak_load(in);
+        if((st->pos += 8) == st->rate) {cy_keccak_f1600(st->a); st->pos = 0;}
+    }
+    for (; len; len--, st->pos++) st->a[st->pos / 8] ^= (uint64_t)*in++ << (8 * (st->pos % 8));
+    return CY_OK;
+}
+
+// the first call pads and closes absorbing, later calls continue the output stream
+void cy_keccak_squeeze(CY_KECCAK_STATE *st, uint8_t *out, size_t len)
+{
+    if(!st->squeezing)
+    {
+        st->a[st->pos / 8] ^= (uint64_t)st->pad << (8 * (st->pos % 8));
+        st->a[(st->rate - 1) / 8] ^= (uint64_t)0x80 << (8 * ((st->rate - 1) % 8));
+        cy_keccak_f1600(st->a);
+        st->pos = 0; st->squeezing = 1;
+    }
+    for (; len; len--, st->pos++)
+    {
+        if(st->pos == st->rate) {cy_keccak_f1600(st->a); st->pos = 0;}
+        *out++ = (uint8_t)(st->a[st->pos / 8] >> (8 * (st->pos % 8)));
+    }
+}
+
+static void cy_keccak(const CY_HASH_TYPE type, const uint8_t *in, const size_t len, uint8_t *out, const size_t outlen)
+{
+    CY_KECCAK_STATE st;
+    cy_keccak_init(&st, type); cy_keccak_update(&st, in, len); cy_keccak_squeeze(&st, out, outlen);
+}
+
+void cy_sha3_256(const uint8_t *in, const size_t len, uint8_t out[32]) {cy_keccak(CY_HASH_SHA3_256, in, len, out, CY_SHA3_256_SIZE);}
+
+void cy_sha3_512(const uint8_t *in, const size_t len, uint8_t out[64]) {cy_keccak(CY_HASH_SHA3_512, in, len, out, CY_SHA3_512_SIZE);}
+
+void cy_shake128(const uint8_t *in, const size_t len, uint8_t *out, const size_t outlen) {cy_keccak(CY_HASH_SHAKE128, in, len, out, outlen);}
+
+void cy_shake256(const uint8_t *in, const size_t len, uint8_t *out, const size_t outlen) {cy_keccak(CY_HASH_SHAKE256, in, len, out, outlen);}
+
+// independent messages, four at a time through the AVX2 permutation when available
+CY_STATE_FLAG cy_keccak_batch(const CY_HASH_TYPE type, const size_t count, const uint8_t *const in[], const size_t len[], uint8_t *const out[], const size_t outlen)
+{
+    CY_KECCAK_STATE st[4];
+    size_t size;
+    if(count && (!in || !len || !out)) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    if(cy_keccak_init(&st[0], type) != CY_OK) return CY_ERR;
+    if((type == CY_HASH_SHA3_256 || type == CY_HASH_SHA3_512) && (cy_hash_size(type, &size), outlen != size))
+        return cy_state_manager(CY_ERR_SIZE, __func__, ": SHA-3 output is the digest size");
+    const int x4 = cy_keccak_has_avx2();
+    for (size_t i = 0; i < count; i += 4)
+    {
+        size_t n = count - i < 4 ? count - i : 4;
+        for (size_t l = 1; l < n; l++) st[l] = st[0];
+        if(x4 && n > 1) cy_keccak_absorb_x4(n, in + i, len + i, st);
+        else for (size_t l = 0; l < n; l++) {cy_keccak_init(&st[l], type); cy_keccak_update(&st[l], in[i + l], len[i + l]);}
+        for (size_t l = 0; l < n; l++) cy_keccak_squeeze(&st[l], out[i + l], outlen);
+        cy_keccak_init(&st[0], type);
+    }
+    return CY_OK;
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                     Merkle Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+// leaves hash 0x00 | data and nodes 0x01 | left | right, so no leaf can pass for a node
+CY_STATE_FLAG cy_merkle_leaf(const CY_HASH_TYPE type, const uint8_t *in, const size_t len, uint8_t *out)
+{
+    static const uint8_t tag = 0x00;
+    CY_HASH_CTX ctx;
+    if(!out || (len && !in)) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    if(cy_hash_init(&ctx, type) != CY_OK) return CY_ERR;
+    cy_hash_update(&ctx, &tag, 1);
+    cy_hash_update(&ctx, in, len);
+    return cy_hash_final(&ctx, out);
+}
+
+typedef struct CY_MERKLE_JOB
+{
+    CY_HASH_TYPE type;
+    const uint8_t *in;
+    size_t len, leaf, size;
+    uint8_t *out;
+} CY_MERKLE_JOB;
+
+static void cy_merkle_task(void *arg, size_t i)
+{
+    CY_MERKLE_JOB *job = arg;
+    size_t off = i * job->leaf, n = job->len - off < job->leaf ? job->len - off : job->leaf;
+    cy_merkle_leaf(job->type, job->in + off, n, job->out + i * job->size);
+}
+
+// one digest per leaf bytes of input, an empty input still has one empty leaf
+CY_STATE_FLAG cy_merkle_leaves(const CY_HASH_TYPE type, const uint8_t *in, const size_t len, const size_t leaf, const size_t nthreads, uint8_t *out)
+{
+    CY_MERKLE_JOB job = {type, in, len, leaf, 0, out};
+    if(!out || (len && !in)) return cy_state_manager(CY_ERR_ARG, __func__, ": NULL argument");
+    if(!leaf) return cy_state_manager(CY_ERR_SIZE, __func__, ": zero leaf size");
+    if(cy_hash_size(type, &job.size) != CY_OK) return CY_ERR;
+    cy_thread_for(nthreads ? nthreads : 1, len ? (len + leaf - 1) / leaf : 1, cy_merkle_task, &job);
+    return CY_OK;
+}
+
+// pairs are merged level by level, an odd last node moves up unchanged
+CY_STATE_FLAG cy_merkle_root(const CY_HASH_TYPE type, const uint8_t *leaves, const size_t count, uint8_t *root)
+{
+    static const uint8_t tag = 0x01;
+    size_t size, n = count;
+    if(!leaves || !root || !count) return cy_state_manager(CY_ERR_ARG, __func__, ": no leaves");
+    if(cy_hash_size(type, &size) != CY_OK) return CY_ERR;
+    uint8_t *t = malloc(count * size);
+    if(!t) return cy_state_manager(CY_ERR_OOM, __func__, "");
+    memcpy(t, leaves, count * size);
+    for (; n > 1; n = (n + 1) / 2)
+    {
+        for (size_t i = 0; i + 1 < n; i += 2)
+        {
+            CY_HASH_CTX ctx;
+            cy_hash_init(&ctx, type);
+            cy_hash_update(&ctx, &tag, 1);
+            cy_hash_update(&ctx, t + i * size, 2 * size);
+            cy_hash_final(&ctx, t + i / 2 * size);
+        }
+        if(n & 1) memmove(t + n / 2 * size, t + (n - 1) * size, size);
+    }
+    memcpy(root, t, size);
+    free(t);
+    return CY_OK;
+}
+
+
+
+
+/******************************************************** 
+ * 
+ * 
+ * 
+ * 
+ *                      CRC Functions 
+ *
+ * 
+ * 
+ * 
+ *********************************************************/
+
+
+
+
+#define CY_CRC32C_POLY 0x82F63B78u  // Castagnoli, bit reflected
+#define CY_CRC32C_BLOCK 1024        // bytes per stream in the 3-way loop
+
+static uint32_t CY_CRC32C_T[8][256];        // slicing-by-8
+static uint32_t CY_CRC32C_SHIFT[4][256];    // state after CY_CRC32C_BLOCK zero bytes, per state byte
+static pthread_once_t cy_crc32c_once = PTHREAD_ONCE_INIT;
+
+// raw state in and out, no inversion
+static uint32_t cy_crc32c_soft(uint32_t c, const uint8_t *p, size_t len)
+{
+    for (; len >= 8; len -= 8, p += 8)
+    {
+        uint32_t lo = c ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+        uint32_t hi = (uint32_t)p[4] | (uint32_t)p[5] << 8 | (uint32_t)p[6] << 16 | (uint32_t)p[7] << 24;
+        c = CY_CRC32C_T[7][lo & 0xFF] ^ CY_CRC32C_T[6][(lo >> 8) & 0xFF] ^ CY_CRC32C_T[5][(lo >> 16) & 0xFF] ^ CY_CRC32C_T[4][lo >> 24]
+          ^ CY_CRC32C_T[3][hi & 0xFF] ^ CY_CRC32C_T[2][(hi >> 8) & 0xFF] ^ CY_CRC32C_T[1][(hi >> 16) & 0xFF] ^ CY_CRC32C_T[0][hi >> 24];
+    }
+    for (; len; len--) c = CY_CRC32C_T[0][(c ^ *p++) & 0xFF] ^ (c >> 8);
+    return c;
+}
+
+// the state is linear, so running zero bytes over it is a 32 x 32 bit matrix, applied bytewise
+static inline uint32_t cy_crc32c_shift(const uint32_t c)
+{
+    return CY_CRC32C_SHIFT[0][c & 0xFF] ^ CY_CRC32C_SHIFT[1][(c >> 8) & 0xFF] ^ CY_CRC32C_SHIFT[2][(c >> 16) & 0xFF] ^ CY_CRC32C_SHIFT[3][c >> 24];
+}
+
+static void cy_crc32c_build(void)
+{
+    static const uint8_t zero[CY_CRC32C_BLOCK];
+    uint32_t basis[32];
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = c & 1 ? (c >> 1) ^ CY_CRC32C_POLY : c >> 1;
+        CY_CRC32C_T[0][i] = c;
+    }
+    for (int k = 1; k < 8; k++)
+        for (int i = 0; i < 256; i++) CY_CRC32C_T[k][i] = (CY_CRC32C_T[k-1][i] >> 8) ^ CY_CRC32C_T[0][CY_CRC32C_T[k-1][i] & 0xFF];
+    for (int j = 0; j < 32; j++) basis[j] = cy_crc32c_soft(UINT32_C(1) << j, zero, sizeof(zero));
+    for (int k = 0; k < 4; k++)
+        for (int i = 0; i < 256; i++)
+        {
+            uint32_t c = 0;
+            for (int j = 0; j < 8; j++) if(i >> j & 1) c ^= basis[8 * k + j];
+            CY_CRC32C_SHIFT[k][i] = c;
+        }
+}
+
+#if defined(__x86_64__)
+
+// three independent streams hide the 3 cycle latency of crc32, then merge through the shift tables
+__attribute__((target("sse4.2")))
+static uint32_t cy_crc32c_hw(uint32_t c, const uint8_t *p, size_t len)
+{
+    uint64_t a = c;
+    for (; len >= 3 * CY_CRC32C_BLOCK; len -= 3 * CY_CRC32C_BLOCK, p += 3 * CY_CRC32C_BLOCK)
+    {
+        uint64_t b = 0, d = 0;
+        for (size_t i = 0; i < CY_CRC32C_BLOCK; i += 8)
+        {
+            uint64_t x, y, z;
+            memcpy(&x, p + i, 8); memcpy(&y, p + CY_CRC32C_BLOCK + i, 8); memcpy(&z, p + 2 * CY_CRC32C_BLOCK + i, 8);
+            a = _mm_crc32_u64(a, x); b = _mm_crc32_u64(b, y); d = _mm_crc32_u64(d, z);
+        }
+        a = cy_crc32c_shift(cy_crc32c_shift((uint32_t)a) ^ (uint32_t)b) ^ (uint32_t)d;
+    }
+    for (; len >= 8; len -= 8, p += 8) {uint64_t x; memcpy(&x, p, 8); a = _mm_crc32_u64(a, x);}
+    for (; len; len--) a = _mm_crc32_u8((uint32_t)a, *p++);
+    return (uint32_t)a;
+}
+
+static int cy_crc32c_has_sse42(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+
+#else
+
+static uint32_t cy_crc32c_hw(uint32_t c, const uint8_t *p, size_t len) {return cy_crc32c_soft(c, p, len);}
+
+static int cy_crc32c_has_sse42(void) {return 0;}
+
+#endif
+
+// picked with the tables, once
+static uint32_t (*cy_crc32c_fn)(uint32_t c, const uint8_t *p, size_t len) = cy_crc32c_soft;
+
+static void cy_crc32c_init(void)
+{
+    cy_crc32c_build();
+    if(cy_crc32c_has_sse42()) cy_crc32c_fn = cy_crc32c_hw;
+}
+
+// crc of the data so far (0 to start), chained calls equal one call on the concatenation
+uint32_t cy_crc32c(const uint32_t crc, const uint8_t *in, const size_t len)
+{
+    pthread_once(&cy_crc32c_once, cy_crc32c_init);
+    if(!len) return crc;
+    return ~cy_crc32c_fn(~crc, in, len);
 }
 
 
@@ -69,6 +69,15 @@ typedef enum CY_STATE_FLAG
 
 } CY_STATE_FLAG;
 
+typedef enum CY_PRIMALITY_FLAG 
+{
+
+    CY_INCONCLUSIVE, 
+    CY_COMPOSITE, 
+    CY_PRIME
+
+} CY_PRIMALITY_FLAG;
+
 typedef struct CY_String 
 {
     mpz_t *key; 
@@ -81,35 +90,456 @@ typedef enum CY_CYPHER_TYPE
     CY_AES
 } CY_CYPHER_TYPE;
 
+// value of the header's cy_hash_type byte
+typedef enum CY_HASH_TYPE
+{
+    CY_HASH_NONE,
+    CY_HASH_SHA256,
+    CY_HASH_BLAKE3,
+    CY_HASH_SHA3_256,
+    CY_HASH_SHA3_512,
+    CY_HASH_SHAKE128,   // cy_hash gives 32 bytes, cy_keccak_squeeze any length
+    CY_HASH_SHAKE256    // cy_hash gives 64 bytes
+} CY_HASH_TYPE;
+
+#define CY_SHA256_SIZE 32
+#define CY_BLAKE3_SIZE 32
+#define CY_SHA3_256_SIZE 32
+#define CY_SHA3_512_SIZE 64
+
+typedef struct CY_SHA256_STATE
+{
+    uint32_t h[8];
+    uint8_t buff[64];
+    uint64_t len;
+} CY_SHA256_STATE;
+
+typedef struct CY_BLAKE3_STATE
+{
+    uint32_t cv[8];         // chaining value of the open chunk
+    uint64_t chunk;         // index of the open chunk
+    uint8_t buff[64];       // its last, not yet compressed, block
+    uint8_t blen, blocks;   // bytes in buff, blocks of the chunk already compressed
+    uint8_t stack_len;
+    uint8_t stack[54][32];  // CVs of finished subtrees, 54 levels cover 2^64 bytes
+} CY_BLAKE3_STATE;
+
+// Keccak-f[1600] sponge for SHA-3 and SHAKE
+typedef struct CY_KECCAK_STATE
+{
+    uint64_t a[25];
+    uint16_t rate;      // bytes absorbed or squeezed per permutation
+    uint16_t pos;       // byte position inside the rate
+    uint8_t pad;        // domain bits, 0x06 for SHA-3 and 0x1f for SHAKE
+    uint8_t squeezing;
+} CY_KECCAK_STATE;
+
+// streaming state for any CY_HASH_TYPE
+typedef struct CY_HASH_CTX
+{
+    CY_HASH_TYPE type;
+    union {CY_SHA256_STATE sha256; CY_BLAKE3_STATE blake3; CY_KECCAK_STATE keccak;} u;
+} CY_HASH_CTX;
+
+// HMAC-SHA-256 key with the ipad and opad blocks already absorbed
+typedef struct CY_HMAC_KEY
+{
+    CY_SHA256_STATE inner, outer;
+} CY_HMAC_KEY;
+
+typedef struct CY_HMAC_CTX
+{
+    CY_SHA256_STATE st;
+    const CY_HMAC_KEY *key;
+} CY_HMAC_CTX;
+
+/*
+ * CRT private keys extend the {d, n} prefix so every {d, n} consumer keeps
+ * working: {d, n, e, u, r_1, d_1, t_1, ..., r_u, d_u, t_u} following
+ * RFC 8017, d_i = d mod (r_i - 1), t_2 = r_2^-1 mod r_1 (qInv) and
+ * t_i = (r_1 * ... * r_(i-1))^-1 mod r_i for i > 2 (t_1 is unused).
+ * They travel as a CY_KEY so the element count goes with the array, and
+ * prvkey.key alone still reads as the {d, n} pair.
+ */
+#define CY_RSA_MAX_PRIMES 4
+#define CY_RSA_PRV_E 2
+#define CY_RSA_PRV_U 3
+#define CY_RSA_PRV_PRIME(i) (4 + 3 * (i))
+#define CY_RSA_PRV_EXP(i)   (5 + 3 * (i))
+#define CY_RSA_PRV_COEF(i)  (6 + 3 * (i))
+#define CY_RSA_PRV_SIZE(u)  (4 + 3 * (u))
+
+// cy_rsa_key_bin_exp/imp flags
+#define CY_RSA_BIN_CRT  0x01    // key is a CRT private key, else an {exp, n} pair
+#define CY_RSA_BIN_MONT 0x02    // Montgomery R^2 values stored after the key
+#define CY_RSA_BIN_PUB  0x04    // the {exp, n} pair holds the public exponent, else it is treated as secret
+
+// cy_factor_find methods
+#define CY_FACTOR_FERMAT 0x01   // p and q close together
+#define CY_FACTOR_PM1    0x02   // p - 1 smooth
+#define CY_FACTOR_RHO    0x04   // a small prime factor
+#define CY_FACTOR_ALL    0x07
+
+typedef struct CY_RSA_POOL CY_RSA_POOL;
+
+typedef struct CY_RSA_CTX CY_RSA_CTX;
+
+typedef struct CY_KEYSTORE CY_KEYSTORE;
+
+typedef struct CY_CRT CY_CRT;
+
+typedef struct CY_SIEVE_ITER CY_SIEVE_ITER;
+
+// polynomial over GF(2), x^i at bit i % 64 of w[i / 64], n words in use
+typedef struct CY_GF2X
+{
+    uint64_t *w;
+    size_t n, cap;
+} CY_GF2X;
+
+typedef struct CY_GF2X_MOD CY_GF2X_MOD;
+
+// expanded AES-128 key, 11 round keys
+typedef struct CY_AES_SCHED {uint32_t w[44];} CY_AES_SCHED;
+
 
 /**************************** flow Functions ******************************/
 
 CY_STATE_FLAG cy_state_manager(const CY_STATE_FLAG e, const char *funcname, const char *msg);
 
+/***************************** Math Functions ******************************/
+
+CY_STATE_FLAG cy_mpz_inv_batch(const size_t count, const mpz_srcptr a[], mpz_srcptr n, mpz_ptr out[]);
+
+/***************************** Hash Functions ******************************/
+
+void cy_sha256_init(CY_SHA256_STATE *st);
+
+void cy_sha256_update(CY_SHA256_STATE *st, const uint8_t *in, size_t len);
+
+void cy_sha256_final(CY_SHA256_STATE *st, uint8_t out[32]);
+
+void cy_sha256(const uint8_t *in, const size_t len, uint8_t out[32]);
+
+CY_STATE_FLAG cy_sha256_batch(const size_t count, const uint8_t *const in[], const size_t len[], uint8_t (*out)[32]);
+
+CY_STATE_FLAG cy_hash_size(const CY_HASH_TYPE type, size_t *size);
+
+CY_STATE_FLAG cy_hash_init(CY_HASH_CTX *ctx, const CY_HASH_TYPE type);
+
+CY_STATE_FLAG cy_hash_update(CY_HASH_CTX *ctx, const uint8_t *in, const size_t len);
+
+CY_STATE_FLAG cy_hash_final(CY_HASH_CTX *ctx, uint8_t *out);
+
+CY_STATE_FLAG cy_hash(const CY_HASH_TYPE type, const uint8_t *in, const size_t len, uint8_t *out);
+
+CY_STATE_FLAG cy_hmac_key_init(CY_HMAC_KEY *key, const uint8_t *k, const size_t klen);
+
+void cy_hmac_init(CY_HMAC_CTX *ctx, const CY_HMAC_KEY *key);
+
+void cy_hmac_update(CY_HMAC_CTX *ctx, const uint8_t *in, const size_t len);
+
+void cy_hmac_final(CY_HMAC_CTX *ctx, uint8_t out[32]);
+
+void cy_hmac_sha256(const CY_HMAC_KEY *key, const uint8_t *msg, const size_t len, uint8_t out[32]);
+
+CY_STATE_FLAG cy_hkdf_extract(const uint8_t *salt, const size_t saltlen, const uint8_t *ikm, const size_t ikmlen, uint8_t prk[32]);
+
+CY_STATE_FLAG cy_hkdf_expand(const uint8_t prk[32], const uint8_t *info, const size_t infolen, uint8_t *out, const size_t outlen);
+
+CY_STATE_FLAG cy_hkdf_expand_batch(const uint8_t prk[32], const size_t count, const uint8_t *const info[], const size_t infolen[], uint8_t *const out[], const size_t outlen);
+
+/***************************** BLAKE3 Functions *****************************/
+
+void cy_blake3_init(CY_BLAKE3_STATE *st);
+
+void cy_blake3_update(CY_BLAKE3_STATE *st, const uint8_t *in, size_t len);
+
+void cy_blake3_final(const CY_BLAKE3_STATE *st, uint8_t out[32]);
+
+CY_STATE_FLAG cy_blake3(const uint8_t *in, const size_t len, const size_t nthreads, uint8_t out[32]);
+
+CY_STATE_FLAG cy_blake3_file(const char *path, const size_t nthreads, uint8_t out[32]);
+
+/***************************** Keccak Functions *****************************/
+
+CY_STATE_FLAG cy_keccak_init(CY_KECCAK_STATE *st, const CY_HASH_TYPE type);
+
+CY_STATE_FLAG cy_keccak_update(CY_KECCAK_STATE *st, const uint8_t *in, size_t len);
+
+void cy_keccak_squeeze(CY_KECCAK_STATE *st, uint8_t *out, size_t len);
+
+void cy_sha3_256(const uint8_t *in, const size_t len, uint8_t out[32]);
+
+void cy_sha3_512(const uint8_t *in, const size_t len, uint8_t out[64]);
+
+void cy_shake128(const uint8_t *in, const size_t len, uint8_t *out, const size_t outlen);
+
+void cy_shake256(const uint8_t *in, const size_t len, uint8_t *out, const size_t outlen);
+
+CY_STATE_FLAG cy_keccak_batch(const CY_HASH_TYPE type, const size_t count, const uint8_t *const in[], const size_t len[], uint8_t *const out[], const size_t outlen);
+
+/***************************** Merkle Functions *****************************/
+
+CY_STATE_FLAG cy_merkle_leaf(const CY_HASH_TYPE type, const uint8_t *in, const size_t len, uint8_t *out);
+
+CY_STATE_FLAG cy_merkle_leaves(const CY_HASH_TYPE type, const uint8_t *in, const size_t len, const size_t leaf, const size_t nthreads, uint8_t *out);
+
+CY_STATE_FLAG cy_merkle_root(const CY_HASH_TYPE type, const uint8_t *leaves, const size_t count, uint8_t *root);
+
+/****************************** CRC Functions ******************************/
+
+uint32_t cy_crc32c(const uint32_t crc, const uint8_t *in, const size_t len);
+
+/*************************** Primality Functions ***************************/
+
+CY_STATE_FLAG cy_mra_u64(const uint64_t n, const uint64_t base, CY_PRIMALITY_FLAG *out);
+
+CY_STATE_FLAG cy_emra_u64(const uint64_t n, CY_PRIMALITY_FLAG *out);
+
+CY_STATE_FLAG cy_prime_bpsw(mpz_srcptr n, CY_PRIMALITY_FLAG *out);
+
+CY_STATE_FLAG cy_prime_batch(const size_t count, const mpz_srcptr n[], const size_t nthreads, CY_PRIMALITY_FLAG out[]);
+
+CY_STATE_FLAG cy_sieve_count(const uint64_t lo, const uint64_t hi, const size_t nthreads, size_t *count);
+
+CY_STATE_FLAG cy_sieve_table_init(const uint64_t limit, const size_t nthreads);
+
+CY_STATE_FLAG cy_sieve_table(const uint32_t **primes, size_t *count);
+
+void cy_sieve_table_release(const uint32_t *primes);
+
+void cy_sieve_table_free(void);
+
+CY_STATE_FLAG cy_sieve_iter_init(const uint64_t lo, const uint64_t hi, CY_SIEVE_ITER **it);
+
+CY_STATE_FLAG cy_sieve_iter_next(CY_SIEVE_ITER *it, uint64_t *p);
+
+void cy_sieve_iter_free(CY_SIEVE_ITER *it);
+
 /************************* linear Key Functions ***************************/
 
+CY_STATE_FLAG cy_rsa_key_alloc(const size_t size, mpz_t **key);
+
 CY_STATE_FLAG cy_rsa_key_gen(const mp_bitcnt_t bitsize, mpz_t **pubkey, mpz_t **prvkey);
 
 CY_STATE_FLAG cy_rsa_key_imp(const char *path, mpz_t **key);
 
 CY_STATE_FLAG cy_rsa_key_exp(const char *path, const mpz_t *key);
 
+CY_STATE_FLAG cy_rsa_key_gen_mp(const mp_bitcnt_t bitsize, const uint8_t nprimes, mpz_t **pubkey, CY_KEY *prvkey);
+
+CY_STATE_FLAG cy_rsa_prv_key_imp(const char *path, CY_KEY *prvkey);
+
+CY_STATE_FLAG cy_rsa_prv_key_exp(const char *path, const CY_KEY *prvkey);
+
+void cy_rsa_prv_key_free(CY_KEY *prvkey);
+
+CY_STATE_FLAG cy_rsa_key_bin_exp(const char *path, const CY_KEY *key, const uint8_t flags);
+
+CY_STATE_FLAG cy_rsa_key_bin_imp(const char *path, CY_KEY *key, uint8_t *flags);
+
+CY_STATE_FLAG cy_rsa_pub_key_der_exp(const char *path, const mpz_t *pubkey);
+
+CY_STATE_FLAG cy_rsa_pub_key_der_imp(const char *path, mpz_t **pubkey);
+
+CY_STATE_FLAG cy_rsa_prv_key_der_exp(const char *path, const CY_KEY *prvkey);
+
+CY_STATE_FLAG cy_rsa_prv_key_der_imp(const char *path, CY_KEY *prvkey);
+
 CY_STATE_FLAG cy_aes_key_gen(__uint128_t *key);
 
 CY_STATE_FLAG cy_aes_key_imp(const char *path, __uint128_t *key);
 
 CY_STATE_FLAG cy_aes_key_exp(const char *path, __uint128_t key);
 
+/************************** RSA Key Pool Functions *************************/
+
+CY_STATE_FLAG cy_rsa_pool_init(const size_t nthreads, CY_RSA_POOL **pool);
+
+CY_STATE_FLAG cy_rsa_pool_add(CY_RSA_POOL *pool, const mp_bitcnt_t bitsize, const size_t capacity);
+
+CY_STATE_FLAG cy_rsa_pool_key_gen(CY_RSA_POOL *pool, const mp_bitcnt_t bitsize, mpz_t **pubkey, mpz_t **prvkey);
+
+CY_STATE_FLAG cy_rsa_pool_spool_exp(CY_RSA_POOL *pool, const char *path, const __uint128_t key);
+
+CY_STATE_FLAG cy_rsa_pool_spool_imp(CY_RSA_POOL *pool, const char *path, const __uint128_t key);
+
+CY_STATE_FLAG cy_rsa_pool_state(CY_RSA_POOL *pool);
+
+void cy_rsa_pool_free(CY_RSA_POOL *pool);
+
+void cy_rsa_key_free(mpz_t *key);
+
 /**************************** Cypher Functions ****************************/
 
 void cy_rsa_encryption(const uint8_t c, const mpz_t *key, mpz_ptr cy_msg);
 
 void cy_rsa_decryption(const mpz_srcptr cy_msg, const mpz_t *key, uint8_t *c);
 
+CY_STATE_FLAG cy_rsa_crt_powm(const mpz_srcptr in, const CY_KEY *prvkey, mpz_ptr out);
+
+void cy_rsa_crt_decryption(const mpz_srcptr cy_msg, const CY_KEY *prvkey, uint8_t *c);
+
+CY_STATE_FLAG cy_rsa_batch_powm(const size_t count, const mpz_srcptr in[], const CY_KEY *prvkey[], mpz_ptr out[], CY_STATE_FLAG result[]);
+
+CY_STATE_FLAG cy_rsa_batch_decryption(const size_t count, const mpz_srcptr cy_msg[], const CY_KEY *prvkey[], uint8_t c[], CY_STATE_FLAG result[]);
+
 void cy_aes_encryption(__uint128_t msg, __uint128_t key, __uint128_t *cy_msg);
 
 void cy_aes_decryption(__uint128_t msg, __uint128_t key, __uint128_t *cy_msg);
 
+void cy_aes_sched_init(const __uint128_t key, CY_AES_SCHED *sched);
+
+void cy_aes_sched_encryption(const __uint128_t msg, const CY_AES_SCHED *sched, __uint128_t *cy_msg);
+
+void cy_aes_sched_decryption(const __uint128_t cy_msg, const CY_AES_SCHED *sched, __uint128_t *msg);
+
+/************************** RSA Context Functions **************************/
+
+CY_STATE_FLAG cy_rsa_ctx_init(const mpz_t *key, const uint8_t secret, CY_RSA_CTX **ctx);
+
+CY_STATE_FLAG cy_rsa_ctx_crt_init(const CY_KEY *prvkey, CY_RSA_CTX **ctx);
+
+CY_STATE_FLAG cy_rsa_ctx_bin_imp(const char *path, CY_RSA_CTX **ctx);
+
+CY_STATE_FLAG cy_rsa_ctx_powm(CY_RSA_CTX *ctx, mpz_srcptr in, mpz_ptr out);
+
+void cy_rsa_ctx_encryption(const uint8_t c, CY_RSA_CTX *ctx, mpz_ptr cy_msg);
+
+void cy_rsa_ctx_decryption(const mpz_srcptr cy_msg, CY_RSA_CTX *ctx, uint8_t *c);
+
+void cy_rsa_ctx_free(CY_RSA_CTX *ctx);
+
+/************************ RSA Multi-Buffer Functions ***********************/
+
+CY_STATE_FLAG cy_rsa_mb_powm(const size_t count, const mpz_srcptr in[], const mpz_t *key[], mpz_ptr out[]);
+
+CY_STATE_FLAG cy_rsa_mb_decryption(const size_t count, const mpz_srcptr cy_msg[], const mpz_t *key[], uint8_t c[]);
+
+/************************* Fixed Bignum Functions *************************/
+
+#define DECL_FIXED_BIGNUM_API(BITS)                                                                                     \
+typedef struct CY_U##BITS {uint64_t limb[(BITS) / 64];} CY_U##BITS;                                                     \
+typedef struct CY_U##BITS##_MONT {CY_U##BITS n, r2; uint64_t ninv;} CY_U##BITS##_MONT;                                  \
+CY_STATE_FLAG cy_u##BITS##_imp(mpz_srcptr z, CY_U##BITS *x);                                                            \
+void cy_u##BITS##_exp(const CY_U##BITS *x, mpz_ptr z);                                                                  \
+CY_STATE_FLAG cy_u##BITS##_mont_init(const CY_U##BITS *n, CY_U##BITS##_MONT *mont);                                     \
+void cy_u##BITS##_mont_mul(const CY_U##BITS##_MONT *mont, const CY_U##BITS *a, const CY_U##BITS *b, CY_U##BITS *r);     \
+void cy_u##BITS##_mont_sqr(const CY_U##BITS##_MONT *mont, const CY_U##BITS *a, CY_U##BITS *r);                          \
+void cy_u##BITS##_powm(const CY_U##BITS##_MONT *mont, const CY_U##BITS *base, const CY_U##BITS *exp, CY_U##BITS *out);
+
+DECL_FIXED_BIGNUM_API(2048)
+DECL_FIXED_BIGNUM_API(3072)
+DECL_FIXED_BIGNUM_API(4096)
+
+CY_STATE_FLAG cy_rsa_fixed_powm(const mpz_srcptr in, const mpz_t *key, mpz_ptr out);
+
+void cy_rsa_fixed_decryption(const mpz_srcptr cy_msg, const mpz_t *key, uint8_t *c);
+
+/*************************** Keystore Functions ****************************/
+
+CY_STATE_FLAG cy_keystore_init(const size_t nslot, CY_KEYSTORE **ks);
+
+CY_STATE_FLAG cy_keystore_load(CY_KEYSTORE *ks, const char *dir);
+
+unsigned cy_keystore_enter(CY_KEYSTORE *ks);
+
+void cy_keystore_leave(CY_KEYSTORE *ks, const unsigned epoch);
+
+CY_STATE_FLAG cy_keystore_rsa(CY_KEYSTORE *ks, const char *id, CY_RSA_CTX **ctx, const CY_KEY **key);
+
+CY_STATE_FLAG cy_keystore_aes(CY_KEYSTORE *ks, const char *id, const CY_AES_SCHED **sched);
+
+size_t cy_keystore_count(CY_KEYSTORE *ks);
+
+void cy_keystore_free(CY_KEYSTORE *ks);
+
+/*************************** Signature Functions ***************************/
+
+CY_STATE_FLAG cy_rsa_pss_sign(const uint8_t *msg, const size_t len, const CY_KEY *prvkey, mpz_ptr sig);
+
+CY_STATE_FLAG cy_rsa_pss_verify(const uint8_t *msg, const size_t len, const mpz_t *pubkey, mpz_srcptr sig);
+
+CY_STATE_FLAG cy_rsa_pss_verify_batch(const size_t count, const uint8_t *msg[], const size_t len[], const mpz_t *pubkey[], 
+                                      const mpz_srcptr sig[], const size_t nthreads, CY_STATE_FLAG result[]);
+
+/***************************** Audit Functions *****************************/
+
+CY_STATE_FLAG cy_rsa_batch_gcd(const size_t count, const mpz_srcptr n[], const size_t nthreads, mpz_ptr g[]);
+
+CY_STATE_FLAG cy_rsa_batch_gcd_file(const char *in_path, const char *out_path, const size_t nthreads, size_t *nweak);
+
+CY_STATE_FLAG cy_factor_fermat(mpz_srcptr n, const uint64_t max_iter, mpz_ptr f);
+
+CY_STATE_FLAG cy_factor_pm1(mpz_srcptr n, const uint64_t B1, const uint64_t B2, mpz_ptr f);
+
+CY_STATE_FLAG cy_factor_rho(mpz_srcptr n, const uint64_t max_iter, mpz_ptr f);
+
+CY_STATE_FLAG cy_factor_find(mpz_srcptr n, const unsigned methods, const size_t nthreads, const double seconds, mpz_ptr f, unsigned *method);
+
+CY_STATE_FLAG cy_rsa_key_audit(const char *path, const unsigned methods, const size_t nthreads, const double seconds, mpz_ptr f, unsigned *method);
+
+/****************************** CRT Functions ******************************/
+
+CY_STATE_FLAG cy_crt_init(const size_t count, const mpz_srcptr m[], CY_CRT **crt);
+
+CY_STATE_FLAG cy_crt_solve(const CY_CRT *crt, const mpz_srcptr a[], mpz_ptr out);
+
+CY_STATE_FLAG cy_crt_solve_batch(const CY_CRT *crt, const size_t nvec, const mpz_srcptr *a[], const size_t nthreads, mpz_ptr out[]);
+
+CY_STATE_FLAG cy_crt_reduce(const CY_CRT *crt, mpz_srcptr x, mpz_ptr out[]);
+
+void cy_crt_modulus(const CY_CRT *crt, mpz_ptr M);
+
+void cy_crt_free(CY_CRT *crt);
+
+/****************************** DLP Functions ******************************/
+
+CY_STATE_FLAG cy_dlp_bsgs(mpz_srcptr g, mpz_srcptr h, mpz_srcptr p, mpz_srcptr q, mpz_ptr x);
+
+CY_STATE_FLAG cy_dlp_rho(mpz_srcptr g, mpz_srcptr h, mpz_srcptr p, mpz_srcptr q, const size_t nthreads, mpz_ptr x);
+
+CY_STATE_FLAG cy_dlp_solve(mpz_srcptr g, mpz_srcptr h, mpz_srcptr p, mpz_srcptr order, const size_t nthreads, mpz_ptr x);
+
+/**************************** GF(2)[x] Functions ****************************/
+
+void cy_gf2x_init(CY_GF2X *f);
+
+void cy_gf2x_free(CY_GF2X *f);
+
+CY_STATE_FLAG cy_gf2x_set(CY_GF2X *f, const CY_GF2X *g);
+
+CY_STATE_FLAG cy_gf2x_set_words(CY_GF2X *f, const uint64_t *w, const size_t n);
+
+CY_STATE_FLAG cy_gf2x_set_coeff(CY_GF2X *f, const size_t i, const int bit);
+
+int cy_gf2x_coeff(const CY_GF2X *f, const size_t i);
+
+long cy_gf2x_deg(const CY_GF2X *f);
+
+CY_STATE_FLAG cy_gf2x_add(const CY_GF2X *f, const CY_GF2X *g, CY_GF2X *out);
+
+CY_STATE_FLAG cy_gf2x_mul(const CY_GF2X *f, const CY_GF2X *g, CY_GF2X *out);
+
+CY_STATE_FLAG cy_gf2x_sqr(const CY_GF2X *f, CY_GF2X *out);
+
+CY_STATE_FLAG cy_gf2x_divrem(const CY_GF2X *f, const CY_GF2X *g, CY_GF2X *q, CY_GF2X *r);
+
+CY_STATE_FLAG cy_gf2x_gcd(const CY_GF2X *f, const CY_GF2X *g, CY_GF2X *out);
+
+CY_STATE_FLAG cy_gf2x_eea(const CY_GF2X *f, const CY_GF2X *g, CY_GF2X *d, CY_GF2X *s, CY_GF2X *t);
+
+CY_STATE_FLAG cy_gf2x_mod_init(const CY_GF2X *m, CY_GF2X_MOD **ctx);
+
+CY_STATE_FLAG cy_gf2x_mod_reduce(const CY_GF2X_MOD *ctx, const CY_GF2X *a, CY_GF2X *out);
+
+CY_STATE_FLAG cy_gf2x_mod_mul(const CY_GF2X_MOD *ctx, const CY_GF2X *a, const CY_GF2X *b, CY_GF2X *out);
+
+void cy_gf2x_mod_free(CY_GF2X_MOD *ctx);
+
+CY_STATE_FLAG cy_gf2x_irreducible(const CY_GF2X *f, int *irr);
+
 /************************* Buffer Cypher Functions ************************/
 
 // void cy_buff_padd16(const size_t size, uint8_t *pad, uint8_t buffer[]);
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/*
+ * Shared by the test_*.c programs: CY_CHECK counts a failed condition and
+ * keeps going, cy_test_done prints the tally and gives the exit status.
+ * Scratch files go under tmp/, created on demand.
+ */
+
+#if !defined(__CY_TEST__)
+#define __CY_TEST__
+
+#include <cypher.h>
+#include <sys/stat.h>
+
+static int cy_test_fail, cy_test_count;
+
+#define CY_CHECK(cond) do {                                                     \
+    cy_test_count++;                                                            \
+    if(!(cond)) {cy_test_fail++; fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);} \
+} while (0)
+
+// hex to bytes, returns the byte count
+static inline size_t cy_test_hex(const char *hex, uint8_t *out)
+{
+    size_t n = strlen(hex) / 2;
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned v;
+        sscanf(hex + 2 * i, "%2x", &v);
+        out[i] = (uint8_t)v;
+    }
+    return n;
+}
+
+static inline int cy_test_eq_hex(const uint8_t *got, const char *hex)
+{
+    uint8_t want[256];
+    size_t n = cy_test_hex(hex, want);
+    return !memcmp(got, want, n);
+}
+
+// tmp/<name>, the directory made on first use
+static inline const char *cy_test_path(const char *name)
+{
+    static char path[256];
+    mkdir("tmp", 0700);
+    snprintf(path, sizeof(path), "tmp/%s", name);
+    return path;
+}
+
+// same bytes every run, a test failure can be replayed
+static inline void cy_test_fill(uint8_t *buff, const size_t len, uint32_t seed)
+{
+    for (size_t i = 0; i < len; i++) {seed = seed * 1664525u + 1013904223u; buff[i] = (uint8_t)(seed >> 24);}
+}
+
+/*
+ * Textbook RSA: p = 61, q = 53, n = 3233, e = 17, d = 2753, and 65^e = 2790.
+ * Laid out as a two prime CRT key, d_p = 53, d_q = 49, q^-1 mod p = 38.
+ */
+static inline void cy_test_tiny_key(CY_KEY *key)
+{
+    static const unsigned long v[10] = {2753, 3233, 17, 2, 61, 53, 0, 53, 49, 38};
+    key->size = CY_RSA_PRV_SIZE(2);
+    key->key = malloc(key->size * sizeof(mpz_t));
+    for (size_t i = 0; i < key->size; i++) mpz_init_set_ui(key->key[i], v[i]);
+}
+
+static inline int cy_test_done(const char *name)
+{
+    printf("%-16s %s (%d checks, %d failed)\n", name, cy_test_fail ? "FAIL" : "ok", cy_test_count, cy_test_fail);
+    return cy_test_fail != 0;
+}
+
+#endif
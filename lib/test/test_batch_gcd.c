@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Batch GCD: shared primes found in memory and by the streaming file variant across groups
+
+#include "cy_test.h"
+
+#define CY_TEST_SMALL 9
+#define CY_TEST_LARGE 40000     // more than one CY_BGCD_GROUP of the file variant
+
+// n_i = p_2i * p_2i+1 over consecutive primes, then n_b gets a prime of n_a
+static void cy_test_moduli(mpz_t *n, const size_t count, const size_t pairs[][2], const size_t npair)
+{
+    mpz_t p, q; mpz_inits(p, q, NULL);
+    mpz_set_ui(p, 1u << 31);
+    for (size_t i = 0; i < count; i++)
+    {
+        mpz_nextprime(p, p);
+        mpz_nextprime(q, p);
+        mpz_mul(n[i], p, q);
+        mpz_set(p, q);
+    }
+    for (size_t k = 0; k < npair; k++)
+    {
+        // keep n_b's larger prime, swap its smaller one for n_a's
+        mpz_t a, b; mpz_inits(a, b, NULL);
+        mpz_sqrt(a, n[pairs[k][0]]);
+        mpz_nextprime(a, a);
+        mpz_divexact(a, n[pairs[k][0]], a);
+        mpz_sqrt(b, n[pairs[k][1]]);
+        mpz_nextprime(b, b);
+        mpz_mul(n[pairs[k][1]], a, b);
+        mpz_clears(a, b, NULL);
+    }
+    mpz_clears(p, q, NULL);
+}
+
+int main(void)
+{
+    static const size_t small[][2] = {{1, 6}};
+    mpz_t n[CY_TEST_SMALL], g[CY_TEST_SMALL];
+    mpz_ptr np[CY_TEST_SMALL], gp[CY_TEST_SMALL];
+    for (size_t i = 0; i < CY_TEST_SMALL; i++) {mpz_inits(n[i], g[i], NULL); np[i] = n[i]; gp[i] = g[i];}
+    cy_test_moduli(n, CY_TEST_SMALL, small, 1);
+    CY_CHECK(cy_rsa_batch_gcd(CY_TEST_SMALL, (const mpz_srcptr *)np, 2, gp) == CY_OK);
+    for (size_t i = 0; i < CY_TEST_SMALL; i++)
+    {
+        if(i == 1 || i == 6) CY_CHECK(mpz_cmp_ui(g[i], 1) > 0 && mpz_cmp(g[i], n[i]) < 0 && mpz_divisible_p(n[i], g[i]));
+        else CY_CHECK(mpz_cmp_ui(g[i], 1) == 0);
+    }
+    CY_CHECK(mpz_cmp(g[1], g[6]) == 0);
+    // a lone modulus has nothing to share with
+    mpz_set_ui(g[0], 0);
+    CY_CHECK(cy_rsa_batch_gcd(1, (const mpz_srcptr *)np, 1, gp) == CY_OK && mpz_cmp_ui(g[0], 1) == 0);
+    for (size_t i = 0; i < CY_TEST_SMALL; i++) mpz_clears(n[i], g[i], NULL);
+
+    // pairs inside the first group, across groups, and inside the last one
+    static const size_t large[][2] = {{3, 100}, {7, 39990}, {33000, 39999}};
+    mpz_t *big = malloc(CY_TEST_LARGE * sizeof(mpz_t));
+    for (size_t i = 0; i < CY_TEST_LARGE; i++) mpz_init(big[i]);
+    cy_test_moduli(big, CY_TEST_LARGE, large, 3);
+    char in[256], out[256];
+    snprintf(in, sizeof(in), "%s", cy_test_path("moduli.txt"));
+    FILE *fp = fopen(in, "w");
+    for (size_t i = 0; i < CY_TEST_LARGE; i++) gmp_fprintf(fp, "%Zd\n", big[i]);
+    fclose(fp);
+
+    snprintf(out, sizeof(out), "%s", cy_test_path("weak.txt"));
+    size_t nweak = 0;
+    CY_CHECK(cy_rsa_batch_gcd_file(in, out, 4, &nweak) == CY_OK);
+    CY_CHECK(nweak == 6);
+    fp = fopen(out, "r");
+    size_t idx, seen = 0;
+    mpz_t f; mpz_init(f);
+    while (fp && gmp_fscanf(fp, "%zu %Zd", &idx, f) == 2)
+    {
+        int planted = 0;
+        for (size_t k = 0; k < 3; k++) planted |= idx == large[k][0] || idx == large[k][1];
+        CY_CHECK(planted && idx < CY_TEST_LARGE && mpz_cmp_ui(f, 1) > 0 && mpz_divisible_p(big[idx], f));
+        seen++;
+    }
+    if(fp) fclose(fp);
+    CY_CHECK(seen == 6);
+
+    mpz_clear(f);
+    for (size_t i = 0; i < CY_TEST_LARGE; i++) mpz_clear(big[i]);
+    free(big);
+    return cy_test_done("batch_gcd");
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// BLAKE3: reference digests, the threaded tree against the streaming hasher and the file path
+
+#include "cy_test.h"
+
+int main(void)
+{
+    uint8_t out[32], ref[32];
+    const size_t n = 300000;
+    uint8_t *buff = malloc(n);
+    cy_test_fill(buff, n, 3);
+
+    CY_CHECK(cy_blake3((const uint8_t *)"", 0, 1, out) == CY_OK);
+    CY_CHECK(cy_test_eq_hex(out, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"));
+    CY_CHECK(cy_blake3((const uint8_t *)"abc", 3, 1, out) == CY_OK);
+    CY_CHECK(cy_test_eq_hex(out, "6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85"));
+
+    // 300000 bytes span many chunks and an uneven last subtree
+    static const char *big = "2261383b5c61f5b1ed4e86ed3638cefcfc6ffcbe009fdb85f7a2e08f2bad14e2";
+    for (size_t t = 1; t <= 8; t *= 2) {CY_CHECK(cy_blake3(buff, n, t, out) == CY_OK); CY_CHECK(cy_test_eq_hex(out, big));}
+
+    CY_BLAKE3_STATE st;
+    cy_blake3_init(&st);
+    for (size_t off = 0, k = 1; off < n; off += k, k = k * 7 % 3000 + 1) cy_blake3_update(&st, buff + off, n - off < k ? n - off : k);
+    cy_blake3_final(&st, ref);
+    CY_CHECK(cy_test_eq_hex(ref, big));
+
+    // every length around the chunk and block edges, tree against stream
+    for (size_t len = 1000; len < 3200; len += 61)
+    {
+        cy_blake3(buff, len, 4, out);
+        cy_blake3_init(&st); cy_blake3_update(&st, buff, len); cy_blake3_final(&st, ref);
+        CY_CHECK(!memcmp(out, ref, 32));
+    }
+
+    FILE *fp = fopen(cy_test_path("blake3.bin"), "wb");
+    fwrite(buff, 1, n, fp); fclose(fp);
+    CY_CHECK(cy_blake3_file(cy_test_path("blake3.bin"), 4, out) == CY_OK && cy_test_eq_hex(out, big));
+    CY_CHECK(cy_blake3_file(cy_test_path("missing.bin"), 4, out) != CY_OK);
+
+    free(buff);
+    return cy_test_done("blake3");
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// CRC32C: the Castagnoli check value, chaining, and lengths around the 3-way block split
+
+#include "cy_test.h"
+
+// bit at a time, the definition
+static uint32_t cy_test_crc(const uint8_t *p, size_t len)
+{
+    uint32_t c = 0xFFFFFFFFu;
+    while (len--) {c ^= *p++; for (int k = 0; k < 8; k++) c = c & 1 ? (c >> 1) ^ 0x82F63B78u : c >> 1;}
+    return ~c;
+}
+
+int main(void)
+{
+    CY_CHECK(cy_crc32c(0, (const uint8_t *)"123456789", 9) == 0xE3069283u);
+    CY_CHECK(cy_crc32c(0, NULL, 0) == 0);
+
+    static uint8_t buff[10000];
+    cy_test_fill(buff, sizeof(buff), 11);
+    for (size_t len = 0; len <= sizeof(buff); len += len < 64 ? 1 : 997)
+        CY_CHECK(cy_crc32c(0, buff, len) == cy_test_crc(buff, len));
+    CY_CHECK(cy_crc32c(0, buff, 3072) == cy_test_crc(buff, 3072));
+
+    // chained calls equal one call on the concatenation
+    for (size_t cut = 0; cut <= sizeof(buff); cut += 1234)
+        CY_CHECK(cy_crc32c(cy_crc32c(0, buff, cut), buff + cut, sizeof(buff) - cut) == cy_crc32c(0, buff, sizeof(buff)));
+
+    return cy_test_done("crc32c");
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// CRT solver: Garner and the product tree path against reduce, batches, and non-coprime moduli
+
+#include "cy_test.h"
+
+#define CY_TEST_VEC 8
+
+static void cy_test_crt(gmp_randstate_t rs, const size_t k)
+{
+    mpz_t *m = malloc(k * sizeof(mpz_t)), *a = malloc(k * sizeof(mpz_t)), x, M, y;
+    mpz_ptr *mp = malloc(k * sizeof(mpz_ptr)), *ap = malloc(k * sizeof(mpz_ptr));
+    mpz_inits(x, M, y, NULL);
+
+    // distinct primes of mixed sizes are pairwise coprime
+    for (size_t i = 0; i < k; i++)
+    {
+        mpz_inits(m[i], a[i], NULL);
+        mp[i] = m[i]; ap[i] = a[i];
+        mpz_urandomb(m[i], rs, 40 + 13 * (i % 7));
+        mpz_nextprime(m[i], m[i]);
+        for (size_t j = 0; j < i; j++) if(!mpz_cmp(m[i], m[j])) {mpz_nextprime(m[i], m[i]); j = (size_t)-1;}
+    }
+    CY_CRT *crt;
+    CY_CHECK(cy_crt_init(k, (const mpz_srcptr *)mp, &crt) == CY_OK);
+    cy_crt_modulus(crt, M);
+    mpz_set_ui(y, 1);
+    for (size_t i = 0; i < k; i++) mpz_mul(y, y, m[i]);
+    CY_CHECK(mpz_cmp(M, y) == 0);
+
+    // reduce then solve gives x back, and the residues are what reduce gave
+    mpz_urandomm(x, rs, M);
+    CY_CHECK(cy_crt_reduce(crt, x, ap) == CY_OK);
+    for (size_t i = 0; i < k; i++) {mpz_mod(y, x, m[i]); CY_CHECK(mpz_cmp(a[i], y) == 0);}
+    CY_CHECK(cy_crt_solve(crt, (const mpz_srcptr *)ap, y) == CY_OK && mpz_cmp(x, y) == 0);
+
+    // residues outside [0, m_i) still solve
+    mpz_add(a[0], a[0], m[0]);
+    mpz_sub(a[k - 1], a[k - 1], m[k - 1]);
+    CY_CHECK(cy_crt_solve(crt, (const mpz_srcptr *)ap, y) == CY_OK && mpz_cmp(x, y) == 0);
+
+    // a batch of vectors over threads
+    mpz_t want[CY_TEST_VEC], out[CY_TEST_VEC];
+    mpz_ptr outp[CY_TEST_VEC];
+    mpz_t *vec[CY_TEST_VEC];
+    const mpz_srcptr *vecp[CY_TEST_VEC];
+    for (size_t v = 0; v < CY_TEST_VEC; v++)
+    {
+        mpz_inits(want[v], out[v], NULL);
+        outp[v] = out[v];
+        mpz_urandomm(want[v], rs, M);
+        vec[v] = malloc(k * sizeof(mpz_t));
+        mpz_ptr *p = malloc(k * sizeof(mpz_ptr));
+        for (size_t i = 0; i < k; i++) {mpz_init(vec[v][i]); p[i] = vec[v][i];}
+        cy_crt_reduce(crt, want[v], p);
+        vecp[v] = (const mpz_srcptr *)p;
+    }
+    CY_CHECK(cy_crt_solve_batch(crt, CY_TEST_VEC, vecp, 3, outp) == CY_OK);
+    for (size_t v = 0; v < CY_TEST_VEC; v++)
+    {
+        CY_CHECK(mpz_cmp(out[v], want[v]) == 0);
+        for (size_t i = 0; i < k; i++) mpz_clear(vec[v][i]);
+        free(vec[v]); free((void *)vecp[v]);
+        mpz_clears(want[v], out[v], NULL);
+    }
+
+    cy_crt_free(crt);
+    for (size_t i = 0; i < k; i++) mpz_clears(m[i], a[i], NULL);
+    free(m); free(a); free(mp); free(ap);
+    mpz_clears(x, M, y, NULL);
+}
+
+int main(void)
+{
+    gmp_randstate_t rs;
+    gmp_randinit_default(rs);
+    gmp_randseed_ui(rs, 37);
+
+    // small hand vector: x = 2 mod 3, 3 mod 5, 2 mod 7 is 23
+    mpz_t m[3], a[3], x;
+    mpz_ptr mp[3], ap[3];
+    static const unsigned long mv[3] = {3, 5, 7}, av[3] = {2, 3, 2};
+    for (size_t i = 0; i < 3; i++) {mpz_init_set_ui(m[i], mv[i]); mpz_init_set_ui(a[i], av[i]); mp[i] = m[i]; ap[i] = a[i];}
+    mpz_init(x);
+    CY_CRT *crt;
+    CY_CHECK(cy_crt_init(3, (const mpz_srcptr *)mp, &crt) == CY_OK);
+    CY_CHECK(cy_crt_solve(crt, (const mpz_srcptr *)ap, x) == CY_OK && mpz_cmp_ui(x, 23) == 0);
+    cy_crt_free(crt);
+
+    // Garner sizes, the boundary, and the product tree path
+    static const size_t k[] = {1, 2, 5, 16, 17, 40, 129};
+    for (size_t i = 0; i < sizeof(k) / sizeof(k[0]); i++) cy_test_crt(rs, k[i]);
+
+    // 6 and 9 share 3, and a modulus below 2
+    mpz_set_ui(m[0], 6); mpz_set_ui(m[1], 9);
+    CY_CHECK(cy_crt_init(3, (const mpz_srcptr *)mp, &crt) != CY_OK);
+    mpz_set_ui(m[0], 1); mpz_set_ui(m[1], 5);
+    CY_CHECK(cy_crt_init(3, (const mpz_srcptr *)mp, &crt) != CY_OK);
+
+    for (size_t i = 0; i < 3; i++) mpz_clears(m[i], a[i], NULL);
+    mpz_clear(x);
+    gmp_randclear(rs);
+    return cy_test_done("crt");
+}
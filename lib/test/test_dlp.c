@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Discrete logs: BSGS on both widths, Pollard rho in a prime subgroup, Pohlig-Hellman
+
+#include "cy_test.h"
+
+// p = k q + 1 prime above 2^pbits, g of order q
+static void cy_test_group(gmp_randstate_t rs, const mp_bitcnt_t pbits, const mp_bitcnt_t qbits, mpz_t p, mpz_t q, mpz_t g)
+{
+    mpz_t k, t; mpz_inits(k, t, NULL);
+    mpz_urandomb(q, rs, qbits - 1);
+    mpz_setbit(q, qbits - 1);
+    mpz_nextprime(q, q);
+    do
+    {
+        mpz_urandomb(k, rs, pbits - qbits);
+        mpz_setbit(k, pbits - qbits);
+        mpz_clrbit(k, 0);
+        mpz_mul(p, k, q);
+        mpz_add_ui(p, p, 1);
+    } while (!mpz_probab_prime_p(p, 30));
+    for (unsigned long a = 2;; a++)
+    {
+        mpz_set_ui(t, a);
+        mpz_powm(g, t, k, p);
+        if(mpz_cmp_ui(g, 1)) break;
+    }
+    mpz_clears(k, t, NULL);
+}
+
+// x solves g^x = h and is the x0 that made h, mod the order
+static int cy_test_log_ok(mpz_srcptr g, mpz_srcptr h, mpz_srcptr p, mpz_srcptr x, mpz_srcptr x0, mpz_srcptr q)
+{
+    mpz_t t, u; mpz_inits(t, u, NULL);
+    mpz_powm(t, g, x, p);
+    int ok = mpz_cmp(t, h) == 0;
+    if(q) {mpz_mod(t, x, q); mpz_mod(u, x0, q); ok &= mpz_cmp(t, u) == 0;}
+    mpz_clears(t, u, NULL);
+    return ok;
+}
+
+int main(void)
+{
+    gmp_randstate_t rs;
+    gmp_randinit_default(rs);
+    gmp_randseed_ui(rs, 38);
+    mpz_t p, q, g, h, x, x0, bad; mpz_inits(p, q, g, h, x, x0, bad, NULL);
+
+    // 62 bit p stays on the u64 tables, 100 bit p goes through mpz
+    static const mp_bitcnt_t pbits[2] = {62, 100};
+    for (size_t i = 0; i < 2; i++)
+    {
+        cy_test_group(rs, pbits[i], 34, p, q, g);
+        for (unsigned j = 0; j < 3; j++)
+        {
+            mpz_urandomm(x0, rs, q);
+            if(j == 0) mpz_set_ui(x0, 0);
+            mpz_powm(h, g, x0, p);
+            CY_CHECK(cy_dlp_bsgs(g, h, p, q, x) == CY_OK && cy_test_log_ok(g, h, p, x, x0, q));
+        }
+    }
+
+    // rho over threads, then h outside <g>: g^q = 1, so a generator of Z_p^* is not in it
+    cy_test_group(rs, 90, 36, p, q, g);
+    mpz_urandomm(x0, rs, q);
+    mpz_powm(h, g, x0, p);
+    CY_CHECK(cy_dlp_rho(g, h, p, q, 4, x) == CY_OK && cy_test_log_ok(g, h, p, x, x0, q));
+    mpz_set_ui(bad, 2);
+    while (mpz_powm(x, bad, q, p), mpz_cmp_ui(x, 1) == 0) mpz_add_ui(bad, bad, 1);
+    CY_CHECK(cy_dlp_rho(g, bad, p, q, 2, x) != CY_OK);
+    mpz_add_ui(x, q, 1);
+    CY_CHECK(cy_dlp_rho(g, h, p, x, 2, x0) != CY_OK);
+
+    // Pohlig-Hellman with p - 1 a product of primes below 2^16, order taken from p
+    do
+    {
+        mpz_set_ui(q, 2);
+        while (mpz_sizeinbase(q, 2) < 80)
+        {
+            mpz_urandomb(x, rs, 16);
+            mpz_nextprime(x, x);
+            mpz_mul(q, q, x);
+        }
+        mpz_add_ui(p, q, 1);
+    } while (!mpz_probab_prime_p(p, 30));
+    mpz_set_ui(g, 3);
+    for (unsigned j = 0; j < 3; j++)
+    {
+        mpz_urandomm(x0, rs, q);
+        mpz_powm(h, g, x0, p);
+        CY_CHECK(cy_dlp_solve(g, h, p, NULL, 2, x) == CY_OK && cy_test_log_ok(g, h, p, x, x0, NULL));
+    }
+
+    // a given order that g's order divides, and one that it does not
+    cy_test_group(rs, 70, 30, p, q, g);
+    mpz_urandomm(x0, rs, q);
+    mpz_powm(h, g, x0, p);
+    mpz_mul_ui(bad, q, 12);
+    CY_CHECK(cy_dlp_solve(g, h, p, bad, 2, x) == CY_OK && cy_test_log_ok(g, h, p, x, x0, q));
+    mpz_set_ui(bad, 12);
+    CY_CHECK(cy_dlp_solve(g, h, p, bad, 2, x) != CY_OK);
+
+    mpz_clears(p, q, g, h, x, x0, bad, NULL);
+    gmp_randclear(rs);
+    return cy_test_done("dlp");
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Factoring: each method on the weakness it targets, cy_factor_find's dispatch, and the key file audit
+
+#include "cy_test.h"
+
+static gmp_randstate_t cy_test_rs;
+
+static void cy_test_prime(mpz_t p, const mp_bitcnt_t bits)
+{
+    mpz_urandomb(p, cy_test_rs, bits - 1);
+    mpz_setbit(p, bits - 1);
+    mpz_nextprime(p, p);
+}
+
+// p = 2 * (distinct odd primes below bound, at random) * big + 1, prime
+static void cy_test_smooth_prime(mpz_t p, const unsigned long bound, const unsigned long big, const mp_bitcnt_t bits)
+{
+    mpz_t r; mpz_init(r);
+    do
+    {
+        mpz_set_ui(p, 2 * big);
+        while (mpz_sizeinbase(p, 2) < bits)
+        {
+            mpz_set_ui(r, gmp_urandomm_ui(cy_test_rs, bound));
+            mpz_nextprime(r, r);
+            if(mpz_cmp_ui(r, bound) < 0 && !mpz_divisible_p(p, r)) mpz_mul(p, p, r);
+        }
+        mpz_add_ui(p, p, 1);
+    } while (!mpz_probab_prime_p(p, 30));
+    mpz_clear(r);
+}
+
+static int cy_test_proper(mpz_srcptr f, mpz_srcptr n)
+{
+    return mpz_cmp_ui(f, 1) > 0 && mpz_cmp(f, n) < 0 && mpz_divisible_p(n, f);
+}
+
+int main(void)
+{
+    gmp_randinit_default(cy_test_rs);
+    gmp_randseed_ui(cy_test_rs, 42);
+    mpz_t p, q, n, f; mpz_inits(p, q, n, f, NULL);
+    unsigned method = 99;
+
+    // Fermat: q the prime right after p
+    cy_test_prime(p, 256);
+    mpz_nextprime(q, p);
+    mpz_mul(n, p, q);
+    CY_CHECK(cy_factor_fermat(n, 100, f) == CY_OK && cy_test_proper(f, n));
+    CY_CHECK(cy_factor_find(n, CY_FACTOR_FERMAT, 1, 5, f, &method) == CY_OK && cy_test_proper(f, n) && method == CY_FACTOR_FERMAT);
+
+    // p - 1: 1000 smooth for stage 1, one prime near 60000 left over for stage 2
+    cy_test_smooth_prime(p, 1000, 1, 160);
+    cy_test_prime(q, 256);
+    mpz_mul(n, p, q);
+    CY_CHECK(cy_factor_pm1(n, 1000, 0, f) == CY_OK && mpz_cmp(f, p) == 0);
+    cy_test_smooth_prime(p, 1000, 60013, 160);
+    mpz_mul(n, p, q);
+    CY_CHECK(cy_factor_pm1(n, 1000, 0, f) == CY_OK && mpz_cmp_ui(f, 1) == 0);
+    CY_CHECK(cy_factor_pm1(n, 1000, 100000, f) == CY_OK && mpz_cmp(f, p) == 0);
+    CY_CHECK(cy_factor_find(n, CY_FACTOR_PM1, 2, 5, f, &method) == CY_OK && cy_test_proper(f, n) && method == CY_FACTOR_PM1);
+
+    // rho: a 32 bit prime factor
+    cy_test_prime(p, 32);
+    cy_test_prime(q, 200);
+    mpz_mul(n, p, q);
+    CY_CHECK(cy_factor_rho(n, 1000000, f) == CY_OK && cy_test_proper(f, n));
+    CY_CHECK(cy_factor_find(n, CY_FACTOR_RHO, 1, 5, f, &method) == CY_OK && cy_test_proper(f, n) && method == CY_FACTOR_RHO);
+    CY_CHECK(cy_factor_find(n, CY_FACTOR_ALL, 3, 5, f, &method) == CY_OK && cy_test_proper(f, n) && method != 0);
+
+    // trial division catches a prime below 2^16 before any method runs, a prime n has no factor
+    mpz_mul_ui(n, q, 65521);
+    CY_CHECK(cy_factor_find(n, CY_FACTOR_ALL, 2, 5, f, &method) == CY_OK && mpz_cmp_ui(f, 65521) == 0 && method == 0);
+    CY_CHECK(cy_factor_find(q, CY_FACTOR_ALL, 2, 5, f, &method) == CY_OK && mpz_cmp_ui(f, 1) == 0 && method == 0);
+
+    // a sound key gives nothing in a short budget, a Fermat weak one is broken from its file
+    mpz_t *pk, *sk;
+    CY_CHECK(cy_rsa_key_gen(512, &pk, &sk) == CY_OK);
+    CY_CHECK(cy_rsa_key_exp(cy_test_path("sound.key"), pk) == CY_OK);
+    CY_CHECK(cy_rsa_key_audit(cy_test_path("sound.key"), CY_FACTOR_ALL, 2, 0.2, f, &method) == CY_OK && mpz_cmp_ui(f, 1) == 0);
+    cy_test_prime(p, 256);
+    mpz_nextprime(q, p);
+    mpz_mul(pk[1], p, q);
+    CY_CHECK(cy_rsa_key_exp(cy_test_path("weak.key"), pk) == CY_OK);
+    CY_CHECK(cy_rsa_key_audit(cy_test_path("weak.key"), CY_FACTOR_ALL, 2, 5, f, &method) == CY_OK);
+    CY_CHECK((mpz_cmp(f, p) == 0 || mpz_cmp(f, q) == 0) && method == CY_FACTOR_FERMAT);
+    cy_rsa_key_free(pk); cy_rsa_key_free(sk);
+
+    mpz_clears(p, q, n, f, NULL);
+    gmp_randclear(cy_test_rs);
+    return cy_test_done("factor");
+}
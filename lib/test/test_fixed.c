@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Fixed width bignums: limb round trips, Montgomery products and powm at 2048, 3072 and 4096 bits
+
+#include "cy_test.h"
+
+int main(void)
+{
+    gmp_randstate_t rs;
+    gmp_randinit_default(rs);
+    gmp_randseed_ui(rs, 31);
+    mpz_t key[2], in, out, want; mpz_inits(key[0], key[1], in, out, want, NULL);
+
+    static const mp_bitcnt_t bits[3] = {2048, 3072, 4096};
+    for (size_t b = 0; b < 3; b++)
+    {
+        for (unsigned i = 0; i < 4; i++)
+        {
+            // any odd modulus of the exact width, full and short exponents
+            mpz_urandomb(key[1], rs, bits[b] - 1);
+            mpz_setbit(key[1], bits[b] - 1);
+            mpz_setbit(key[1], 0);
+            if(i & 1) mpz_set_ui(key[0], 65537);
+            else mpz_urandomm(key[0], rs, key[1]);
+            mpz_urandomb(in, rs, bits[b] + 8);
+            CY_CHECK(cy_rsa_fixed_powm(in, (const mpz_t *)key, out) == CY_OK);
+            mpz_powm(want, in, key[0], key[1]);
+            CY_CHECK(mpz_cmp(out, want) == 0);
+        }
+    }
+
+    // widths without a fixed type and even moduli go to mpz_powm
+    mpz_set_ui(key[1], 1000000);
+    mpz_set_ui(key[0], 77);
+    mpz_set_ui(in, 123457);
+    CY_CHECK(cy_rsa_fixed_powm(in, (const mpz_t *)key, out) == CY_OK);
+    mpz_powm(want, in, key[0], key[1]);
+    CY_CHECK(mpz_cmp(out, want) == 0);
+
+    // limb import refuses what does not fit, exports what it took
+    CY_U2048 x, y, r;
+    CY_U2048_MONT mont;
+    mpz_urandomb(in, rs, 2048);
+    CY_CHECK(cy_u2048_imp(in, &x) == CY_OK);
+    cy_u2048_exp(&x, out);
+    CY_CHECK(mpz_cmp(in, out) == 0);
+    mpz_setbit(in, 2048);
+    CY_CHECK(cy_u2048_imp(in, &x) != CY_OK);
+
+    // mont_mul(aR, bR) = abR, so multiplying by R^2 then by 1 is the identity
+    mpz_urandomb(key[1], rs, 2047);
+    mpz_setbit(key[1], 2047);
+    mpz_setbit(key[1], 0);
+    cy_u2048_imp(key[1], &mont.n);
+    CY_CHECK(cy_u2048_mont_init(&mont.n, &mont) == CY_OK);
+    mpz_urandomm(in, rs, key[1]);
+    cy_u2048_imp(in, &x);
+    cy_u2048_mont_mul(&mont, &x, &mont.r2, &y);
+    memset(&r, 0, sizeof(r));
+    r.limb[0] = 1;
+    cy_u2048_mont_mul(&mont, &y, &r, &y);
+    cy_u2048_exp(&y, out);
+    CY_CHECK(mpz_cmp(in, out) == 0);
+    cy_u2048_mont_mul(&mont, &x, &mont.r2, &y);
+    cy_u2048_mont_sqr(&mont, &y, &y);
+    cy_u2048_mont_mul(&mont, &y, &r, &y);
+    cy_u2048_exp(&y, out);
+    mpz_mul(want, in, in);
+    mpz_mod(want, want, key[1]);
+    CY_CHECK(mpz_cmp(out, want) == 0);
+
+    mpz_clears(key[0], key[1], in, out, want, NULL);
+    gmp_randclear(rs);
+    return cy_test_done("fixed");
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// GF(2)[x]: products against a shift and xor reference, division, gcd and EEA identities, Barrett, Ben-Or
+
+#include "cy_test.h"
+
+static void cy_test_rand(CY_GF2X *f, const size_t words, const uint32_t seed)
+{
+    uint64_t *w = calloc(words, sizeof(w[0]));
+    cy_test_fill((uint8_t *)w, words * sizeof(w[0]), seed);
+    w[words - 1] |= (uint64_t)1 << 63;
+    cy_gf2x_set_words(f, w, words);
+    free(w);
+}
+
+// f g one set bit of f at a time
+static void cy_test_mul_ref(const CY_GF2X *f, const CY_GF2X *g, CY_GF2X *out)
+{
+    CY_GF2X acc, sh;
+    cy_gf2x_init(&acc); cy_gf2x_init(&sh);
+    for (size_t i = 0; i < 64 * f->n; i++)
+    {
+        if(!cy_gf2x_coeff(f, i)) continue;
+        uint64_t *w = calloc(g->n + i / 64 + 1, sizeof(w[0]));
+        for (size_t j = 0; j < g->n; j++)
+        {
+            w[j + i / 64] ^= g->w[j] << (i % 64);
+            if(i % 64) w[j + i / 64 + 1] ^= g->w[j] >> (64 - i % 64);
+        }
+        cy_gf2x_set_words(&sh, w, g->n + i / 64 + 1);
+        cy_gf2x_add(&acc, &sh, &acc);
+        free(w);
+    }
+    cy_gf2x_set(out, &acc);
+    cy_gf2x_free(&acc); cy_gf2x_free(&sh);
+}
+
+static int cy_test_eq(const CY_GF2X *f, const CY_GF2X *g)
+{
+    return f->n == g->n && (!f->n || !memcmp(f->w, g->w, f->n * sizeof(f->w[0])));
+}
+
+// sets f from the exponents of its terms, -1 ends the list
+static void cy_test_poly(CY_GF2X *f, const int *e)
+{
+    cy_gf2x_set_words(f, NULL, 0);
+    for (; *e >= 0; e++) cy_gf2x_set_coeff(f, (size_t)*e, 1);
+}
+
+int main(void)
+{
+    CY_GF2X a, b, c, d, q, r, s, t;
+    CY_GF2X *all[] = {&a, &b, &c, &d, &q, &r, &s, &t};
+    for (size_t i = 0; i < 8; i++) cy_gf2x_init(all[i]);
+
+    // (x^2 + x + 1)(x + 1) = x^3 + 1
+    cy_test_poly(&a, (const int[]){2, 1, 0, -1});
+    cy_test_poly(&b, (const int[]){1, 0, -1});
+    CY_CHECK(cy_gf2x_mul(&a, &b, &c) == CY_OK);
+    cy_test_poly(&d, (const int[]){3, 0, -1});
+    CY_CHECK(cy_test_eq(&c, &d));
+
+    // schoolbook and Karatsuba sizes, uneven operands, squares
+    static const size_t sz[][2] = {{1, 1}, {3, 2}, {17, 17}, {40, 33}, {128, 128}, {200, 7}};
+    for (size_t i = 0; i < sizeof(sz) / sizeof(sz[0]); i++)
+    {
+        cy_test_rand(&a, sz[i][0], 100 + (uint32_t)i);
+        cy_test_rand(&b, sz[i][1], 200 + (uint32_t)i);
+        CY_CHECK(cy_gf2x_mul(&a, &b, &c) == CY_OK);
+        cy_test_mul_ref(&a, &b, &d);
+        CY_CHECK(cy_test_eq(&c, &d));
+        CY_CHECK(cy_gf2x_sqr(&a, &c) == CY_OK && cy_gf2x_mul(&a, &a, &d) == CY_OK && cy_test_eq(&c, &d));
+
+        // f = q g + r with deg r < deg g, q and r back from a b + r
+        cy_test_rand(&r, sz[i][1] > 1 ? sz[i][1] - 1 : 1, 300 + (uint32_t)i);
+        if(sz[i][1] == 1) cy_gf2x_set_words(&r, (const uint64_t[]){5}, 1);
+        cy_gf2x_mul(&a, &b, &c);
+        cy_gf2x_add(&c, &r, &c);
+        CY_CHECK(cy_gf2x_divrem(&c, &b, &q, &s) == CY_OK);
+        CY_CHECK(cy_test_eq(&q, &a) && cy_test_eq(&s, &r));
+        // the quotient written over the divisor
+        cy_gf2x_set(&t, &b);
+        CY_CHECK(cy_gf2x_divrem(&c, &t, &t, &s) == CY_OK && cy_test_eq(&t, &a) && cy_test_eq(&s, &r));
+        // and the product written over an operand
+        cy_gf2x_set(&t, &a);
+        cy_gf2x_mul(&t, &b, &t);
+        cy_gf2x_mul(&a, &b, &d);
+        CY_CHECK(cy_test_eq(&t, &d));
+    }
+    cy_gf2x_set_words(&b, NULL, 0);
+    CY_CHECK(cy_gf2x_divrem(&a, &b, &q, &r) != CY_OK);
+
+    // gcd(a h, b h) = h for a, b coprime, and s a + t b = d from the EEA
+    cy_test_poly(&a, (const int[]){127, 1, 0, -1});
+    cy_test_poly(&b, (const int[]){64, 4, 3, 1, 0, -1});
+    cy_test_rand(&c, 5, 7);
+    cy_gf2x_mul(&a, &c, &q);
+    cy_gf2x_mul(&b, &c, &r);
+    CY_CHECK(cy_gf2x_gcd(&q, &r, &d) == CY_OK && cy_test_eq(&d, &c));
+    CY_CHECK(cy_gf2x_eea(&q, &r, &d, &s, &t) == CY_OK && cy_test_eq(&d, &c));
+    cy_gf2x_mul(&s, &q, &s);
+    cy_gf2x_mul(&t, &r, &t);
+    cy_gf2x_add(&s, &t, &s);
+    CY_CHECK(cy_test_eq(&s, &d));
+
+    // inverse mod an irreducible: a s = 1 mod b
+    cy_test_rand(&c, 1, 9);
+    CY_CHECK(cy_gf2x_eea(&c, &b, &d, &s, NULL) == CY_OK && d.n == 1 && d.w[0] == 1);
+    cy_gf2x_mul(&c, &s, &t);
+    cy_gf2x_divrem(&t, &b, NULL, &t);
+    CY_CHECK(t.n == 1 && t.w[0] == 1);
+
+    // Barrett reduction against long division, for a word sized and a long modulus
+    for (size_t k = 0; k < 2; k++)
+    {
+        CY_GF2X_MOD *mod;
+        if(k == 0) cy_test_poly(&b, (const int[]){8, 4, 3, 1, 0, -1});
+        else cy_test_rand(&b, 21, 11);
+        CY_CHECK(cy_gf2x_mod_init(&b, &mod) == CY_OK);
+        cy_test_rand(&a, b.n, 12);
+        cy_test_rand(&c, b.n, 13);
+        cy_gf2x_divrem(&a, &b, NULL, &a);
+        cy_gf2x_divrem(&c, &b, NULL, &c);
+        CY_CHECK(cy_gf2x_mod_mul(mod, &a, &c, &d) == CY_OK);
+        cy_gf2x_mul(&a, &c, &q);
+        cy_gf2x_divrem(&q, &b, NULL, &r);
+        CY_CHECK(cy_test_eq(&d, &r));
+        CY_CHECK(cy_gf2x_mod_reduce(mod, &q, &d) == CY_OK && cy_test_eq(&d, &r));
+        cy_gf2x_mod_free(mod);
+    }
+
+    // Ben-Or on known irreducibles and reducibles
+    int irr = -1;
+    cy_test_poly(&a, (const int[]){2, 1, 0, -1});
+    CY_CHECK(cy_gf2x_irreducible(&a, &irr) == CY_OK && irr == 1);
+    cy_test_poly(&a, (const int[]){2, 0, -1});
+    CY_CHECK(cy_gf2x_irreducible(&a, &irr) == CY_OK && irr == 0);
+    cy_test_poly(&a, (const int[]){8, 4, 3, 1, 0, -1});
+    CY_CHECK(cy_gf2x_irreducible(&a, &irr) == CY_OK && irr == 1);
+    cy_test_poly(&a, (const int[]){127, 1, 0, -1});
+    CY_CHECK(cy_gf2x_irreducible(&a, &irr) == CY_OK && irr == 1);
+    cy_test_poly(&a, (const int[]){8, 4, 3, 2, 0, -1});
+    cy_test_poly(&b, (const int[]){7, 1, 0, -1});
+    cy_gf2x_mul(&a, &b, &c);
+    CY_CHECK(cy_gf2x_irreducible(&c, &irr) == CY_OK && irr == 0);
+
+    for (size_t i = 0; i < 8; i++) cy_gf2x_free(all[i]);
+    return cy_test_done("gf2x");
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// HMAC-SHA-256 (RFC 4231) and HKDF (RFC 5869) vectors, precomputed keys reused across messages
+
+#include "cy_test.h"
+
+int main(void)
+{
+    uint8_t k[131], out[42];
+    CY_HMAC_KEY key;
+
+    memset(k, 0x0b, 20);
+    CY_CHECK(cy_hmac_key_init(&key, k, 20) == CY_OK);
+    cy_hmac_sha256(&key, (const uint8_t *)"Hi There", 8, out);
+    CY_CHECK(cy_test_eq_hex(out, "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7"));
+
+    CY_CHECK(cy_hmac_key_init(&key, (const uint8_t *)"Jefe", 4) == CY_OK);
+    cy_hmac_sha256(&key, (const uint8_t *)"what do ya want for nothing?", 28, out);
+    CY_CHECK(cy_test_eq_hex(out, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"));
+    // the same key again, streamed in two pieces
+    CY_HMAC_CTX ctx;
+    cy_hmac_init(&ctx, &key);
+    cy_hmac_update(&ctx, (const uint8_t *)"what do ya ", 11);
+    cy_hmac_update(&ctx, (const uint8_t *)"want for nothing?", 17);
+    cy_hmac_final(&ctx, out);
+    CY_CHECK(cy_test_eq_hex(out, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"));
+
+    // a key longer than a block is hashed first
+    memset(k, 0xaa, 131);
+    CY_CHECK(cy_hmac_key_init(&key, k, 131) == CY_OK);
+    cy_hmac_sha256(&key, (const uint8_t *)"Test Using Larger Than Block-Size Key - Hash Key First", 54, out);
+    CY_CHECK(cy_test_eq_hex(out, "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54"));
+
+    // RFC 5869 test case 1
+    uint8_t ikm[22], salt[13], info[10], prk[32];
+    memset(ikm, 0x0b, 22);
+    for (int i = 0; i < 13; i++) salt[i] = (uint8_t)i;
+    for (int i = 0; i < 10; i++) info[i] = (uint8_t)(0xf0 + i);
+    CY_CHECK(cy_hkdf_extract(salt, 13, ikm, 22, prk) == CY_OK);
+    CY_CHECK(cy_test_eq_hex(prk, "077709362c2e32df0ddc3f0dc47bba6390b6c73bb50f9c3122ec844ad7c2b3e5"));
+    CY_CHECK(cy_hkdf_expand(prk, info, 10, out, 42) == CY_OK);
+    CY_CHECK(cy_test_eq_hex(out, "3cb25f25faacd57a90434f64d0362f2a2d2d0a90cf1a5a4c5db02d56ecc4c5bf34007208d5b887185865"));
+    CY_CHECK(cy_hkdf_expand(prk, info, 10, out, 255 * 32 + 1) != CY_OK);
+
+    // the batch gives what one expand per info gives
+    uint8_t b[3][42], one[42];
+    const uint8_t *infos[3] = {info, info + 1, info + 2};
+    const size_t ilen[3] = {10, 5, 0};
+    uint8_t *const outs[3] = {b[0], b[1], b[2]};
+    CY_CHECK(cy_hkdf_expand_batch(prk, 3, infos, ilen, outs, 42) == CY_OK);
+    for (int i = 0; i < 3; i++) {cy_hkdf_expand(prk, infos[i], ilen[i], one, 42); CY_CHECK(!memcmp(one, b[i], 42));}
+
+    return cy_test_done("hmac");
+}
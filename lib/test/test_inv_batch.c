@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Batch inversion: Montgomery's trick against mpz_invert, aliasing, and the non-unit fallback
+
+#include "cy_test.h"
+
+#define CY_TEST_INV 64
+
+int main(void)
+{
+    gmp_randstate_t rs;
+    gmp_randinit_default(rs);
+    gmp_randseed_ui(rs, 36);
+    mpz_t a[CY_TEST_INV], out[CY_TEST_INV], n, want;
+    mpz_ptr ap[CY_TEST_INV], outp[CY_TEST_INV];
+    mpz_inits(n, want, NULL);
+    for (size_t i = 0; i < CY_TEST_INV; i++) {mpz_inits(a[i], out[i], NULL); ap[i] = a[i]; outp[i] = out[i];}
+
+    // a prime modulus, inputs above n are reduced first
+    mpz_urandomb(n, rs, 1024);
+    mpz_nextprime(n, n);
+    for (size_t i = 0; i < CY_TEST_INV; i++)
+    {
+        mpz_urandomb(a[i], rs, 1100);
+        if(mpz_divisible_p(a[i], n)) mpz_add_ui(a[i], a[i], 1);
+    }
+    CY_CHECK(cy_mpz_inv_batch(CY_TEST_INV, (const mpz_srcptr *)ap, n, outp) == CY_OK);
+    for (size_t i = 0; i < CY_TEST_INV; i++) CY_CHECK(mpz_invert(want, a[i], n) && mpz_cmp(out[i], want) == 0);
+
+    // in place, and a single element
+    for (size_t i = 0; i < CY_TEST_INV; i++) mpz_set(out[i], a[i]);
+    CY_CHECK(cy_mpz_inv_batch(CY_TEST_INV, (const mpz_srcptr *)outp, n, outp) == CY_OK);
+    for (size_t i = 0; i < CY_TEST_INV; i++) CY_CHECK(mpz_invert(want, a[i], n) && mpz_cmp(out[i], want) == 0);
+    CY_CHECK(cy_mpz_inv_batch(1, (const mpz_srcptr *)ap, n, outp) == CY_OK);
+    CY_CHECK(mpz_invert(want, a[0], n) && mpz_cmp(out[0], want) == 0);
+    CY_CHECK(cy_mpz_inv_batch(0, NULL, n, NULL) == CY_OK);
+
+    // n = 2^4 * 3^2 * 5 * 7: even and multiple of 3 inputs have no inverse, the rest still get theirs
+    mpz_set_ui(n, 5040);
+    for (size_t i = 0; i < CY_TEST_INV; i++) mpz_set_ui(a[i], 11 * i + 1);
+    CY_CHECK(cy_mpz_inv_batch(CY_TEST_INV, (const mpz_srcptr *)ap, n, outp) == CY_ERR_VALUE);
+    for (size_t i = 0; i < CY_TEST_INV; i++)
+    {
+        if(mpz_invert(want, a[i], n)) CY_CHECK(mpz_cmp(out[i], want) == 0);
+        else CY_CHECK(mpz_sgn(out[i]) == 0);
+    }
+    mpz_set_ui(n, 0);
+    CY_CHECK(cy_mpz_inv_batch(CY_TEST_INV, (const mpz_srcptr *)ap, n, outp) != CY_OK);
+
+    for (size_t i = 0; i < CY_TEST_INV; i++) mpz_clears(a[i], out[i], NULL);
+    mpz_clears(n, want, NULL);
+    gmp_randclear(rs);
+    return cy_test_done("inv_batch");
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Binary key container: the byte layout, round trips with every flag, and damaged files refused
+
+#include "cy_test.h"
+
+static size_t cy_test_slurp(const char *path, uint8_t *buff, const size_t cap)
+{
+    FILE *fp = fopen(path, "rb");
+    if(!fp) return 0;
+    size_t n = fread(buff, 1, cap, fp);
+    fclose(fp);
+    return n;
+}
+
+static void cy_test_spit(const char *path, const uint8_t *buff, const size_t len)
+{
+    FILE *fp = fopen(path, "wb");
+    fwrite(buff, 1, len, fp);
+    fclose(fp);
+}
+
+int main(void)
+{
+    const char *path = cy_test_path("key.bin");
+    uint8_t raw[4096], flags = 0xFF;
+    CY_KEY tiny, back = {NULL, 0};
+    cy_test_tiny_key(&tiny);
+
+    // {e, n} = {17, 3233} as a public pair
+    mpz_t pub[2]; mpz_init_set_ui(pub[0], 17); mpz_init_set_ui(pub[1], 3233);
+    CY_KEY pair = {pub, 2};
+    CY_CHECK(cy_rsa_key_bin_exp(path, &pair, CY_RSA_BIN_PUB) == CY_OK);
+    size_t n = cy_test_slurp(path, raw, sizeof(raw));
+    CY_CHECK(n == 31 && cy_test_eq_hex(raw, "43595253414b4559" "01040200" "000000000000000111" "00000000000000020ca1"));
+    CY_CHECK(cy_rsa_key_bin_imp(path, &back, &flags) == CY_OK);
+    CY_CHECK(flags == CY_RSA_BIN_PUB && back.size == 2 && !mpz_cmp(back.key[0], pub[0]) && !mpz_cmp(back.key[1], pub[1]));
+    cy_rsa_prv_key_free(&back);
+
+    // CRT key with its R^2 values, every number comes back
+    CY_CHECK(cy_rsa_key_bin_exp(path, &tiny, CY_RSA_BIN_CRT | CY_RSA_BIN_MONT) == CY_OK);
+    CY_CHECK(cy_rsa_key_bin_imp(path, &back, &flags) == CY_OK);
+    CY_CHECK(flags == (CY_RSA_BIN_CRT | CY_RSA_BIN_MONT) && back.size == tiny.size);
+    for (size_t i = 0; i < tiny.size && i < back.size; i++) CY_CHECK(mpz_cmp(back.key[i], tiny.key[i]) == 0);
+    cy_rsa_prv_key_free(&back);
+
+    // a generated key through the container and then a context
+    mpz_t *pk, m, c, r; mpz_inits(m, c, r, NULL);
+    CY_KEY sk;
+    CY_CHECK(cy_rsa_key_gen_mp(768, 3, &pk, &sk) == CY_OK);
+    CY_CHECK(cy_rsa_key_bin_exp(path, &sk, CY_RSA_BIN_CRT | CY_RSA_BIN_MONT) == CY_OK);
+    CY_RSA_CTX *ctx;
+    CY_CHECK(cy_rsa_ctx_bin_imp(path, &ctx) == CY_OK);
+    mpz_set_ui(m, 0xC0FFEE);
+    mpz_powm(c, m, pk[0], pk[1]);
+    CY_CHECK(cy_rsa_ctx_powm(ctx, c, r) == CY_OK && mpz_cmp(r, m) == 0);
+    cy_rsa_ctx_free(ctx);
+
+    // damage: bad magic, unknown version, CRT with PUB, short file, trailing byte
+    CY_CHECK(cy_rsa_key_bin_exp(path, &sk, CY_RSA_BIN_CRT) == CY_OK);
+    n = cy_test_slurp(path, raw, sizeof(raw));
+    const char *bad = cy_test_path("bad.bin");
+    raw[0] ^= 1; cy_test_spit(bad, raw, n); raw[0] ^= 1;
+    CY_CHECK(cy_rsa_key_bin_imp(bad, &back, &flags) != CY_OK);
+    raw[8] = 2; cy_test_spit(bad, raw, n); raw[8] = 1;
+    CY_CHECK(cy_rsa_key_bin_imp(bad, &back, &flags) != CY_OK);
+    raw[9] |= CY_RSA_BIN_PUB; cy_test_spit(bad, raw, n); raw[9] &= ~CY_RSA_BIN_PUB;
+    CY_CHECK(cy_rsa_key_bin_imp(bad, &back, &flags) != CY_OK);
+    cy_test_spit(bad, raw, n - 1);
+    CY_CHECK(cy_rsa_key_bin_imp(bad, &back, &flags) != CY_OK);
+    raw[n] = 0; cy_test_spit(bad, raw, n + 1);
+    CY_CHECK(cy_rsa_key_bin_imp(bad, &back, &flags) != CY_OK);
+    cy_test_spit(bad, raw, 5);
+    CY_CHECK(cy_rsa_key_bin_imp(bad, &back, &flags) != CY_OK);
+    CY_CHECK(back.key == NULL && back.size == 0);
+    cy_test_spit(bad, raw, n);
+    CY_CHECK(cy_rsa_key_bin_imp(bad, &back, &flags) == CY_OK);
+    cy_rsa_prv_key_free(&back);
+
+    // the public DER and text forms agree with the container
+    mpz_t *pk2;
+    CY_CHECK(cy_rsa_pub_key_der_exp(cy_test_path("pub.der"), pk) == CY_OK);
+    CY_CHECK(cy_rsa_pub_key_der_imp(cy_test_path("pub.der"), &pk2) == CY_OK);
+    CY_CHECK(!mpz_cmp(pk2[0], pk[0]) && !mpz_cmp(pk2[1], pk[1]));
+    cy_rsa_key_free(pk2);
+    CY_CHECK(cy_rsa_key_exp(cy_test_path("pub.key"), pk) == CY_OK);
+    CY_CHECK(cy_rsa_key_imp(cy_test_path("pub.key"), &pk2) == CY_OK);
+    CY_CHECK(!mpz_cmp(pk2[0], pk[0]) && !mpz_cmp(pk2[1], pk[1]));
+    cy_rsa_key_free(pk2);
+
+    cy_rsa_key_free(pk);
+    cy_rsa_prv_key_free(&sk); cy_rsa_prv_key_free(&tiny);
+    mpz_clears(pub[0], pub[1], m, c, r, NULL);
+    return cy_test_done("key_bin");
+}
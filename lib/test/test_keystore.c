@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Keystore: loading every key file type from a directory, lookups by id, and reloads under readers
+
+#include "cy_test.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+static CY_KEYSTORE *cy_test_ks;
+static atomic_int cy_test_stop, cy_test_bad;
+
+// hammers lookups while the main thread reloads, every lookup must find a live context
+static void *cy_test_reader(void *arg)
+{
+    (void)arg;
+    mpz_t m, c; mpz_inits(m, c, NULL);
+    mpz_set_ui(m, 5);
+    while (!atomic_load(&cy_test_stop))
+    {
+        CY_RSA_CTX *ctx;
+        const unsigned e = cy_keystore_enter(cy_test_ks);
+        if(cy_keystore_rsa(cy_test_ks, "crt.bin", &ctx, NULL) != CY_OK || cy_rsa_ctx_powm(ctx, m, c) != CY_OK)
+            atomic_fetch_add(&cy_test_bad, 1);
+        cy_keystore_leave(cy_test_ks, e);
+    }
+    mpz_clears(m, c, NULL);
+    return NULL;
+}
+
+int main(void)
+{
+    const char *dir = "tmp/ks";
+    char path[256];
+    mkdir("tmp", 0700);
+    mkdir(dir, 0700);
+
+    mpz_t *pk, m, c, r; mpz_inits(m, c, r, NULL);
+    CY_KEY sk;
+    CY_CHECK(cy_rsa_key_gen_mp(768, 2, &pk, &sk) == CY_OK);
+    CY_KEY pub = {pk, 2};
+    snprintf(path, sizeof(path), "%s/crt.bin", dir);
+    CY_CHECK(cy_rsa_key_bin_exp(path, &sk, CY_RSA_BIN_CRT | CY_RSA_BIN_MONT) == CY_OK);
+    snprintf(path, sizeof(path), "%s/pub.bin", dir);
+    CY_CHECK(cy_rsa_key_bin_exp(path, &pub, CY_RSA_BIN_PUB) == CY_OK);
+    snprintf(path, sizeof(path), "%s/prv.der", dir);
+    CY_CHECK(cy_rsa_prv_key_der_exp(path, &sk) == CY_OK);
+    snprintf(path, sizeof(path), "%s/pub.der", dir);
+    CY_CHECK(cy_rsa_pub_key_der_exp(path, pk) == CY_OK);
+    snprintf(path, sizeof(path), "%s/pub.key", dir);
+    CY_CHECK(cy_rsa_key_exp(path, pk) == CY_OK);
+    snprintf(path, sizeof(path), "%s/prv.key", dir);
+    CY_CHECK(cy_rsa_prv_key_exp(path, &sk) == CY_OK);
+    const __uint128_t aes = ((__uint128_t)0x0123456789ABCDEFull << 64) | 0xFEDCBA9876543210ull;
+    snprintf(path, sizeof(path), "%s/k.aes", dir);
+    CY_CHECK(cy_aes_key_exp(path, aes) == CY_OK);
+    snprintf(path, sizeof(path), "%s/README", dir);
+    FILE *fp = fopen(path, "w");
+    fputs("not a key\n", fp);
+    fclose(fp);
+
+    CY_KEYSTORE *ks;
+    CY_CHECK(cy_keystore_init(2, &ks) == CY_OK);
+    CY_CHECK(cy_keystore_load(ks, dir) == CY_OK);
+    CY_CHECK(cy_keystore_count(ks) == 7);
+
+    // every RSA form of the key decrypts what the public forms encrypt
+    static const char *prv[] = {"crt.bin", "prv.der", "prv.key"};
+    static const char *pubs[] = {"pub.bin", "pub.der"};
+    mpz_set_ui(m, 0xBEEF);
+    const unsigned e = cy_keystore_enter(ks);
+    for (size_t i = 0; i < 2; i++)
+    {
+        CY_RSA_CTX *ctx;
+        CY_CHECK(cy_keystore_rsa(ks, pubs[i], &ctx, NULL) == CY_OK);
+        mpz_set_ui(c, 0);
+        cy_rsa_ctx_powm(ctx, m, c);
+        for (size_t j = 0; j < 3; j++)
+        {
+            const CY_KEY *key;
+            CY_CHECK(cy_keystore_rsa(ks, prv[j], &ctx, &key) == CY_OK);
+            CY_CHECK(cy_rsa_ctx_powm(ctx, c, r) == CY_OK && mpz_cmp(r, m) == 0);
+            CY_CHECK(key->size == sk.size && mpz_cmp(key->key[1], pk[1]) == 0);
+        }
+    }
+    // AES by id, wrong type and unknown ids refused
+    const CY_AES_SCHED *sched;
+    __uint128_t ct1, ct2;
+    CY_CHECK(cy_keystore_aes(ks, "k.aes", &sched) == CY_OK);
+    cy_aes_sched_encryption(42, sched, &ct1);
+    cy_aes_encryption(42, aes, &ct2);
+    CY_CHECK(ct1 == ct2);
+    CY_CHECK(cy_keystore_aes(ks, "crt.bin", &sched) != CY_OK);
+    CY_CHECK(cy_keystore_rsa(ks, "k.aes", NULL, NULL) != CY_OK);
+    CY_CHECK(cy_keystore_rsa(ks, "README", NULL, NULL) != CY_OK);
+    CY_CHECK(cy_keystore_rsa(ks, "nope", NULL, NULL) != CY_OK);
+    cy_keystore_leave(ks, e);
+
+    // reloads swap the table under running readers, a broken key file keeps the old one
+    cy_test_ks = ks;
+    pthread_t th[2];
+    for (size_t i = 0; i < 2; i++) pthread_create(&th[i], NULL, cy_test_reader, NULL);
+    for (unsigned i = 0; i < 20; i++) CY_CHECK(cy_keystore_load(ks, dir) == CY_OK);
+    snprintf(path, sizeof(path), "%s/broken.bin", dir);
+    fp = fopen(path, "wb");
+    fputs("CYRSAKEY\x01", fp);
+    fclose(fp);
+    CY_CHECK(cy_keystore_load(ks, dir) != CY_OK);
+    CY_CHECK(cy_keystore_count(ks) == 7);
+    atomic_store(&cy_test_stop, 1);
+    for (size_t i = 0; i < 2; i++) pthread_join(th[i], NULL);
+    CY_CHECK(atomic_load(&cy_test_bad) == 0);
+    remove(path);
+
+    cy_keystore_free(ks);
+    cy_rsa_key_free(pk);
+    cy_rsa_prv_key_free(&sk);
+    mpz_clears(m, c, r, NULL);
+    return cy_test_done("keystore");
+}
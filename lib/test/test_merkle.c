@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Merkle tree: a root computed independently, parallel leaves against single ones, tamper detection
+
+#include "cy_test.h"
+
+int main(void)
+{
+    const size_t n = 5000, leaf = 1024, count = 5;
+    uint8_t data[5000], leaves[5 * 32], one[32], root[32];
+    cy_test_fill(data, n, 9);
+
+    // SHA-256 over 0x00 || leaf and 0x01 || left || right, the odd fifth leaf moving up
+    CY_CHECK(cy_merkle_leaves(CY_HASH_SHA256, data, n, leaf, 4, leaves) == CY_OK);
+    CY_CHECK(cy_test_eq_hex(leaves, "76c8494ed2a4529c80238bad22214785c2bb1b201cee1ad2454720005c406e90"));
+    CY_CHECK(cy_merkle_root(CY_HASH_SHA256, leaves, count, root) == CY_OK);
+    CY_CHECK(cy_test_eq_hex(root, "f1f9d0e37eda962b4ebff04197bcffbe16cba760de65ed92eb94cd9cc1f91732"));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t off = i * leaf;
+        cy_merkle_leaf(CY_HASH_SHA256, data + off, n - off < leaf ? n - off : leaf, one);
+        CY_CHECK(!memcmp(one, leaves + i * 32, 32));
+    }
+
+    // one flipped bit changes its leaf and the root, and nothing else
+    uint8_t leaves2[5 * 32], root2[32];
+    data[3000] ^= 1;
+    cy_merkle_leaves(CY_HASH_SHA256, data, n, leaf, 2, leaves2);
+    cy_merkle_root(CY_HASH_SHA256, leaves2, count, root2);
+    CY_CHECK(memcmp(leaves2 + 2 * 32, leaves + 2 * 32, 32) && !memcmp(leaves2, leaves, 2 * 32) && !memcmp(leaves2 + 3 * 32, leaves + 3 * 32, 2 * 32));
+    CY_CHECK(memcmp(root, root2, 32));
+
+    // other hashes size the tree by their digest, an empty input still has a leaf
+    uint8_t wide[5 * 64];
+    CY_CHECK(cy_merkle_leaves(CY_HASH_SHA3_512, data, n, leaf, 3, wide) == CY_OK);
+    CY_CHECK(cy_merkle_root(CY_HASH_SHA3_512, wide, count, wide) == CY_OK);
+    CY_CHECK(cy_merkle_leaves(CY_HASH_BLAKE3, NULL, 0, leaf, 1, one) == CY_OK);
+    CY_CHECK(cy_merkle_root(CY_HASH_BLAKE3, one, 1, root) == CY_OK && !memcmp(root, one, 32));
+    CY_CHECK(cy_merkle_leaves(CY_HASH_SHA256, data, n, 0, 1, leaves) != CY_OK);
+    CY_CHECK(cy_merkle_root(CY_HASH_SHA256, leaves, 0, root) != CY_OK);
+
+    return cy_test_done("merkle");
+}
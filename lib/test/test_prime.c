@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Primality: Miller-Rabin rounds, exact u64 answers, BPSW on known primes and pseudoprimes, batches
+
+#include "cy_test.h"
+
+#define CY_TEST_BATCH 200
+
+static CY_PRIMALITY_FLAG cy_test_bpsw_str(const char *dec)
+{
+    CY_PRIMALITY_FLAG f = CY_INCONCLUSIVE;
+    mpz_t n; mpz_init_set_str(n, dec, 10);
+    if(cy_prime_bpsw(n, &f) != CY_OK) f = CY_INCONCLUSIVE;
+    mpz_clear(n);
+    return f;
+}
+
+int main(void)
+{
+    CY_PRIMALITY_FLAG f;
+
+    // 2047 = 23 * 89 is a strong pseudoprime to base 2 only
+    CY_CHECK(cy_mra_u64(2047, 2, &f) == CY_OK && f == CY_INCONCLUSIVE);
+    CY_CHECK(cy_mra_u64(2047, 3, &f) == CY_OK && f == CY_COMPOSITE);
+    CY_CHECK(cy_mra_u64(1000003, 2, &f) == CY_OK && f == CY_INCONCLUSIVE);
+
+    // 3215031751 fools bases 2, 3, 5 and 7; 2^61 - 1 and the largest prime below 2^64
+    CY_CHECK(cy_emra_u64(3215031751u, &f) == CY_OK && f == CY_COMPOSITE);
+    CY_CHECK(cy_emra_u64(3825123056546413051ull, &f) == CY_OK && f == CY_COMPOSITE);
+    CY_CHECK(cy_emra_u64((1ull << 61) - 1, &f) == CY_OK && f == CY_PRIME);
+    CY_CHECK(cy_emra_u64(18446744073709551557ull, &f) == CY_OK && f == CY_PRIME);
+    CY_CHECK(cy_emra_u64(18446744073709551559ull, &f) == CY_OK && f == CY_COMPOSITE);
+
+    // every n below 20000 agrees with GMP
+    mpz_t n; mpz_init(n);
+    size_t bad = 0;
+    for (unsigned long i = 0; i < 20000; i++)
+    {
+        mpz_set_ui(n, i);
+        if(cy_prime_bpsw(n, &f) != CY_OK || (f == CY_PRIME) != (mpz_probab_prime_p(n, 30) != 0)) bad++;
+    }
+    CY_CHECK(bad == 0);
+
+    // Mersenne primes, Carmichael numbers, and a semiprime of two 2^89 - 1 sized primes
+    CY_CHECK(cy_test_bpsw_str("618970019642690137449562111") == CY_PRIME);
+    CY_CHECK(cy_test_bpsw_str("170141183460469231731687303715884105727") == CY_PRIME);
+    CY_CHECK(cy_test_bpsw_str("561") == CY_COMPOSITE);
+    CY_CHECK(cy_test_bpsw_str("3825123056546413051") == CY_COMPOSITE);
+    CY_CHECK(cy_test_bpsw_str("318665857834031151167461") == CY_COMPOSITE);
+    CY_CHECK(cy_test_bpsw_str("3317044064679887385961981") == CY_COMPOSITE);
+    CY_CHECK(cy_test_bpsw_str("383123885216472214589586756787577295904684780545900543") == CY_COMPOSITE);
+    CY_CHECK(cy_test_bpsw_str("170141183460469231731687303715884105729") == CY_COMPOSITE);
+
+    // a threaded batch of random 256 bit odd numbers against GMP
+    gmp_randstate_t rs;
+    gmp_randinit_default(rs);
+    gmp_randseed_ui(rs, 39);
+    mpz_t v[CY_TEST_BATCH];
+    mpz_ptr vp[CY_TEST_BATCH];
+    CY_PRIMALITY_FLAG out[CY_TEST_BATCH];
+    size_t nprime = 0;
+    for (size_t i = 0; i < CY_TEST_BATCH; i++)
+    {
+        mpz_init(v[i]); vp[i] = v[i];
+        mpz_urandomb(v[i], rs, 256);
+        mpz_setbit(v[i], 0);
+        if(i % 4 == 0) mpz_nextprime(v[i], v[i]);
+    }
+    CY_CHECK(cy_prime_batch(CY_TEST_BATCH, (const mpz_srcptr *)vp, 4, out) == CY_OK);
+    bad = 0;
+    for (size_t i = 0; i < CY_TEST_BATCH; i++)
+    {
+        if((out[i] == CY_PRIME) != (mpz_probab_prime_p(v[i], 30) != 0)) bad++;
+        nprime += out[i] == CY_PRIME;
+        mpz_clear(v[i]);
+    }
+    CY_CHECK(bad == 0 && nprime >= CY_TEST_BATCH / 4);
+
+    mpz_clear(n);
+    gmp_randclear(rs);
+    return cy_test_done("prime");
+}
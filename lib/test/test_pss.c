@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// RSA-PSS: sign and verify round trips, tampering, and the threaded verify batch
+
+#include "cy_test.h"
+
+#define CY_TEST_SIGS 5
+
+int main(void)
+{
+    mpz_t *pk;
+    CY_KEY sk;
+    mpz_t sig[CY_TEST_SIGS], other;
+    mpz_ptr sigp[CY_TEST_SIGS];
+    uint8_t msg[CY_TEST_SIGS][100];
+    const uint8_t *msgp[CY_TEST_SIGS];
+    size_t len[CY_TEST_SIGS];
+    const mpz_t *keys[CY_TEST_SIGS];
+    CY_STATE_FLAG result[CY_TEST_SIGS];
+    mpz_init(other);
+
+    CY_CHECK(cy_rsa_key_gen_mp(1024, 2, &pk, &sk) == CY_OK);
+    for (size_t i = 0; i < CY_TEST_SIGS; i++)
+    {
+        mpz_init(sig[i]); sigp[i] = sig[i];
+        len[i] = 20 * i;
+        cy_test_fill(msg[i], sizeof(msg[i]), (uint32_t)i + 1);
+        msgp[i] = msg[i];
+        keys[i] = (const mpz_t *)pk;
+        CY_CHECK(cy_rsa_pss_sign(msg[i], len[i], &sk, sig[i]) == CY_OK);
+        CY_CHECK(cy_rsa_pss_verify(msg[i], len[i], pk, sig[i]) == CY_OK);
+    }
+
+    // the salt is random, two signatures of one message differ and both verify
+    CY_CHECK(cy_rsa_pss_sign(msg[1], len[1], &sk, other) == CY_OK);
+    CY_CHECK(mpz_cmp(other, sig[1]) != 0);
+    CY_CHECK(cy_rsa_pss_verify(msg[1], len[1], pk, other) == CY_OK);
+
+    // a changed message, a changed signature, and a signature of n or above
+    msg[2][3] ^= 1;
+    CY_CHECK(cy_rsa_pss_verify(msg[2], len[2], pk, sig[2]) != CY_OK);
+    msg[2][3] ^= 1;
+    mpz_add_ui(other, sig[3], 1);
+    CY_CHECK(cy_rsa_pss_verify(msg[3], len[3], pk, other) != CY_OK);
+    mpz_add(other, sig[3], pk[1]);
+    CY_CHECK(cy_rsa_pss_verify(msg[3], len[3], pk, other) != CY_OK);
+
+    // the batch flags exactly the bad item
+    CY_CHECK(cy_rsa_pss_verify_batch(CY_TEST_SIGS, msgp, len, keys, (const mpz_srcptr *)sigp, 3, result) == CY_OK);
+    for (size_t i = 0; i < CY_TEST_SIGS; i++) CY_CHECK(result[i] == CY_OK);
+    msg[4][0] ^= 0x80;
+    cy_rsa_pss_verify_batch(CY_TEST_SIGS, msgp, len, keys, (const mpz_srcptr *)sigp, 2, result);
+    for (size_t i = 0; i < CY_TEST_SIGS; i++) CY_CHECK((result[i] == CY_OK) == (i != 4));
+
+    // a key too small for the encoding is refused
+    CY_KEY tiny;
+    cy_test_tiny_key(&tiny);
+    CY_CHECK(cy_rsa_pss_sign(msg[0], len[0], &tiny, other) != CY_OK);
+
+    for (size_t i = 0; i < CY_TEST_SIGS; i++) mpz_clear(sig[i]);
+    cy_rsa_key_free(pk);
+    cy_rsa_prv_key_free(&sk); cy_rsa_prv_key_free(&tiny);
+    mpz_clear(other);
+    return cy_test_done("pss");
+}
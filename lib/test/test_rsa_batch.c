@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Batch RSA: Fiat's shared modulus path and the item by item fallback, both against mpz_powm
+
+#include "cy_test.h"
+
+#define CY_TEST_BATCH 6
+
+// a copy of key with public exponent e and its private half rederived, 0 if e is not a unit mod phi
+static int cy_test_rekey(const CY_KEY *key, const unsigned long e, CY_KEY *out)
+{
+    mpz_t phi, t; mpz_inits(phi, t, NULL);
+    mpz_sub_ui(phi, key->key[CY_RSA_PRV_PRIME(0)], 1);
+    mpz_sub_ui(t, key->key[CY_RSA_PRV_PRIME(1)], 1);
+    mpz_mul(phi, phi, t);
+    int ok = 0;
+    mpz_set_ui(t, e);
+    if(mpz_invert(t, t, phi))
+    {
+        out->size = key->size;
+        out->key = malloc(out->size * sizeof(mpz_t));
+        for (size_t i = 0; i < out->size; i++) mpz_init_set(out->key[i], key->key[i]);
+        mpz_set(out->key[0], t);
+        mpz_set_ui(out->key[CY_RSA_PRV_E], e);
+        for (size_t i = 0; i < 2; i++)
+        {
+            mpz_sub_ui(phi, out->key[CY_RSA_PRV_PRIME(i)], 1);
+            mpz_mod(out->key[CY_RSA_PRV_EXP(i)], t, phi);
+        }
+        ok = 1;
+    }
+    mpz_clears(phi, t, NULL);
+    return ok;
+}
+
+int main(void)
+{
+    mpz_t *pk;
+    CY_KEY sk, keys[CY_TEST_BATCH];
+    const CY_KEY *kp[CY_TEST_BATCH];
+    mpz_t in[CY_TEST_BATCH], out[CY_TEST_BATCH], want;
+    mpz_ptr inp[CY_TEST_BATCH], outp[CY_TEST_BATCH];
+    CY_STATE_FLAG result[CY_TEST_BATCH];
+    mpz_init(want);
+    for (size_t i = 0; i < CY_TEST_BATCH; i++) {mpz_inits(in[i], out[i], NULL); inp[i] = in[i]; outp[i] = out[i];}
+
+    // one modulus, pairwise coprime exponents: the Fiat path
+    CY_CHECK(cy_rsa_key_gen_mp(512, 2, &pk, &sk) == CY_OK);
+    size_t n = 0;
+    static const unsigned long primes[] = {3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47};
+    for (size_t i = 0; i < sizeof(primes) / sizeof(primes[0]) && n < CY_TEST_BATCH; i++)
+        if(cy_test_rekey(&sk, primes[i], &keys[n])) n++;
+    CY_CHECK(n == CY_TEST_BATCH);
+    for (size_t i = 0; i < n; i++) {kp[i] = &keys[i]; mpz_set_ui(in[i], 1000003u * i + 12345);}
+    CY_CHECK(cy_rsa_batch_powm(n, (const mpz_srcptr *)inp, kp, outp, result) == CY_OK);
+    for (size_t i = 0; i < n; i++)
+    {
+        mpz_powm(want, in[i], keys[i].key[0], keys[i].key[1]);
+        CY_CHECK(result[i] == CY_OK && mpz_cmp(out[i], want) == 0);
+    }
+
+    // byte decryption through the batch
+    uint8_t c[CY_TEST_BATCH];
+    for (size_t i = 0; i < n; i++)
+    {
+        mpz_set_ui(want, 0x40 + i);
+        mpz_powm(in[i], want, keys[i].key[CY_RSA_PRV_E], pk[1]);
+    }
+    CY_CHECK(cy_rsa_batch_decryption(n, (const mpz_srcptr *)inp, kp, c, result) == CY_OK);
+    for (size_t i = 0; i < n; i++) CY_CHECK(result[i] == CY_OK && c[i] == 0x40 + i);
+
+    // a second modulus forces the per item path, a bare pair is refused in result[]
+    mpz_t *pk2;
+    CY_KEY sk2, tiny;
+    CY_CHECK(cy_rsa_key_gen_mp(512, 3, &pk2, &sk2) == CY_OK);
+    cy_test_tiny_key(&tiny);
+    CY_KEY pair = {tiny.key, 2};
+    kp[1] = &sk2;
+    kp[2] = &pair;
+    for (size_t i = 0; i < n; i++) mpz_set_ui(in[i], 777u * i + 2);
+    CY_CHECK(cy_rsa_batch_powm(n, (const mpz_srcptr *)inp, kp, outp, result) != CY_OK);
+    CY_CHECK(result[2] != CY_OK);
+    for (size_t i = 0; i < n; i++)
+    {
+        if(i == 2) continue;
+        mpz_powm(want, in[i], kp[i]->key[0], kp[i]->key[1]);
+        CY_CHECK(result[i] == CY_OK && mpz_cmp(out[i], want) == 0);
+    }
+
+    for (size_t i = 0; i < n; i++) cy_rsa_prv_key_free(&keys[i]);
+    for (size_t i = 0; i < CY_TEST_BATCH; i++) mpz_clears(in[i], out[i], NULL);
+    cy_rsa_key_free(pk); cy_rsa_key_free(pk2);
+    cy_rsa_prv_key_free(&sk); cy_rsa_prv_key_free(&sk2); cy_rsa_prv_key_free(&tiny);
+    mpz_clear(want);
+    return cy_test_done("rsa_batch");
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// RSA contexts: the textbook vector, Montgomery results against mpz_powm, CRT and container contexts
+
+#include "cy_test.h"
+
+int main(void)
+{
+    CY_RSA_CTX *enc, *dec;
+    mpz_t m, c, r, x; mpz_inits(m, c, r, x, NULL);
+
+    CY_KEY tiny;
+    cy_test_tiny_key(&tiny);
+    mpz_t pub[2]; mpz_init_set_ui(pub[0], 17); mpz_init_set_ui(pub[1], 3233);
+    CY_CHECK(cy_rsa_ctx_init(pub, 0, &enc) == CY_OK);
+    CY_CHECK(cy_rsa_ctx_init(tiny.key, 1, &dec) == CY_OK);
+    mpz_set_ui(m, 65);
+    CY_CHECK(cy_rsa_ctx_powm(enc, m, c) == CY_OK && mpz_cmp_ui(c, 2790) == 0);
+    CY_CHECK(cy_rsa_ctx_powm(dec, c, r) == CY_OK && mpz_cmp_ui(r, 65) == 0);
+    cy_rsa_ctx_free(enc); cy_rsa_ctx_free(dec);
+    mpz_clears(pub[0], pub[1], NULL);
+
+    mpz_t *pk, *sk;
+    CY_CHECK(cy_rsa_key_gen(512, &pk, &sk) == CY_OK);
+    CY_CHECK(cy_rsa_ctx_init(pk, 0, &enc) == CY_OK);
+    CY_CHECK(cy_rsa_ctx_init(sk, 1, &dec) == CY_OK);
+    for (unsigned i = 0; i < 20; i++)
+    {
+        mpz_set_ui(m, 1000003u * i + 7);
+        cy_rsa_ctx_powm(enc, m, c);
+        mpz_powm(x, m, pk[0], pk[1]);
+        CY_CHECK(mpz_cmp(c, x) == 0);
+        cy_rsa_ctx_powm(dec, c, r);
+        CY_CHECK(mpz_cmp(r, m) == 0);
+    }
+    // the byte helpers go through the same context
+    uint8_t back = 0;
+    cy_rsa_ctx_encryption(0x3C, enc, c);
+    cy_rsa_ctx_decryption(c, dec, &back);
+    CY_CHECK(back == 0x3C);
+    // inputs at or above n are reduced first, not refused
+    mpz_add(m, pk[1], m);
+    CY_CHECK(cy_rsa_ctx_powm(enc, m, c) == CY_OK);
+    mpz_powm(x, m, pk[0], pk[1]);
+    CY_CHECK(mpz_cmp(c, x) == 0);
+    cy_rsa_ctx_free(enc); cy_rsa_ctx_free(dec);
+
+    // the CRT context and a public container with its Montgomery values
+    CY_CHECK(cy_rsa_ctx_crt_init(&tiny, &dec) == CY_OK);
+    mpz_set_ui(c, 2790);
+    CY_CHECK(cy_rsa_ctx_powm(dec, c, r) == CY_OK && mpz_cmp_ui(r, 65) == 0);
+    cy_rsa_ctx_free(dec);
+    CY_KEY pair = {pk, 2};
+    CY_CHECK(cy_rsa_key_bin_exp(cy_test_path("ctx_pub.bin"), &pair, CY_RSA_BIN_PUB | CY_RSA_BIN_MONT) == CY_OK);
+    CY_CHECK(cy_rsa_ctx_bin_imp(cy_test_path("ctx_pub.bin"), &enc) == CY_OK);
+    mpz_set_ui(m, 42);
+    cy_rsa_ctx_powm(enc, m, c);
+    mpz_powm(x, m, pk[0], pk[1]);
+    CY_CHECK(mpz_cmp(c, x) == 0);
+    cy_rsa_ctx_free(enc);
+
+    // an even modulus has no Montgomery form
+    mpz_t even[2]; mpz_init_set_ui(even[0], 3); mpz_init_set_ui(even[1], 3234);
+    CY_CHECK(cy_rsa_ctx_init(even, 0, &enc) != CY_OK);
+    mpz_clears(even[0], even[1], NULL);
+
+    cy_rsa_key_free(pk); cy_rsa_key_free(sk);
+    cy_rsa_prv_key_free(&tiny);
+    mpz_clears(m, c, r, x, NULL);
+    return cy_test_done("rsa_ctx");
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Multi-buffer powm: mixed modulus sizes across and inside a lane chunk, against mpz_powm
+
+#include "cy_test.h"
+
+#define CY_TEST_MB 11
+
+int main(void)
+{
+    mpz_t *pk[CY_TEST_MB], *sk[CY_TEST_MB];
+    const mpz_t *key[CY_TEST_MB];
+    mpz_t in[CY_TEST_MB], out[CY_TEST_MB], want;
+    mpz_ptr inp[CY_TEST_MB], outp[CY_TEST_MB];
+    static const mp_bitcnt_t bits[CY_TEST_MB] = {512, 1024, 512, 768, 512, 1024, 512, 512, 768, 512, 1024};
+    mpz_init(want);
+
+    for (size_t i = 0; i < CY_TEST_MB; i++)
+    {
+        CY_CHECK(cy_rsa_key_gen(bits[i], &pk[i], &sk[i]) == CY_OK);
+        mpz_inits(in[i], out[i], NULL);
+        inp[i] = in[i]; outp[i] = out[i];
+    }
+
+    // private exponents on odd items, public on even, the inputs cover 0 and n - 1
+    for (size_t i = 0; i < CY_TEST_MB; i++)
+    {
+        key[i] = i & 1 ? (const mpz_t *)sk[i] : (const mpz_t *)pk[i];
+        if(i == 0) mpz_set_ui(in[i], 0);
+        else if(i == 1) mpz_sub_ui(in[i], pk[i][1], 1);
+        else mpz_set_ui(in[i], 99991u * i + 5);
+    }
+    CY_CHECK(cy_rsa_mb_powm(CY_TEST_MB, (const mpz_srcptr *)inp, key, outp) == CY_OK);
+    for (size_t i = 0; i < CY_TEST_MB; i++)
+    {
+        mpz_powm(want, in[i], key[i][0], key[i][1]);
+        CY_CHECK(mpz_cmp(out[i], want) == 0);
+    }
+
+    // encrypt then decrypt a byte per key
+    uint8_t c[CY_TEST_MB];
+    for (size_t i = 0; i < CY_TEST_MB; i++) {cy_rsa_encryption((uint8_t)(3 * i + 1), pk[i], in[i]); key[i] = (const mpz_t *)sk[i];}
+    CY_CHECK(cy_rsa_mb_decryption(CY_TEST_MB, (const mpz_srcptr *)inp, key, c) == CY_OK);
+    for (size_t i = 0; i < CY_TEST_MB; i++) CY_CHECK(c[i] == 3 * i + 1);
+
+    // a single item and an empty batch
+    CY_CHECK(cy_rsa_mb_powm(1, (const mpz_srcptr *)inp, key, outp) == CY_OK);
+    mpz_powm(want, in[0], sk[0][0], sk[0][1]);
+    CY_CHECK(mpz_cmp(out[0], want) == 0);
+    CY_CHECK(cy_rsa_mb_powm(0, (const mpz_srcptr *)inp, key, outp) == CY_OK);
+
+    for (size_t i = 0; i < CY_TEST_MB; i++)
+    {
+        cy_rsa_key_free(pk[i]); cy_rsa_key_free(sk[i]);
+        mpz_clears(in[i], out[i], NULL);
+    }
+    mpz_clear(want);
+    return cy_test_done("rsa_mb");
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Multi-prime CRT keys: generation, CRT powm against mpz_powm, and the text, DER and binary forms
+
+#include "cy_test.h"
+
+static int cy_test_same_key(const CY_KEY *a, const CY_KEY *b)
+{
+    if(a->size != b->size) return 0;
+    for (size_t i = 0; i < a->size; i++) if(mpz_cmp(a->key[i], b->key[i])) return 0;
+    return 1;
+}
+
+static int cy_test_file_hex(const char *path, const char *hex)
+{
+    uint8_t got[256], want[256];
+    size_t n = cy_test_hex(hex, want);
+    FILE *fp = fopen(path, "rb");
+    if(!fp) return 0;
+    size_t len = fread(got, 1, sizeof(got), fp);
+    fclose(fp);
+    return len == n && !memcmp(got, want, n);
+}
+
+int main(void)
+{
+    mpz_t m, c, r, x; mpz_inits(m, c, r, x, NULL);
+
+    // the textbook key through every export, the DER form checked byte for byte
+    CY_KEY tiny, back = {NULL, 0};
+    cy_test_tiny_key(&tiny);
+    mpz_set_ui(c, 2790);
+    CY_CHECK(cy_rsa_crt_powm(c, &tiny, r) == CY_OK && mpz_cmp_ui(r, 65) == 0);
+    CY_CHECK(cy_rsa_prv_key_der_exp(cy_test_path("tiny.der"), &tiny) == CY_OK);
+    CY_CHECK(cy_test_file_hex(cy_test_path("tiny.der"), "301d02010002020ca10201110202"
+                                                         "0ac102013d020135020135020131020126"));
+    CY_CHECK(cy_rsa_prv_key_der_imp(cy_test_path("tiny.der"), &back) == CY_OK);
+    CY_CHECK(cy_test_same_key(&tiny, &back));
+    cy_rsa_prv_key_free(&back);
+
+    for (uint8_t u = 2; u <= CY_RSA_MAX_PRIMES; u++)
+    {
+        mpz_t *pk;
+        CY_KEY sk;
+        CY_CHECK(cy_rsa_key_gen_mp(1024, u, &pk, &sk) == CY_OK);
+        CY_CHECK(sk.size == (size_t)CY_RSA_PRV_SIZE(u) && mpz_cmp_ui(sk.key[CY_RSA_PRV_U], u) == 0);
+        CY_CHECK(mpz_sizeinbase(pk[1], 2) == 1024 && mpz_cmp(pk[1], sk.key[1]) == 0);
+        for (unsigned i = 0; i < 8; i++)
+        {
+            mpz_set_ui(m, 7919u * i + 3);
+            mpz_powm(c, m, pk[0], pk[1]);
+            CY_CHECK(cy_rsa_crt_powm(c, &sk, r) == CY_OK && mpz_cmp(r, m) == 0);
+            mpz_powm(x, c, sk.key[0], sk.key[1]);
+            CY_CHECK(mpz_cmp(x, m) == 0);
+        }
+        uint8_t byte = 0;
+        cy_rsa_encryption(0xA5, pk, c);
+        cy_rsa_crt_decryption(c, &sk, &byte);
+        CY_CHECK(byte == 0xA5);
+
+        CY_CHECK(cy_rsa_prv_key_exp(cy_test_path("mp.key"), &sk) == CY_OK);
+        CY_CHECK(cy_rsa_prv_key_imp(cy_test_path("mp.key"), &back) == CY_OK);
+        CY_CHECK(cy_test_same_key(&sk, &back));
+        cy_rsa_prv_key_free(&back);
+        CY_CHECK(cy_rsa_prv_key_der_exp(cy_test_path("mp.der"), &sk) == CY_OK);
+        CY_CHECK(cy_rsa_prv_key_der_imp(cy_test_path("mp.der"), &back) == CY_OK);
+        CY_CHECK(cy_test_same_key(&sk, &back));
+        cy_rsa_prv_key_free(&back);
+        uint8_t flags = 0;
+        CY_CHECK(cy_rsa_key_bin_exp(cy_test_path("mp.bin"), &sk, CY_RSA_BIN_CRT) == CY_OK);
+        CY_CHECK(cy_rsa_key_bin_imp(cy_test_path("mp.bin"), &back, &flags) == CY_OK);
+        CY_CHECK(flags == CY_RSA_BIN_CRT && cy_test_same_key(&sk, &back));
+        cy_rsa_prv_key_free(&back);
+
+        cy_rsa_key_free(pk);
+        cy_rsa_prv_key_free(&sk);
+    }
+
+    // a bare {d, n} pair is not a CRT key, nor is one whose u disagrees with its size
+    CY_KEY pair = {tiny.key, 2};
+    CY_CHECK(cy_rsa_crt_powm(c, &pair, r) != CY_OK);
+    mpz_set_ui(tiny.key[CY_RSA_PRV_U], 3);
+    CY_CHECK(cy_rsa_crt_powm(c, &tiny, r) != CY_OK);
+    CY_CHECK(cy_rsa_prv_key_der_exp(cy_test_path("bad.der"), &tiny) != CY_OK);
+    mpz_set_ui(tiny.key[CY_RSA_PRV_U], 2);
+
+    // files that are not keys
+    FILE *fp = fopen(cy_test_path("junk.key"), "w");
+    fputs("not a key\n", fp);
+    fclose(fp);
+    CY_CHECK(cy_rsa_prv_key_imp(cy_test_path("junk.key"), &back) != CY_OK);
+    CY_CHECK(cy_rsa_prv_key_der_imp(cy_test_path("junk.key"), &back) != CY_OK);
+    CY_CHECK(cy_rsa_prv_key_imp(cy_test_path("missing.key"), &back) != CY_OK);
+
+    cy_rsa_prv_key_free(&tiny);
+    mpz_clears(m, c, r, x, NULL);
+    return cy_test_done("rsa_mp");
+}
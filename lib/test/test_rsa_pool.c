@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// RSA key pool: pooled keys work, the encrypted spool round-trips and refuses a wrong key or a flipped byte
+
+#include "cy_test.h"
+#include <unistd.h>
+
+static long cy_test_spool_size(CY_RSA_POOL *pool)
+{
+    const char *probe = cy_test_path("probe.spool");
+    long size = -1;
+    if(cy_rsa_pool_spool_exp(pool, probe, 1) == CY_OK)
+    {
+        FILE *fp = fopen(probe, "rb");
+        if(fp) {fseek(fp, 0, SEEK_END); size = ftell(fp); fclose(fp);}
+    }
+    remove(probe);
+    return size;
+}
+
+// the spool grows with every pooled key, full once it stops growing
+static void cy_test_wait_keys(CY_RSA_POOL *pool, const long empty)
+{
+    long last = -1, size;
+    for (int i = 0; i < 400; i++, last = size, usleep(50000))
+        if((size = cy_test_spool_size(pool)) > empty && size == last) return;
+}
+
+static int cy_test_pair_ok(mpz_t *pub, mpz_t *prv)
+{
+    mpz_t c; mpz_init(c);
+    uint8_t back = 0;
+    cy_rsa_encryption(0xA5, pub, c);
+    cy_rsa_decryption(c, prv, &back);
+    mpz_clear(c);
+    return back == 0xA5;
+}
+
+int main(void)
+{
+    const __uint128_t spool_key = ((__uint128_t)0x0123456789abcdefULL << 64) | 0xfedcba9876543210ULL;
+    CY_RSA_POOL *pool, *next;
+    mpz_t *pub, *prv;
+
+    CY_CHECK(cy_rsa_pool_init(2, &pool) == CY_OK);
+    const long empty = cy_test_spool_size(pool);
+    CY_CHECK(empty > 0);
+    CY_CHECK(cy_rsa_pool_add(pool, 256, 4) == CY_OK);
+    cy_test_wait_keys(pool, empty);
+    CY_CHECK(cy_rsa_pool_state(pool) == CY_OK);
+
+    // a hit and a miss on a bit size the pool does not keep both give working pairs
+    CY_CHECK(cy_rsa_pool_key_gen(pool, 256, &pub, &prv) == CY_OK);
+    CY_CHECK(cy_test_pair_ok(pub, prv));
+    cy_rsa_key_free(pub); cy_rsa_key_free(prv);
+    CY_CHECK(cy_rsa_pool_key_gen(pool, 192, &pub, &prv) == CY_OK);
+    CY_CHECK(cy_test_pair_ok(pub, prv));
+    cy_rsa_key_free(pub); cy_rsa_key_free(prv);
+
+    // export keeps the keys in the pool, the spool holds copies
+    cy_test_wait_keys(pool, empty);
+    const char *spool = cy_test_path("pool.spool");
+    CY_CHECK(cy_rsa_pool_spool_exp(pool, spool, spool_key) == CY_OK);
+    CY_CHECK(access(spool, F_OK) == 0);
+    CY_CHECK(cy_rsa_pool_key_gen(pool, 256, &pub, &prv) == CY_OK && cy_test_pair_ok(pub, prv));
+    cy_rsa_key_free(pub); cy_rsa_key_free(prv);
+    // a spooled key went out, so the spool is gone and cannot hand it out again
+    CY_CHECK(access(spool, F_OK) != 0);
+
+    cy_test_wait_keys(pool, empty);
+    CY_CHECK(cy_rsa_pool_spool_exp(pool, spool, spool_key) == CY_OK);
+    cy_rsa_pool_free(pool);
+
+    CY_CHECK(cy_rsa_pool_init(1, &next) == CY_OK);
+    CY_CHECK(cy_rsa_pool_add(next, 256, 8) == CY_OK);
+    CY_CHECK(cy_rsa_pool_spool_imp(next, spool, spool_key ^ 1) != CY_OK);
+
+    // one flipped byte in the body fails the tag
+    FILE *fp = fopen(spool, "r+b");
+    int c;
+    fseek(fp, 40, SEEK_SET); c = fgetc(fp);
+    fseek(fp, 40, SEEK_SET); fputc(c ^ 0x55, fp); fclose(fp);
+    CY_CHECK(cy_rsa_pool_spool_imp(next, spool, spool_key) != CY_OK);
+    fp = fopen(spool, "r+b");
+    fseek(fp, 40, SEEK_SET); fputc(c, fp); fclose(fp);
+
+    // loaded once: the file is removed and the keys are served
+    CY_CHECK(cy_rsa_pool_spool_imp(next, spool, spool_key) == CY_OK);
+    CY_CHECK(access(spool, F_OK) != 0);
+    CY_CHECK(cy_rsa_pool_key_gen(next, 256, &pub, &prv) == CY_OK && cy_test_pair_ok(pub, prv));
+    cy_rsa_key_free(pub); cy_rsa_key_free(prv);
+    CY_CHECK(cy_rsa_pool_state(next) == CY_OK);
+    cy_rsa_pool_free(next);
+
+    CY_CHECK(cy_rsa_pool_key_gen(NULL, 256, &pub, &prv) != CY_OK);
+    return cy_test_done("rsa_pool");
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// SHA-256: FIPS 180-2 vectors through every entry point, the batch lanes against the one-shot hash
+
+#include "cy_test.h"
+
+int main(void)
+{
+    static const char *abc = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+    static const char *two = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    uint8_t out[32];
+
+    cy_sha256((const uint8_t *)"", 0, out);
+    CY_CHECK(cy_test_eq_hex(out, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+    cy_sha256((const uint8_t *)"abc", 3, out);
+    CY_CHECK(cy_test_eq_hex(out, abc));
+    cy_sha256((const uint8_t *)two, strlen(two), out);
+    CY_CHECK(cy_test_eq_hex(out, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"));
+
+    // one million 'a', fed in uneven pieces so blocks straddle updates
+    uint8_t *a = malloc(1000000);
+    memset(a, 'a', 1000000);
+    CY_SHA256_STATE st;
+    cy_sha256_init(&st);
+    for (size_t off = 0, k = 1; off < 1000000; off += k, k = k * 3 % 1000 + 1)
+        cy_sha256_update(&st, a + off, 1000000 - off < k ? 1000000 - off : k);
+    cy_sha256_final(&st, out);
+    CY_CHECK(cy_test_eq_hex(out, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"));
+    CY_CHECK(cy_hash(CY_HASH_SHA256, (const uint8_t *)"abc", 3, out) == CY_OK && cy_test_eq_hex(out, abc));
+
+    // 19 messages, every length class from empty to several blocks, more than two lane groups
+    const uint8_t *in[19]; size_t len[19]; uint8_t batch[19][32];
+    for (int i = 0; i < 19; i++) {in[i] = a + i; len[i] = (size_t)i * 37;}
+    CY_CHECK(cy_sha256_batch(19, in, len, batch) == CY_OK);
+    for (int i = 0; i < 19; i++) {cy_sha256(in[i], len[i], out); CY_CHECK(!memcmp(out, batch[i], 32));}
+    CY_CHECK(cy_sha256_batch(1, NULL, NULL, NULL) != CY_OK);
+
+    free(a);
+    return cy_test_done("sha256");
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// SHA-3 and SHAKE: FIPS 202 digests of "abc", the sponge across the rate, the 4-way batch
+
+#include "cy_test.h"
+
+int main(void)
+{
+    uint8_t out[80], ref[80];
+    const uint8_t *abc = (const uint8_t *)"abc";
+
+    cy_sha3_256(abc, 3, out);
+    CY_CHECK(cy_test_eq_hex(out, "3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532"));
+    cy_sha3_512(abc, 3, out);
+    CY_CHECK(cy_test_eq_hex(out, "b751850b1a57168a5693cd924b6b096e08f621827444f70d884f5d0240d2712e"
+                                 "10e116e9192af3c91a7ec57647e3934057340b4cf408d5a56592f8274eec53f0"));
+    cy_shake128(abc, 3, out, 40);
+    CY_CHECK(cy_test_eq_hex(out, "5881092dd818bf5cf8a3ddb793fbcba74097d5c526a6d35f97b83351940f2cc844c50af32acd3f2c"));
+    cy_shake256(abc, 3, out, 80);
+    CY_CHECK(cy_test_eq_hex(out, "483366601360a8771c6863080cc4114d8db44530f8f1e1ee4f94ea37e78b5739d5a15bef186a5386c75744c0527e1faa"
+                                 "9f8726e462a12a4feb06bd8801e751e41385141204f329979fd3047a13c56577"));
+
+    // 1000 bytes cross the 136 byte rate several times, absorbed in odd pieces
+    uint8_t buff[1000];
+    cy_test_fill(buff, sizeof(buff), 7);
+    CY_KECCAK_STATE st;
+    CY_CHECK(cy_keccak_init(&st, CY_HASH_SHA3_256) == CY_OK);
+    for (size_t off = 0, k = 1; off < sizeof(buff); off += k, k = k * 5 % 200 + 1) cy_keccak_update(&st, buff + off, sizeof(buff) - off < k ? sizeof(buff) - off : k);
+    cy_keccak_squeeze(&st, out, 32);
+    CY_CHECK(cy_test_eq_hex(out, "eb94e72ef0e3cf6df79f5cf764dc7fa9dc8ff20d1f6df78bce3e24431cf55913"));
+
+    // squeezing in pieces gives the same stream as one squeeze
+    cy_keccak_init(&st, CY_HASH_SHAKE128); cy_keccak_update(&st, abc, 3);
+    cy_keccak_squeeze(&st, ref, 7); cy_keccak_squeeze(&st, ref + 7, 33);
+    cy_shake128(abc, 3, out, 40);
+    CY_CHECK(!memcmp(out, ref, 40));
+
+    // six messages, one full group of four and a partial one
+    const uint8_t *in[6]; size_t len[6]; uint8_t b[6][64];
+    uint8_t *const outs[6] = {b[0], b[1], b[2], b[3], b[4], b[5]};
+    for (int i = 0; i < 6; i++) {in[i] = buff + i; len[i] = (size_t)i * 150;}
+    CY_CHECK(cy_keccak_batch(CY_HASH_SHA3_512, 6, in, len, outs, 64) == CY_OK);
+    for (int i = 0; i < 6; i++) {cy_sha3_512(in[i], len[i], out); CY_CHECK(!memcmp(out, b[i], 64));}
+    CY_CHECK(cy_keccak_batch(CY_HASH_SHAKE256, 6, in, len, outs, 48) == CY_OK);
+    for (int i = 0; i < 6; i++) {cy_shake256(in[i], len[i], out, 48); CY_CHECK(!memcmp(out, b[i], 48));}
+
+    return cy_test_done("sha3");
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2025 Jebbari Marouane
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Sieve: prime counts over ranges, the shared table, and the range iterator
+
+#include "cy_test.h"
+
+int main(void)
+{
+    size_t count = 0;
+
+    // pi(10^6) = 78498, pi(10^8) = 5761455, and a window far from 0 checked one by one
+    CY_CHECK(cy_sieve_count(0, 1000000, 1, &count) == CY_OK && count == 78498);
+    CY_CHECK(cy_sieve_count(0, 100000000, 4, &count) == CY_OK && count == 5761455);
+    CY_CHECK(cy_sieve_count(0, 2, 1, &count) == CY_OK && count == 0);
+    CY_CHECK(cy_sieve_count(2, 8, 1, &count) == CY_OK && count == 4);
+    const uint64_t lo = 1000000000000ull, hi = lo + 200000;
+    mpz_t n; mpz_init(n);
+    size_t want = 0;
+    for (uint64_t i = lo; i < hi; i++) {mpz_set_ui(n, i); want += mpz_probab_prime_p(n, 25) != 0;}
+    CY_CHECK(cy_sieve_count(lo, hi, 3, &count) == CY_OK && count == want);
+
+    // the table holds every prime below the limit in order
+    const uint32_t *primes;
+    CY_CHECK(cy_sieve_table_init(1000000, 2) == CY_OK);
+    CY_CHECK(cy_sieve_table(&primes, &count) == CY_OK && count == 78498);
+    CY_CHECK(primes[0] == 2 && primes[1] == 3 && primes[2] == 5 && primes[count - 1] == 999983);
+    size_t order = 0;
+    for (size_t i = 1; i < count; i++) order += primes[i] <= primes[i - 1];
+    CY_CHECK(order == 0);
+
+    // a larger table replaces it, the held one stays readable until released
+    CY_CHECK(cy_sieve_table_init(2000000, 2) == CY_OK);
+    CY_CHECK(primes[count - 1] == 999983);
+    const uint32_t *bigger;
+    size_t nbig = 0;
+    CY_CHECK(cy_sieve_table(&bigger, &nbig) == CY_OK && nbig == 148933);
+    cy_sieve_table_release(primes);
+    cy_sieve_table_release(bigger);
+    cy_sieve_table_free();
+
+    // the iterator walks the range in order, 2, 3 and 5 included
+    CY_SIEVE_ITER *it;
+    uint64_t p, prev = 0;
+    CY_CHECK(cy_sieve_iter_init(0, 100, &it) == CY_OK);
+    count = 0;
+    while (cy_sieve_iter_next(it, &p) == CY_OK) {CY_CHECK(p > prev); prev = p; count++;}
+    CY_CHECK(count == 25 && prev == 97);
+    cy_sieve_iter_free(it);
+    CY_CHECK(cy_sieve_iter_init(lo, hi, &it) == CY_OK);
+    count = 0;
+    size_t bad = 0;
+    while (cy_sieve_iter_next(it, &p) == CY_OK)
+    {
+        mpz_set_ui(n, p);
+        bad += p < lo || p >= hi || !mpz_probab_prime_p(n, 25);
+        count++;
+    }
+    CY_CHECK(bad == 0 && count == want);
+    CY_CHECK(cy_sieve_iter_next(it, &p) == CY_INFO_EOF);
+    cy_sieve_iter_free(it);
+
+    mpz_clear(n);
+    return cy_test_done("sieve");
+}